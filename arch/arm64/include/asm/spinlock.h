@@ -70,6 +70,11 @@ static inline void arch_spin_unlock(arch_spinlock_t *lock)
 	stl32(lock, 0);
 }
 
+static inline int arch_spin_value_unlocked(arch_spinlock_t lock)
+{
+	return lock == 0;
+}
+
 static inline int arch_spin_is_locked(arch_spinlock_t *lock)
 {
 	/*
@@ -789,3 +789,19 @@ __SYSCALL(381, sys_ni_syscall)
 __SYSCALL(382, sys_ni_syscall)
 #define __NR_seccomp 383
 __SYSCALL(__NR_seccomp, sys_seccomp)
+/* #define __NR_getrandom 384 */
+__SYSCALL(384, sys_ni_syscall)
+/* #define __NR_memfd_create 385 */
+__SYSCALL(385, sys_ni_syscall)
+/* #define __NR_bpf 386 */
+__SYSCALL(386, sys_ni_syscall)
+/* #define __NR_execveat 387 */
+__SYSCALL(387, sys_ni_syscall)
+/* #define __NR_userfaultfd 388 */
+__SYSCALL(388, sys_ni_syscall)
+/* #define __NR_membarrier 389 */
+__SYSCALL(389, sys_ni_syscall)
+/* #define __NR_mlock2 390 */
+__SYSCALL(390, sys_ni_syscall)
+#define __NR_copy_file_range 391
+__SYSCALL(__NR_copy_file_range, sys_copy_file_range)
@@ -725,6 +725,9 @@ blk_init_allocated_queue(struct request_queue *q, request_fn_proc *rfn,
 	if (blk_init_rl(&q->root_rl, q, GFP_KERNEL))
 		return NULL;
 
+	if (wbt_init(q))
+		return NULL;
+
 	q->request_fn		= rfn;
 	q->prep_rq_fn		= NULL;
 	q->unprep_rq_fn		= NULL;
@@ -1285,6 +1288,7 @@ void __blk_put_request(struct request_queue *q, struct request *req)
 	if (unlikely(--req->ref_count))
 		return;
 
+	wbt_done(q, req);
 	blk_pm_put_request(req);
 
 	elv_completed_request(q, req);
@@ -1479,6 +1483,7 @@ void blk_queue_bio(struct request_queue *q, struct bio *bio)
 	int el_ret, rw_flags, where = ELEVATOR_INSERT_SORT;
 	struct request *req;
 	unsigned int request_count = 0;
+	bool wbt;
 
 	/*
 	 * low level driver can indicate that it wants pages above a
@@ -1534,15 +1539,24 @@ get_rq:
 	if (sync)
 		rw_flags |= REQ_SYNC;
 
+	/*
+	 * Hold back buffered writeback while reads are slow.  This might
+	 * sleep with the queue unlocked.
+	 */
+	wbt = wbt_wait(q, bio);
+
 	/*
 	 * Grab a free request. This is might sleep but can not fail.
 	 * Returns with the queue unlocked.
 	 */
 	req = get_request(q, rw_flags, bio, GFP_NOIO);
 	if (IS_ERR(req)) {
+		if (wbt)
+			wbt_cancel(q);
 		bio_endio(bio, PTR_ERR(req));	/* @q is dead */
 		goto out_unlock;
 	}
+	wbt_track(req, wbt);
 
 	/*
 	 * After dropping the lock and possibly sleeping here, our request
@@ -2241,6 +2255,7 @@ void blk_start_request(struct request *req)
 
 	BUG_ON(test_bit(REQ_ATOM_COMPLETE, &req->atomic_flags));
 	blk_add_timer(req);
+	wbt_issue(req->q, req);
 }
 EXPORT_SYMBOL(blk_start_request);
 
@@ -310,6 +310,27 @@ queue_rq_affinity_store(struct request_queue *q, const char *page, size_t count)
 	return ret;
 }
 
+#ifdef CONFIG_BLK_WBT
+static ssize_t queue_wbt_lat_show(struct request_queue *q, char *page)
+{
+	return sprintf(page, "%lld\n", wbt_lat_show(q));
+}
+
+static ssize_t
+queue_wbt_lat_store(struct request_queue *q, const char *page, size_t count)
+{
+	s64 val;
+	int err;
+
+	err = kstrtos64(page, 10, &val);
+	if (err)
+		return err;
+
+	err = wbt_lat_store(q, val);
+	return err ? err : count;
+}
+#endif
+
 static struct queue_sysfs_entry queue_requests_entry = {
 	.attr = {.name = "nr_requests", .mode = S_IRUGO | S_IWUSR },
 	.show = queue_requests_show,
@@ -429,6 +450,14 @@ static struct queue_sysfs_entry queue_random_entry = {
 	.store = queue_store_random,
 };
 
+#ifdef CONFIG_BLK_WBT
+static struct queue_sysfs_entry queue_wbt_lat_entry = {
+	.attr = {.name = "wbt_lat_usec", .mode = S_IRUGO | S_IWUSR },
+	.show = queue_wbt_lat_show,
+	.store = queue_wbt_lat_store,
+};
+#endif
+
 static struct attribute *default_attrs[] = {
 	&queue_requests_entry.attr,
 	&queue_ra_entry.attr,
@@ -452,6 +481,9 @@ static struct attribute *default_attrs[] = {
 	&queue_rq_affinity_entry.attr,
 	&queue_iostats_entry.attr,
 	&queue_random_entry.attr,
+#ifdef CONFIG_BLK_WBT
+	&queue_wbt_lat_entry.attr,
+#endif
 	NULL,
 };
 
@@ -530,6 +562,8 @@ static void blk_release_queue(struct kobject *kobj)
 
 	blkcg_exit_queue(q);
 
+	wbt_exit(q);
+
 	if (q->elevator) {
 		spin_lock_irq(q->queue_lock);
 		ioc_clear_queue(q);
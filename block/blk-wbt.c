@@ -0,0 +1,283 @@
+/*
+ * Writeback throttling: keep buffered writeback from crowding out reads
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+/*
+ * Background writeback can fill a queue with enough writes that a read
+ * issued behind them waits for all of them.  To avoid that, the latency
+ * of completed reads is checked over 100ms windows.  If even the fastest
+ * read in a window missed the target (queue/wbt_lat_usec in sysfs) while
+ * buffered writes were in flight, the number of buffered writes allowed
+ * in flight is halved, down to one.  Each window in which reads met the
+ * target, or that saw no reads at all, doubles it again, back up to
+ * nr_requests.  Writes somebody is waiting for (REQ_SYNC, REQ_FUA and
+ * flushes) and discards are never held back.
+ *
+ * All of it is protected by the queue lock.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/blkdev.h>
+#include <linux/bio.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/wait.h>
+#include "blk.h"
+
+#define WBT_WINDOW_MSEC		100
+
+/* default read latency targets */
+#define WBT_LAT_NONROT		(2ULL * NSEC_PER_MSEC)
+#define WBT_LAT_ROT		(75ULL * NSEC_PER_MSEC)
+
+struct rq_wb {
+	struct request_queue *q;
+
+	u64 min_lat_nsec;		/* read latency target, 0 disables */
+	bool lat_default;		/* target follows the rotational flag */
+	unsigned int scale_step;	/* allowed depth is nr_requests >> step */
+	unsigned int inflight;		/* tracked writes not yet completed */
+
+	/* statistics of the current window */
+	u64 win_min_lat;
+	unsigned int win_reads;
+	unsigned int win_writes;
+
+	struct timer_list window;
+	wait_queue_head_t wait;
+};
+
+/* A bio is held back if it is a buffered write nobody waits for */
+static bool wbt_should_throttle(struct bio *bio)
+{
+	return (bio->bi_rw & (REQ_WRITE | REQ_SYNC | REQ_FLUSH | REQ_FUA |
+			      REQ_DISCARD)) == REQ_WRITE;
+}
+
+/*
+ * The default is looked up whenever it is needed as drivers such as mmc
+ * mark their queue non-rotational only after it has been set up.
+ */
+static u64 rwb_target(struct rq_wb *rwb)
+{
+	if (rwb->lat_default)
+		return blk_queue_nonrot(rwb->q) ? WBT_LAT_NONROT : WBT_LAT_ROT;
+	return rwb->min_lat_nsec;
+}
+
+static unsigned int rwb_depth(struct rq_wb *rwb)
+{
+	if (!rwb_target(rwb))
+		return UINT_MAX;
+	return max_t(unsigned long, rwb->q->nr_requests >> rwb->scale_step, 1);
+}
+
+static void rwb_arm_window(struct rq_wb *rwb)
+{
+	if (!timer_pending(&rwb->window))
+		mod_timer(&rwb->window,
+			  jiffies + msecs_to_jiffies(WBT_WINDOW_MSEC));
+}
+
+static void rwb_reset_window(struct rq_wb *rwb)
+{
+	rwb->win_min_lat = 0;
+	rwb->win_reads = 0;
+	rwb->win_writes = 0;
+}
+
+static void wbt_window_fn(unsigned long data)
+{
+	struct rq_wb *rwb = (struct rq_wb *)data;
+	struct request_queue *q = rwb->q;
+	unsigned long flags;
+	u64 target;
+
+	spin_lock_irqsave(q->queue_lock, flags);
+
+	target = rwb_target(rwb);
+	if (target && rwb->win_reads && rwb->win_min_lat > target) {
+		/* only writes can be made to back off */
+		if ((rwb->win_writes || rwb->inflight) && rwb_depth(rwb) > 1)
+			rwb->scale_step++;
+	} else if (rwb->scale_step) {
+		rwb->scale_step--;
+		wake_up_all(&rwb->wait);
+	}
+	rwb_reset_window(rwb);
+
+	if (rwb->inflight || rwb->scale_step)
+		rwb_arm_window(rwb);
+
+	spin_unlock_irqrestore(q->queue_lock, flags);
+}
+
+/**
+ * wbt_wait - wait until a bio may be turned into a request
+ * @q: request queue the bio is for
+ * @bio: the bio
+ *
+ * Called with the queue lock held, which is dropped while waiting.
+ * Returns %true if the request made for @bio has to be passed to
+ * wbt_track(), or to wbt_cancel() if none could be allocated after all.
+ */
+bool wbt_wait(struct request_queue *q, struct bio *bio)
+{
+	struct rq_wb *rwb = q->rq_wb;
+	DEFINE_WAIT(wait);
+
+	if (!rwb || !wbt_should_throttle(bio))
+		return false;
+
+	while (rwb->inflight >= rwb_depth(rwb)) {
+		prepare_to_wait_exclusive(&rwb->wait, &wait,
+					  TASK_UNINTERRUPTIBLE);
+		if (rwb->inflight < rwb_depth(rwb))
+			break;
+		/* io_schedule() flushes our plug, it may hold tracked writes */
+		spin_unlock_irq(q->queue_lock);
+		io_schedule();
+		spin_lock_irq(q->queue_lock);
+	}
+	finish_wait(&rwb->wait, &wait);
+
+	rwb->inflight++;
+	rwb->win_writes++;
+	rwb_arm_window(rwb);
+	return true;
+}
+
+/* Give back a slot taken by wbt_wait() */
+static void __wbt_done(struct rq_wb *rwb)
+{
+	rwb->inflight--;
+	if (rwb->inflight < rwb_depth(rwb) && waitqueue_active(&rwb->wait))
+		wake_up(&rwb->wait);
+}
+
+/**
+ * wbt_cancel - undo wbt_wait() for a bio that got no request
+ * @q: request queue
+ *
+ * Called with the queue lock held.
+ */
+void wbt_cancel(struct request_queue *q)
+{
+	if (q->rq_wb)
+		__wbt_done(q->rq_wb);
+}
+
+/**
+ * wbt_issue - note that a request is handed to the driver
+ * @q: request queue
+ * @rq: request being started
+ *
+ * Only reads are timed; they are what the latency target is about.
+ */
+void wbt_issue(struct request_queue *q, struct request *rq)
+{
+	if (q->rq_wb && rq->cmd_type == REQ_TYPE_FS &&
+	    rq_data_dir(rq) == READ)
+		rq->wbt_issue_ns = ktime_to_ns(ktime_get());
+}
+
+/**
+ * wbt_done - account a request that is being freed
+ * @q: request queue
+ * @rq: the request
+ *
+ * Called with the queue lock held.
+ */
+void wbt_done(struct request_queue *q, struct request *rq)
+{
+	struct rq_wb *rwb = q->rq_wb;
+	u64 lat;
+
+	if (!rwb)
+		return;
+
+	if (rq->wbt_tracked) {
+		rq->wbt_tracked = false;
+		__wbt_done(rwb);
+	}
+
+	if (rq->wbt_issue_ns) {
+		lat = ktime_to_ns(ktime_get()) - rq->wbt_issue_ns;
+		rq->wbt_issue_ns = 0;
+		if (!rwb->win_reads || lat < rwb->win_min_lat)
+			rwb->win_min_lat = lat;
+		rwb->win_reads++;
+		rwb_arm_window(rwb);
+	}
+}
+
+/**
+ * wbt_lat_show - current read latency target in usecs, 0 if disabled
+ * @q: request queue
+ */
+s64 wbt_lat_show(struct request_queue *q)
+{
+	return q->rq_wb ? div_u64(rwb_target(q->rq_wb), NSEC_PER_USEC) : 0;
+}
+
+/**
+ * wbt_lat_store - set the read latency target
+ * @q: request queue
+ * @usec: target in usecs, 0 to disable throttling, -1 for the default
+ */
+int wbt_lat_store(struct request_queue *q, s64 usec)
+{
+	struct rq_wb *rwb = q->rq_wb;
+
+	if (!rwb)
+		return -EINVAL;
+	if (usec < -1)
+		return -EINVAL;
+
+	spin_lock_irq(q->queue_lock);
+	rwb->lat_default = usec == -1;
+	rwb->min_lat_nsec = usec > 0 ? usec * NSEC_PER_USEC : 0;
+	rwb->scale_step = 0;
+	rwb_reset_window(rwb);
+	wake_up_all(&rwb->wait);
+	spin_unlock_irq(q->queue_lock);
+
+	return 0;
+}
+
+int wbt_init(struct request_queue *q)
+{
+	struct rq_wb *rwb;
+
+	rwb = kzalloc_node(sizeof(*rwb), GFP_KERNEL, q->node);
+	if (!rwb)
+		return -ENOMEM;
+
+	rwb->q = q;
+	rwb->lat_default = true;
+	setup_timer(&rwb->window, wbt_window_fn, (unsigned long)rwb);
+	init_waitqueue_head(&rwb->wait);
+	q->rq_wb = rwb;
+
+	return 0;
+}
+
+void wbt_exit(struct request_queue *q)
+{
+	struct rq_wb *rwb = q->rq_wb;
+
+	if (!rwb)
+		return;
+
+	del_timer_sync(&rwb->window);
+	q->rq_wb = NULL;
+	kfree(rwb);
+}
@@ -231,4 +231,34 @@ static inline int blk_throtl_init(struct request_queue *q) { return 0; }
 static inline void blk_throtl_exit(struct request_queue *q) { }
 #endif /* CONFIG_BLK_DEV_THROTTLING */
 
+/*
+ * Internal writeback throttling interface
+ */
+#ifdef CONFIG_BLK_WBT
+extern bool wbt_wait(struct request_queue *q, struct bio *bio);
+extern void wbt_cancel(struct request_queue *q);
+extern void wbt_issue(struct request_queue *q, struct request *rq);
+extern void wbt_done(struct request_queue *q, struct request *rq);
+extern s64 wbt_lat_show(struct request_queue *q);
+extern int wbt_lat_store(struct request_queue *q, s64 usec);
+extern int wbt_init(struct request_queue *q);
+extern void wbt_exit(struct request_queue *q);
+
+static inline void wbt_track(struct request *rq, bool tracked)
+{
+	rq->wbt_tracked = tracked;
+}
+#else /* CONFIG_BLK_WBT */
+static inline bool wbt_wait(struct request_queue *q, struct bio *bio)
+{
+	return false;
+}
+static inline void wbt_cancel(struct request_queue *q) { }
+static inline void wbt_track(struct request *rq, bool tracked) { }
+static inline void wbt_issue(struct request_queue *q, struct request *rq) { }
+static inline void wbt_done(struct request_queue *q, struct request *rq) { }
+static inline int wbt_init(struct request_queue *q) { return 0; }
+static inline void wbt_exit(struct request_queue *q) { }
+#endif /* CONFIG_BLK_WBT */
+
 #endif /* BLK_INTERNAL_H */
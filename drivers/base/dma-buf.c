@@ -28,6 +28,7 @@
 #include <linux/anon_inodes.h>
 #include <linux/export.h>
 #include <linux/debugfs.h>
+#include <linux/notifier.h>
 #include <linux/seq_file.h>
 
 static inline int is_dma_buf_file(struct file *);
@@ -41,6 +42,8 @@ static struct dma_buf_list db_list;
 
 static bool dmabuf_lazy_unmapping; /* Set if lazy unmapping for iommu'ed */
 
+static BLOCKING_NOTIFIER_HEAD(dma_buf_release_chain);
+
 static void ____dma_buf_detach(struct dma_buf *dmabuf,
 			     struct dma_buf_attachment *attach);
 static void __dma_buf_unmap_attachment(struct dma_buf_attachment *attach,
@@ -96,6 +99,26 @@ void *dma_buf_get_drvdata(struct dma_buf *dmabuf, struct device *device)
 }
 EXPORT_SYMBOL(dma_buf_get_drvdata);
 
+/**
+ * dma_buf_register_release_notifier - get told when buffers are released
+ * @nb:	[in]	notifier block; called with the struct dma_buf as data
+ *
+ * The notifier runs from the final dma_buf_put(), before the buffer's
+ * attachments are torn down. Importers that keep attachments and mappings
+ * around between uses without holding a reference drop them there.
+ */
+int dma_buf_register_release_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_register(&dma_buf_release_chain, nb);
+}
+EXPORT_SYMBOL(dma_buf_register_release_notifier);
+
+void dma_buf_unregister_release_notifier(struct notifier_block *nb)
+{
+	blocking_notifier_chain_unregister(&dma_buf_release_chain, nb);
+}
+EXPORT_SYMBOL(dma_buf_unregister_release_notifier);
+
 static void dma_buf_release_cached(struct dma_buf *dmabuf)
 {
 	struct dma_buf_attachment *attach, *temp;
@@ -153,6 +176,8 @@ static int dma_buf_release(struct inode *inode, struct file *file)
 
 	dmabuf = file->private_data;
 
+	blocking_notifier_call_chain(&dma_buf_release_chain, 0, dmabuf);
+
 	if (dmabuf_lazy_unmapping)
 		dma_buf_release_cached(dmabuf);
 
@@ -31,6 +31,11 @@
 #include <linux/cpuidle.h>
 #include <linux/timer.h>
 #include <linux/wakeup_reason.h>
+#include <linux/slab.h>
+#include <linux/srcu.h>
+#include <linux/rculist.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include "../base.h"
 #include "power.h"
@@ -67,6 +72,43 @@ struct dpm_watchdog {
 
 static int async_error;
 
+/*
+ * Explicit suspend/resume ordering constraints between devices that are not
+ * parent and child.  The consumer is suspended before and resumed after the
+ * supplier.  The lists are modified under dpm_links_mtx and walked under
+ * dpm_links_srcu.  Links are freed with call_srcu(), because a device may be
+ * unregistered from a PM callback that other devices are waiting for.
+ */
+struct dpm_link {
+	struct list_head	s_node;		/* consumer->power.suppliers */
+	struct list_head	c_node;		/* supplier->power.consumers */
+	struct device		*supplier;
+	struct device		*consumer;
+	struct rcu_head		rcu_head;
+};
+
+static DEFINE_MUTEX(dpm_links_mtx);
+DEFINE_STATIC_SRCU(dpm_links_srcu);
+
+/* Per-phase timing summary, reported through debugfs and tracepoints. */
+enum {
+	DPM_STATS_SUSPEND,
+	DPM_STATS_RESUME,
+	DPM_STATS_NR,
+};
+
+struct dpm_phase_stats {
+	unsigned int	devices;
+	unsigned int	async_devices;
+	ktime_t		total_time;	/* Sum of per-device callback times */
+	ktime_t		max_time;
+	ktime_t		elapsed;	/* Wall clock time of the whole phase */
+	char		slowest[32];	/* Name of the device behind max_time */
+};
+
+static DEFINE_SPINLOCK(dpm_stats_lock);
+static struct dpm_phase_stats dpm_stats[DPM_STATS_NR];
+
 /**
  * device_pm_sleep_init - Initialize system suspend-related device fields.
  * @dev: Device object being initialized.
@@ -79,6 +121,10 @@ void device_pm_sleep_init(struct device *dev)
 	complete_all(&dev->power.completion);
 	dev->power.wakeup = NULL;
 	INIT_LIST_HEAD(&dev->power.entry);
+	INIT_LIST_HEAD(&dev->power.suppliers);
+	INIT_LIST_HEAD(&dev->power.consumers);
+	dev->power.suspend_time = ktime_set(0, 0);
+	dev->power.resume_time = ktime_set(0, 0);
 }
 
 /**
@@ -113,6 +159,8 @@ void device_pm_add(struct device *dev)
 	mutex_unlock(&dpm_list_mtx);
 }
 
+static void dpm_remove_links(struct device *dev);
+
 /**
  * device_pm_remove - Remove a device from the PM core's list of active devices.
  * @dev: Device to be removed from the list.
@@ -125,6 +173,7 @@ void device_pm_remove(struct device *dev)
 	mutex_lock(&dpm_list_mtx);
 	list_del_init(&dev->power.entry);
 	mutex_unlock(&dpm_list_mtx);
+	dpm_remove_links(dev);
 	device_wakeup_disable(dev);
 	pm_runtime_remove(dev);
 }
@@ -195,17 +244,27 @@ static void initcall_debug_report(struct device *dev, ktime_t calltime,
 	}
 }
 
+/**
+ * is_async - Check if a device is to be suspended and resumed asynchronously.
+ * @dev: Device to check.
+ */
+static bool is_async(struct device *dev)
+{
+	return (dev->power.async_suspend || pm_async_all_enabled)
+		&& pm_async_enabled && !pm_trace_is_enabled();
+}
+
 /**
  * dpm_wait - Wait for a PM operation to complete.
  * @dev: Device to wait for.
- * @async: If unset, wait only if the device's power.async_suspend flag is set.
+ * @async: If unset, wait only if @dev is handled asynchronously.
  */
 static void dpm_wait(struct device *dev, bool async)
 {
 	if (!dev)
 		return;
 
-	if (async || (pm_async_enabled && dev->power.async_suspend))
+	if (async || is_async(dev))
 		wait_for_completion(&dev->power.completion);
 }
 
@@ -220,6 +279,67 @@ static void dpm_wait_for_children(struct device *dev, bool async)
        device_for_each_child(dev, &async, dpm_wait_fn);
 }
 
+static void dpm_wait_for_suppliers(struct device *dev, bool async)
+{
+	struct dpm_link *link;
+	int idx;
+
+	idx = srcu_read_lock(&dpm_links_srcu);
+	list_for_each_entry_rcu(link, &dev->power.suppliers, s_node)
+		dpm_wait(link->supplier, async);
+	srcu_read_unlock(&dpm_links_srcu, idx);
+}
+
+static void dpm_wait_for_consumers(struct device *dev, bool async)
+{
+	struct dpm_link *link;
+	int idx;
+
+	idx = srcu_read_lock(&dpm_links_srcu);
+	list_for_each_entry_rcu(link, &dev->power.consumers, c_node)
+		dpm_wait(link->consumer, async);
+	srcu_read_unlock(&dpm_links_srcu, idx);
+}
+
+static void dpm_stats_start(int phase)
+{
+	spin_lock(&dpm_stats_lock);
+	memset(&dpm_stats[phase], 0, sizeof(dpm_stats[phase]));
+	spin_unlock(&dpm_stats_lock);
+}
+
+static void dpm_stats_account(int phase, struct device *dev, ktime_t delta,
+			      bool async)
+{
+	struct dpm_phase_stats *st = &dpm_stats[phase];
+
+	spin_lock(&dpm_stats_lock);
+	st->devices++;
+	if (async)
+		st->async_devices++;
+	st->total_time = ktime_add(st->total_time, delta);
+	if (ktime_compare(delta, st->max_time) > 0) {
+		st->max_time = delta;
+		strlcpy(st->slowest, dev_name(dev), sizeof(st->slowest));
+	}
+	spin_unlock(&dpm_stats_lock);
+}
+
+static void dpm_stats_end(int phase, ktime_t starttime, pm_message_t state)
+{
+	struct dpm_phase_stats *st = &dpm_stats[phase];
+
+	spin_lock(&dpm_stats_lock);
+	st->elapsed = ktime_sub(ktime_get(), starttime);
+	spin_unlock(&dpm_stats_lock);
+
+	trace_device_pm_phase_summary(phase == DPM_STATS_SUSPEND ?
+			TPS("dpm_suspend") : TPS("dpm_resume"), state.event,
+			st->devices, st->async_devices,
+			ktime_to_us(st->total_time), ktime_to_us(st->max_time),
+			ktime_to_us(st->elapsed));
+}
+
 /**
  * pm_op - Return the PM operation appropriate for given PM event.
  * @ops: PM operations to choose from.
@@ -755,6 +875,7 @@ static int device_resume(struct device *dev, pm_message_t state, bool async)
 	char *info = NULL;
 	int error = 0;
 	struct dpm_watchdog wd;
+	ktime_t starttime;
 
 	TRACE_DEVICE(dev);
 	TRACE_RESUME(0);
@@ -763,6 +884,8 @@ static int device_resume(struct device *dev, pm_message_t state, bool async)
 		goto Complete;
 
 	dpm_wait(dev->parent, async);
+	dpm_wait_for_suppliers(dev, async);
+	starttime = ktime_get();
 	device_lock(dev);
 
 	/*
@@ -823,6 +946,8 @@ static int device_resume(struct device *dev, pm_message_t state, bool async)
  Unlock:
 	device_unlock(dev);
 	dpm_wd_clear(&wd);
+	dev->power.resume_time = ktime_sub(ktime_get(), starttime);
+	dpm_stats_account(DPM_STATS_RESUME, dev, dev->power.resume_time, async);
 
  Complete:
 	complete_all(&dev->power.completion);
@@ -843,12 +968,6 @@ static void async_resume(void *data, async_cookie_t cookie)
 	put_device(dev);
 }
 
-static bool is_async(struct device *dev)
-{
-	return dev->power.async_suspend && pm_async_enabled
-		&& !pm_trace_is_enabled();
-}
-
 /**
  * dpm_resume - Execute "resume" callbacks for non-sysdev devices.
  * @state: PM transition of the system being carried out.
@@ -863,6 +982,7 @@ void dpm_resume(pm_message_t state)
 
 	trace_suspend_resume(TPS("dpm_resume"), state.event, true);
 	might_sleep();
+	dpm_stats_start(DPM_STATS_RESUME);
 
 	mutex_lock(&dpm_list_mtx);
 	pm_transition = state;
@@ -901,6 +1021,7 @@ void dpm_resume(pm_message_t state)
 	mutex_unlock(&dpm_list_mtx);
 	async_synchronize_full();
 	dpm_show_time(starttime, state, NULL);
+	dpm_stats_end(DPM_STATS_RESUME, starttime, state);
 	trace_suspend_resume(TPS("dpm_resume"), state.event, false);
 }
 
@@ -1357,8 +1478,10 @@ static int __device_suspend(struct device *dev, pm_message_t state, bool async)
 	int error = 0;
 	struct dpm_watchdog wd;
 	char suspend_abort[MAX_SUSPEND_ABORT_LEN];
+	ktime_t starttime;
 
 	dpm_wait_for_children(dev, async);
+	dpm_wait_for_consumers(dev, async);
 
 	if (async_error)
 		goto Complete;
@@ -1382,7 +1505,8 @@ static int __device_suspend(struct device *dev, pm_message_t state, bool async)
 
 	if (dev->power.syscore)
 		goto Complete;
-	
+
+	starttime = ktime_get();
 	dpm_wd_set(&wd, dev);
 
 	device_lock(dev);
@@ -1443,6 +1567,9 @@ static int __device_suspend(struct device *dev, pm_message_t state, bool async)
 	device_unlock(dev);
 
 	dpm_wd_clear(&wd);
+	dev->power.suspend_time = ktime_sub(ktime_get(), starttime);
+	dpm_stats_account(DPM_STATS_SUSPEND, dev, dev->power.suspend_time,
+			  async);
 
  Complete:
 	complete_all(&dev->power.completion);
@@ -1470,7 +1597,7 @@ static int device_suspend(struct device *dev)
 {
 	INIT_COMPLETION(dev->power.completion);
 
-	if (pm_async_enabled && dev->power.async_suspend) {
+	if (is_async(dev)) {
 		get_device(dev);
 		async_schedule(async_suspend, dev);
 		return 0;
@@ -1490,6 +1617,7 @@ int dpm_suspend(pm_message_t state)
 
 	trace_suspend_resume(TPS("dpm_suspend"), state.event, true);
 	might_sleep();
+	dpm_stats_start(DPM_STATS_SUSPEND);
 
 	mutex_lock(&dpm_list_mtx);
 	pm_transition = state;
@@ -1524,6 +1652,7 @@ int dpm_suspend(pm_message_t state)
 		dpm_save_failed_step(SUSPEND_SUSPEND);
 	} else
 		dpm_show_time(starttime, state, NULL);
+	dpm_stats_end(DPM_STATS_SUSPEND, starttime, state);
 	trace_suspend_resume(TPS("dpm_suspend"), state.event, false);
 	return error;
 }
@@ -1671,7 +1800,7 @@ EXPORT_SYMBOL_GPL(__suspend_report_result);
  */
 int device_pm_wait_for_dev(struct device *subordinate, struct device *dev)
 {
-	dpm_wait(dev, subordinate->power.async_suspend);
+	dpm_wait(dev, is_async(subordinate));
 	return async_error;
 }
 EXPORT_SYMBOL_GPL(device_pm_wait_for_dev);
@@ -1697,3 +1826,198 @@ void dpm_for_each_dev(void *data, void (*fn)(struct device *, void *))
 	device_pm_unlock();
 }
 EXPORT_SYMBOL_GPL(dpm_for_each_dev);
+
+/**
+ * dpm_depends_on - Check if a device has to be resumed after another one.
+ * @dev: Device to check.
+ * @target: Device that @dev may depend on.
+ *
+ * Return true if @target is an ancestor or a (direct or indirect) supplier of
+ * @dev.  Must be called under dpm_links_mtx.
+ */
+static bool dpm_depends_on(struct device *dev, struct device *target)
+{
+	struct dpm_link *link;
+
+	if (dev == target)
+		return true;
+
+	if (dev->parent && dpm_depends_on(dev->parent, target))
+		return true;
+
+	list_for_each_entry(link, &dev->power.suppliers, s_node)
+		if (dpm_depends_on(link->supplier, target))
+			return true;
+
+	return false;
+}
+
+/*
+ * Synchronous devices are handled in dpm_list order, so move the consumer,
+ * its descendants and their consumers behind the supplier.  Must be called
+ * under dpm_list_mtx and dpm_links_mtx.
+ */
+static int dpm_reorder_to_tail(struct device *dev, void *not_used)
+{
+	struct dpm_link *link;
+
+	if (list_empty(&dev->power.entry))
+		return 0;
+
+	device_pm_move_last(dev);
+	device_for_each_child(dev, NULL, dpm_reorder_to_tail);
+	list_for_each_entry(link, &dev->power.consumers, c_node)
+		dpm_reorder_to_tail(link->consumer, NULL);
+
+	return 0;
+}
+
+/**
+ * device_pm_add_link - Add a suspend/resume dependency between two devices.
+ * @consumer: Device depending on @supplier.
+ * @supplier: Device to suspend after and resume before @consumer.
+ *
+ * Describe a dependency that is not reflected by the device hierarchy (e.g. a
+ * panel using a regulator or a clock provider), so that both devices can be
+ * suspended and resumed asynchronously.  Links are dropped automatically when
+ * either device is unregistered.  Must not be called from PM callbacks.
+ */
+int device_pm_add_link(struct device *consumer, struct device *supplier)
+{
+	struct dpm_link *link;
+	int error = 0;
+
+	if (!consumer || !supplier)
+		return -EINVAL;
+
+	link = kzalloc(sizeof(*link), GFP_KERNEL);
+	if (!link)
+		return -ENOMEM;
+
+	link->consumer = consumer;
+	link->supplier = supplier;
+
+	device_pm_lock();
+	mutex_lock(&dpm_links_mtx);
+
+	if (dpm_depends_on(supplier, consumer)) {
+		error = -EINVAL;
+		goto out;
+	}
+
+	list_add_tail_rcu(&link->s_node, &consumer->power.suppliers);
+	list_add_tail_rcu(&link->c_node, &supplier->power.consumers);
+	link = NULL;
+
+	if (!list_empty(&supplier->power.entry))
+		dpm_reorder_to_tail(consumer, NULL);
+
+ out:
+	mutex_unlock(&dpm_links_mtx);
+	device_pm_unlock();
+	kfree(link);
+	return error;
+}
+EXPORT_SYMBOL_GPL(device_pm_add_link);
+
+static void dpm_link_free_rcu(struct rcu_head *rhp)
+{
+	kfree(container_of(rhp, struct dpm_link, rcu_head));
+}
+
+static void dpm_unlink(struct dpm_link *link)
+{
+	list_del_rcu(&link->s_node);
+	list_del_rcu(&link->c_node);
+	call_srcu(&dpm_links_srcu, &link->rcu_head, dpm_link_free_rcu);
+}
+
+/**
+ * device_pm_remove_link - Remove a dependency added by device_pm_add_link().
+ * @consumer: Device depending on @supplier.
+ * @supplier: Device @consumer depends on.
+ */
+void device_pm_remove_link(struct device *consumer, struct device *supplier)
+{
+	struct dpm_link *link, *tmp;
+
+	mutex_lock(&dpm_links_mtx);
+	list_for_each_entry_safe(link, tmp, &consumer->power.suppliers, s_node)
+		if (link->supplier == supplier)
+			dpm_unlink(link);
+	mutex_unlock(&dpm_links_mtx);
+}
+EXPORT_SYMBOL_GPL(device_pm_remove_link);
+
+static void dpm_remove_links(struct device *dev)
+{
+	struct dpm_link *link, *tmp;
+
+	mutex_lock(&dpm_links_mtx);
+	list_for_each_entry_safe(link, tmp, &dev->power.suppliers, s_node)
+		dpm_unlink(link);
+	list_for_each_entry_safe(link, tmp, &dev->power.consumers, c_node)
+		dpm_unlink(link);
+	mutex_unlock(&dpm_links_mtx);
+}
+
+static const char * const dpm_stats_names[DPM_STATS_NR] = {
+	[DPM_STATS_SUSPEND] = "suspend",
+	[DPM_STATS_RESUME] = "resume",
+};
+
+/**
+ * dpm_times_show - Print device suspend/resume timing information.
+ * @m: seq_file to print the statistics into.
+ */
+static int dpm_times_show(struct seq_file *m, void *unused)
+{
+	struct dpm_phase_stats st;
+	struct device *dev;
+	int i;
+
+	seq_puts(m, "phase\tdevices\tasync\ttotal_us\tmax_us\t\telapsed_us\t"
+		"slowest\n");
+	for (i = 0; i < DPM_STATS_NR; i++) {
+		spin_lock(&dpm_stats_lock);
+		st = dpm_stats[i];
+		spin_unlock(&dpm_stats_lock);
+
+		seq_printf(m, "%s\t%u\t%u\t%lld\t\t%lld\t\t%lld\t\t%s\n",
+			   dpm_stats_names[i], st.devices, st.async_devices,
+			   ktime_to_us(st.total_time), ktime_to_us(st.max_time),
+			   ktime_to_us(st.elapsed), st.slowest);
+	}
+
+	seq_puts(m, "\nasync\tsuspend_us\tresume_us\tdevice\n");
+	device_pm_lock();
+	list_for_each_entry(dev, &dpm_list, power.entry)
+		seq_printf(m, "%d\t%lld\t\t%lld\t\t%s\n", is_async(dev),
+			   ktime_to_us(dev->power.suspend_time),
+			   ktime_to_us(dev->power.resume_time), dev_name(dev));
+	device_pm_unlock();
+
+	return 0;
+}
+
+static int dpm_times_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dpm_times_show, NULL);
+}
+
+static const struct file_operations dpm_times_fops = {
+	.owner = THIS_MODULE,
+	.open = dpm_times_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int __init dpm_times_debugfs_init(void)
+{
+	debugfs_create_file("pm_device_times", S_IRUGO, NULL, NULL,
+			    &dpm_times_fops);
+	return 0;
+}
+
+postcore_initcall(dpm_times_debugfs_init);
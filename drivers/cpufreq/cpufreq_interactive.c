@@ -31,6 +31,7 @@
 #include <linux/workqueue.h>
 #include <linux/kthread.h>
 #include <linux/slab.h>
+#include <linux/tegra-throughput.h>
 #include "cpufreq_governor.h"
 
 #define CREATE_TRACE_POINTS
@@ -135,6 +136,15 @@ struct cpufreq_interactive_tunables {
 	 */
 #define DEFAULT_BOOST_FACTOR 0
 	unsigned int boost_factor;
+
+#ifdef CONFIG_TEGRA_THROUGHPUT
+	/*
+	 * Non-zero means a boost pulse whenever the throughput frame hint
+	 * predicts that the app will miss its frame deadline.
+	 */
+	unsigned int frame_hint_boost;
+	struct notifier_block frame_hint_nb;
+#endif
 };
 
 /* For cases where we have single governor instance for system */
@@ -667,6 +677,33 @@ static void cpufreq_interactive_boost(struct cpufreq_interactive_tunables *tunab
 		wake_up_process(speedchange_task);
 }
 
+static void cpufreq_interactive_boostpulse(
+	struct cpufreq_interactive_tunables *tunables, const char *s)
+{
+	tunables->boostpulse_endtime = ktime_to_us(ktime_get()) +
+		tunables->boostpulse_duration_val;
+	trace_cpufreq_interactive_boost(s);
+	if (!tunables->boosted)
+		cpufreq_interactive_boost(tunables);
+}
+
+#ifdef CONFIG_TEGRA_THROUGHPUT
+static int cpufreq_interactive_frame_hint(
+	struct notifier_block *nb, unsigned long hint, void *data)
+{
+	struct cpufreq_interactive_tunables *tunables =
+		container_of(nb, struct cpufreq_interactive_tunables,
+			     frame_hint_nb);
+	struct tegra_throughput_frame_hint *fh = data;
+
+	if (!fh || !tunables->frame_hint_boost || fh->slack_us >= 0)
+		return NOTIFY_DONE;
+
+	cpufreq_interactive_boostpulse(tunables, "frame");
+	return NOTIFY_OK;
+}
+#endif
+
 static int cpufreq_interactive_notifier(
 	struct notifier_block *nb, unsigned long val, void *data)
 {
@@ -991,11 +1028,7 @@ static ssize_t store_boostpulse(struct cpufreq_interactive_tunables *tunables,
 	if (ret < 0)
 		return ret;
 
-	tunables->boostpulse_endtime = ktime_to_us(ktime_get()) +
-		tunables->boostpulse_duration_val;
-	trace_cpufreq_interactive_boost("pulse");
-	if (!tunables->boosted)
-		cpufreq_interactive_boost(tunables);
+	cpufreq_interactive_boostpulse(tunables, "pulse");
 	return count;
 }
 
@@ -1058,6 +1091,28 @@ static ssize_t store_io_busy_threshold(
 	return count;
 }
 
+#ifdef CONFIG_TEGRA_THROUGHPUT
+static ssize_t show_frame_hint_boost(
+		struct cpufreq_interactive_tunables *tunables, char *buf)
+{
+	return sprintf(buf, "%u\n", tunables->frame_hint_boost);
+}
+
+static ssize_t store_frame_hint_boost(
+		struct cpufreq_interactive_tunables *tunables, const char *buf,
+		size_t count)
+{
+	int ret;
+	unsigned long val;
+
+	ret = kstrtoul(buf, 0, &val);
+	if (ret < 0)
+		return ret;
+	tunables->frame_hint_boost = val;
+	return count;
+}
+#endif
+
 /*
  * Create show/store routines
  * - sys: One governor instance for complete SYSTEM
@@ -1107,6 +1162,9 @@ store_gov_pol_sys(boostpulse);
 show_store_gov_pol_sys(boostpulse_duration);
 show_store_gov_pol_sys(io_is_busy);
 show_store_gov_pol_sys(io_busy_threshold);
+#ifdef CONFIG_TEGRA_THROUGHPUT
+show_store_gov_pol_sys(frame_hint_boost);
+#endif
 
 gov_sys_pol_attr_rw(target_loads);
 gov_sys_pol_attr_rw(above_hispeed_delay);
@@ -1120,6 +1178,9 @@ gov_sys_pol_attr_rw(boost);
 gov_sys_pol_attr_rw(boostpulse_duration);
 gov_sys_pol_attr_rw(io_is_busy);
 gov_sys_pol_attr_rw(io_busy_threshold);
+#ifdef CONFIG_TEGRA_THROUGHPUT
+gov_sys_pol_attr_rw(frame_hint_boost);
+#endif
 
 static struct global_attr boostpulse_gov_sys =
 	__ATTR(boostpulse, 0200, NULL, store_boostpulse_gov_sys);
@@ -1142,6 +1203,9 @@ static struct attribute *interactive_attributes_gov_sys[] = {
 	&io_is_busy_gov_sys.attr,
 	&io_busy_threshold_gov_sys.attr,
 	&boost_factor_gov_sys.attr,
+#ifdef CONFIG_TEGRA_THROUGHPUT
+	&frame_hint_boost_gov_sys.attr,
+#endif
 	NULL,
 };
 
@@ -1165,6 +1229,9 @@ static struct attribute *interactive_attributes_gov_pol[] = {
 	&io_is_busy_gov_pol.attr,
 	&io_busy_threshold_gov_pol.attr,
 	&boost_factor_gov_pol.attr,
+#ifdef CONFIG_TEGRA_THROUGHPUT
+	&frame_hint_boost_gov_pol.attr,
+#endif
 	NULL,
 };
 
@@ -1269,6 +1336,12 @@ static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 					CPUFREQ_TRANSITION_NOTIFIER);
 		}
 
+#ifdef CONFIG_TEGRA_THROUGHPUT
+		tunables->frame_hint_nb.notifier_call =
+			cpufreq_interactive_frame_hint;
+		blocking_notifier_chain_register(&throughput_notifier_list,
+						 &tunables->frame_hint_nb);
+#endif
 		break;
 
 	case CPUFREQ_GOV_POLICY_EXIT:
@@ -1279,6 +1352,11 @@ static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 				idle_notifier_unregister(&cpufreq_interactive_idle_nb);
 			}
 
+#ifdef CONFIG_TEGRA_THROUGHPUT
+			blocking_notifier_chain_unregister(
+					&throughput_notifier_list,
+					&tunables->frame_hint_nb);
+#endif
 			sysfs_remove_group(get_governor_parent_kobj(policy),
 					get_sysfs_attr());
 			common_tunables = NULL;
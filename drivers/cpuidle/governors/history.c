@@ -0,0 +1,305 @@
+/*
+ * history.c - the idle interval history governor
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This code is licenced under the GPL version 2 as described
+ * in the COPYING file that accompanies the Linux Kernel.
+ */
+
+#include <linux/kernel.h>
+#include <linux/cpuidle.h>
+#include <linux/pm_qos.h>
+#include <linux/ktime.h>
+#include <linux/tick.h>
+#include <linux/sched.h>
+#include <linux/module.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/cpumask.h>
+
+/*
+ * Concepts and ideas behind the history governor
+ *
+ * The menu governor scales the time to the next timer event by a slowly
+ * adapting correction factor.  When the wakeup pattern changes, it keeps
+ * picking states whose target residency is not met (wasting the entry and
+ * exit energy) or states that are too shallow for a long time.
+ *
+ * This governor instead keeps the last INTERVALS observed idle durations of
+ * every CPU and checks each candidate state directly against them:  a state
+ * is good enough if at least HIT_THRESH of the recent idle periods were long
+ * enough to reach its target residency.  The time to the next timer event is
+ * a hard upper bound, since the CPU is certain to wake up by then, so a state
+ * whose target residency ends after the next timer is never selected.
+ *
+ * The outcome of every idle period is classified per state:
+ * - hit:     the CPU stayed idle for at least the state's target residency,
+ *            and no deeper allowed state would have been a hit as well;
+ * - miss:    the CPU woke up before the target residency was reached, so the
+ *            entry and exit cost was wasted;
+ * - shallow: a deeper state would have been a hit.
+ * These counters are exported through debugfs (cpuidle_history/stats).
+ */
+
+#define INTERVALS	8
+#define HIT_THRESH	5	/* out of INTERVALS */
+
+struct history_state_stats {
+	u64		hits;
+	u64		misses;
+	u64		shallow;
+};
+
+struct history_device {
+	int		last_state_idx;
+	int		needs_update;
+
+	unsigned int	sleep_length_us;
+	unsigned int	intervals[INTERVALS];
+	int		interval_ptr;
+
+	struct history_state_stats stats[CPUIDLE_STATE_MAX];
+};
+
+static DEFINE_PER_CPU(struct history_device, history_devices);
+
+static void history_update(struct cpuidle_driver *drv,
+			   struct cpuidle_device *dev);
+
+/*
+ * Count the recent idle periods that lasted at least @residency_us.
+ */
+static int history_count_hits(struct history_device *data,
+			      unsigned int residency_us)
+{
+	int i, count = 0;
+
+	for (i = 0; i < INTERVALS; i++)
+		if (data->intervals[i] >= residency_us)
+			count++;
+
+	return count;
+}
+
+static bool history_state_usable(struct cpuidle_driver *drv,
+				 struct cpuidle_device *dev, int i,
+				 int latency_req)
+{
+	return !drv->states[i].disabled && !dev->states_usage[i].disable &&
+		drv->states[i].exit_latency <= latency_req;
+}
+
+/**
+ * history_select - selects the next idle state to enter
+ * @drv: cpuidle driver containing state data
+ * @dev: the CPU
+ */
+static int history_select(struct cpuidle_driver *drv,
+			  struct cpuidle_device *dev)
+{
+	struct history_device *data = &__get_cpu_var(history_devices);
+	int latency_req = pm_qos_request(PM_QOS_CPU_DMA_LATENCY);
+	int i;
+
+	if (data->needs_update) {
+		history_update(drv, dev);
+		data->needs_update = 0;
+	}
+
+	data->last_state_idx = CPUIDLE_DRIVER_STATE_START - 1;
+
+	/* Special case when user has set very strict latency requirement */
+	if (unlikely(latency_req == 0))
+		return 0;
+
+	data->sleep_length_us = ktime_to_us(tick_nohz_get_sleep_length());
+
+	/*
+	 * We want to default to C1 (hlt), not to busy polling
+	 * unless the timer is happening really really soon.
+	 */
+	if (data->sleep_length_us > 5 &&
+	    !drv->states[CPUIDLE_DRIVER_STATE_START].disabled &&
+	    dev->states_usage[CPUIDLE_DRIVER_STATE_START].disable == 0)
+		data->last_state_idx = CPUIDLE_DRIVER_STATE_START;
+
+	/*
+	 * Pick the deepest state that ends before the next timer event and
+	 * whose target residency most recent idle periods would have met.
+	 * Deeper states have longer target residencies, so stop at the first
+	 * one that fails the history check.
+	 */
+	for (i = CPUIDLE_DRIVER_STATE_START + 1; i < drv->state_count; i++) {
+		struct cpuidle_state *s = &drv->states[i];
+
+		if (!history_state_usable(drv, dev, i, latency_req))
+			continue;
+		if (s->target_residency > data->sleep_length_us)
+			break;
+		if (history_count_hits(data, s->target_residency) < HIT_THRESH)
+			break;
+
+		data->last_state_idx = i;
+	}
+
+	return data->last_state_idx;
+}
+
+/**
+ * history_reflect - records that data structures need update
+ * @dev: the CPU
+ * @index: the index of actual entered state
+ *
+ * NOTE: it's important to be fast here because this operation will add to
+ *       the overall exit latency.
+ */
+static void history_reflect(struct cpuidle_device *dev, int index)
+{
+	struct history_device *data = &__get_cpu_var(history_devices);
+
+	data->last_state_idx = index;
+	if (index >= 0)
+		data->needs_update = 1;
+}
+
+/**
+ * history_update - records the outcome of the last idle period
+ * @drv: cpuidle driver containing state data
+ * @dev: the CPU
+ */
+static void history_update(struct cpuidle_driver *drv,
+			   struct cpuidle_device *dev)
+{
+	struct history_device *data = &__get_cpu_var(history_devices);
+	int last_idx = data->last_state_idx;
+	struct cpuidle_state *target = &drv->states[last_idx];
+	struct history_state_stats *st = &data->stats[last_idx];
+	int latency_req = pm_qos_request(PM_QOS_CPU_DMA_LATENCY);
+	unsigned int measured_us;
+	int i;
+
+	/*
+	 * This idle state doesn't support residency measurements, so assume
+	 * we slept until the next timer event.
+	 */
+	if (unlikely(!(target->flags & CPUIDLE_FLAG_TIME_VALID)))
+		measured_us = data->sleep_length_us;
+	else
+		measured_us = cpuidle_get_last_residency(dev);
+
+	/* The exit latency is assumed to follow the wakeup event. */
+	if (measured_us > target->exit_latency)
+		measured_us -= target->exit_latency;
+	else
+		measured_us = 0;
+
+	if (measured_us < target->target_residency) {
+		st->misses++;
+	} else {
+		for (i = last_idx + 1; i < drv->state_count; i++) {
+			if (!history_state_usable(drv, dev, i, latency_req))
+				continue;
+			if (drv->states[i].target_residency <= measured_us)
+				break;
+		}
+		if (i < drv->state_count)
+			st->shallow++;
+		else
+			st->hits++;
+	}
+
+	data->intervals[data->interval_ptr++] = measured_us;
+	if (data->interval_ptr >= INTERVALS)
+		data->interval_ptr = 0;
+}
+
+/**
+ * history_enable_device - scans a CPU's states and does setup
+ * @drv: cpuidle driver
+ * @dev: the CPU
+ */
+static int history_enable_device(struct cpuidle_driver *drv,
+				 struct cpuidle_device *dev)
+{
+	struct history_device *data = &per_cpu(history_devices, dev->cpu);
+
+	memset(data, 0, sizeof(struct history_device));
+
+	return 0;
+}
+
+static int history_stats_show(struct seq_file *s, void *data)
+{
+	struct cpuidle_driver *drv;
+	int cpu, i;
+
+	seq_puts(s, "cpu\tstate\t\thits\t\tmisses\t\tshallow\n");
+	for_each_online_cpu(cpu) {
+		struct history_device *hdev = &per_cpu(history_devices, cpu);
+		struct cpuidle_device *dev = per_cpu(cpuidle_devices, cpu);
+
+		drv = dev ? cpuidle_get_cpu_driver(dev) : NULL;
+		if (!drv)
+			continue;
+
+		for (i = CPUIDLE_DRIVER_STATE_START; i < drv->state_count; i++)
+			seq_printf(s, "%d\t%-16s%-16llu%-16llu%llu\n", cpu,
+				   drv->states[i].name,
+				   hdev->stats[i].hits,
+				   hdev->stats[i].misses,
+				   hdev->stats[i].shallow);
+	}
+
+	return 0;
+}
+
+static int history_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, history_stats_show, inode->i_private);
+}
+
+static const struct file_operations history_stats_fops = {
+	.open		= history_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static struct cpuidle_governor history_governor = {
+	.name =		"history",
+	.rating =	19,
+	.enable =	history_enable_device,
+	.select =	history_select,
+	.reflect =	history_reflect,
+	.owner =	THIS_MODULE,
+};
+
+/**
+ * init_history - initializes the governor
+ */
+static int __init init_history(void)
+{
+	return cpuidle_register_governor(&history_governor);
+}
+
+postcore_initcall(init_history);
+
+static int __init history_debugfs_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("cpuidle_history", NULL);
+	if (!dir)
+		return -ENOMEM;
+
+	if (!debugfs_create_file("stats", S_IRUGO, dir, NULL,
+				 &history_stats_fops)) {
+		debugfs_remove_recursive(dir);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+late_initcall(history_debugfs_init);
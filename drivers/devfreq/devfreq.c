@@ -26,6 +26,7 @@
 #include <linux/list.h>
 #include <linux/printk.h>
 #include <linux/hrtimer.h>
+#include <linux/math64.h>
 #include "governor.h"
 
 static struct class *devfreq_class;
@@ -135,6 +136,22 @@ static int devfreq_update_status(struct devfreq *devfreq, unsigned long freq)
 	return 0;
 }
 
+static int devfreq_notify_transition(struct devfreq *devfreq,
+		struct devfreq_freqs *freqs, unsigned int state)
+{
+	switch (state) {
+	case DEVFREQ_PRECHANGE:
+	case DEVFREQ_POSTCHANGE:
+		srcu_notifier_call_chain(&devfreq->transition_notifier_list,
+					 state, freqs);
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 /**
  * find_devfreq_governor() - find devfreq governor from name
  * @name:	name of the governor
@@ -172,6 +189,7 @@ static struct devfreq_governor *find_devfreq_governor(const char *name)
  */
 int update_devfreq(struct devfreq *devfreq)
 {
+	struct devfreq_freqs freqs;
 	unsigned long freq;
 	int err = 0;
 	u32 flags = 0;
@@ -206,9 +224,19 @@ int update_devfreq(struct devfreq *devfreq)
 		flags |= DEVFREQ_FLAG_LEAST_UPPER_BOUND; /* Use LUB */
 	}
 
+	freqs.old = devfreq->previous_freq;
+	freqs.new = freq;
+	devfreq_notify_transition(devfreq, &freqs, DEVFREQ_PRECHANGE);
+
 	err = devfreq->profile->target(devfreq->dev.parent, &freq, flags);
-	if (err)
+	if (err) {
+		freqs.new = freqs.old;
+		devfreq_notify_transition(devfreq, &freqs, DEVFREQ_POSTCHANGE);
 		return err;
+	}
+
+	freqs.new = freq;
+	devfreq_notify_transition(devfreq, &freqs, DEVFREQ_POSTCHANGE);
 
 	if (devfreq->profile->freq_table)
 		if (devfreq_update_status(devfreq, freq))
@@ -421,6 +449,7 @@ static void _remove_devfreq(struct devfreq *devfreq, bool skip)
 		put_device(&devfreq->dev);
 	}
 
+	srcu_cleanup_notifier_head(&devfreq->transition_notifier_list);
 	mutex_destroy(&devfreq->lock);
 	kfree(devfreq);
 }
@@ -498,6 +527,7 @@ struct devfreq *devfreq_add_device(struct device *dev,
 						devfreq->profile->max_state,
 						GFP_KERNEL);
 	devfreq->last_stat_updated = jiffies;
+	srcu_init_notifier_head(&devfreq->transition_notifier_list);
 
 	dev_set_name(&devfreq->dev, dev_name(dev));
 	err = device_register(&devfreq->dev);
@@ -531,6 +561,7 @@ err_init:
 	list_del(&devfreq->node);
 	device_unregister(&devfreq->dev);
 err_dev:
+	srcu_cleanup_notifier_head(&devfreq->transition_notifier_list);
 	kfree(devfreq);
 err_out:
 	return ERR_PTR(err);
@@ -1032,6 +1063,105 @@ int devfreq_watermark_event(struct devfreq *devfreq, int type)
 }
 EXPORT_SYMBOL(devfreq_watermark_event);
 
+/**
+ * devfreq_register_notifier() - Register a driver with devfreq
+ * @devfreq:	The devfreq object.
+ * @nb:		The notifier block to register.
+ * @list:	DEVFREQ_TRANSITION_NOTIFIER.
+ *
+ * Notifiers are called with struct devfreq_freqs as data and with
+ * devfreq->lock held.
+ */
+int devfreq_register_notifier(struct devfreq *devfreq,
+			      struct notifier_block *nb,
+			      unsigned int list)
+{
+	if (!devfreq)
+		return -EINVAL;
+
+	switch (list) {
+	case DEVFREQ_TRANSITION_NOTIFIER:
+		return srcu_notifier_chain_register(
+				&devfreq->transition_notifier_list, nb);
+	default:
+		return -EINVAL;
+	}
+}
+EXPORT_SYMBOL(devfreq_register_notifier);
+
+/**
+ * devfreq_unregister_notifier() - Unregister a driver with devfreq
+ * @devfreq:	The devfreq object.
+ * @nb:		The notifier block to be unregistered.
+ * @list:	DEVFREQ_TRANSITION_NOTIFIER.
+ */
+int devfreq_unregister_notifier(struct devfreq *devfreq,
+				struct notifier_block *nb,
+				unsigned int list)
+{
+	if (!devfreq)
+		return -EINVAL;
+
+	switch (list) {
+	case DEVFREQ_TRANSITION_NOTIFIER:
+		return srcu_notifier_chain_unregister(
+				&devfreq->transition_notifier_list, nb);
+	default:
+		return -EINVAL;
+	}
+}
+EXPORT_SYMBOL(devfreq_unregister_notifier);
+
+/**
+ * devfreq_load_history_init() - Reset a load history.
+ * @history:	the load history
+ * @shift:	weight of a new sample is 1 / 2^shift
+ */
+void devfreq_load_history_init(struct devfreq_load_history *history,
+			       unsigned int shift)
+{
+	history->shift = min_t(unsigned int, shift, DEVFREQ_LOAD_HISTORY_FRAC);
+	history->avg_load = 0;
+	history->last_load = 0;
+	history->valid = false;
+}
+EXPORT_SYMBOL(devfreq_load_history_init);
+
+/**
+ * devfreq_load_history_update() - Account a sample in a load history.
+ * @history:	the load history
+ * @stat:	the sample, as returned by profile->get_dev_status()
+ *
+ * Returns the exponentially weighted load, scaled between 0 and 1000.
+ * Samples with a zero total_time don't change the history.
+ */
+unsigned int devfreq_load_history_update(struct devfreq_load_history *history,
+					 struct devfreq_dev_status *stat)
+{
+	unsigned long load;
+
+	if (stat->total_time) {
+		load = div64_u64((u64)min(stat->busy_time, stat->total_time) *
+				 1000, stat->total_time);
+		history->last_load = load;
+		load <<= DEVFREQ_LOAD_HISTORY_FRAC;
+
+		if (!history->valid) {
+			history->avg_load = load;
+			history->valid = true;
+		} else if (load > history->avg_load) {
+			history->avg_load +=
+				(load - history->avg_load) >> history->shift;
+		} else {
+			history->avg_load -=
+				(history->avg_load - load) >> history->shift;
+		}
+	}
+
+	return history->avg_load >> DEVFREQ_LOAD_HISTORY_FRAC;
+}
+EXPORT_SYMBOL(devfreq_load_history_update);
+
 
 static int __init devfreq_init(void)
 {
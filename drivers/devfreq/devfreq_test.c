@@ -0,0 +1,196 @@
+/*
+ *  linux/drivers/devfreq/devfreq_test.c
+ *
+ * Simulated devfreq devices for evaluating governors.
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Registers a "parent" device scaled by a load-based governor and a "child"
+ * device using the passive governor. The load of the parent is set through
+ * debugfs (devfreq_test/load, 0 to 1000) and smoothed with a load history
+ * before being reported to the governor. Frequency decisions can be followed
+ * through the usual devfreq sysfs attributes (cur_freq, trans_stat).
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/platform_device.h>
+#include <linux/devfreq.h>
+#include <linux/debugfs.h>
+#include <linux/jiffies.h>
+#include <linux/err.h>
+#include <linux/math64.h>
+
+static char *parent_governor = "simple_ondemand";
+module_param(parent_governor, charp, S_IRUGO);
+MODULE_PARM_DESC(parent_governor, "Governor of the simulated parent device");
+
+static unsigned int history_shift = 2;
+module_param(history_shift, uint, S_IRUGO);
+MODULE_PARM_DESC(history_shift, "Load history weight (1 / 2^shift)");
+
+static unsigned long parent_freqs[] = {
+	102000000, 204000000, 408000000, 614400000, 768000000, 998400000,
+};
+
+static unsigned long child_freqs[] = {
+	40800000, 68000000, 102000000, 204000000,
+};
+
+struct devfreq_test_dev {
+	struct platform_device *pdev;
+	struct devfreq *devfreq;
+	struct devfreq_dev_profile profile;
+	unsigned long cur_freq;
+	unsigned long last_sample;
+	struct devfreq_load_history history;
+};
+
+static struct devfreq_test_dev test_parent, test_child;
+static u32 test_load = 500;
+static struct dentry *test_debugfs_dir;
+static struct devfreq_passive_data test_passive_data;
+
+static struct devfreq_test_dev *devfreq_test_lookup(struct device *dev)
+{
+	return dev == &test_parent.pdev->dev ? &test_parent : &test_child;
+}
+
+static int devfreq_test_target(struct device *dev, unsigned long *freq,
+			       u32 flags)
+{
+	struct devfreq_test_dev *tdev = devfreq_test_lookup(dev);
+	struct devfreq_dev_profile *profile = &tdev->profile;
+	int i;
+
+	/* Lowest frequency not below the request, or the highest one */
+	for (i = 0; i < profile->max_state - 1; i++)
+		if (profile->freq_table[i] >= *freq)
+			break;
+
+	if ((flags & DEVFREQ_FLAG_LEAST_UPPER_BOUND) && i > 0 &&
+	    profile->freq_table[i] > *freq)
+		i--;
+
+	tdev->cur_freq = *freq = profile->freq_table[i];
+	dev_dbg(dev, "frequency set to %lu\n", *freq);
+
+	return 0;
+}
+
+static int devfreq_test_get_dev_status(struct device *dev,
+				       struct devfreq_dev_status *stat)
+{
+	struct devfreq_test_dev *tdev = devfreq_test_lookup(dev);
+	unsigned long now = jiffies;
+	unsigned int load;
+
+	stat->current_frequency = tdev->cur_freq;
+	stat->total_time = jiffies_to_usecs(now - tdev->last_sample);
+	tdev->last_sample = now;
+
+	/*
+	 * The simulated device has a fixed amount of work per unit of time
+	 * at the highest frequency, so its busy time scales inversely with
+	 * the current frequency.
+	 */
+	load = min_t(u64, 1000, div64_u64((u64)ACCESS_ONCE(test_load) *
+			parent_freqs[ARRAY_SIZE(parent_freqs) - 1],
+			max(tdev->cur_freq, 1UL)));
+	stat->busy_time = stat->total_time * load / 1000;
+
+	/* Report the smoothed load to the governor */
+	load = devfreq_load_history_update(&tdev->history, stat);
+	stat->busy_time = stat->total_time * load / 1000;
+
+	return 0;
+}
+
+static int devfreq_test_get_cur_freq(struct device *dev, unsigned long *freq)
+{
+	*freq = devfreq_test_lookup(dev)->cur_freq;
+	return 0;
+}
+
+static int devfreq_test_add(struct devfreq_test_dev *tdev, const char *name,
+			    unsigned long *freqs, unsigned int nr_freqs,
+			    const char *governor, void *data)
+{
+	int err;
+
+	tdev->pdev = platform_device_register_simple(name, -1, NULL, 0);
+	if (IS_ERR(tdev->pdev))
+		return PTR_ERR(tdev->pdev);
+
+	tdev->cur_freq = freqs[0];
+	tdev->last_sample = jiffies;
+	devfreq_load_history_init(&tdev->history, history_shift);
+
+	tdev->profile.initial_freq = freqs[0];
+	/* Only the parent polls, the passive child follows its transitions */
+	tdev->profile.polling_ms = data ? 0 : 50;
+	tdev->profile.target = devfreq_test_target;
+	tdev->profile.get_dev_status = devfreq_test_get_dev_status;
+	tdev->profile.get_cur_freq = devfreq_test_get_cur_freq;
+	tdev->profile.freq_table = freqs;
+	tdev->profile.max_state = nr_freqs;
+
+	tdev->devfreq = devfreq_add_device(&tdev->pdev->dev, &tdev->profile,
+					   governor, data);
+	if (IS_ERR(tdev->devfreq)) {
+		err = PTR_ERR(tdev->devfreq);
+		platform_device_unregister(tdev->pdev);
+		return err;
+	}
+
+	return 0;
+}
+
+static void devfreq_test_remove(struct devfreq_test_dev *tdev)
+{
+	devfreq_remove_device(tdev->devfreq);
+	platform_device_unregister(tdev->pdev);
+}
+
+static int __init devfreq_test_init(void)
+{
+	int err;
+
+	err = devfreq_test_add(&test_parent, "devfreq-test-parent",
+			       parent_freqs, ARRAY_SIZE(parent_freqs),
+			       parent_governor, NULL);
+	if (err)
+		return err;
+
+	test_passive_data.parent = test_parent.devfreq;
+	err = devfreq_test_add(&test_child, "devfreq-test-child",
+			       child_freqs, ARRAY_SIZE(child_freqs),
+			       "passive", &test_passive_data);
+	if (err) {
+		devfreq_test_remove(&test_parent);
+		return err;
+	}
+
+	test_debugfs_dir = debugfs_create_dir("devfreq_test", NULL);
+	if (test_debugfs_dir)
+		debugfs_create_u32("load", S_IRUGO | S_IWUSR, test_debugfs_dir,
+				   &test_load);
+
+	return 0;
+}
+module_init(devfreq_test_init);
+
+static void __exit devfreq_test_exit(void)
+{
+	debugfs_remove_recursive(test_debugfs_dir);
+	devfreq_test_remove(&test_child);
+	devfreq_test_remove(&test_parent);
+}
+module_exit(devfreq_test_exit);
+
+MODULE_DESCRIPTION("Simulated devfreq devices for governor evaluation");
+MODULE_LICENSE("GPL");
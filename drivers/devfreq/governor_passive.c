@@ -0,0 +1,153 @@
+/*
+ *  linux/drivers/devfreq/governor_passive.c
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/errno.h>
+#include <linux/module.h>
+#include <linux/devfreq.h>
+#include "governor.h"
+
+/*
+ * The passive governor does not sample the load of its device. Instead, it
+ * follows the frequency transitions of a parent devfreq device, e.g. a memory
+ * clock following the engine that generates the traffic.
+ */
+
+static int devfreq_passive_get_freq_level(struct devfreq *devfreq,
+					  unsigned long freq)
+{
+	int lev;
+
+	for (lev = 0; lev < devfreq->profile->max_state; lev++)
+		if (freq <= devfreq->profile->freq_table[lev])
+			return lev;
+
+	return devfreq->profile->max_state - 1;
+}
+
+static int devfreq_passive_get_target_freq(struct devfreq *devfreq,
+					   unsigned long *freq)
+{
+	struct devfreq_passive_data *p_data = devfreq->data;
+	struct devfreq *parent = p_data->parent;
+	int lev, parent_lev;
+
+	if (p_data->get_target_freq)
+		return p_data->get_target_freq(devfreq, p_data->parent_freq,
+					       freq);
+
+	if (!parent->profile->freq_table || !parent->profile->max_state ||
+	    !devfreq->profile->freq_table || !devfreq->profile->max_state)
+		return -EINVAL;
+
+	/* Map the parent level proportionally onto our own table */
+	parent_lev = devfreq_passive_get_freq_level(parent,
+						    p_data->parent_freq);
+	if (parent->profile->max_state > 1)
+		lev = DIV_ROUND_UP(parent_lev *
+				   (devfreq->profile->max_state - 1),
+				   parent->profile->max_state - 1);
+	else
+		lev = devfreq->profile->max_state - 1;
+
+	*freq = devfreq->profile->freq_table[lev];
+
+	return 0;
+}
+
+static int devfreq_passive_notifier_call(struct notifier_block *nb,
+					 unsigned long event, void *ptr)
+{
+	struct devfreq_passive_data *p_data =
+			container_of(nb, struct devfreq_passive_data, nb);
+	struct devfreq *devfreq = p_data->this;
+	struct devfreq_freqs *freqs = ptr;
+	int ret = 0;
+
+	/*
+	 * Scale up before the parent does and scale down after it did, so
+	 * that the passive device never lags behind its parent's demand.
+	 */
+	switch (event) {
+	case DEVFREQ_PRECHANGE:
+		if (freqs->new <= freqs->old)
+			return NOTIFY_DONE;
+		break;
+	case DEVFREQ_POSTCHANGE:
+		if (freqs->new >= freqs->old)
+			return NOTIFY_DONE;
+		break;
+	default:
+		return NOTIFY_DONE;
+	}
+
+	mutex_lock(&devfreq->lock);
+	p_data->parent_freq = freqs->new;
+	if (!devfreq->suspended)
+		ret = update_devfreq(devfreq);
+	mutex_unlock(&devfreq->lock);
+
+	if (ret)
+		dev_warn(&devfreq->dev, "failed to follow parent: %d\n", ret);
+
+	return NOTIFY_DONE;
+}
+
+static int devfreq_passive_handler(struct devfreq *devfreq,
+				   unsigned int event, void *data)
+{
+	struct devfreq_passive_data *p_data = devfreq->data;
+	int ret = 0;
+
+	if (!p_data || !p_data->parent)
+		return -EINVAL;
+
+	switch (event) {
+	case DEVFREQ_GOV_START:
+		p_data->this = devfreq;
+		p_data->parent_freq = p_data->parent->previous_freq;
+		p_data->nb.notifier_call = devfreq_passive_notifier_call;
+		ret = devfreq_register_notifier(p_data->parent, &p_data->nb,
+						DEVFREQ_TRANSITION_NOTIFIER);
+		break;
+
+	case DEVFREQ_GOV_STOP:
+		ret = devfreq_unregister_notifier(p_data->parent, &p_data->nb,
+						  DEVFREQ_TRANSITION_NOTIFIER);
+		break;
+
+	default:
+		break;
+	}
+
+	return ret;
+}
+
+static struct devfreq_governor devfreq_passive = {
+	.name = "passive",
+	.get_target_freq = devfreq_passive_get_target_freq,
+	.event_handler = devfreq_passive_handler,
+};
+
+static int __init devfreq_passive_init(void)
+{
+	return devfreq_add_governor(&devfreq_passive);
+}
+subsys_initcall(devfreq_passive_init);
+
+static void __exit devfreq_passive_exit(void)
+{
+	int ret;
+
+	ret = devfreq_remove_governor(&devfreq_passive);
+	if (ret)
+		pr_err("%s: failed remove governor %d\n", __func__, ret);
+}
+module_exit(devfreq_passive_exit);
+MODULE_LICENSE("GPL");
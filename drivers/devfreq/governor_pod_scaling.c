@@ -91,6 +91,7 @@ struct podgov_info_rec {
 	unsigned int		p_slowdown_delay;
 	unsigned int		p_block_window;
 	unsigned int		p_use_throughput_hint;
+	unsigned int		p_use_frame_hint;
 	unsigned int		p_hint_lo_limit;
 	unsigned int		p_hint_hi_limit;
 	unsigned int		p_scaleup_limit;
@@ -461,7 +462,9 @@ static int freqlist_down(struct podgov_info_rec *podgov, unsigned long target,
  * nvhost_scale_emc_set_throughput_hint(hint)
  *
  * This function can be used to request scaling up or down based on the
- * required throughput
+ * required throughput. If the notifier passes a frame hint and frame hints
+ * are enabled, the target is the lowest frequency predicted to make the frame
+ * deadline at the current load, approached one step at a time.
  ******************************************************************************/
 
 static int nvhost_scale_emc_set_throughput_hint(struct notifier_block *nb,
@@ -472,6 +475,7 @@ static int nvhost_scale_emc_set_throughput_hint(struct notifier_block *nb,
 			     throughput_hint_notifier);
 	struct devfreq *df = podgov->power_manager;
 	struct device *dev = df->dev.parent;
+	struct tegra_throughput_frame_hint *fh = data;
 	int hint = tegra_throughput_get_hint();
 	long idle;
 	unsigned long curr, target;
@@ -508,7 +512,17 @@ static int nvhost_scale_emc_set_throughput_hint(struct notifier_block *nb,
 
 	/* set the target using avg_hint and avg_idle */
 	target = curr;
-	if (avg_hint < podgov->p_hint_lo_limit) {
+	if (fh && podgov->p_use_frame_hint) {
+		unsigned long need = tegra_throughput_hint_rate(fh, curr,
+							1000 - avg_idle);
+
+		/* hold the rate while recent frames still miss */
+		if (need > curr)
+			target = freqlist_up(podgov, curr, 1);
+		else if (!fh->miss_permille &&
+			 freqlist_down(podgov, curr, 1) >= need)
+			target = freqlist_down(podgov, curr, 1);
+	} else if (avg_hint < podgov->p_hint_lo_limit) {
 		target = freqlist_up(podgov, curr, 1);
 	} else {
 		scale_score = avg_idle + avg_hint;
@@ -580,6 +594,7 @@ static void nvhost_scale_emc_debug_init(struct devfreq *df)
 	CREATE_PODGOV_FILE(bias);
 	CREATE_PODGOV_FILE(damp);
 	CREATE_PODGOV_FILE(use_throughput_hint);
+	CREATE_PODGOV_FILE(use_frame_hint);
 	CREATE_PODGOV_FILE(hint_hi_limit);
 	CREATE_PODGOV_FILE(hint_lo_limit);
 	CREATE_PODGOV_FILE(scaleup_limit);
@@ -845,6 +860,7 @@ static int nvhost_pod_init(struct devfreq *df)
 	podgov->enable = 1;
 	podgov->block = 0;
 	podgov->p_use_throughput_hint = 1;
+	podgov->p_use_frame_hint = 0;
 
 	if (!strcmp(d->name, "vic03.0")) {
 		podgov->p_load_max = 990;
@@ -51,6 +51,7 @@ static void balloc_print_stats(struct gk20a_allocator *a, struct seq_file *s,
 static struct gk20a_buddy *balloc_free_buddy(struct gk20a_allocator *a,
 					     u64 addr);
 static void balloc_coalesce(struct gk20a_allocator *a, struct gk20a_buddy *b);
+static int balloc_drain(struct gk20a_allocator *a);
 static void __balloc_do_free_fixed(struct gk20a_allocator *a,
 				   struct gk20a_fixed_alloc *falloc);
 
@@ -218,8 +219,11 @@ static int balloc_init_lists(struct gk20a_allocator *a)
 	bend = a->end;
 
 	/* First make sure the LLs are valid. */
-	for (i = 0; i < GPU_BALLOC_ORDER_LIST_LEN; i++)
+	for (i = 0; i < GPU_BALLOC_ORDER_LIST_LEN; i++) {
 		INIT_LIST_HEAD(balloc_get_order_list(a, i));
+		INIT_LIST_HEAD(balloc_get_cache_list(a, i));
+	}
+	INIT_LIST_HEAD(&a->slabs);
 
 	while (bstart < bend) {
 		order = __balloc_max_order_in(a, bstart, bend);
@@ -362,20 +366,34 @@ void gk20a_allocator_destroy(struct gk20a_allocator *a)
 	}
 
 	/*
-	 * And now free all outstanding allocations.
+	 * And now free all outstanding allocations, slabs included.
 	 */
 	while ((node = rb_first(&a->alloced_buddies)) != NULL) {
 		bud = container_of(node, struct gk20a_buddy, alloced_entry);
+		if (buddy_is_slab(bud)) {
+			kfree(bud->slab);
+			bud->slab = NULL;
+			buddy_clr_slab(bud);
+		}
 		balloc_free_buddy(a, bud->start);
 		balloc_blist_add(a, bud);
 		balloc_coalesce(a, bud);
 	}
+	INIT_LIST_HEAD(&a->slabs);
+	a->nr_slabs = 0;
+	a->nr_empty_slabs = 0;
+
+	/*
+	 * Cached buddies stopped the above from coalescing all the way.
+	 */
+	balloc_drain(a);
 
 	/*
 	 * Now clean up the unallocated buddies.
 	 */
 	for (i = 0; i < GPU_BALLOC_ORDER_LIST_LEN; i++) {
 		BUG_ON(a->buddy_list_alloced[i] != 0);
+		BUG_ON(a->free_cache_len[i] != 0);
 
 		while (!list_empty(balloc_get_order_list(a, i))) {
 			bud = list_first_entry(balloc_get_order_list(a, i),
@@ -432,7 +450,8 @@ static void balloc_coalesce(struct gk20a_allocator *a, struct gk20a_buddy *b)
 	 */
 	if (!b->buddy)
 		return;
-	if (buddy_is_alloced(b->buddy) || buddy_is_split(b->buddy))
+	if (buddy_is_alloced(b->buddy) || buddy_is_split(b->buddy) ||
+	    buddy_is_cached(b->buddy))
 		return;
 
 	parent = b->parent;
@@ -565,6 +584,143 @@ static struct gk20a_buddy *balloc_free_buddy(struct gk20a_allocator *a,
 	return bud;
 }
 
+/*
+ * Find the allocated buddy that contains @addr. Unlike balloc_free_buddy()
+ * @addr does not have to be the start of the buddy, which is what lets a slab
+ * object be traced back to its slab.
+ *
+ * @a must be locked.
+ */
+static struct gk20a_buddy *balloc_find_alloced(struct gk20a_allocator *a,
+					       u64 addr)
+{
+	struct rb_node *node = a->alloced_buddies.rb_node;
+	struct gk20a_buddy *bud;
+
+	while (node) {
+		bud = container_of(node, struct gk20a_buddy, alloced_entry);
+
+		if (addr < bud->start)
+			node = node->rb_left;
+		else if (addr >= bud->end)
+			node = node->rb_right;
+		else
+			return bud;
+	}
+
+	return NULL;
+}
+
+static void balloc_uncache_buddy(struct gk20a_allocator *a,
+				 struct gk20a_buddy *b)
+{
+	list_del_init(&b->buddy_entry);
+	buddy_clr_cached(b);
+	a->free_cache_len[b->order]--;
+}
+
+/*
+ * Put a buddy that was just freed in its order's cache. If that pushes the
+ * oldest buddy out of the cache, that one goes back into the buddy lists and
+ * is coalesced. With GPU_BALLOC_NO_CACHE the buddy is coalesced right away.
+ *
+ * @a must be locked.
+ */
+static void balloc_cache_buddy(struct gk20a_allocator *a, struct gk20a_buddy *b)
+{
+	struct list_head *cache = balloc_get_cache_list(a, b->order);
+
+	if (a->flags & GPU_BALLOC_NO_CACHE) {
+		balloc_blist_add(a, b);
+		balloc_coalesce(a, b);
+		return;
+	}
+
+	list_add(&b->buddy_entry, cache);
+	buddy_set_cached(b);
+	a->free_cache_len[b->order]++;
+
+	if (a->free_cache_len[b->order] > GPU_BALLOC_CACHE_LEN) {
+		b = list_last_entry(cache, struct gk20a_buddy, buddy_entry);
+		balloc_uncache_buddy(a, b);
+		balloc_blist_add(a, b);
+		balloc_coalesce(a, b);
+	}
+}
+
+/*
+ * Find the most recently freed buddy of @order that suits @pte_size.
+ *
+ * @a must be locked.
+ */
+static struct gk20a_buddy *__balloc_find_cached(struct gk20a_allocator *a,
+						u64 order, int pte_size)
+{
+	struct gk20a_buddy *bud;
+
+	list_for_each_entry(bud, balloc_get_cache_list(a, order), buddy_entry)
+		if (bud->pte_size == BALLOC_PTE_SIZE_ANY ||
+		    bud->pte_size == pte_size)
+			return bud;
+
+	return NULL;
+}
+
+/*
+ * Give back a slab whose objects have all been freed.
+ *
+ * @a must be locked.
+ */
+static void balloc_release_slab(struct gk20a_allocator *a,
+				struct gk20a_balloc_slab *slab)
+{
+	struct gk20a_buddy *bud = slab->buddy;
+
+	list_del(&slab->slab_entry);
+	a->nr_slabs--;
+
+	bud->slab = NULL;
+	buddy_clr_slab(bud);
+	kfree(slab);
+
+	balloc_free_buddy(a, bud->start);
+	balloc_cache_buddy(a, bud);
+}
+
+/*
+ * Give back everything the allocator holds on to for speed: empty slabs and
+ * the cached buddies, which are then coalesced as far as they go. Returns
+ * non-zero if there was anything to give back.
+ *
+ * @a must be locked.
+ */
+static int balloc_drain(struct gk20a_allocator *a)
+{
+	struct gk20a_balloc_slab *slab, *tmp;
+	struct gk20a_buddy *bud;
+	int i, drained = 0;
+
+	list_for_each_entry_safe(slab, tmp, &a->slabs, slab_entry) {
+		if (slab->nr_alloced)
+			continue;
+		a->nr_empty_slabs--;
+		balloc_release_slab(a, slab);
+	}
+
+	for (i = 0; i < GPU_BALLOC_ORDER_LIST_LEN; i++) {
+		while (!list_empty(balloc_get_cache_list(a, i))) {
+			bud = list_first_entry(balloc_get_cache_list(a, i),
+					       struct gk20a_buddy, buddy_entry);
+			balloc_uncache_buddy(a, bud);
+			balloc_blist_add(a, bud);
+			balloc_coalesce(a, bud);
+			drained = 1;
+		}
+	}
+
+	return drained;
+}
+
 /*
  * Find a suitable buddy for the given order and PTE type (big or little).
  */
@@ -593,19 +749,29 @@ static struct gk20a_buddy *__balloc_find_buddy(struct gk20a_allocator *a,
 }
 
 /*
- * Allocate a suitably sized buddy. If no suitable buddy exists split higher
- * order buddies until we have a suitable buddy to allocate.
+ * Allocate a suitably sized buddy. A recently freed buddy of the right order
+ * is reused as is. Otherwise, if no suitable buddy exists split higher order
+ * buddies until we have a suitable buddy to allocate.
  *
  * For PDE grouping add an extra check to see if a buddy is suitable: that the
  * buddy exists in a PDE who's PTE size is reasonable
  *
  * @a must be locked.
  */
-static u64 __balloc_do_alloc(struct gk20a_allocator *a, u64 order, int pte_size)
+static struct gk20a_buddy *__balloc_do_alloc_buddy(struct gk20a_allocator *a,
+						   u64 order, int pte_size)
 {
 	u64 split_order;
 	struct gk20a_buddy *bud = NULL;
 
+	bud = __balloc_find_cached(a, order, pte_size);
+	if (bud) {
+		balloc_uncache_buddy(a, bud);
+		balloc_alloc_buddy(a, bud);
+		a->free_cache_hits++;
+		return bud;
+	}
+
 	split_order = order;
 	while (split_order <= a->max_order &&
 	       !(bud = __balloc_find_buddy(a, split_order, pte_size)))
@@ -613,18 +779,139 @@ static u64 __balloc_do_alloc(struct gk20a_allocator *a, u64 order, int pte_size)
 
 	/* Out of memory! */
 	if (!bud)
-		return 0;
+		return NULL;
 
 	while (bud->order != order) {
 		if (balloc_split_buddy(a, bud, pte_size))
-			return 0; /* No mem... */
+			return NULL; /* No mem... */
 		bud = bud->left;
 	}
 
 	balloc_blist_rem(a, bud);
 	balloc_alloc_buddy(a, bud);
 
-	return bud->start;
+	return bud;
+}
+
+static u64 __balloc_do_alloc(struct gk20a_allocator *a, u64 order, int pte_size)
+{
+	struct gk20a_buddy *bud = __balloc_do_alloc_buddy(a, order, pte_size);
+
+	return bud ? bud->start : 0;
+}
+
+static int balloc_use_slabs(struct gk20a_allocator *a)
+{
+	return !(a->flags & GPU_BALLOC_NO_CACHE) &&
+		a->max_order >= GPU_BALLOC_SLAB_ORDER;
+}
+
+/*
+ * Carve a new slab out of the buddy allocator. It starts out empty.
+ *
+ * @a must be locked.
+ */
+static struct gk20a_balloc_slab *balloc_new_slab(struct gk20a_allocator *a,
+						 int pte_size)
+{
+	struct gk20a_balloc_slab *slab;
+	struct gk20a_buddy *bud;
+
+	slab = kzalloc(sizeof(*slab), GFP_KERNEL);
+	if (!slab)
+		return NULL;
+
+	bud = __balloc_do_alloc_buddy(a, GPU_BALLOC_SLAB_ORDER, pte_size);
+	if (!bud) {
+		kfree(slab);
+		return NULL;
+	}
+
+	slab->buddy = bud;
+	bud->slab = slab;
+	buddy_set_slab(bud);
+
+	list_add_tail(&slab->slab_entry, &a->slabs);
+	a->nr_slabs++;
+	a->nr_empty_slabs++;
+
+	return slab;
+}
+
+/*
+ * Allocate an order 0 object from a slab, partially used slabs first. Returns
+ * 0 if there is no slab to take it from and no new slab can be made.
+ *
+ * @a must be locked.
+ */
+static u64 balloc_slab_alloc(struct gk20a_allocator *a, int pte_size)
+{
+	struct gk20a_balloc_slab *slab = NULL, *s;
+	int obj;
+
+	list_for_each_entry(s, &a->slabs, slab_entry) {
+		if (s->buddy->pte_size == BALLOC_PTE_SIZE_ANY ||
+		    s->buddy->pte_size == pte_size) {
+			slab = s;
+			break;
+		}
+	}
+
+	if (!slab) {
+		slab = balloc_new_slab(a, pte_size);
+		if (!slab)
+			return 0;
+	}
+
+	if (!slab->nr_alloced)
+		a->nr_empty_slabs--;
+
+	obj = find_first_zero_bit(slab->alloced, GPU_BALLOC_SLAB_OBJS);
+	__set_bit(obj, slab->alloced);
+
+	/* Full slabs are only found through the RB tree. */
+	if (++slab->nr_alloced == GPU_BALLOC_SLAB_OBJS)
+		list_del_init(&slab->slab_entry);
+
+	a->slab_allocs++;
+
+	return slab->buddy->start + ((u64)obj << a->blk_shift);
+}
+
+/*
+ * Free an object back to its slab. Returns the number of bytes freed, which
+ * is 0 if @addr isn't an allocated object.
+ *
+ * @a must be locked.
+ */
+static u64 balloc_slab_free(struct gk20a_allocator *a,
+			    struct gk20a_balloc_slab *slab, u64 addr)
+{
+	u64 offs = addr - slab->buddy->start;
+	int obj = offs >> a->blk_shift;
+
+	if (offs & (a->blk_size - 1) || !test_bit(obj, slab->alloced))
+		return 0;
+
+	__clear_bit(obj, slab->alloced);
+	if (slab->nr_alloced-- == GPU_BALLOC_SLAB_OBJS)
+		list_add(&slab->slab_entry, &a->slabs);
+
+	if (slab->nr_alloced)
+		return a->blk_size;
+
+	/*
+	 * Keep a few empty slabs around so that the next order 0 alloc doesn't
+	 * have to make a new one.
+	 */
+	if (a->nr_empty_slabs >= GPU_BALLOC_SLAB_EMPTY_MAX) {
+		balloc_release_slab(a, slab);
+	} else {
+		list_move_tail(&slab->slab_entry, &a->slabs);
+		a->nr_empty_slabs++;
+	}
+
+	return a->blk_size;
 }
 
 /*
@@ -662,7 +949,18 @@ u64 gk20a_balloc(struct gk20a_allocator *a, u64 len)
 	else
 		pte_size = BALLOC_PTE_SIZE_ANY;
 
-	addr = __balloc_do_alloc(a, order, pte_size);
+	addr = 0;
+	if (order == 0 && balloc_use_slabs(a))
+		addr = balloc_slab_alloc(a, pte_size);
+	if (!addr)
+		addr = __balloc_do_alloc(a, order, pte_size);
+
+	/*
+	 * Don't fail while there are cached buddies or empty slabs that could
+	 * coalesce into what we need.
+	 */
+	if (!addr && balloc_drain(a))
+		addr = __balloc_do_alloc(a, order, pte_size);
 
 	if (addr) {
 		a->bytes_alloced += len;
@@ -953,6 +1251,13 @@ u64 gk20a_balloc_fixed(struct gk20a_allocator *a, u64 base, u64 len)
 	falloc->end = base + len;
 
 	balloc_lock(a);
+
+	/*
+	 * Fixed allocs look for their buddies in the buddy lists only, so put
+	 * the cached buddies back first.
+	 */
+	balloc_drain(a);
+
 	if (!balloc_is_range_free(a, base, base + len)) {
 		balloc_dbg(a, "Range not free: 0x%llx -> 0x%llx\n",
 			   base, base + len);
@@ -1039,17 +1344,25 @@ void gk20a_bfree(struct gk20a_allocator *a, u64 addr)
 		goto done;
 	}
 
-	bud = balloc_free_buddy(a, addr);
+	bud = balloc_find_alloced(a, addr);
 	if (!bud)
 		goto done;
 
-	balloc_blist_add(a, bud);
+	if (buddy_is_slab(bud)) {
+		a->bytes_freed += balloc_slab_free(a, bud->slab, addr);
+		goto done;
+	}
+
+	if (bud->start != addr)
+		goto done;
+
+	balloc_free_buddy(a, addr);
 	a->bytes_freed += balloc_order_to_len(a, bud->order);
 
 	/*
-	 * Attemp to defrag the allocation.
+	 * The buddy is coalesced once it ages out of the free cache.
 	 */
-	balloc_coalesce(a, bud);
+	balloc_cache_buddy(a, bud);
 
 done:
 	balloc_unlock(a);
@@ -1088,21 +1401,23 @@ static void balloc_print_stats(struct gk20a_allocator *a, struct seq_file *s,
 	__balloc_pstat(s, "  max_order = %llu\n", a->max_order);
 
 	__balloc_pstat(s, "Buddy blocks:\n");
-	__balloc_pstat(s, "  Order   Free    Alloced   Split\n");
-	__balloc_pstat(s, "  -----   ----    -------   -----\n");
+	__balloc_pstat(s, "  Order   Free    Alloced   Split   Cached\n");
+	__balloc_pstat(s, "  -----   ----    -------   -----   ------\n");
 
 	if (lock)
 		balloc_lock(a);
 	for (i = a->max_order; i >= 0; i--) {
 		if (a->buddy_list_len[i] == 0 &&
 		    a->buddy_list_alloced[i] == 0 &&
-		    a->buddy_list_split[i] == 0)
+		    a->buddy_list_split[i] == 0 &&
+		    a->free_cache_len[i] == 0)
 			continue;
 
-		__balloc_pstat(s, "  %3d     %-7llu %-9llu %llu\n", i,
+		__balloc_pstat(s, "  %3d     %-7llu %-9llu %-7llu %llu\n", i,
 			       a->buddy_list_len[i],
 			       a->buddy_list_alloced[i],
-			       a->buddy_list_split[i]);
+			       a->buddy_list_split[i],
+			       a->free_cache_len[i]);
 	}
 
 	__balloc_pstat(s, "\n");
@@ -1122,6 +1437,10 @@ static void balloc_print_stats(struct gk20a_allocator *a, struct seq_file *s,
 	__balloc_pstat(s, "Bytes allocated (real): %llu\n",
 		       a->bytes_alloced_real);
 	__balloc_pstat(s, "Bytes freed:            %llu\n", a->bytes_freed);
+	__balloc_pstat(s, "Free cache hits:        %llu\n", a->free_cache_hits);
+	__balloc_pstat(s, "Slab allocs:            %llu\n", a->slab_allocs);
+	__balloc_pstat(s, "Slabs (empty):          %llu (%llu)\n",
+		       a->nr_slabs, a->nr_empty_slabs);
 
 	if (lock)
 		balloc_unlock(a);
@@ -19,6 +19,7 @@
 
 #include <linux/list.h>
 #include <linux/rbtree.h>
+#include <linux/bitmap.h>
 #include <linux/debugfs.h>
 #include <linux/platform_device.h>
 
@@ -43,8 +44,12 @@ struct gk20a_buddy {
 #define BALLOC_BUDDY_ALLOCED	0x1
 #define BALLOC_BUDDY_SPLIT	0x2
 #define BALLOC_BUDDY_IN_LIST	0x4
+#define BALLOC_BUDDY_CACHED	0x8
+#define BALLOC_BUDDY_SLAB	0x10
 	int flags;			/* List of associated flags. */
 
+	struct gk20a_balloc_slab *slab;	/* Slab carved out of this buddy. */
+
 	/*
 	 * Size of the PDE this buddy is using. This allows for grouping like
 	 * sized allocations into the same PDE.
@@ -81,10 +86,20 @@ struct gk20a_buddy {
  * int  buddy_is_in_list(struct gk20a_buddy *b);
  * void buddy_set_in_list(struct gk20a_buddy *b);
  * void buddy_clr_in_list(struct gk20a_buddy *b);
+ *
+ * int  buddy_is_cached(struct gk20a_buddy *b);
+ * void buddy_set_cached(struct gk20a_buddy *b);
+ * void buddy_clr_cached(struct gk20a_buddy *b);
+ *
+ * int  buddy_is_slab(struct gk20a_buddy *b);
+ * void buddy_set_slab(struct gk20a_buddy *b);
+ * void buddy_clr_slab(struct gk20a_buddy *b);
  */
 __buddy_flag_ops(alloced, ALLOCED);
 __buddy_flag_ops(split,   SPLIT);
 __buddy_flag_ops(in_list, IN_LIST);
+__buddy_flag_ops(cached,  CACHED);
+__buddy_flag_ops(slab,    SLAB);
 
 /*
  * Keeps info for a fixed allocation.
@@ -97,6 +112,22 @@ struct gk20a_fixed_alloc {
 	u64 end;			/* End address. */
 };
 
+/*
+ * A slab is an allocated buddy of order GPU_BALLOC_SLAB_ORDER carved up into
+ * order 0 objects. Order 0 allocations are handed out of slabs so that they
+ * need neither buddy meta data nor an RB tree entry of their own.
+ */
+#define GPU_BALLOC_SLAB_ORDER		6
+#define GPU_BALLOC_SLAB_OBJS		(1 << GPU_BALLOC_SLAB_ORDER)
+
+struct gk20a_balloc_slab {
+	struct gk20a_buddy *buddy;	/* Buddy backing this slab. */
+	struct list_head slab_entry;	/* Entry in the list of open slabs. */
+
+	int nr_alloced;			/* Objects handed out. */
+	DECLARE_BITMAP(alloced, GPU_BALLOC_SLAB_OBJS);
+};
+
 struct vm_gk20a;
 
 /*
@@ -135,6 +166,7 @@ struct gk20a_allocator {
 	struct mutex lock;		/* Protects buddy access. */
 
 #define GPU_BALLOC_GVA_SPACE		0x1
+#define GPU_BALLOC_NO_CACHE		0x2
 	u64 flags;
 
 	/*
@@ -148,6 +180,30 @@ struct gk20a_allocator {
 	u64 buddy_list_split[GPU_BALLOC_ORDER_LIST_LEN];
 	u64 buddy_list_alloced[GPU_BALLOC_ORDER_LIST_LEN];
 
+	/*
+	 * Recently freed buddies, newest first. A freed buddy is only put back
+	 * in the buddy lists and coalesced once it ages out of its order's
+	 * cache, so an alloc that follows a free of the same size reuses the
+	 * buddy instead of splitting what the free just coalesced. The caches
+	 * are drained before an alloc is allowed to fail.
+	 *
+	 * Not used if GPU_BALLOC_NO_CACHE is set.
+	 */
+#define GPU_BALLOC_CACHE_LEN		16
+	struct list_head free_cache[GPU_BALLOC_ORDER_LIST_LEN];
+	u64 free_cache_len[GPU_BALLOC_ORDER_LIST_LEN];
+
+	/*
+	 * Slabs with free objects: partially used ones at the head, empty ones
+	 * at the tail. Only GPU_BALLOC_SLAB_EMPTY_MAX empty slabs are kept.
+	 * Slabs are used when the allocator can hold one and GPU_BALLOC_NO_CACHE
+	 * is not set.
+	 */
+#define GPU_BALLOC_SLAB_EMPTY_MAX	1
+	struct list_head slabs;
+	u64 nr_slabs;
+	u64 nr_empty_slabs;
+
 	/*
 	 * This is for when the allocator is managing a GVA space (the
 	 * GPU_BALLOC_GVA_SPACE bit is set in @flags). This requires
@@ -160,12 +216,16 @@ struct gk20a_allocator {
 	u64 bytes_alloced;
 	u64 bytes_alloced_real;
 	u64 bytes_freed;
+
+	u64 free_cache_hits;
+	u64 slab_allocs;
 };
 
 #define balloc_lock(a)		mutex_lock(&(a)->lock)
 #define balloc_unlock(a)	mutex_unlock(&(a)->lock)
 
 #define balloc_get_order_list(a, order)	(&(a)->buddy_list[(order)])
+#define balloc_get_cache_list(a, order)	(&(a)->free_cache[(order)])
 #define balloc_order_to_len(a, order)	((1 << order) * (a)->blk_size)
 #define balloc_base_shift(a, base)	((base) - (a)->start)
 #define balloc_base_unshift(a, base)	((base) + (a)->start)
@@ -4182,7 +4182,8 @@ static void __exit rm_tch_spi_exit(void)
 	spi_unregister_driver(&rm_tch_spi_driver);
 }
 
-module_init(rm_tch_spi_init);
+/* probe resets the controller for 145ms, don't hold up the boot for it */
+async_initcall(rm_tch_spi_init);
 module_exit(rm_tch_spi_exit);
 
 MODULE_AUTHOR("Valentine Hsu <valentine.hsu@rad-ic.com>");
@@ -0,0 +1,151 @@
+/*
+ * Frame time estimator for tegra-throughput
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The next frame is predicted to take as long as the
+ * TEGRA_THROUGHPUT_PERCENTILE percentile of the recent frames. Unlike the
+ * last frame time this follows a load change within a few frames without
+ * being thrown by a single long frame, and it errs on the side of meeting
+ * the deadline.
+ */
+
+#include <linux/kernel.h>
+#include <linux/export.h>
+#include <linux/math64.h>
+#include <linux/string.h>
+#include <linux/tegra-throughput.h>
+
+/* headroom tegra_throughput_hint_rate() adds, in permille */
+#define HINT_RATE_HEADROOM	200
+
+static unsigned int est_bucket(struct tegra_throughput_est *est, u32 frame_us)
+{
+	unsigned int b = (frame_us + est->bucket_us / 2) / est->bucket_us;
+
+	return min_t(unsigned int, b, TEGRA_THROUGHPUT_BUCKETS - 1);
+}
+
+void tegra_throughput_est_init(struct tegra_throughput_est *est,
+			       u32 target_us)
+{
+	memset(est, 0, sizeof(*est));
+	est->target_us = target_us;
+	est->bucket_us = max_t(u32, target_us / TEGRA_THROUGHPUT_TARGET_BUCKET,
+			       1);
+}
+EXPORT_SYMBOL(tegra_throughput_est_init);
+
+/*
+ * Change the deadline. The frames in the window are kept and sorted into the
+ * buckets for the new target.
+ */
+void tegra_throughput_est_set_target(struct tegra_throughput_est *est,
+				     u32 target_us)
+{
+	unsigned int i;
+
+	if (target_us == est->target_us)
+		return;
+
+	est->target_us = target_us;
+	est->bucket_us = max_t(u32, target_us / TEGRA_THROUGHPUT_TARGET_BUCKET,
+			       1);
+
+	memset(est->hist, 0, sizeof(est->hist));
+	for (i = 0; i < est->count; i++)
+		est->hist[est_bucket(est, est->window[i])]++;
+}
+EXPORT_SYMBOL(tegra_throughput_est_set_target);
+
+/*
+ * Account a frame, pushing the oldest one out of the window. A frame more
+ * than four times the target is the app pausing rather than rendering and
+ * is left out.
+ */
+void tegra_throughput_est_add(struct tegra_throughput_est *est, u32 frame_us)
+{
+	est->last_us = frame_us;
+	if (frame_us > 4 * est->target_us)
+		return;
+
+	if (est->count == TEGRA_THROUGHPUT_WINDOW)
+		est->hist[est_bucket(est, est->window[est->head])]--;
+	else
+		est->count++;
+
+	est->window[est->head] = frame_us;
+	est->hist[est_bucket(est, frame_us)]++;
+	est->head = (est->head + 1) % TEGRA_THROUGHPUT_WINDOW;
+}
+EXPORT_SYMBOL(tegra_throughput_est_add);
+
+/*
+ * Fill in everything but the legacy @fh->hint. With no frames seen yet the
+ * next one is predicted to just make the deadline.
+ */
+void tegra_throughput_est_hint(struct tegra_throughput_est *est,
+			       struct tegra_throughput_frame_hint *fh)
+{
+	unsigned int rank, seen = 0, misses = 0, b = 0;
+
+	if (est->count) {
+		rank = DIV_ROUND_UP(est->count * TEGRA_THROUGHPUT_PERCENTILE,
+				    100);
+		for (b = 0; b < TEGRA_THROUGHPUT_BUCKETS - 1; b++) {
+			seen += est->hist[b];
+			if (seen >= rank)
+				break;
+		}
+
+		for (seen = TEGRA_THROUGHPUT_TARGET_BUCKET + 1;
+		     seen < TEGRA_THROUGHPUT_BUCKETS; seen++)
+			misses += est->hist[seen];
+	} else {
+		b = TEGRA_THROUGHPUT_TARGET_BUCKET;
+	}
+
+	fh->target_us = est->target_us;
+	fh->last_us = est->last_us;
+	fh->predicted_us = b * est->target_us / TEGRA_THROUGHPUT_TARGET_BUCKET;
+	fh->slack_us = (s32)fh->target_us - (s32)fh->predicted_us;
+	fh->miss_permille = est->count ? misses * 1000 / est->count : 0;
+	fh->scale = est->target_us ?
+		fh->predicted_us * 1000 / est->target_us : 1000;
+}
+EXPORT_SYMBOL(tegra_throughput_est_hint);
+
+/**
+ * tegra_throughput_hint_rate - rate a unit needs to make the frame deadline
+ * @fh:		frame hint
+ * @rate:	current rate of the unit
+ * @busy:	permille of the recent frames the unit was busy
+ *
+ * Assumes the time the unit is busy in a frame scales inversely with its
+ * rate: a unit busy for the whole of frames that run 10% late needs 10% more,
+ * a unit busy for half of frames that make the deadline can run at half the
+ * rate. HINT_RATE_HEADROOM is added on top.
+ */
+unsigned long tegra_throughput_hint_rate(
+		const struct tegra_throughput_frame_hint *fh,
+		unsigned long rate, unsigned int busy)
+{
+	u64 r = (u64)rate * min(busy, 1000U) * fh->scale;
+
+	return div_u64(r * (1000 + HINT_RATE_HEADROOM), 1000000000);
+}
+EXPORT_SYMBOL(tegra_throughput_hint_rate);
@@ -47,6 +47,10 @@ static u64 frame_timestamp;
 static struct work_struct work;
 static int throughput_hint;
 
+/* frame time estimator and the hint it last produced, under lock */
+static struct tegra_throughput_est frame_est;
+static struct tegra_throughput_frame_hint frame_hint;
+
 static int sync_rate;
 static int throughput_active_app_count;
 
@@ -55,11 +59,19 @@ EXPORT_SYMBOL(throughput_notifier_list);
 
 static void set_throughput_hint(struct work_struct *work)
 {
+	struct tegra_throughput_frame_hint fh;
+
+	spin_lock(&lock);
+	fh = frame_hint;
+	spin_unlock(&lock);
+
 	trace_tegra_throughput_hint(throughput_hint);
+	trace_tegra_throughput_frame_hint(fh.predicted_us, fh.slack_us,
+					  fh.miss_permille, fh.scale);
 
 	/* notify throughput hint clients here */
 	blocking_notifier_call_chain(&throughput_notifier_list,
-				     throughput_hint, NULL);
+				     throughput_hint, &fh);
 }
 
 int tegra_throughput_get_hint(void)
@@ -68,6 +80,25 @@ int tegra_throughput_get_hint(void)
 }
 EXPORT_SYMBOL(tegra_throughput_get_hint);
 
+/*
+ * Get the last frame hint. Returns -ENODATA until an app has set a target
+ * and flipped at least twice.
+ */
+int tegra_throughput_get_frame_hint(struct tegra_throughput_frame_hint *fh)
+{
+	int err = 0;
+
+	spin_lock(&lock);
+	if (frame_hint.target_us)
+		*fh = frame_hint;
+	else
+		err = -ENODATA;
+	spin_unlock(&lock);
+
+	return err;
+}
+EXPORT_SYMBOL(tegra_throughput_get_frame_hint);
+
 static void throughput_flip_callback(void)
 {
 	long timediff;
@@ -98,6 +129,13 @@ static void throughput_flip_callback(void)
 
 		trace_tegra_throughput_gen_hint(throughput_hint, timediff);
 
+		spin_lock(&lock);
+		tegra_throughput_est_set_target(&frame_est, target_frame_time);
+		tegra_throughput_est_add(&frame_est, timediff);
+		tegra_throughput_est_hint(&frame_est, &frame_hint);
+		frame_hint.hint = throughput_hint;
+		spin_unlock(&lock);
+
 		/* only deliver throughput hints when a single app is active */
 		if (throughput_active_app_count == 1 && !work_pending(&work))
 			schedule_work(&work);
@@ -136,6 +174,8 @@ static int throughput_open(struct inode *inode, struct file *file)
 
 	throughput_active_app_count++;
 	frame_time_sum_init = 1;
+	tegra_throughput_est_init(&frame_est, target_frame_time);
+	memset(&frame_hint, 0, sizeof(frame_hint));
 
 	trace_tegra_throughput_open(throughput_active_app_count);
 
@@ -153,6 +193,8 @@ static int throughput_release(struct inode *inode, struct file *file)
 
 	throughput_active_app_count--;
 	frame_time_sum_init = 1;
+	tegra_throughput_est_init(&frame_est, target_frame_time);
+	memset(&frame_hint, 0, sizeof(frame_hint));
 
 	trace_tegra_throughput_release(throughput_active_app_count);
 
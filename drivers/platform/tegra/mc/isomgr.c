@@ -34,6 +34,9 @@
 #include <linux/err.h>
 #include <linux/kref.h>
 #include <linux/sched.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
+#include <linux/ktime.h>
 #include <linux/tegra-soc.h>
 #include <asm/processor.h>
 #include <asm/current.h>
@@ -353,6 +356,10 @@ static struct {
 	struct clk *emc_clk;		/* isomgr emc clock for floor freq */
 	s32 lt_mf;			/* min freq to support worst LT */
 	s32 lt_mf_rq;			/* requested lt_mf */
+	struct work_struct clk_work;	/* applies the floor freqs */
+	wait_queue_head_t clk_wq;	/* for the floor freqs to be applied */
+	u32 clk_seq;			/* floor freqs update sequence */
+	u32 clk_done;			/* clk_seq applied by clk_work */
 	s32 avail_bw;			/* globally available MC BW */
 	s32 dedi_bw;			/* total BW 'dedicated' to clients */
 	s32 sleep_bw;			/* pending bw requirement */
@@ -396,45 +403,93 @@ static inline void isomgr_unlock(void)
 	mutex_unlock(&isomgr.lock);
 }
 
-/* call with isomgr_lock held. */
-static void update_mc_clock(void)
+/*
+ * Program the floor freqs update_mc_clock() asked for. Runs without
+ * isomgr_lock, so that reserve and realize are not held up by EMC freq
+ * switches, and only applies the latest floors: the updates made while
+ * an earlier switch was in progress are coalesced into one.
+ */
+static void isomgr_clk_work(struct work_struct *work)
 {
+	s32 real_mf[TEGRA_ISO_CLIENT_COUNT];
+	ktime_t start = ktime_get();
+	s32 lt_mf;
+	u32 seq;
 	int i;
 
-	BUG_ON(mutex_trylock(&isomgr.lock));
-	/* determine worst case freq to satisfy LT */
-	isomgr.lt_mf = 0;
+	isomgr_lock();
+	seq = isomgr.clk_seq;
+	lt_mf = isomgr.lt_mf;
 	for (i = 0; i < TEGRA_ISO_CLIENT_COUNT; i++)
-		isomgr.lt_mf = max(isomgr.lt_mf, isomgr_clients[i].real_mf);
+		real_mf[i] = isomgr_clients[i].real_mf;
+	isomgr_unlock();
 
-	/* request the floor freq to satisfy LT */
-	if (isomgr.lt_mf_rq != isomgr.lt_mf &&
-	    !clk_set_rate(isomgr.emc_clk, isomgr.lt_mf * 1000)) {
+	/*
+	 * request the floor freq to satisfy LT; the *_rq fields are only
+	 * used here, and clk_work doesn't run concurrently with itself.
+	 */
+	if (isomgr.lt_mf_rq != lt_mf &&
+	    !clk_set_rate(isomgr.emc_clk, lt_mf * 1000)) {
 
 		if (isomgr.lt_mf_rq == 0)
 			clk_enable(isomgr.emc_clk);
-		isomgr.lt_mf_rq = isomgr.lt_mf;
+		isomgr.lt_mf_rq = lt_mf;
 		if (isomgr.lt_mf_rq == 0)
 			clk_disable(isomgr.emc_clk);
 	}
 
 	for (i = 0; i < TEGRA_ISO_CLIENT_COUNT; i++) {
-		if (isomgr_clients[i].real_mf != isomgr_clients[i].real_mf_rq) {
+		if (real_mf[i] != isomgr_clients[i].real_mf_rq) {
 			/* Ignore clocks for clients that are non-existent. */
 			if (!isomgr_clients[i].emc_clk)
 				continue;
 
 			if (clk_set_rate(isomgr_clients[i].emc_clk,
-					 isomgr_clients[i].real_mf * 1000))
+					 real_mf[i] * 1000))
 				continue;
 
 			if (isomgr_clients[i].real_mf_rq == 0)
 				clk_enable(isomgr_clients[i].emc_clk);
-			isomgr_clients[i].real_mf_rq = isomgr_clients[i].real_mf;
+			isomgr_clients[i].real_mf_rq = real_mf[i];
 			if (isomgr_clients[i].real_mf_rq == 0)
 				clk_disable(isomgr_clients[i].emc_clk);
 		}
 	}
+
+	isomgr_lock();
+	isomgr.clk_done = seq;
+	isomgr_unlock();
+	wake_up_all(&isomgr.clk_wq);
+
+	trace_tegra_isomgr_clk_apply(lt_mf, seq,
+		ktime_us_delta(ktime_get(), start));
+}
+
+/*
+ * call with isomgr_lock held. Recomputes the floor freqs and leaves
+ * programming them to clk_work; returns the sequence number to pass to
+ * wait_mc_clock() for them to be in effect.
+ */
+static u32 update_mc_clock(void)
+{
+	int i;
+
+	BUG_ON(mutex_trylock(&isomgr.lock));
+	/* determine worst case freq to satisfy LT */
+	isomgr.lt_mf = 0;
+	for (i = 0; i < TEGRA_ISO_CLIENT_COUNT; i++)
+		isomgr.lt_mf = max(isomgr.lt_mf, isomgr_clients[i].real_mf);
+
+	isomgr.clk_seq++;
+	schedule_work(&isomgr.clk_work);
+	return isomgr.clk_seq;
+}
+
+/* call without isomgr_lock held. */
+static void wait_mc_clock(u32 seq)
+{
+	wait_event(isomgr.clk_wq,
+		   (s32)(ACCESS_ONCE(isomgr.clk_done) - seq) >= 0);
 }
 
 static void purge_isomgr_client(struct isomgr_client *cp)
@@ -738,9 +793,16 @@ validation_fail:
 u32 tegra_isomgr_reserve(tegra_isomgr_handle handle,
 			 u32 ubw, u32 ult)
 {
+	ktime_t start;
+	u32 ret;
+
 	if (test_mode)
 		return 1;
-	return __tegra_isomgr_reserve(handle, ubw, ult);
+	start = ktime_get();
+	ret = __tegra_isomgr_reserve(handle, ubw, ult);
+	trace_tegra_isomgr_latency(handle, "reserve",
+		ktime_us_delta(ktime_get(), start));
+	return ret;
 }
 EXPORT_SYMBOL(tegra_isomgr_reserve);
 
@@ -749,6 +811,9 @@ static u32 __tegra_isomgr_realize(tegra_isomgr_handle handle)
 	bool retry = false;
 	u32 dvfs_latency = 0;
 	s32 delta_bw = 0;
+	s32 old_mf;
+	bool raise;
+	u32 seq;
 	struct isomgr_client *cp = (struct isomgr_client *) handle;
 	int client = cp - &isomgr_clients[0];
 
@@ -767,6 +832,7 @@ retry:
 
 	if (!retry)
 		trace_tegra_isomgr_realize(handle, cname[client], "enter");
+	old_mf = cp->real_mf;
 	if (cp->margin_bw < cp->real_bw)
 		isomgr.avail_bw += cp->real_bw - cp->margin_bw;
 	cp->real_bw = 0;
@@ -807,10 +873,19 @@ retry:
 
 	dvfs_latency = (u32)cp->lto;
 	cp->realize = false;
-	update_mc_clock();
+	seq = update_mc_clock();
+	raise = cp->real_mf > old_mf;
 
 	kref_put(&cp->kref, unregister_iso_client);
 	isomgr_unlock();
+
+	/*
+	 * The client may use its bw once this returns, so wait for a higher
+	 * floor freq to be in effect. A lower one is applied behind its back.
+	 */
+	if (raise)
+		wait_mc_clock(seq);
+
 	trace_tegra_isomgr_realize(handle, cname[client],
 		dvfs_latency ? "exit" : "real_fail_exit");
 	return dvfs_latency;
@@ -828,14 +903,24 @@ validation_fail:
  *
  * @handle	handle acquired during tegra_isomgr_register.
  *
+ * If this raises the client's minimum freq, it returns once the EMC runs
+ * at that floor; other clients can reserve and realize in the meantime.
+ *
  * returns dvfs latency thresh in usec.
  * return 0 indicates that realize failed.
  */
 u32 tegra_isomgr_realize(tegra_isomgr_handle handle)
 {
+	ktime_t start;
+	u32 ret;
+
 	if (test_mode)
 		return 1;
-	return __tegra_isomgr_realize(handle);
+	start = ktime_get();
+	ret = __tegra_isomgr_realize(handle);
+	trace_tegra_isomgr_latency(handle, "realize",
+		ktime_us_delta(ktime_get(), start));
+	return ret;
 }
 EXPORT_SYMBOL(tegra_isomgr_realize);
 
@@ -1156,6 +1241,8 @@ int __init isomgr_init(void)
 	unsigned int max_emc_bw;
 
 	mutex_init(&isomgr.lock);
+	INIT_WORK(&isomgr.clk_work, isomgr_clk_work);
+	init_waitqueue_head(&isomgr.clk_wq);
 	isoclient_info = get_iso_client_info(&isoclients);
 
 	for (i = 0; ; i++) {
@@ -0,0 +1,557 @@
+/*
+ * drivers/platform/tegra/mc/la_disp_calc.c
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <linux/kernel.h>
+#include <linux/export.h>
+#include <linux/math64.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+
+#include <mach/dc.h>
+
+#include <linux/platform/tegra/latency_allowance.h>
+#include <linux/platform/tegra/la_disp_calc.h>
+
+/*
+ * Note about fixed point arithmetic:
+ * ----------------------------------
+ * tegra_la_disp_calc_params(...) and tegra_la_disp_calc_la(...) contain fixed
+ * point values and arithmetic due to the need to use floating point values.
+ * All fixed point values have the "_fp" or "_FP" suffix in their name. The
+ * expressions and their types are kept as they were in bandwidth.c and
+ * tegra21x_la.c, where these calculations used to be done, so that the
+ * results are bit for bit the same.
+ */
+
+#define T12X_LA_BW_DISRUPTION_TIME_EMCCLKS_FP			1342000
+#define T12X_LA_STATIC_LA_SNAP_ARB_TO_ROW_SRT_EMCCLKS_FP	54000
+#define T12X_LA_CONS_MEM_EFFICIENCY_FP				500
+#define T12X_LA_ROW_SRT_SZ_BYTES	(64 * (T12X_LA_MC_EMEM_NUM_SLOTS + 1))
+#define T12X_LA_MC_EMEM_NUM_SLOTS				63
+#define T12X_LA_MAX_DRAIN_TIME_USEC				10
+
+#define YUV		TEGRA_LA_DISP_FMT_YUV
+#define PLANAR		TEGRA_LA_DISP_FMT_PLANAR
+#define PACKED422	TEGRA_LA_DISP_FMT_PACKED422
+#define F420		TEGRA_LA_DISP_FMT_420
+#define F422		TEGRA_LA_DISP_FMT_422
+#define F422R		TEGRA_LA_DISP_FMT_422R
+#define F444		TEGRA_LA_DISP_FMT_444
+
+#define FMT(fmt, _bpp, _flags) \
+	[TEGRA_WIN_FMT_##fmt] = { .bpp = _bpp, .flags = _flags }
+
+/*
+ * bpp as tegra_dc_fmt_bpp() reports it, which is 0 for some of the formats
+ * the calculations below still have a class for.
+ */
+static const struct tegra_la_disp_fmt la_disp_fmts[256] = {
+	FMT(P1,				1,  0),
+	FMT(P2,				2,  0),
+	FMT(P4,				4,  0),
+	FMT(P8,				8,  0),
+	FMT(B4G4R4A4,			16, 0),
+	FMT(B5G5R5A,			16, 0),
+	FMT(B5G6R5,			16, 0),
+	FMT(AB5G5R5,			16, 0),
+	FMT(T_R4G4B4A4,			16, 0),
+	FMT(B8G8R8A8,			32, 0),
+	FMT(R8G8B8A8,			32, 0),
+	FMT(B6x2G6x2R6x2A8,		32, 0),
+	FMT(R6x2G6x2B6x2A8,		32, 0),
+	FMT(T_A2R10G10B10,		32, 0),
+	FMT(T_A2B10G10R10,		32, 0),
+	FMT(T_X2BL10GL10RL10_XRBIAS,	32, 0),
+	FMT(T_X2BL10GL10RL10_XVYCC,	32, 0),
+	FMT(T_R16_G16_B16_A16,		64, 0),
+
+	FMT(YCbCr422,			16, YUV | PACKED422 | F422),
+	FMT(YUV422,			16, YUV | PACKED422 | F422),
+	FMT(YCbCr420P,			8,  YUV | PLANAR | F420),
+	FMT(YUV420P,			8,  YUV | PLANAR | F420),
+	FMT(YCbCr422P,			8,  YUV | PLANAR | F422),
+	FMT(YUV422P,			8,  YUV | PLANAR | F422),
+	FMT(YCbCr422R,			8,  YUV | PLANAR | F422R),
+	FMT(YUV422R,			8,  YUV | PLANAR | F422R),
+	FMT(YCbCr422RA,			8,  YUV | PLANAR | F422R),
+	FMT(YUV422RA,			8,  YUV | PLANAR | F422R),
+	FMT(YCbCr444P,			8,  YUV | PLANAR | F444),
+	FMT(YUV444P,			8,  YUV | PLANAR | F444),
+	FMT(YCrCb420SP,			0,  F420),
+	FMT(YCbCr420SP,			8,  YUV | F420),
+	FMT(YVU420SP,			0,  F420),
+	FMT(YUV420SP,			8,  YUV | F420),
+	FMT(YCrCb422SP,			0,  F422),
+	FMT(YCbCr422SP,			8,  YUV | F422),
+	FMT(YVU422SP,			0,  F422),
+	FMT(YUV422SP,			8,  YUV | F422),
+	FMT(YVU444SP,			0,  F444),
+	FMT(YUV444SP,			0,  F444),
+
+	FMT(T_Y10___U10___V10_N420,	8,  YUV | PLANAR),
+	FMT(T_Y10___U10___V10_N444,	8,  YUV | PLANAR),
+	FMT(T_Y10___V10U10_N420,	8,  YUV | PLANAR),
+	FMT(T_Y10___U10V10_N422,	8,  YUV | PLANAR),
+	FMT(T_Y10___U10V10_N422R,	8,  YUV | PLANAR),
+	FMT(T_Y10___U10V10_N444,	8,  YUV | PLANAR),
+	FMT(T_Y12___U12___V12_N420,	8,  YUV | PLANAR),
+	FMT(T_Y12___U12___V12_N444,	8,  YUV | PLANAR),
+	FMT(T_Y12___V12U12_N420,	8,  YUV | PLANAR),
+	FMT(T_Y12___U12V12_N422,	8,  YUV | PLANAR),
+	FMT(T_Y12___U12V12_N422R,	8,  YUV | PLANAR),
+	FMT(T_Y12___U12V12_N444,	8,  YUV | PLANAR),
+};
+
+/* @fmt may carry the byte order */
+const struct tegra_la_disp_fmt *tegra_la_disp_fmt(u32 fmt)
+{
+	return &la_disp_fmts[fmt & 0xff];
+}
+EXPORT_SYMBOL(tegra_la_disp_fmt);
+
+/*
+ * Peak EMC bandwidth of a window, in kBps =
+ * pixel_clock * win_bpp * H_scale_factor * V_downscale_factor /
+ * (window tiled ? tiled_mult : 1)
+ *
+ * All of tegra's YUV formats fetch 2 bytes per pixel, but tegra_dc_fmt_bpp()
+ * reports the size of the luma plane only for the planar ones.
+ */
+unsigned long tegra_la_disp_win_bw(const struct tegra_la_disp_mode *mode,
+				   const struct tegra_la_disp_win *win,
+				   unsigned int tiled_mult)
+{
+	const struct tegra_la_disp_fmt *f = tegra_la_disp_fmt(win->fmt);
+	u64 ret;
+	unsigned long bpp;
+	unsigned in_w, out_w, in_h, out_h;
+
+	if (!(win->flags & TEGRA_WIN_FLAG_ENABLED))
+		return 0;
+
+	if (win->w == 0 || win->h == 0 || win->out_w == 0 || win->out_h == 0)
+		return 0;
+
+	if (win->flags & TEGRA_WIN_FLAG_SCAN_COLUMN) {
+		/* rotated: PRESCALE_SIZE swapped, but WIN_SIZE is unchanged */
+		in_w = win->h;
+		out_w = win->out_h;
+		in_h = win->w;
+		out_h = win->out_w;
+	} else {
+		in_w = win->w;
+		out_w = win->out_w;
+		in_h = win->h;
+		out_h = win->out_h;
+	}
+
+	bpp = (f->flags & TEGRA_LA_DISP_FMT_PLANAR) ? 2 * f->bpp : f->bpp;
+	/* tegra_dc_is_yuv420() never masked off the byte order */
+	if ((f->flags & TEGRA_LA_DISP_FMT_420) && win->fmt == (win->fmt & 0xff))
+		bpp = 16;
+
+	ret = (mode->pclk / 1000UL) * (bpp / 8);
+	ret *= in_w;
+	ret = div_u64(ret, out_w * ((win->flags & TEGRA_WIN_FLAG_TILED) ?
+				    tiled_mult : 1));
+
+	if (in_h > out_h) {
+		/* vertical downscaling enabled  */
+		ret *= in_h;
+		ret = div_u64(ret, out_h);
+	}
+
+	return ret;
+}
+EXPORT_SYMBOL(tegra_la_disp_win_bw);
+
+/*
+ * Fills in disp_params->thresh_lwm_bytes, ->spool_up_buffering_adj_bytes and
+ * ->drain_time_usec_fp. The total dc bandwidths are up to the caller.
+ */
+void tegra_la_disp_calc_params(const struct la_to_dc_params *la,
+			       const struct tegra_la_disp_in *in,
+			       struct dc_to_la_params *disp_params)
+{
+	const struct tegra_la_disp_win *w = &in->win;
+	const struct tegra_la_disp_fmt *f = tegra_la_disp_fmt(w->fmt);
+	unsigned int bw_mbps = in->bw_mbps;
+	unsigned int bw_mbps_fp = la->la_real_to_fp(bw_mbps);
+	bool active = w->flags & TEGRA_WIN_FLAG_ENABLED;
+	bool win_rotated = w->flags & TEGRA_WIN_FLAG_SCAN_COLUMN;
+	bool pitch = !(w->flags & TEGRA_WIN_FLAG_BLOCKLINEAR) &&
+		     !(w->flags & TEGRA_WIN_FLAG_TILED);
+	bool planar = f->flags & TEGRA_LA_DISP_FMT_PLANAR;
+	bool packed_yuv422 = f->flags & TEGRA_LA_DISP_FMT_PACKED422;
+	unsigned int bytes_per_pixel = planar ? 2 * f->bpp / 8 : f->bpp / 8;
+	unsigned int total_screen_area = in->mode.h_total * in->mode.v_total;
+	unsigned int total_active_area = in->mode.h_active * in->mode.v_active;
+	unsigned int total_blank_area = total_screen_area - total_active_area;
+	unsigned int surface_width;
+	bool vertical_scaling_enabled;
+	unsigned int c1_fp, c2, c3;
+	unsigned int bpp_for_line_buffer_storage_fp;
+	unsigned int reqd_buffering_thresh_disp_bytes_fp;
+	unsigned int latency_buffering_available_in_reqd_buffering_fp;
+	unsigned long emc_freq_khz = in->emc_freq_hz / 1000;
+	unsigned long emc_freq_mhz = emc_freq_khz / 1000;
+	unsigned int bw_disruption_time_usec_fp =
+					T12X_LA_BW_DISRUPTION_TIME_EMCCLKS_FP /
+					emc_freq_mhz;
+	unsigned int effective_row_srt_sz_bytes_fp =
+		min((unsigned long)la->la_real_to_fp(min(
+					(unsigned long)T12X_LA_ROW_SRT_SZ_BYTES,
+					16 * min(emc_freq_mhz + 50,
+						400ul))),
+			(T12X_LA_MAX_DRAIN_TIME_USEC *
+			emc_freq_mhz -
+			la->la_fp_to_real(
+			T12X_LA_STATIC_LA_SNAP_ARB_TO_ROW_SRT_EMCCLKS_FP)) *
+			2 *
+			la->dram_width_bits /
+			8 *
+			T12X_LA_CONS_MEM_EFFICIENCY_FP);
+	unsigned int drain_time_usec_fp =
+			effective_row_srt_sz_bytes_fp *
+			la->fp_factor /
+			(emc_freq_mhz *
+				la->dram_width_bits /
+				4 *
+				T12X_LA_CONS_MEM_EFFICIENCY_FP) +
+			T12X_LA_STATIC_LA_SNAP_ARB_TO_ROW_SRT_EMCCLKS_FP /
+			emc_freq_mhz;
+	unsigned int total_latency_usec_fp =
+		drain_time_usec_fp +
+		la->static_la_minus_snap_arb_to_row_srt_emcclks_fp /
+		emc_freq_mhz;
+	unsigned int bw_disruption_buffering_bytes_fp =
+					bw_mbps *
+					max(bw_disruption_time_usec_fp,
+						total_latency_usec_fp) +
+					la->la_real_to_fp(1)/2;
+	unsigned int reqd_lines;
+	unsigned int lines_of_latency;
+	unsigned int thresh_lwm_bytes;
+	unsigned int total_buf_sz_bytes = in->client.line_buf_sz_bytes +
+					  in->client.mccif_size_bytes;
+	unsigned int num_active_wins_to_use = in->num_active_wins;
+	unsigned int total_active_space_bw = in->total_active_space_bw;
+	unsigned int total_vblank_bw;
+	unsigned int bw_other_wins;
+	unsigned int bw_display_fp;
+	unsigned int bw_delta_fp = 0;
+	unsigned int fill_rate_other_wins_fp;
+	unsigned int data_shortfall_other_wins_fp;
+	unsigned int duration_usec_fp;
+
+	disp_params->drain_time_usec_fp = drain_time_usec_fp;
+
+	if (win_rotated) {
+		surface_width = w->h;
+		vertical_scaling_enabled = w->w != w->out_w;
+	} else {
+		surface_width = w->w;
+		vertical_scaling_enabled = w->h != w->out_h;
+	}
+
+	if (in->client.line_buf_sz_bytes == 0 || pitch)
+		reqd_lines = 0;
+	else if (win_rotated && planar)
+		reqd_lines = vertical_scaling_enabled ? 17 : 16;
+	else if (win_rotated)
+		reqd_lines = 16 / bytes_per_pixel +
+			     (vertical_scaling_enabled ? 1 : 0);
+	else
+		reqd_lines = vertical_scaling_enabled ? 3 : 1;
+
+	if (reqd_lines > 0 && !vertical_scaling_enabled && win_rotated)
+		lines_of_latency = 1;
+	else
+		lines_of_latency = 0;
+
+	if ((f->flags & TEGRA_LA_DISP_FMT_422R) && !win_rotated)
+		c1_fp = la->la_real_to_fp(5) / 2;
+	else
+		c1_fp = la->la_real_to_fp(1);
+
+	if (((f->flags & TEGRA_LA_DISP_FMT_420) && !win_rotated) ||
+	    ((f->flags & TEGRA_LA_DISP_FMT_YUV) && win_rotated))
+		c2 = 3;
+	else
+		c2 = bytes_per_pixel;
+
+	c3 = (packed_yuv422 && win_rotated) ? 2 : 1;
+	latency_buffering_available_in_reqd_buffering_fp = active *
+							surface_width *
+							lines_of_latency *
+							c1_fp *
+							c2 *
+							c3;
+
+	if (f->flags & TEGRA_LA_DISP_FMT_420)
+		c1_fp = la->la_real_to_fp(win_rotated ? 2 : 3);
+	else if (f->flags & TEGRA_LA_DISP_FMT_422)
+		c1_fp = la->la_real_to_fp(win_rotated ? 3 : 2);
+	else if (f->flags & TEGRA_LA_DISP_FMT_422R)
+		c1_fp = la->la_real_to_fp(win_rotated ? 2 : 5);
+	else if (f->flags & TEGRA_LA_DISP_FMT_444)
+		c1_fp = la->la_real_to_fp(3);
+	else
+		c1_fp = la->la_real_to_fp(bytes_per_pixel);
+
+	c2 = (packed_yuv422 && win_rotated) ? 2 : 1;
+	bpp_for_line_buffer_storage_fp = c1_fp * c2;
+	reqd_buffering_thresh_disp_bytes_fp = active *
+						surface_width *
+						reqd_lines *
+						bpp_for_line_buffer_storage_fp;
+	thresh_lwm_bytes =
+		la->la_fp_to_real(reqd_buffering_thresh_disp_bytes_fp);
+	thresh_lwm_bytes +=
+		la->la_fp_to_real(
+			(bw_disruption_buffering_bytes_fp >=
+			latency_buffering_available_in_reqd_buffering_fp) ?
+			(bw_disruption_buffering_bytes_fp -
+			latency_buffering_available_in_reqd_buffering_fp) : 0);
+	disp_params->thresh_lwm_bytes = thresh_lwm_bytes;
+
+	if (in->client.win_type == TEGRA_LA_DISP_WIN_TYPE_FULL ||
+	    in->client.win_type == TEGRA_LA_DISP_WIN_TYPE_FULLA ||
+	    in->client.win_type == TEGRA_LA_DISP_WIN_TYPE_FULLB)
+		total_vblank_bw = total_buf_sz_bytes / total_blank_area;
+	else
+		total_vblank_bw = 0;
+
+	bw_display_fp = la->disp_catchup_factor_fp *
+			max(total_active_space_bw,
+				total_vblank_bw);
+	if (active)
+		bw_delta_fp = bw_mbps_fp -
+				(bw_display_fp /
+				num_active_wins_to_use);
+
+	bw_other_wins = total_active_space_bw - bw_mbps;
+
+	if (num_active_wins_to_use > 0) {
+		fill_rate_other_wins_fp =
+				bw_display_fp *
+				(num_active_wins_to_use - active) /
+				num_active_wins_to_use -
+				la->la_real_to_fp(bw_other_wins);
+	} else {
+		fill_rate_other_wins_fp = 0;
+	}
+
+	data_shortfall_other_wins_fp = in->dvfs_time_nsec *
+					bw_other_wins *
+					la->fp_factor /
+					1000;
+
+	duration_usec_fp = (fill_rate_other_wins_fp == 0) ? 0 :
+				data_shortfall_other_wins_fp *
+				la->fp_factor /
+				fill_rate_other_wins_fp;
+
+	disp_params->spool_up_buffering_adj_bytes = (bw_delta_fp > 0) ?
+					(bw_delta_fp *
+					duration_usec_fp /
+					(la->fp_factor *
+					la->fp_factor)) :
+					0;
+}
+EXPORT_SYMBOL(tegra_la_disp_calc_params);
+
+/*
+ * Latency allowance, in ticks, that keeps a display client fed at @bw_mbps
+ * from an EMC running at @emc_freq_hz. Returns -1 if there is none.
+ */
+long long tegra_la_disp_calc_la(const struct tegra_la_disp_chip *chip,
+				const struct disp_client *client,
+				unsigned long emc_freq_hz,
+				unsigned int bw_mbps,
+				unsigned int dvfs_time_nsec,
+				const struct dc_to_la_params *disp_params)
+{
+	unsigned int dvfs_buffering_reqd_bytes;
+	unsigned int thresh_dvfs_bytes;
+	unsigned int total_buf_sz_bytes;
+	int effective_mccif_buf_sz;
+	long long la_bw_upper_bound_nsec_fp;
+	long long la_bw_upper_bound_nsec;
+	long long la_nsec;
+	long long la_to_set;
+	unsigned int min_la_fp;
+
+	dvfs_buffering_reqd_bytes = bw_mbps * dvfs_time_nsec / 1000;
+
+	thresh_dvfs_bytes =
+			disp_params->thresh_lwm_bytes +
+			dvfs_buffering_reqd_bytes +
+			disp_params->spool_up_buffering_adj_bytes;
+	total_buf_sz_bytes =
+		client->line_buf_sz_bytes + client->mccif_size_bytes;
+	effective_mccif_buf_sz =
+		(client->line_buf_sz_bytes > thresh_dvfs_bytes) ?
+		client->mccif_size_bytes :
+		total_buf_sz_bytes - thresh_dvfs_bytes;
+
+	if (effective_mccif_buf_sz < 0)
+		return -1;
+
+	la_bw_upper_bound_nsec_fp = effective_mccif_buf_sz *
+					chip->fp_factor /
+					bw_mbps;
+	la_bw_upper_bound_nsec_fp = la_bw_upper_bound_nsec_fp *
+					chip->fp_factor /
+					chip->catchup_factor_fp;
+	la_bw_upper_bound_nsec_fp =
+		la_bw_upper_bound_nsec_fp -
+		(chip->st_la_minus_snap_arb_to_row_srt_emcclks_fp +
+		 chip->exp_time_emcclks_fp) /
+		(emc_freq_hz / 1000000);
+	la_bw_upper_bound_nsec_fp *= 1000;
+	la_bw_upper_bound_nsec = la_bw_upper_bound_nsec_fp / chip->fp_factor;
+
+	la_nsec = min(la_bw_upper_bound_nsec,
+			(long long)chip->max_la_nsec);
+
+	la_to_set = min((long long)(la_nsec/chip->ns_per_tick),
+			(long long)chip->la_max_value);
+
+	/* at least the drain time, rounded up */
+	min_la_fp = disp_params->drain_time_usec_fp * 1000 / chip->ns_per_tick;
+	if (min_la_fp % chip->fp_factor != 0)
+		min_la_fp += chip->fp_factor;
+
+	if (la_to_set < min_la_fp / chip->fp_factor || la_to_set > 255)
+		return -1;
+
+	return la_to_set;
+}
+EXPORT_SYMBOL(tegra_la_disp_calc_la);
+
+void tegra_la_disp_cache_init(struct tegra_la_disp_cache *cache)
+{
+	memset(cache, 0, sizeof(*cache));
+	spin_lock_init(&cache->lock);
+}
+EXPORT_SYMBOL(tegra_la_disp_cache_init);
+
+static bool la_disp_win_eq(const struct tegra_la_disp_win *a,
+			   const struct tegra_la_disp_win *b)
+{
+	return a->fmt == b->fmt && a->flags == b->flags &&
+		a->w == b->w && a->h == b->h &&
+		a->out_w == b->out_w && a->out_h == b->out_h;
+}
+
+static bool la_disp_mode_eq(const struct tegra_la_disp_mode *a,
+			    const struct tegra_la_disp_mode *b)
+{
+	return a->pclk == b->pclk &&
+		a->h_active == b->h_active && a->v_active == b->v_active &&
+		a->h_total == b->h_total && a->v_total == b->v_total;
+}
+
+static bool la_disp_in_eq(const struct tegra_la_disp_in *a,
+			  const struct tegra_la_disp_in *b)
+{
+	return la_disp_win_eq(&a->win, &b->win) &&
+		la_disp_mode_eq(&a->mode, &b->mode) &&
+		a->client.win_type == b->client.win_type &&
+		a->client.mccif_size_bytes == b->client.mccif_size_bytes &&
+		a->client.line_buf_sz_bytes == b->client.line_buf_sz_bytes &&
+		a->emc_freq_hz == b->emc_freq_hz &&
+		a->bw_mbps == b->bw_mbps &&
+		a->total_active_space_bw == b->total_active_space_bw &&
+		a->num_active_wins == b->num_active_wins &&
+		a->dvfs_time_nsec == b->dvfs_time_nsec;
+}
+
+unsigned long tegra_la_disp_win_bw_cached(struct tegra_la_disp_cache *cache,
+				const struct tegra_la_disp_mode *mode,
+				const struct tegra_la_disp_win *win,
+				unsigned int tiled_mult)
+{
+	unsigned long bw;
+
+	spin_lock(&cache->lock);
+	if (cache->bw_valid && cache->bw_tiled_mult == tiled_mult &&
+	    la_disp_win_eq(&cache->bw_win, win) &&
+	    la_disp_mode_eq(&cache->bw_mode, mode)) {
+		bw = cache->bw_kbps;
+		cache->hits++;
+		spin_unlock(&cache->lock);
+		return bw;
+	}
+	cache->misses++;
+	spin_unlock(&cache->lock);
+
+	bw = tegra_la_disp_win_bw(mode, win, tiled_mult);
+
+	spin_lock(&cache->lock);
+	cache->bw_win = *win;
+	cache->bw_mode = *mode;
+	cache->bw_tiled_mult = tiled_mult;
+	cache->bw_kbps = bw;
+	cache->bw_valid = true;
+	spin_unlock(&cache->lock);
+
+	return bw;
+}
+EXPORT_SYMBOL(tegra_la_disp_win_bw_cached);
+
+/*
+ * Like tegra_la_disp_calc_params(), but looks @in up among the last
+ * TEGRA_LA_DISP_CACHE_SIZE inputs first. @la must not change over the life
+ * of @cache.
+ */
+void tegra_la_disp_calc_params_cached(struct tegra_la_disp_cache *cache,
+				const struct la_to_dc_params *la,
+				const struct tegra_la_disp_in *in,
+				struct dc_to_la_params *disp_params)
+{
+	unsigned int i;
+
+	spin_lock(&cache->lock);
+	for (i = 0; i < cache->nr_ent; i++) {
+		if (la_disp_in_eq(&cache->ent[i].in, in)) {
+			disp_params->thresh_lwm_bytes =
+				cache->ent[i].params.thresh_lwm_bytes;
+			disp_params->spool_up_buffering_adj_bytes =
+				cache->ent[i].params.spool_up_buffering_adj_bytes;
+			disp_params->drain_time_usec_fp =
+				cache->ent[i].params.drain_time_usec_fp;
+			cache->hits++;
+			spin_unlock(&cache->lock);
+			return;
+		}
+	}
+	cache->misses++;
+	spin_unlock(&cache->lock);
+
+	tegra_la_disp_calc_params(la, in, disp_params);
+
+	spin_lock(&cache->lock);
+	i = cache->next;
+	cache->ent[i].in = *in;
+	cache->ent[i].params = *disp_params;
+	cache->next = (i + 1) % TEGRA_LA_DISP_CACHE_SIZE;
+	if (cache->nr_ent < TEGRA_LA_DISP_CACHE_SIZE)
+		cache->nr_ent++;
+	spin_unlock(&cache->lock);
+}
+EXPORT_SYMBOL(tegra_la_disp_calc_params_cached);
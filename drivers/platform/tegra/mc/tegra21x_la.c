@@ -18,6 +18,7 @@
 #include <asm/io.h>
 
 #include <linux/platform/tegra/latency_allowance.h>
+#include <linux/platform/tegra/la_disp_calc.h>
 #include <linux/platform/tegra/tegra_emc.h>
 #include <linux/platform/tegra/mc.h>
 #include <linux/platform/tegra/clock.h>
@@ -580,19 +581,6 @@ static int t21x_set_la(enum tegra_la_id id,
 	return 0;
 }
 
-static unsigned int t21x_min_la(struct dc_to_la_params *disp_params)
-{
-	unsigned int min_la_fp = disp_params->drain_time_usec_fp *
-				1000 /
-				cs->ns_per_tick;
-
-	/* round up */
-	if (min_la_fp % LA_FP_FACTOR != 0)
-		min_la_fp += LA_FP_FACTOR;
-
-	return LA_FP_TO_REAL(min_la_fp);
-}
-
 static int t21x_handle_disp_la(enum tegra_la_id id,
 			       unsigned long emc_freq_hz,
 			       unsigned int bw_mbps,
@@ -603,13 +591,16 @@ static int t21x_handle_disp_la(enum tegra_la_id id,
 	struct la_client_info *ci = NULL;
 	long long la_to_set = 0;
 	unsigned int dvfs_time_nsec = 0;
-	unsigned int dvfs_buffering_reqd_bytes = 0;
-	unsigned int thresh_dvfs_bytes = 0;
-	unsigned int total_buf_sz_bytes = 0;
-	int effective_mccif_buf_sz = 0;
-	long long la_bw_upper_bound_nsec_fp = 0;
-	long long la_bw_upper_bound_nsec = 0;
-	long long la_nsec = 0;
+	struct tegra_la_disp_chip chip = {
+		.ns_per_tick = cs->ns_per_tick,
+		.fp_factor = LA_FP_FACTOR,
+		.catchup_factor_fp = LA_DISP_CATCHUP_FACTOR_FP,
+		.st_la_minus_snap_arb_to_row_srt_emcclks_fp =
+			LA_ST_LA_MINUS_SNAP_ARB_TO_ROW_SRT_EMCCLKS_FP,
+		.exp_time_emcclks_fp = EXP_TIME_EMCCLKS_FP,
+		.max_la_nsec = MAX_LA_NSEC,
+		.la_max_value = MC_LA_MAX_VALUE,
+	};
 
 	if (!is_display_client(id)) {
 		/* Non-display clients should be handled by t21x_set_la(...). */
@@ -624,51 +615,14 @@ static int t21x_handle_disp_la(enum tegra_la_id id,
 
 	idx = cs->id_to_index[id];
 	ci = &cs->la_info_array[idx];
-	la_to_set = 0;
 	dvfs_time_nsec =
 		tegra_get_dvfs_clk_change_latency_nsec(emc_freq_hz / 1000);
-	dvfs_buffering_reqd_bytes = bw_mbps *
-					dvfs_time_nsec /
-					LA_USEC_TO_NSEC_FACTOR;
-
-	thresh_dvfs_bytes =
-			disp_params.thresh_lwm_bytes +
-			dvfs_buffering_reqd_bytes +
-			disp_params.spool_up_buffering_adj_bytes;
-	total_buf_sz_bytes =
-		cs->disp_clients[DISP_CLIENT_LA_ID(id)].line_buf_sz_bytes +
-		cs->disp_clients[DISP_CLIENT_LA_ID(id)].mccif_size_bytes;
-	effective_mccif_buf_sz =
-		(cs->disp_clients[DISP_CLIENT_LA_ID(id)].line_buf_sz_bytes >
-		thresh_dvfs_bytes) ?
-		cs->disp_clients[DISP_CLIENT_LA_ID(id)].mccif_size_bytes :
-		total_buf_sz_bytes - thresh_dvfs_bytes;
-
-	if (effective_mccif_buf_sz < 0)
-		return -1;
-
-	la_bw_upper_bound_nsec_fp = effective_mccif_buf_sz *
-					LA_FP_FACTOR /
-					bw_mbps;
-	la_bw_upper_bound_nsec_fp = la_bw_upper_bound_nsec_fp *
-					LA_FP_FACTOR /
-					LA_DISP_CATCHUP_FACTOR_FP;
-	la_bw_upper_bound_nsec_fp =
-		la_bw_upper_bound_nsec_fp -
-		(LA_ST_LA_MINUS_SNAP_ARB_TO_ROW_SRT_EMCCLKS_FP +
-		 EXP_TIME_EMCCLKS_FP) /
-		(emc_freq_hz / LA_HZ_TO_MHZ_FACTOR);
-	la_bw_upper_bound_nsec_fp *= LA_USEC_TO_NSEC_FACTOR;
-	la_bw_upper_bound_nsec = LA_FP_TO_REAL(la_bw_upper_bound_nsec_fp);
-
-
-	la_nsec = min(la_bw_upper_bound_nsec,
-			(long long)MAX_LA_NSEC);
-
-	la_to_set = min((long long)(la_nsec/cs->ns_per_tick),
-			(long long)MC_LA_MAX_VALUE);
 
-	if ((la_to_set < t21x_min_la(&disp_params)) || (la_to_set > 255))
+	la_to_set = tegra_la_disp_calc_la(&chip,
+				&cs->disp_clients[DISP_CLIENT_LA_ID(id)],
+				emc_freq_hz, bw_mbps, dvfs_time_nsec,
+				&disp_params);
+	if (la_to_set < 0)
 		return -1;
 
 	if (write_la)
@@ -111,6 +111,20 @@ static status_t hwmboxq_enqueue(struct hwmbox_queue *queue,
 	return ret;
 }
 
+/* Must be called with queue lock held in non-interrupt context */
+static bool hwmboxq_contains(struct hwmbox_queue *queue, uint32_t data)
+{
+	uint16_t pos = queue->head;
+	uint16_t i;
+
+	for (i = 0; i < queue->count; i++) {
+		if (queue->array[pos] == data)
+			return true;
+		pos = (pos + 1) & HWMBOX_QUEUE_SIZE_MASK;
+	}
+	return false;
+}
+
 void reset_hwmbox_queue(void)
 {
 	struct hwmbox_queue *queue = &nvadsp_drv_data->hwmbox_send_queue;
@@ -144,6 +158,15 @@ status_t nvadsp_hwmbox_send_data(uint16_t mid, uint32_t data, uint32_t flags)
 		is_hwmbox_busy = true;
 		pr_debug("nvadsp_mbox_send: empty mailbox. write to mailbox.\n");
 		hwmbox_writel(data, SEND_HWMBOX);
+	} else if ((flags & NVADSP_MBOX_COALESCE) &&
+		   hwmboxq_contains(&nvadsp_drv_data->hwmbox_send_queue,
+				    data)) {
+		/*
+		 * An identical message is still queued and reaches the ADSP
+		 * after everything the caller has done so far: for a doorbell
+		 * whose receiver drains its queue, one interrupt is enough.
+		 */
+		pr_debug("nvadsp_mbox_send: coalesce data\n");
 	} else {
 		pr_debug("nvadsp_mbox_send: enqueue data\n");
 		ret = hwmboxq_enqueue(&nvadsp_drv_data->hwmbox_send_queue,
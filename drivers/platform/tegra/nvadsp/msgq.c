@@ -49,6 +49,102 @@ void msgq_init(msgq_t *msgq, int32_t size)
 	msgq->write_index = 0;
 }
 
+/* copy words into the queue at wi, wrapping at the end of the queue */
+static void msgq_copy_in(msgq_t *msgq, int32_t wi, const int32_t *src,
+			 int32_t words)
+{
+	int32_t qremainder = msgq->size - wi;
+
+	if (words < qremainder) {
+		msgq_wmemcpy(&msgq->queue[wi], src, words);
+	} else {
+		/* message wrapped */
+		msgq_wmemcpy(&msgq->queue[wi], src, qremainder);
+		msgq_wmemcpy(msgq->queue, src + qremainder,
+			words - qremainder);
+	}
+}
+
+/* copy words out of the queue from ri, wrapping at the end of the queue */
+static void msgq_copy_out(msgq_t *msgq, int32_t ri, int32_t *dest,
+			  int32_t words)
+{
+	int32_t qremainder = msgq->size - ri;
+
+	if (words < qremainder) {
+		msgq_wmemcpy(dest, &msgq->queue[ri], words);
+	} else {
+		/* message wrapped */
+		msgq_wmemcpy(dest, &msgq->queue[ri], qremainder);
+		msgq_wmemcpy(dest + qremainder, msgq->queue,
+			words - qremainder);
+	}
+}
+
+static inline int32_t msgq_advance(msgq_t *msgq, int32_t index, int32_t words)
+{
+	index += words;
+	return index < msgq->size ? index : index - msgq->size;
+}
+
+/**
+ * msgq_queue_messages - Queues a batch of messages in the queue
+ * @msgq:           pointer to the client message queue
+ * @messages:       array of message buffers to copy from
+ * @count:          number of messages in @messages
+ * @signal:         set to true if the peer must be signalled, or NULL
+ *
+ * This function returns the number of messages queued, which stops short
+ * of @count at the first message there is no space for, or -ENOSPC if
+ * not even the first one fits.
+ *
+ * The messages are published to the reader with a single barrier and
+ * write_index update. *@signal is only set when the reader had drained
+ * the queue by the time they were, i.e. on an empty to non-empty
+ * transition: a reader that empties the queue on every signal will see
+ * messages queued while it had not yet, without another interrupt.
+ */
+int32_t msgq_queue_messages(msgq_t *msgq, const msgq_message_t * const *messages,
+			    int32_t count, bool *signal)
+{
+	int32_t ri = ACCESS_ONCE(msgq->read_index);
+	int32_t wi = msgq->write_index;
+	int32_t old_wi = wi;
+	/* free words, one of which always stays free so read != write */
+	int32_t qsize = ri <= wi ? msgq->size - wi + ri : ri - wi;
+	int32_t n;
+
+	if (signal)
+		*signal = false;
+
+	for (n = 0; n < count; n++) {
+		const msgq_message_t *message = messages[n];
+		int32_t msize = MSGQ_MESSAGE_HEADER_WSIZE + message->size;
+
+		if (qsize <= msize)
+			break;
+
+		msgq_copy_in(msgq, wi, (const int32_t *)message, msize);
+		wi = msgq_advance(msgq, wi, msize);
+		qsize -= msize;
+	}
+
+	if (!n)
+		return -ENOSPC;
+
+	/* order the messages before the write_index that publishes them */
+	wmb();
+	msgq->write_index = wi;
+
+	if (signal) {
+		/* order the write_index update before the read_index load */
+		mb();
+		*signal = ACCESS_ONCE(msgq->read_index) == old_wi;
+	}
+
+	return n;
+}
+
 /**
  * msgq_queue_message - Queues a message in the queue
  * @msgq:           pointer to the client message queue
@@ -64,35 +160,81 @@ void msgq_init(msgq_t *msgq, int32_t size)
  */
 int32_t msgq_queue_message(msgq_t *msgq, const msgq_message_t *message)
 {
-	int32_t ret = 0;
+	int32_t ret = msgq_queue_messages(msgq, &message, 1, NULL);
+
+	return ret < 0 ? ret : 0;
+}
+
+/**
+ * msgq_dequeue_messages - Dequeues a batch of messages from the queue
+ * @msgq:           pointer to the client message queue
+ * @messages:       array of message buffers to copy to, with their
+ *                  msgq_message_t::size set to their payload size in
+ *                  words, or NULL entries to discard messages
+ * @count:          number of buffers in @messages
+ *
+ * This function returns the number of messages dequeued, each with
+ * msgq_message_t::size set to the size of the message in words.
+ * Dequeueing stops early when the queue runs empty or at the first
+ * buffer too small for its message, whose size is then set to that of
+ * the message. -ENOMSG (with the first size set to 0) or -ENOSPC are
+ * returned if not even the first message could be dequeued.
+ *
+ * The space of all the messages is released to the writer with a single
+ * read_index update.
+ */
+int32_t msgq_dequeue_messages(msgq_t *msgq, msgq_message_t **messages,
+			      int32_t count)
+{
+	int32_t wi = ACCESS_ONCE(msgq->write_index);
 	int32_t ri = msgq->read_index;
-	int32_t wi = msgq->write_index;
-	bool wrap = ri <= wi;
-	int32_t *start = msgq->queue;
-	int32_t *end = &msgq->queue[msgq->size];
-	int32_t *first = &msgq->queue[wi];
-	int32_t *last = &msgq->queue[ri];
-	int32_t qremainder = wrap ? end - first : last - first;
-	int32_t qsize = wrap ? qremainder + (last - start) : qremainder;
-	int32_t msize = &message->payload[message->size] - (int32_t *)message;
-
-	if (qsize <= msize) {
-		/* don't allow read == write */
-		ret = -ENOSPC;
-	} else if (msize < qremainder) {
-		msgq_wmemcpy(first, message, msize);
-		msgq->write_index = wi + MSGQ_MESSAGE_HEADER_WSIZE +
-			message->size;
-	} else {
-		/* message wrapped */
-		msgq_wmemcpy(first, message, qremainder);
-		msgq_wmemcpy(msgq->queue, (int32_t *)message + qremainder,
-			msize - qremainder);
-		msgq->write_index = wi + MSGQ_MESSAGE_HEADER_WSIZE +
-			message->size - msgq->size;
+	int32_t ret = -ENOMSG;
+	int32_t n;
+
+	/* order the write_index load before the loads of the messages */
+	rmb();
+
+	for (n = 0; n < count; n++) {
+		msgq_message_t *message = messages[n];
+		msgq_message_t *msg = (msgq_message_t *)&msgq->queue[ri];
+
+		if (ri == wi) {
+			/* empty queue */
+			if (message)
+				message->size = 0;
+			ret = -ENOMSG;
+			break;
+		}
+
+		if (message && message->size < msg->size) {
+			/* return buffer too small */
+			message->size = msg->size;
+			ret = -ENOSPC;
+			break;
+		}
+
+		/* copy message to the output buffer, unless discarding it */
+		if (message)
+			msgq_copy_out(msgq, ri, (int32_t *)message,
+				MSGQ_MESSAGE_HEADER_WSIZE + msg->size);
+		ri = msgq_advance(msgq, ri,
+				MSGQ_MESSAGE_HEADER_WSIZE + msg->size);
 	}
 
-	return ret;
+	if (!n)
+		return ret;
+
+	/* finish reading the messages before handing their space back */
+	mb();
+	msgq->read_index = ri;
+	/*
+	 * Order the read_index update before the next write_index load too:
+	 * a writer that missed the update doesn't signal, so our next empty
+	 * check must see its messages.
+	 */
+	mb();
+
+	return n;
 }
 
 /**
@@ -111,44 +253,7 @@ int32_t msgq_queue_message(msgq_t *msgq, const msgq_message_t *message)
  */
 int32_t msgq_dequeue_message(msgq_t *msgq, msgq_message_t *message)
 {
-	int32_t ret = 0;
-	int32_t ri = msgq->read_index;
-	int32_t wi = msgq->write_index;
-	msgq_message_t *msg = (msgq_message_t *)&msgq->queue[msgq->read_index];
-
-	if (ri == wi) {
-		/* empty queue */
-		if (message)
-			message->size = 0;
-		ret = -ENOMSG;
-	} else if (!message) {
-		/* no input buffer, discard top message */
-		ri += MSGQ_MESSAGE_HEADER_WSIZE + msg->size;
-		msgq->read_index = ri < msgq->size ? ri : ri - msgq->size;
-	} else if (message->size < msg->size) {
-		/* return buffer too small */
-		message->size = msg->size;
-		ret = -ENOSPC;
-	} else {
-		/* copy message to the output buffer */
-		int32_t msize = MSGQ_MESSAGE_HEADER_WSIZE + msg->size;
-		int32_t *first = &msgq->queue[msgq->read_index];
-		int32_t *end = &msgq->queue[msgq->size];
-		int32_t qremainder = end - first;
-
-		if (msize < qremainder) {
-			msgq_wmemcpy(message, first, msize);
-			msgq->read_index = ri + MSGQ_MESSAGE_HEADER_WSIZE +
-				msg->size;
-		} else {
-			/* message wrapped */
-			msgq_wmemcpy(message, first, qremainder);
-			msgq_wmemcpy((int32_t *)message + qremainder,
-				msgq->queue, msize - qremainder);
-			msgq->read_index = ri + MSGQ_MESSAGE_HEADER_WSIZE +
-				msg->size - msgq->size;
-		}
-	}
+	int32_t ret = msgq_dequeue_messages(msgq, &message, 1);
 
-	return ret;
+	return ret < 0 ? ret : 0;
 }
@@ -178,26 +178,52 @@ static inline uint32_t ivc_channel_avail_count(struct ivc *ivc,
 	return ACCESS_ONCE(ch->w_count) - ACCESS_ONCE(ch->r_count);
 }
 
-static inline void ivc_advance_tx(struct ivc *ivc)
+static inline uint32_t ivc_next_pos(struct ivc *ivc, uint32_t pos,
+		uint32_t count)
+{
+	/* count never exceeds nframes */
+	pos += count;
+	if (pos >= ivc->nframes)
+		pos -= ivc->nframes;
+
+	return pos;
+}
+
+static inline void ivc_advance_tx(struct ivc *ivc, uint32_t count)
 {
 	ACCESS_ONCE(ivc->tx_channel->w_count) =
-		ACCESS_ONCE(ivc->tx_channel->w_count) + 1;
+		ACCESS_ONCE(ivc->tx_channel->w_count) + count;
 
-	if (ivc->w_pos == ivc->nframes - 1)
-		ivc->w_pos = 0;
-	else
-		ivc->w_pos++;
+	ivc->w_pos = ivc_next_pos(ivc, ivc->w_pos, count);
 }
 
-static inline void ivc_advance_rx(struct ivc *ivc)
+static inline void ivc_advance_rx(struct ivc *ivc, uint32_t count)
 {
 	ACCESS_ONCE(ivc->rx_channel->r_count) =
-		ACCESS_ONCE(ivc->rx_channel->r_count) + 1;
+		ACCESS_ONCE(ivc->rx_channel->r_count) + count;
 
-	if (ivc->r_pos == ivc->nframes - 1)
-		ivc->r_pos = 0;
-	else
-		ivc->r_pos++;
+	ivc->r_pos = ivc_next_pos(ivc, ivc->r_pos, count);
+}
+
+/*
+ * Number of frames ready to read. Like ivc_channel_empty(), an over-full
+ * queue reads as empty.
+ */
+static inline uint32_t ivc_rx_count(struct ivc *ivc)
+{
+	uint32_t count = ivc_channel_avail_count(ivc, ivc->rx_channel);
+
+	return count > ivc->nframes ? 0 : count;
+}
+
+/*
+ * Number of frames free to write. An over-full queue has none.
+ */
+static inline uint32_t ivc_tx_count(struct ivc *ivc)
+{
+	uint32_t count = ivc_channel_avail_count(ivc, ivc->tx_channel);
+
+	return count >= ivc->nframes ? 0 : ivc->nframes - count;
 }
 
 static inline int ivc_check_read(struct ivc *ivc)
@@ -343,7 +369,7 @@ static int ivc_read_frame(struct ivc *ivc, void *buf, void __user *user_buf,
 	} else
 		BUG();
 
-	ivc_advance_rx(ivc);
+	ivc_advance_rx(ivc, 1);
 	ivc_flush_counter(ivc, ivc->rx_handle +
 			offsetof(struct ivc_channel_header, r_count));
 
@@ -438,7 +464,7 @@ int tegra_ivc_read_advance(struct ivc *ivc)
 	if (result)
 		return result;
 
-	ivc_advance_rx(ivc);
+	ivc_advance_rx(ivc, 1);
 	ivc_flush_counter(ivc, ivc->rx_handle +
 			offsetof(struct ivc_channel_header, r_count));
 
@@ -502,7 +528,7 @@ static int ivc_write_frame(struct ivc *ivc, const void *buf,
 	 */
 	ivc_wmb();
 
-	ivc_advance_tx(ivc);
+	ivc_advance_tx(ivc, 1);
 	ivc_flush_counter(ivc, ivc->tx_handle +
 			offsetof(struct ivc_channel_header, w_count));
 
@@ -584,7 +610,7 @@ int tegra_ivc_write_advance(struct ivc *ivc)
 	 */
 	ivc_wmb();
 
-	ivc_advance_tx(ivc);
+	ivc_advance_tx(ivc, 1);
 	ivc_flush_counter(ivc, ivc->tx_handle +
 			offsetof(struct ivc_channel_header, w_count));
 
@@ -608,6 +634,150 @@ int tegra_ivc_write_advance(struct ivc *ivc)
 }
 EXPORT_SYMBOL(tegra_ivc_write_advance);
 
+/* directly peek at up to max frames rx'ed */
+int tegra_ivc_read_get_frames(struct ivc *ivc, void **frames, unsigned max)
+{
+	uint32_t count, pos, i;
+	int result;
+
+	result = ivc_check_read(ivc);
+	if (result)
+		return result;
+
+	/*
+	 * ivc_check_read() only refreshes w_count when the channel looks
+	 * empty; refresh it once here to see everything the peer has sent.
+	 */
+	ivc_invalidate_counter(ivc, ivc->rx_handle +
+			offsetof(struct ivc_channel_header, w_count));
+	count = min_t(uint32_t, ivc_rx_count(ivc), max);
+	if (!count)
+		return -ENOMEM;
+
+	/*
+	 * Order observation of w_pos potentially indicating new data before
+	 * data read.
+	 */
+	ivc_rmb();
+
+	for (i = 0, pos = ivc->r_pos; i < count; i++) {
+		ivc_invalidate_frame(ivc, ivc->rx_handle, pos, 0,
+				ivc->frame_size);
+		frames[i] = ivc_frame_pointer(ivc, ivc->rx_channel, pos);
+		pos = ivc_next_pos(ivc, pos, 1);
+	}
+
+	return (int)count;
+}
+EXPORT_SYMBOL(tegra_ivc_read_get_frames);
+
+/* release count frames rx'ed, with a single counter update */
+int tegra_ivc_read_advance_frames(struct ivc *ivc, unsigned count)
+{
+	int result = ivc_check_read(ivc);
+	if (result)
+		return result;
+
+	/* the caller has observed these frames, this catches misuse */
+	if (!count || count > ivc_rx_count(ivc))
+		return -EINVAL;
+
+	ivc_advance_rx(ivc, count);
+	ivc_flush_counter(ivc, ivc->rx_handle +
+			offsetof(struct ivc_channel_header, r_count));
+
+	/*
+	 * Ensure our write to r_pos occurs before our read from w_pos.
+	 */
+	ivc_mb();
+
+	/*
+	 * Notify only upon transition from full to non-full, as for a single
+	 * frame: the queue was full if freeing count frames left nframes -
+	 * count of them.
+	 */
+	ivc_invalidate_counter(ivc, ivc->rx_handle +
+		offsetof(struct ivc_channel_header, w_count));
+
+	if (ivc_channel_avail_count(ivc, ivc->rx_channel) ==
+			ivc->nframes - count)
+		ivc->notify(ivc);
+
+	return 0;
+}
+EXPORT_SYMBOL(tegra_ivc_read_advance_frames);
+
+/* directly poke at up to max frames to be tx'ed */
+int tegra_ivc_write_get_frames(struct ivc *ivc, void **frames, unsigned max)
+{
+	uint32_t count, pos, i;
+	int result;
+
+	result = ivc_check_write(ivc);
+	if (result)
+		return result;
+
+	ivc_invalidate_counter(ivc, ivc->tx_handle +
+			offsetof(struct ivc_channel_header, r_count));
+	count = min_t(uint32_t, ivc_tx_count(ivc), max);
+	if (!count)
+		return -ENOMEM;
+
+	for (i = 0, pos = ivc->w_pos; i < count; i++) {
+		frames[i] = ivc_frame_pointer(ivc, ivc->tx_channel, pos);
+		pos = ivc_next_pos(ivc, pos, 1);
+	}
+
+	return (int)count;
+}
+EXPORT_SYMBOL(tegra_ivc_write_get_frames);
+
+/* publish count frames written in place, with a single counter update */
+int tegra_ivc_write_advance_frames(struct ivc *ivc, unsigned count)
+{
+	uint32_t pos, i;
+	int result;
+
+	result = ivc_check_write(ivc);
+	if (result)
+		return result;
+
+	if (!count || count > ivc_tx_count(ivc))
+		return -EINVAL;
+
+	for (i = 0, pos = ivc->w_pos; i < count; i++) {
+		ivc_flush_frame(ivc, ivc->tx_handle, pos, 0, ivc->frame_size);
+		pos = ivc_next_pos(ivc, pos, 1);
+	}
+
+	/*
+	 * Order any possible stores to the frames before update of w_pos.
+	 */
+	ivc_wmb();
+
+	ivc_advance_tx(ivc, count);
+	ivc_flush_counter(ivc, ivc->tx_handle +
+			offsetof(struct ivc_channel_header, w_count));
+
+	/*
+	 * Ensure our write to w_pos occurs before our read from r_pos.
+	 */
+	ivc_mb();
+
+	/*
+	 * Notify only upon transition from empty to non-empty: the queue was
+	 * empty if it now holds just the frames we published.
+	 */
+	ivc_invalidate_counter(ivc, ivc->tx_handle +
+		offsetof(struct ivc_channel_header, r_count));
+
+	if (ivc_channel_avail_count(ivc, ivc->tx_channel) == count)
+		ivc->notify(ivc);
+
+	return 0;
+}
+EXPORT_SYMBOL(tegra_ivc_write_advance_frames);
+
 void tegra_ivc_channel_reset(struct ivc *ivc)
 {
 	ivc->tx_channel->state = ivc_state_sync;
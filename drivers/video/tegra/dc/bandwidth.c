@@ -135,24 +135,30 @@ static unsigned int num_active_external_wins(struct tegra_dc *dc)
 	return num_active_external_wins;
 }
 
-/*
- * Note about fixed point arithmetic:
- * ----------------------------------
- * calc_disp_params(...) contains fixed point values and arithmetic due to the
- * need to use floating point values. All fixed point values have the "_fp" or
- * "_FP" suffix in their name. Functions/values used to convert between real and
- * fixed point values are listed below:
- *    - la_params.fp_factor
- *    - la_params.la_real_to_fp(real_val)
- *    - la_params.la_fp_to_real(fp_val)
- */
+static void tegra_dc_la_disp_win(struct tegra_dc_win *w,
+				 struct tegra_la_disp_win *lw)
+{
+	lw->fmt = w->fmt;
+	lw->flags = w->flags;
+	lw->w = dfixed_trunc(w->w);
+	lw->h = dfixed_trunc(w->h);
+	lw->out_w = w->out_w;
+	lw->out_h = w->out_h;
+}
 
-#define T12X_LA_BW_DISRUPTION_TIME_EMCCLKS_FP			1342000
-#define T12X_LA_STATIC_LA_SNAP_ARB_TO_ROW_SRT_EMCCLKS_FP	54000
-#define T12X_LA_CONS_MEM_EFFICIENCY_FP				500
-#define T12X_LA_ROW_SRT_SZ_BYTES	(64 * (T12X_LA_MC_EMEM_NUM_SLOTS + 1))
-#define T12X_LA_MC_EMEM_NUM_SLOTS				63
-#define T12X_LA_MAX_DRAIN_TIME_USEC				10
+static void tegra_dc_la_disp_mode(struct tegra_dc *dc,
+				  struct tegra_la_disp_mode *lm)
+{
+	struct tegra_dc_mode *mode = &dc->mode;
+
+	lm->pclk = mode->pclk;
+	lm->h_active = mode->h_active;
+	lm->v_active = mode->v_active;
+	lm->h_total = mode->h_active + mode->h_front_porch +
+		      mode->h_back_porch + mode->h_sync_width;
+	lm->v_total = mode->v_active + mode->v_front_porch +
+		      mode->v_back_porch + mode->v_sync_width;
+}
 
 /*
  * Function outputs:
@@ -167,341 +173,44 @@ static void calc_disp_params(struct tegra_dc *dc,
 				unsigned long emc_freq_hz,
 				unsigned int bw_mbps,
 				struct dc_to_la_params *disp_params) {
-	const struct disp_client *disp_clients_info =
-						tegra_la_disp_clients_info;
 	struct la_to_dc_params la_params = tegra_get_la_to_dc_params();
-	unsigned int bw_mbps_fp = la_params.la_real_to_fp(bw_mbps);
-	bool active = WIN_IS_ENABLED(w);
-	bool win_rotated = false;
-	unsigned int surface_width = 0;
-	bool vertical_scaling_enabled = false;
-	bool pitch = !WIN_IS_BLOCKLINEAR(w) && !WIN_IS_TILED(w);
-	bool planar = tegra_dc_is_yuv_planar(w->fmt);
-	bool packed_yuv422 =
-			((tegra_dc_fmt(w->fmt) == TEGRA_WIN_FMT_YCbCr422) ||
-			(tegra_dc_fmt(w->fmt) == TEGRA_WIN_FMT_YUV422));
-	/* all of tegra's YUV formats(420 and 422) fetch 2 bytes per pixel,
-	 * but the size reported by tegra_dc_fmt_bpp for the planar version
-	 * is of the luma plane's size only. */
-	unsigned int bytes_per_pixel = tegra_dc_is_yuv_planar(w->fmt) ?
-				2 * tegra_dc_fmt_bpp(w->fmt) / 8 :
-				tegra_dc_fmt_bpp(w->fmt) / 8;
-	struct tegra_dc_mode mode = dc->mode;
-	unsigned int total_h = mode.h_active +
-				mode.h_front_porch +
-				mode.h_back_porch +
-				mode.h_sync_width;
-	unsigned int total_v = mode.v_active +
-				mode.v_front_porch +
-				mode.v_back_porch +
-				mode.v_sync_width;
-	unsigned int total_screen_area = total_h * total_v;
-	unsigned int total_active_area = mode.h_active * mode.v_active;
-	unsigned int total_blank_area = total_screen_area - total_active_area;
-	unsigned int c1_fp = 0;
-	unsigned int c2 = 0;
-	unsigned int c3 = 0;
-	unsigned int bpp_for_line_buffer_storage_fp = 0;
-	unsigned int reqd_buffering_thresh_disp_bytes_fp = 0;
-	unsigned int latency_buffering_available_in_reqd_buffering_fp = 0;
-	unsigned long emc_freq_khz = emc_freq_hz / 1000;
-	unsigned long emc_freq_mhz = emc_freq_khz / 1000;
-	unsigned int bw_disruption_time_usec_fp =
-					T12X_LA_BW_DISRUPTION_TIME_EMCCLKS_FP /
-					emc_freq_mhz;
-	unsigned int effective_row_srt_sz_bytes_fp =
-		min((unsigned long)la_params.la_real_to_fp(min(
-					(unsigned long)T12X_LA_ROW_SRT_SZ_BYTES,
-					16 * min(emc_freq_mhz + 50,
-						400ul))),
-			(T12X_LA_MAX_DRAIN_TIME_USEC *
-			emc_freq_mhz -
-			la_params.la_fp_to_real(
-			T12X_LA_STATIC_LA_SNAP_ARB_TO_ROW_SRT_EMCCLKS_FP)) *
-			2 *
-			la_params.dram_width_bits /
-			8 *
-			T12X_LA_CONS_MEM_EFFICIENCY_FP);
-	unsigned int drain_time_usec_fp =
-			effective_row_srt_sz_bytes_fp *
-			la_params.fp_factor /
-			(emc_freq_mhz *
-				la_params.dram_width_bits /
-				4 *
-				T12X_LA_CONS_MEM_EFFICIENCY_FP) +
-			T12X_LA_STATIC_LA_SNAP_ARB_TO_ROW_SRT_EMCCLKS_FP /
-			emc_freq_mhz;
-	unsigned int total_latency_usec_fp =
-		drain_time_usec_fp +
-		la_params.static_la_minus_snap_arb_to_row_srt_emcclks_fp /
-		emc_freq_mhz;
-	unsigned int bw_disruption_buffering_bytes_fp =
-					bw_mbps *
-					max(bw_disruption_time_usec_fp,
-						total_latency_usec_fp) +
-					la_params.la_real_to_fp(1)/2;
-	unsigned int reqd_lines = 0;
-	unsigned int lines_of_latency = 0;
-	unsigned int thresh_lwm_bytes = 0;
-	unsigned int total_buf_sz_bytes =
-	disp_clients_info[DISP_CLIENT_LA_ID(la_id)].line_buf_sz_bytes +
-	disp_clients_info[DISP_CLIENT_LA_ID(la_id)].mccif_size_bytes;
-	unsigned int num_active_wins_to_use = is_internal_win(la_id) ?
-						num_active_internal_wins(dc) :
-						num_active_external_wins(dc);
-	unsigned int total_active_space_bw = 0;
-	unsigned int total_vblank_bw = 0;
-	unsigned int bw_other_wins = 0;
-	unsigned int bw_display_fp = 0;
-	unsigned int bw_delta_fp = 0;
-	unsigned int fill_rate_other_wins_fp = 0;
-	unsigned int dvfs_time_nsec =
-			tegra_get_dvfs_clk_change_latency_nsec(emc_freq_khz);
-	unsigned int data_shortfall_other_wins_fp = 0;
-	unsigned int duration_usec_fp = 0;
-	unsigned int spool_up_buffering_adj_bytes = 0;
+	struct tegra_la_disp_in in;
+	bool internal = is_internal_win(la_id);
 	unsigned int curr_dc_head_bw = 0;
+	int i = 0;
 
-	disp_params->drain_time_usec_fp = drain_time_usec_fp;
-
-	if (w->flags & TEGRA_WIN_FLAG_SCAN_COLUMN) {
-		win_rotated = true;
-		surface_width = dfixed_trunc(w->h);
-		vertical_scaling_enabled = (dfixed_trunc(w->w) == w->out_w) ?
-					false : true;
-	} else {
-		win_rotated = false;
-		surface_width = dfixed_trunc(w->w);
-		vertical_scaling_enabled = (dfixed_trunc(w->h) == w->out_h) ?
-					false : true;
-	}
-
-	if ((disp_clients_info[DISP_CLIENT_LA_ID(la_id)].line_buf_sz_bytes
-									== 0) ||
-		(pitch == true)) {
-		reqd_lines = 0;
-	} else if (win_rotated && planar) {
-		if (vertical_scaling_enabled)
-			reqd_lines = 17;
-		else
-			reqd_lines = 16;
-	} else {
-		if (win_rotated) {
-			if (vertical_scaling_enabled)
-				reqd_lines = 16 / bytes_per_pixel + 1;
-			else
-				reqd_lines = 16 / bytes_per_pixel;
-		} else {
-			if (vertical_scaling_enabled)
-				reqd_lines = 3;
-			else
-				reqd_lines = 1;
-		}
-	}
-
-	if (reqd_lines > 0 && !vertical_scaling_enabled && win_rotated)
-		lines_of_latency = 1;
-	else
-		lines_of_latency = 0;
-
-
-	if (((tegra_dc_fmt(w->fmt) == TEGRA_WIN_FMT_YCbCr422R) ||
-		(tegra_dc_fmt(w->fmt) == TEGRA_WIN_FMT_YUV422R) ||
-		(tegra_dc_fmt(w->fmt) == TEGRA_WIN_FMT_YCbCr422RA) ||
-		(tegra_dc_fmt(w->fmt) == TEGRA_WIN_FMT_YUV422RA)) &&
-		!win_rotated) {
-		c1_fp = la_params.la_real_to_fp(5) / 2;
-	} else {
-		c1_fp = la_params.la_real_to_fp(1);
-	}
-
-	if ((((tegra_dc_fmt(w->fmt) == TEGRA_WIN_FMT_YCbCr420P) ||
-		(tegra_dc_fmt(w->fmt) == TEGRA_WIN_FMT_YUV420P) ||
-		(tegra_dc_fmt(w->fmt) == TEGRA_WIN_FMT_YCrCb420SP) ||
-		(tegra_dc_fmt(w->fmt) == TEGRA_WIN_FMT_YCbCr420SP) ||
-		(tegra_dc_fmt(w->fmt) == TEGRA_WIN_FMT_YVU420SP) ||
-		(tegra_dc_fmt(w->fmt) == TEGRA_WIN_FMT_YUV420SP)) &&
-		!win_rotated) ||
-		(tegra_dc_is_yuv(w->fmt) && win_rotated)) {
-		c2 = 3;
-	} else {
-		c2 = bytes_per_pixel;
-	}
-
-	c3 = (packed_yuv422 && win_rotated) ? 2 : 1;
-	latency_buffering_available_in_reqd_buffering_fp = active *
-							surface_width *
-							lines_of_latency *
-							c1_fp *
-							c2 *
-							c3;
-
-	switch (tegra_dc_fmt(w->fmt)) {
-	/* YUV 420 case*/
-	case TEGRA_WIN_FMT_YCbCr420P:
-	case TEGRA_WIN_FMT_YUV420P:
-	case TEGRA_WIN_FMT_YCrCb420SP:
-	case TEGRA_WIN_FMT_YCbCr420SP:
-	case TEGRA_WIN_FMT_YVU420SP:
-	case TEGRA_WIN_FMT_YUV420SP:
-		c1_fp = (win_rotated) ?
-			la_params.la_real_to_fp(2) :
-			la_params.la_real_to_fp(3);
-		break;
-
-	/* YUV 422 case */
-	case TEGRA_WIN_FMT_YCbCr422:
-	case TEGRA_WIN_FMT_YUV422:
-	case TEGRA_WIN_FMT_YCbCr422P:
-	case TEGRA_WIN_FMT_YUV422P:
-	case TEGRA_WIN_FMT_YCrCb422SP:
-	case TEGRA_WIN_FMT_YCbCr422SP:
-	case TEGRA_WIN_FMT_YVU422SP:
-	case TEGRA_WIN_FMT_YUV422SP:
-		c1_fp = (win_rotated) ?
-			la_params.la_real_to_fp(3) :
-			la_params.la_real_to_fp(2);
-		break;
-
-	/* YUV 422R case */
-	case TEGRA_WIN_FMT_YCbCr422R:
-	case TEGRA_WIN_FMT_YUV422R:
-	case TEGRA_WIN_FMT_YCbCr422RA:
-	case TEGRA_WIN_FMT_YUV422RA:
-		c1_fp = (win_rotated) ?
-			la_params.la_real_to_fp(2) :
-			la_params.la_real_to_fp(5);
-		break;
-
-	/* YUV 444 case */
-	case TEGRA_WIN_FMT_YCbCr444P:
-	case TEGRA_WIN_FMT_YUV444P:
-	case TEGRA_WIN_FMT_YVU444SP:
-	case TEGRA_WIN_FMT_YUV444SP:
-		c1_fp = la_params.la_real_to_fp(3);
-		break;
-
-	default:
-		c1_fp = la_params.la_real_to_fp(bytes_per_pixel);
-		break;
-	}
-
-	c2 = (packed_yuv422 && win_rotated) ? 2 : 1;
-	bpp_for_line_buffer_storage_fp = c1_fp * c2;
-	reqd_buffering_thresh_disp_bytes_fp = active *
-						surface_width *
-						reqd_lines *
-						bpp_for_line_buffer_storage_fp;
-	thresh_lwm_bytes =
-		la_params.la_fp_to_real(reqd_buffering_thresh_disp_bytes_fp);
-	thresh_lwm_bytes +=
-		la_params.la_fp_to_real(
-			(bw_disruption_buffering_bytes_fp >=
-			latency_buffering_available_in_reqd_buffering_fp) ?
-			(bw_disruption_buffering_bytes_fp -
-			latency_buffering_available_in_reqd_buffering_fp) : 0);
-	disp_params->thresh_lwm_bytes = thresh_lwm_bytes;
-
-
-	if (is_internal_win(la_id)) {
-		int i = 0;
-
-		for_each_set_bit(i, &dc->valid_windows, DC_N_WINDOWS) {
-			struct tegra_dc_win *curr_win =
-				tegra_dc_get_window(dc, i);
-			enum tegra_la_id curr_win_la_id =
-					la_id_tab[dc->ctrl_num][curr_win->idx];
-			unsigned int curr_win_bw = 0;
-
-			if (!is_internal_win(curr_win_la_id))
-				continue;
-
-			curr_win_bw = max(curr_win->bandwidth,
-						curr_win->new_bandwidth);
-			/* our bandwidth is in kbytes/sec, but LA takes MBps.
-			 * round up bandwidth to next 1MBps */
-			if (curr_win_bw != UINT_MAX)
-				curr_win_bw = curr_win_bw / 1000 + 1;
-
-			total_active_space_bw += curr_win_bw;
-		}
-	} else {
-		int i = 0;
-
-		for_each_set_bit(i, &dc->valid_windows, DC_N_WINDOWS) {
-			struct tegra_dc_win *curr_win =
-				tegra_dc_get_window(dc, i);
-			enum tegra_la_id curr_win_la_id =
-					la_id_tab[dc->ctrl_num][curr_win->idx];
-			unsigned int curr_win_bw = 0;
-
-			if (is_internal_win(curr_win_la_id))
-				continue;
-
-			curr_win_bw = max(curr_win->bandwidth,
-						curr_win->new_bandwidth);
-			/* our bandwidth is in kbytes/sec, but LA takes MBps.
-			 * round up bandwidth to next 1MBps */
-			if (curr_win_bw != UINT_MAX)
-				curr_win_bw = curr_win_bw / 1000 + 1;
-
-			total_active_space_bw += curr_win_bw;
-		}
-	}
-
-
-	if ((disp_clients_info[DISP_CLIENT_LA_ID(la_id)].win_type  ==
-						TEGRA_LA_DISP_WIN_TYPE_FULL) ||
-		(disp_clients_info[DISP_CLIENT_LA_ID(la_id)].win_type  ==
-						TEGRA_LA_DISP_WIN_TYPE_FULLA) ||
-		(disp_clients_info[DISP_CLIENT_LA_ID(la_id)].win_type  ==
-						TEGRA_LA_DISP_WIN_TYPE_FULLB)) {
-		total_vblank_bw = total_buf_sz_bytes / total_blank_area;
-	} else {
-		total_vblank_bw = 0;
-	}
-
+	tegra_dc_la_disp_win(w, &in.win);
+	tegra_dc_la_disp_mode(dc, &in.mode);
+	in.client = tegra_la_disp_clients_info[DISP_CLIENT_LA_ID(la_id)];
+	in.emc_freq_hz = emc_freq_hz;
+	in.bw_mbps = bw_mbps;
+	in.total_active_space_bw = 0;
+	in.num_active_wins = internal ? num_active_internal_wins(dc) :
+					num_active_external_wins(dc);
+	in.dvfs_time_nsec =
+		tegra_get_dvfs_clk_change_latency_nsec(emc_freq_hz / 1000);
 
-	bw_display_fp = la_params.disp_catchup_factor_fp *
-			max(total_active_space_bw,
-				total_vblank_bw);
-	if (active)
-		bw_delta_fp = bw_mbps_fp -
-				(bw_display_fp /
-				num_active_wins_to_use);
+	for_each_set_bit(i, &dc->valid_windows, DC_N_WINDOWS) {
+		struct tegra_dc_win *curr_win = tegra_dc_get_window(dc, i);
+		enum tegra_la_id curr_win_la_id =
+				la_id_tab[dc->ctrl_num][curr_win->idx];
+		unsigned int curr_win_bw = 0;
 
+		if (is_internal_win(curr_win_la_id) != internal)
+			continue;
 
-	bw_other_wins = total_active_space_bw - bw_mbps;
+		curr_win_bw = max(curr_win->bandwidth,
+					curr_win->new_bandwidth);
+		/* our bandwidth is in kbytes/sec, but LA takes MBps.
+		 * round up bandwidth to next 1MBps */
+		if (curr_win_bw != UINT_MAX)
+			curr_win_bw = curr_win_bw / 1000 + 1;
 
-	if (num_active_wins_to_use > 0) {
-		fill_rate_other_wins_fp =
-				bw_display_fp *
-				(num_active_wins_to_use - active) /
-				num_active_wins_to_use -
-				la_params.la_real_to_fp(bw_other_wins);
-	} else {
-		fill_rate_other_wins_fp = 0;
+		in.total_active_space_bw += curr_win_bw;
 	}
 
-	data_shortfall_other_wins_fp = dvfs_time_nsec *
-					bw_other_wins *
-					la_params.fp_factor /
-					1000;
-
-	duration_usec_fp = (fill_rate_other_wins_fp == 0) ? 0 :
-				data_shortfall_other_wins_fp *
-				la_params.fp_factor /
-				fill_rate_other_wins_fp;
-
-
-	spool_up_buffering_adj_bytes = (bw_delta_fp > 0) ?
-					(bw_delta_fp *
-					duration_usec_fp /
-					(la_params.fp_factor *
-					la_params.fp_factor)) :
-					0;
-	disp_params->spool_up_buffering_adj_bytes =
-						spool_up_buffering_adj_bytes;
+	tegra_la_disp_calc_params_cached(&dc->la_cache[w->idx], &la_params,
+					 &in, disp_params);
 
 	mutex_lock(&tegra_dcs_total_bw_lock);
 	curr_dc_head_bw = max(dc->new_bw_kbps, dc->bw_kbps);
@@ -686,21 +395,6 @@ static unsigned long tegra_dc_find_max_bandwidth(struct tegra_dc_win *wins[],
 	return max;
 }
 
-static inline int tegra_dc_is_yuv420(int fmt)
-{
-	switch (fmt) {
-	case TEGRA_WIN_FMT_YCbCr420P:
-	case TEGRA_WIN_FMT_YUV420P:
-	case TEGRA_WIN_FMT_YCrCb420SP:
-	case TEGRA_WIN_FMT_YCbCr420SP:
-	case TEGRA_WIN_FMT_YVU420SP:
-	case TEGRA_WIN_FMT_YUV420SP:
-		return 1;
-	default:
-		return 0;
-	}
-}
-
 /*
  * Calculate peak EMC bandwidth for each enabled window =
  * pixel_clock * win_bpp * (use_v_filter ? 2 : 1)) * H_scale_factor *
@@ -716,6 +410,19 @@ static inline int tegra_dc_is_yuv420(int fmt)
 static unsigned long tegra_dc_calc_win_bandwidth(struct tegra_dc *dc,
 	struct tegra_dc_win *w)
 {
+#if !defined(CONFIG_ARCH_TEGRA_2x_SOC) && \
+	!defined(CONFIG_ARCH_TEGRA_3x_SOC) && \
+	!defined(CONFIG_ARCH_TEGRA_11x_SOC) && \
+	!defined(CONFIG_ARCH_TEGRA_14x_SOC)
+	struct tegra_la_disp_win lw;
+	struct tegra_la_disp_mode lm;
+
+	tegra_dc_la_disp_win(w, &lw);
+	tegra_dc_la_disp_mode(dc, &lm);
+
+	return tegra_la_disp_win_bw_cached(&dc->la_cache[w->idx], &lm, &lw,
+			tegra_mc_get_tiled_memory_bandwidth_multiplier());
+#else
 	u64 ret;
 	int tiled_windows_bw_multiplier;
 	unsigned long bpp;
@@ -751,13 +458,6 @@ static unsigned long tegra_dc_calc_win_bandwidth(struct tegra_dc *dc,
 	 * is of the luma plane's size only. */
 	bpp = tegra_dc_is_yuv_planar(w->fmt) ?
 		2 * tegra_dc_fmt_bpp(w->fmt) : tegra_dc_fmt_bpp(w->fmt);
-#if !defined(CONFIG_ARCH_TEGRA_2x_SOC) && \
-	!defined(CONFIG_ARCH_TEGRA_3x_SOC) && \
-	!defined(CONFIG_ARCH_TEGRA_11x_SOC) && \
-	!defined(CONFIG_ARCH_TEGRA_14x_SOC)
-	if (tegra_dc_is_yuv420(w->fmt))
-		bpp = 16;
-#endif
 	ret = (dc->mode.pclk / 1000UL) * (bpp / 8);
 	ret *= in_w;
 	ret = div_u64(ret, out_w * (WIN_IS_TILED(w) ?
@@ -782,6 +482,7 @@ static unsigned long tegra_dc_calc_win_bandwidth(struct tegra_dc *dc,
 	ret = ret + (17 * div_u64(ret, 25));
 #endif
 	return ret;
+#endif
 }
 
 unsigned long tegra_dc_get_bandwidth(
@@ -812,6 +513,7 @@ void tegra_dc_clear_bandwidth(struct tegra_dc *dc)
 	int latency;
 
 	trace_clear_bandwidth(dc);
+	mutex_lock(&dc->bw_lock);
 	latency = tegra_isomgr_reserve(dc->isomgr_handle, 0, 1000);
 	if (latency) {
 		dc->reserved_bw = 0;
@@ -821,6 +523,9 @@ void tegra_dc_clear_bandwidth(struct tegra_dc *dc)
 		dev_dbg(&dc->ndev->dev, "Failed to clear bw.\n");
 		tegra_dc_process_bandwidth_renegotiate(dc, NULL);
 	}
+	dc->bw_ahead_kbps = 0;
+	dc->bw_seq++;
+	mutex_unlock(&dc->bw_lock);
 	dc->bw_kbps = 0;
 }
 #else
@@ -828,8 +533,12 @@ void tegra_dc_clear_bandwidth(struct tegra_dc *dc)
 void tegra_dc_clear_bandwidth(struct tegra_dc *dc)
 {
 	trace_clear_bandwidth(dc);
+	mutex_lock(&dc->bw_lock);
 	if (tegra_is_clk_enabled(dc->emc_clk))
 		tegra_disp_clk_disable_unprepare(dc->emc_clk);
+	dc->bw_ahead_kbps = 0;
+	dc->bw_seq++;
+	mutex_unlock(&dc->bw_lock);
 	dc->bw_kbps = 0;
 }
 
@@ -851,16 +560,71 @@ static inline unsigned long tegra_dc_kbps_to_emc(unsigned long bw)
 }
 #endif
 
+/*
+ * reserve bw from isomgr or set the EMC rate for it. returns 0 when bw is in
+ * effect. call with dc->bw_lock held.
+ */
+static int tegra_dc_reserve_bandwidth(struct tegra_dc *dc, long bw)
+{
+#ifdef CONFIG_TEGRA_ISOMGR
+	int latency;
+
+	/* reserve atleast the minimum bandwidth. */
+	bw = max(bw, tegra_dc_calc_min_bandwidth(dc));
+	latency = tegra_isomgr_reserve(dc->isomgr_handle, bw, 1000);
+	if (latency) {
+		dc->reserved_bw = bw;
+		latency = tegra_isomgr_realize(dc->isomgr_handle);
+		WARN_ONCE(!latency, "tegra_isomgr_realize failed\n");
+	} else {
+		dev_dbg(&dc->ndev->dev, "Failed to reserve bw %ld.\n",
+								bw);
+		tegra_dc_process_bandwidth_renegotiate(dc, NULL);
+		return -EBUSY;
+	}
+#else /* EMC version */
+	int emc_freq;
+
+	/* going from 0 to non-zero */
+	if (bw && !tegra_is_clk_enabled(dc->emc_clk))
+		tegra_disp_clk_prepare_enable(dc->emc_clk);
+
+	emc_freq = tegra_dc_kbps_to_emc(bw);
+	clk_set_rate(dc->emc_clk, emc_freq);
+
+	/* going from non-zero to 0 */
+	if (!bw && tegra_is_clk_enabled(dc->emc_clk))
+		tegra_disp_clk_disable_unprepare(dc->emc_clk);
+#endif
+	return 0;
+}
+
+static void tegra_dc_program_latency_allowance(struct tegra_dc *dc,
+					       bool use_new)
+{
+	unsigned i;
+
+	for_each_set_bit(i, &dc->valid_windows, DC_N_WINDOWS) {
+		struct tegra_dc_win *w = tegra_dc_get_window(dc, i);
+
+		if ((use_new || w->bandwidth != w->new_bandwidth) &&
+			w->new_bandwidth != 0)
+			tegra_dc_set_latency_allowance(dc, w);
+		trace_program_bandwidth(dc);
+		w->bandwidth = w->new_bandwidth;
+	}
+}
+
 /* use the larger of dc->bw_kbps or dc->new_bw_kbps, and copies
  * dc->new_bw_kbps into dc->bw_kbps.
  * calling this function both before and after a flip is sufficient to select
  * the best possible frequency and latency allowance.
  * set use_new to true to force dc->new_bw_kbps programming.
+ * before a flip, bandwidth that bw_work already raised ahead of it is not
+ * programmed again. after a flip, use_new drops what was raised ahead.
  */
 void tegra_dc_program_bandwidth(struct tegra_dc *dc, bool use_new)
 {
-	unsigned i;
-
 	if (!dc->enabled)
 		return;
 
@@ -871,52 +635,155 @@ void tegra_dc_program_bandwidth(struct tegra_dc *dc, bool use_new)
 		long bw = max(dc->bw_kbps, dc->new_bw_kbps);
 
 #ifdef CONFIG_TEGRA_ISOMGR
-		int latency;
-
 		if (!dc->isomgr_handle)
 			return;
+#endif
+		mutex_lock(&dc->bw_lock);
+		if (use_new)
+			dc->bw_ahead_kbps = 0;
+
+		if (!dc->bw_ahead_kbps ||
+			(unsigned long)bw > dc->bw_ahead_kbps)
+			tegra_dc_reserve_bandwidth(dc, bw);
+		dc->bw_seq++;
+		mutex_unlock(&dc->bw_lock);
+		dc->bw_kbps = dc->new_bw_kbps;
+	}
 
-		/* reserve atleast the minimum bandwidth. */
-		bw = max(bw, tegra_dc_calc_min_bandwidth(dc));
-		latency = tegra_isomgr_reserve(dc->isomgr_handle, bw, 1000);
-		if (latency) {
-			dc->reserved_bw = bw;
-			latency = tegra_isomgr_realize(dc->isomgr_handle);
-			WARN_ONCE(!latency, "tegra_isomgr_realize failed\n");
-		} else {
-			dev_dbg(&dc->ndev->dev, "Failed to reserve bw %ld.\n",
-									bw);
-			tegra_dc_process_bandwidth_renegotiate(dc, NULL);
-		}
-#else /* EMC version */
-		int emc_freq;
+	tegra_dc_program_latency_allowance(dc, use_new);
+}
 
-		/* going from 0 to non-zero */
-		if (!dc->bw_kbps && dc->new_bw_kbps &&
-			!tegra_is_clk_enabled(dc->emc_clk))
-			tegra_disp_clk_prepare_enable(dc->emc_clk);
+/*
+ * Bandwidth of a flip is raised by bw_work while the flip waits for its
+ * fences, so that the flip itself does not wait for isomgr or for the EMC
+ * clock. What the flip no longer needs is dropped by bw_work once it has been
+ * latched, and only if no other flip is on its way by then.
+ *
+ * bw_work decides what to reserve under dc->lock and reserves it after
+ * dropping dc->lock, so that flips and vblank handling do not wait for
+ * isomgr or for the EMC clock either. If anything reserved bandwidth
+ * meanwhile, what bw_work decided is stale and is skipped: a flip programs
+ * what it needs itself, and a disable has cleared the bandwidth.
+ */
+static void tegra_dc_bandwidth_worker(struct work_struct *work)
+{
+	struct tegra_dc *dc = container_of(work, struct tegra_dc, bw_work);
+	unsigned long ahead;
+	bool release;
+	long bw = 0;
+	u32 seq;
+	unsigned i;
 
-		emc_freq = tegra_dc_kbps_to_emc(bw);
-		clk_set_rate(dc->emc_clk, emc_freq);
+	spin_lock(&dc->bw_req_lock);
+	ahead = dc->bw_ahead_req_kbps;
+	release = dc->bw_release_req;
+	dc->bw_ahead_req_kbps = 0;
+	dc->bw_release_req = false;
+	spin_unlock(&dc->bw_req_lock);
 
-		/* going from non-zero to 0 */
-		if (dc->bw_kbps && !dc->new_bw_kbps &&
-			tegra_is_clk_enabled(dc->emc_clk))
-			tegra_disp_clk_disable_unprepare(dc->emc_clk);
+	mutex_lock(&dc->lock);
+	if (!dc->enabled || !tegra_platform_is_silicon()) {
+		mutex_unlock(&dc->lock);
+		return;
+	}
+#ifdef CONFIG_TEGRA_ISOMGR
+	if (!dc->isomgr_handle) {
+		mutex_unlock(&dc->lock);
+		return;
+	}
 #endif
+
+	/* release first, not to drop what a flip queued since asked for */
+	if (release) {
+		for_each_set_bit(i, &dc->valid_windows, DC_N_WINDOWS)
+			if (tegra_dc_get_window(dc, i)->dirty)
+				release = false;
+	}
+	if (release) {
+		trace_bandwidth_release(dc, dc->new_bw_kbps);
+		bw = max(dc->bw_kbps, dc->new_bw_kbps);
 		dc->bw_kbps = dc->new_bw_kbps;
+		tegra_dc_program_latency_allowance(dc, true);
 	}
+	if ((long)ahead <= dc->bw_kbps)
+		ahead = 0;
 
-	for_each_set_bit(i, &dc->valid_windows, DC_N_WINDOWS) {
-		struct tegra_dc_win *w = tegra_dc_get_window(dc, i);
+	mutex_lock(&dc->bw_lock);
+	seq = dc->bw_seq;
+	mutex_unlock(&dc->bw_lock);
+	mutex_unlock(&dc->lock);
 
-		if ((use_new || w->bandwidth != w->new_bandwidth) &&
-			w->new_bandwidth != 0)
-			tegra_dc_set_latency_allowance(dc, w);
-		trace_program_bandwidth(dc);
-		w->bandwidth = w->new_bandwidth;
+	mutex_lock(&dc->bw_lock);
+	if (dc->bw_seq != seq)
+		goto out;
+
+	if (release) {
+		dc->bw_ahead_kbps = 0;
+		tegra_dc_reserve_bandwidth(dc, bw);
+	}
+	if (ahead > dc->bw_ahead_kbps) {
+		trace_bandwidth_raise(dc, ahead);
+		if (!tegra_dc_reserve_bandwidth(dc, ahead))
+			dc->bw_ahead_kbps = ahead;
 	}
+	dc->bw_seq++;
+out:
+	mutex_unlock(&dc->bw_lock);
+}
+
+void tegra_dc_bandwidth_init(struct tegra_dc *dc)
+{
+	mutex_init(&dc->bw_lock);
+	spin_lock_init(&dc->bw_req_lock);
+	INIT_WORK(&dc->bw_work, tegra_dc_bandwidth_worker);
+}
+
+/**
+ * tegra_dc_bandwidth_ahead - raise bandwidth for a flip that was queued
+ * @dc:		display controller
+ * @windows:	all windows of @dc as they will be after the flip
+ * @n:		number of windows
+ *
+ * Sets new_bandwidth of @windows, so callers pass copies. Lowers nothing;
+ * what was raised ahead is dropped by tegra_dc_bandwidth_release().
+ */
+void tegra_dc_bandwidth_ahead(struct tegra_dc *dc,
+			struct tegra_dc_win *windows[], int n)
+{
+	unsigned long bw;
+
+	if (!use_dynamic_emc)
+		return;
+#ifndef CONFIG_TEGRA_ISOMGR
+	/* tegra_dc_set_dynamic_emc() asks for the top rate then */
+	if (tegra_dc_has_multiple_dc())
+		return;
+#endif
+
+	bw = tegra_dc_get_bandwidth(windows, n);
+	trace_bandwidth_ahead(dc, bw);
+	if ((long)bw <= dc->bw_kbps)
+		return;
+
+	spin_lock(&dc->bw_req_lock);
+	dc->bw_ahead_req_kbps = max(dc->bw_ahead_req_kbps, bw);
+	spin_unlock(&dc->bw_req_lock);
+	queue_work(system_freezable_wq, &dc->bw_work);
+}
+EXPORT_SYMBOL(tegra_dc_bandwidth_ahead);
+
+/*
+ * drop bandwidth the last flip no longer needs, once it has been latched.
+ * callers skip this while more flips are queued, whose release follows.
+ */
+void tegra_dc_bandwidth_release(struct tegra_dc *dc)
+{
+	spin_lock(&dc->bw_req_lock);
+	dc->bw_release_req = true;
+	spin_unlock(&dc->bw_req_lock);
+	queue_work(system_freezable_wq, &dc->bw_work);
 }
+EXPORT_SYMBOL(tegra_dc_bandwidth_release);
 
 int tegra_dc_set_dynamic_emc(struct tegra_dc *dc)
 {
@@ -1010,10 +877,13 @@ int tegra_dc_bandwidth_negotiate_bw(struct tegra_dc *dc,
 		return 0;
 	}
 
+	mutex_lock(&dc->bw_lock);
+	dc->bw_seq++;
 	latency = tegra_isomgr_reserve(dc->isomgr_handle, bw, 1000);
 	if (!latency) {
 		dev_dbg(&dc->ndev->dev, "Failed to reserve proposed bw %d.\n",
 									bw);
+		mutex_unlock(&dc->bw_lock);
 		mutex_unlock(&dc->lock);
 		return -1;
 	}
@@ -1027,11 +897,13 @@ int tegra_dc_bandwidth_negotiate_bw(struct tegra_dc *dc,
 		latency = tegra_isomgr_realize(dc->isomgr_handle);
 		if (!latency) {
 			WARN_ONCE(!latency, "tegra_isomgr_realize failed\n");
+			mutex_unlock(&dc->bw_lock);
 			mutex_unlock(&dc->lock);
 			return -1;
 		}
 		dc->bw_kbps = bw;
 	}
+	mutex_unlock(&dc->bw_lock);
 
 	for_each_set_bit(i, &dc->valid_windows, DC_N_WINDOWS) {
 		struct tegra_dc_win *w = tegra_dc_get_window(dc, i);
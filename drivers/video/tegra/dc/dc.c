@@ -4541,7 +4541,7 @@ static void tegra_dc_disable_irq_ops(struct tegra_dc *dc, bool from_irq)
 	/* it's important that new underflow work isn't scheduled before the
 	 * lock is acquired. */
 	cancel_delayed_work_sync(&dc->underflow_work);
-
+	cancel_work_sync(&dc->bw_work);
 
 	if (dc->out->flags & TEGRA_DC_OUT_ONE_SHOT_MODE) {
 		mutex_lock(&dc->one_shot_lock);
@@ -5045,6 +5045,8 @@ static int tegra_dc_probe(struct platform_device *ndev)
 
 	mutex_init(&dc->lock);
 	mutex_init(&dc->one_shot_lock);
+	for (i = 0; i < DC_N_WINDOWS; i++)
+		tegra_la_disp_cache_init(&dc->la_cache[i]);
 	mutex_init(&dc->lp_lock);
 	init_completion(&dc->frame_end_complete);
 	init_completion(&dc->crc_complete);
@@ -5062,6 +5064,7 @@ static int tegra_dc_probe(struct platform_device *ndev)
 	dc->vpulse2_ref_count = 0;
 	INIT_DELAYED_WORK(&dc->underflow_work, tegra_dc_underflow_worker);
 	INIT_DELAYED_WORK(&dc->one_shot_work, tegra_dc_one_shot_worker);
+	tegra_dc_bandwidth_init(dc);
 
 	tegra_dc_init_lut_defaults(&dc->fb_lut);
 
@@ -5395,6 +5398,8 @@ static int tegra_dc_remove(struct platform_device *ndev)
 		tegra_dc_ext_unregister(dc->ext);
 	}
 #endif
+	/* no more flips to raise bandwidth for */
+	cancel_work_sync(&dc->bw_work);
 
 	if (dc->out->flags & TEGRA_DC_OUT_ONE_SHOT_MODE) {
 		mutex_lock(&dc->one_shot_lock);
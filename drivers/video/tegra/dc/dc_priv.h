@@ -534,6 +534,11 @@ int _tegra_dc_wait_for_frame_end(struct tegra_dc *dc,
 void tegra_dc_clear_bandwidth(struct tegra_dc *dc);
 void tegra_dc_program_bandwidth(struct tegra_dc *dc, bool use_new);
 int tegra_dc_set_dynamic_emc(struct tegra_dc *dc);
+void tegra_dc_bandwidth_init(struct tegra_dc *dc);
+/* defined in bandwidth.c, used in ext/dev.c */
+void tegra_dc_bandwidth_ahead(struct tegra_dc *dc,
+			struct tegra_dc_win *windows[], int n);
+void tegra_dc_bandwidth_release(struct tegra_dc *dc);
 #ifdef CONFIG_TEGRA_ISOMGR
 int tegra_dc_bandwidth_negotiate_bw(struct tegra_dc *dc,
 			struct tegra_dc_win *windows[], int n);
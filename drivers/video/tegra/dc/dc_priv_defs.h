@@ -35,6 +35,7 @@
 
 #include <mach/tegra_dc_ext.h>
 #include <linux/platform/tegra/isomgr.h>
+#include <linux/platform/tegra/la_disp_calc.h>
 
 #include "dc_reg.h"
 
@@ -175,6 +176,22 @@ struct tegra_dc {
 	struct clk			*emc_la_clk;
 	long				bw_kbps; /* bandwidth in KBps */
 	long				new_bw_kbps;
+	/*
+	 * bandwidth raised ahead of the flips in flight, and the requests
+	 * of the flips queued and of the flips latched for bw_work.
+	 * bw_lock serializes reserving bandwidth and bw_ahead_kbps, and
+	 * bw_seq counts the reservations, for bw_work to reserve without
+	 * dc->lock.
+	 */
+	struct mutex			bw_lock;
+	u32				bw_seq;
+	unsigned long			bw_ahead_kbps;
+	spinlock_t			bw_req_lock;
+	unsigned long			bw_ahead_req_kbps;
+	bool				bw_release_req;
+	struct work_struct		bw_work;
+	/* last bandwidth and LA inputs and results of each window */
+	struct tegra_la_disp_cache	la_cache[DC_N_WINDOWS];
 	struct tegra_dc_shift_clk_div	shift_clk_div;
 
 	u32				powergate_id;
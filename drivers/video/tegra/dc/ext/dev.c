@@ -134,6 +134,7 @@ struct tegra_dc_ext_flip_data {
 	u8 flags;
 	struct tegra_dc_hdr hdr_data;
 	bool hdr_cache_dirty;
+	ktime_t request_time;
 };
 
 static int tegra_dc_ext_set_vblank(struct tegra_dc_ext *ext, bool enable);
@@ -680,6 +681,16 @@ static void tegra_dc_ext_smooth_apc(struct tegra_vrr *vrr)
 	}
 }
 
+static bool tegra_dc_ext_flips_pending(struct tegra_dc_ext *ext)
+{
+	int i;
+
+	for (i = 0; i < ext->dc->n_windows; i++)
+		if (atomic_read(&ext->win[i].nr_pending_flips))
+			return true;
+	return false;
+}
+
 static void tegra_dc_ext_flip_worker(struct kthread_work *work)
 {
 	struct tegra_dc_ext_flip_data *data =
@@ -696,6 +707,7 @@ static void tegra_dc_ext_flip_worker(struct kthread_work *work)
 	int i, nr_unpin = 0, nr_win = 0;
 	bool skip_flip = false;
 	bool wait_for_vblank = false;
+	ktime_t program_time;
 	bool show_background =
 		tegra_dc_ext_should_show_background(data, win_num);
 	BEGIN_TRACE();
@@ -844,19 +856,25 @@ static void tegra_dc_ext_flip_worker(struct kthread_work *work)
 			data->dirty_rect_valid ? data->dirty_rect : NULL,
 			wait_for_vblank);
 		TRACE_NAME_END(tegra_dc_update_windows);
+		program_time = ktime_get();
 		/* TODO: implement swapinterval here */
 		TRACE_NAME_BEGIN(tegra_dc_sync_windows);
 		tegra_dc_sync_windows(wins, nr_win);
 		TRACE_NAME_END(tegra_dc_sync_windows);
+		trace_flip_latency(dc, data->request_time, program_time,
+				   ktime_get());
 		trace_scanout_syncpt_upd((data->win[win_num-1]).syncpt_max);
 		if (dc->out->vrr)
 			trace_scanout_vrr_stats((data->win[win_num-1]).syncpt_max
 							, dc->out->vrr->dcb);
-		tegra_dc_program_bandwidth(dc, true);
 		if (!tegra_dc_has_multiple_dc())
 			tegra_dc_call_flip_callback();
 	}
 
+	/* lower bandwidth off the flip path, after the latch */
+	if (dc->enabled && !tegra_dc_ext_flips_pending(ext))
+		tegra_dc_bandwidth_release(dc);
+
 	if (!skip_flip) {
 		for (i = 0; i < win_num; i++) {
 			struct tegra_dc_ext_flip_win *flip_win = &data->win[i];
@@ -1168,6 +1186,49 @@ static void tegra_dc_ext_read_user_data(struct tegra_dc_ext_flip_data *data,
 	return;
 }
 
+/*
+ * Have bandwidth for the windows as they will be after the flip raised while
+ * the flip waits for its fences. The windows not in the flip are read without
+ * dc->lock; the flip programs what it needs anyway if this falls short.
+ */
+static void tegra_dc_ext_flip_bw_ahead(struct tegra_dc_ext *ext,
+			struct tegra_dc_ext_flip_windowattr *win, int win_num)
+{
+	struct tegra_dc *dc = ext->dc;
+	struct tegra_dc_win *tmp_wins;
+	struct tegra_dc_win *wins[DC_N_WINDOWS];
+	int i, n = 0;
+
+	if (!tegra_platform_is_silicon())
+		return;
+
+	tmp_wins = kcalloc(DC_N_WINDOWS, sizeof(*tmp_wins), GFP_KERNEL);
+	if (!tmp_wins)
+		return;
+
+	for_each_set_bit(i, &dc->valid_windows, DC_N_WINDOWS)
+		tmp_wins[i] = *tegra_dc_get_window(dc, i);
+
+	for (i = 0; i < win_num; i++) {
+		int idx = win[i].index;
+
+		if (idx < 0 || !test_bit(idx, &dc->valid_windows))
+			continue;
+
+		if (win[i].buff_id > 0)
+			tegra_dc_ext_set_windowattr_basic(&tmp_wins[idx],
+							  &win[i]);
+		else
+			tmp_wins[idx].flags = 0;
+	}
+
+	for_each_set_bit(i, &dc->valid_windows, DC_N_WINDOWS)
+		wins[n++] = &tmp_wins[i];
+
+	tegra_dc_bandwidth_ahead(dc, wins, n);
+	kfree(tmp_wins);
+}
+
 static int tegra_dc_ext_flip(struct tegra_dc_ext_user *user,
 			     struct tegra_dc_ext_flip_windowattr *win,
 			     int win_num,
@@ -1197,6 +1258,7 @@ static int tegra_dc_ext_flip(struct tegra_dc_ext_user *user,
 
 	init_kthread_work(&data->work, &tegra_dc_ext_flip_worker);
 	data->ext = ext;
+	data->request_time = ktime_get();
 	data->act_window_num = win_num;
 	if (dirty_rect) {
 		memcpy(data->dirty_rect, dirty_rect, sizeof(data->dirty_rect));
@@ -1284,6 +1346,7 @@ static int tegra_dc_ext_flip(struct tegra_dc_ext_user *user,
 	}
 #endif
 	data->flags = flip_flags;
+	tegra_dc_ext_flip_bw_ahead(ext, win, win_num);
 	queue_kthread_work(&ext->win[work_index].flip_worker, &data->work);
 
 	unlock_windows_for_flip(user, win, win_num);
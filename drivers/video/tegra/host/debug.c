@@ -28,6 +28,7 @@
 #include "debug.h"
 #include "nvhost_acm.h"
 #include "nvhost_channel.h"
+#include "nvhost_vm.h"
 #include "chip_support.h"
 
 unsigned int nvhost_debug_trace_cmdbuf;
@@ -253,6 +254,11 @@ void nvhost_debug_init(struct nvhost_master *master)
 	debugfs_create_u32("trace_cmdbuf", S_IRUGO|S_IWUSR, de,
 			&nvhost_debug_trace_cmdbuf);
 
+	nvhost_intr_debug_init(&master->intr, de);
+
+	debugfs_create_u32("pin_cache", S_IRUGO|S_IWUSR, de,
+			&nvhost_vm_pin_cache_enabled);
+
 	if (nvhost_get_chip_ops()->debug.debug_init)
 		nvhost_get_chip_ops()->debug.debug_init(de);
 
@@ -0,0 +1,334 @@
+/*
+ * Tegra Graphics Host software emulation
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/slab.h>
+
+#include "emu.h"
+#include "../dev.h"
+#include "../debug.h"
+#include "../nvhost_channel.h"
+#include "../nvhost_job.h"
+#include "../host1x/host1x.h"
+
+/* debug_init() isn't passed the master; there is only ever one host1x */
+static struct nvhost_emu *emu_debug;
+
+/**
+ * Write @val to syncpoint @id, as a host1x_sync_syncpt_0_r() write would.
+ */
+void nvhost_emu_syncpt_set(struct nvhost_emu *emu, u32 id, u32 val)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->lock, flags);
+	emu->value[id] = val;
+	nvhost_emu_raise_locked(emu, id);
+	spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+/**
+ * Move syncpoint @id forward to @fence, unless something (a CPU increment
+ * on timeout, say) already took it there.
+ */
+void nvhost_emu_syncpt_advance(struct nvhost_emu *emu, u32 id, u32 fence)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->lock, flags);
+	if ((s32)(fence - emu->value[id]) > 0) {
+		emu->value[id] = fence;
+		nvhost_emu_raise_locked(emu, id);
+	}
+	spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+/**
+ * Raise the threshold interrupt of syncpoint @id if it is enabled and the
+ * value has reached the threshold. Like the hardware, an interrupt that is
+ * already pending isn't raised twice.
+ */
+void nvhost_emu_raise_locked(struct nvhost_emu *emu, u32 id)
+{
+	if (!test_bit(id, emu->enabled) ||
+	    (s32)(emu->value[id] - emu->thresh[id]) < 0 ||
+	    test_and_set_bit(id, emu->pending))
+		return;
+
+	emu->asserted[id] = ktime_get();
+	queue_work(emu->wq, &emu->thresh_work);
+}
+
+/*** emulated engines ***/
+
+static enum hrtimer_restart emu_engine_timer(struct hrtimer *timer)
+{
+	struct nvhost_emu_engine *eng =
+		container_of(timer, struct nvhost_emu_engine, timer);
+	enum hrtimer_restart ret = HRTIMER_NORESTART;
+	struct nvhost_emu_job *job, *n;
+	ktime_t now = ktime_get();
+	unsigned long flags;
+	LIST_HEAD(done);
+	int i;
+
+	spin_lock_irqsave(&eng->lock, flags);
+	list_for_each_entry_safe(job, n, &eng->queue, list) {
+		if (ktime_compare(job->done, now) > 0) {
+			hrtimer_set_expires(timer, job->done);
+			ret = HRTIMER_RESTART;
+			break;
+		}
+		list_move_tail(&job->list, &done);
+		eng->queued--;
+	}
+	spin_unlock_irqrestore(&eng->lock, flags);
+
+	list_for_each_entry_safe(job, n, &done, list) {
+		for (i = 0; i < job->num_syncpts; i++)
+			nvhost_emu_syncpt_advance(eng->emu, job->sp[i].id,
+						  job->sp[i].fence);
+		kfree(job);
+	}
+
+	return ret;
+}
+
+struct nvhost_emu_engine *nvhost_emu_engine(struct nvhost_emu *emu,
+					    int chid)
+{
+	int index = nvhost_channel_get_index_from_id(emu->host, chid);
+
+	if (WARN_ON(index < 0 || index >= emu->nb_engines))
+		return NULL;
+
+	return &emu->engines[index];
+}
+
+/**
+ * Queue @job on @eng. The job completes emu->latency_us after the engine
+ * gets to it, at which point its syncpoints reach their fences.
+ */
+void nvhost_emu_engine_submit(struct nvhost_emu_engine *eng,
+			      struct nvhost_job *job)
+{
+	struct nvhost_emu_job *ej;
+	unsigned long flags;
+	ktime_t start;
+	int i;
+
+	ej = kmalloc(sizeof(*ej) + job->num_syncpts * sizeof(ej->sp[0]),
+		     GFP_KERNEL);
+	if (!ej) {
+		/* can't queue it, so the job finishes right away */
+		for (i = 0; i < job->num_syncpts; i++)
+			nvhost_emu_syncpt_advance(eng->emu, job->sp[i].id,
+						  job->sp[i].fence);
+		return;
+	}
+
+	ej->num_syncpts = job->num_syncpts;
+	for (i = 0; i < job->num_syncpts; i++) {
+		ej->sp[i].id = job->sp[i].id;
+		ej->sp[i].fence = job->sp[i].fence;
+	}
+
+	spin_lock_irqsave(&eng->lock, flags);
+	start = ktime_get();
+	if (ktime_compare(eng->last_done, start) > 0)
+		start = eng->last_done;
+	ej->done = ktime_add_us(start, ACCESS_ONCE(eng->emu->latency_us));
+	eng->last_done = ej->done;
+
+	list_add_tail(&ej->list, &eng->queue);
+	if (!eng->queued++)
+		hrtimer_start(&eng->timer, ej->done, HRTIMER_MODE_ABS);
+	spin_unlock_irqrestore(&eng->lock, flags);
+}
+
+static void emu_engine_drain(struct nvhost_emu_engine *eng)
+{
+	struct nvhost_emu_job *job, *n;
+
+	hrtimer_cancel(&eng->timer);
+	list_for_each_entry_safe(job, n, &eng->queue, list) {
+		list_del(&job->list);
+		kfree(job);
+	}
+	eng->queued = 0;
+}
+
+/*** debug ***/
+
+static void emu_debug_show_channel_cdma(struct nvhost_master *m,
+		struct nvhost_channel *ch, struct output *o, int chid)
+{
+	struct nvhost_emu_engine *eng = nvhost_emu_engine(m->emu, chid);
+
+	if (!eng)
+		return;
+
+	nvhost_debug_output(o, "%d-%s: emulated, %u jobs queued\n", chid,
+			    ch->dev ? ch->dev->name : "", eng->queued);
+}
+
+static void emu_debug_show_channel_fifo(struct nvhost_master *m,
+		struct nvhost_channel *ch, struct output *o, int chid)
+{
+}
+
+static void emu_debug_show_mlocks(struct nvhost_master *m, struct output *o)
+{
+	struct nvhost_emu *emu = m->emu;
+	int i;
+
+	nvhost_debug_output(o, "---- mlocks ----\n");
+	for (i = 0; i < m->info.nb_mlocks; i++)
+		if (atomic_read(&emu->mlock[i]))
+			nvhost_debug_output(o, "%d: locked by cpu\n", i);
+	nvhost_debug_output(o, "\n");
+}
+
+static void emu_debug_init(struct dentry *de)
+{
+	struct nvhost_emu *emu = emu_debug;
+
+	if (!emu)
+		return;
+
+	emu->debugfs = debugfs_create_dir("emu", de);
+	if (!emu->debugfs)
+		return;
+
+	debugfs_create_u32("latency_us", S_IRUGO|S_IWUSR, emu->debugfs,
+			   &emu->latency_us);
+	nvhost_emu_bench_init(emu, emu->debugfs);
+}
+
+void emu_init_host1x_debug_ops(struct nvhost_debug_ops *ops)
+{
+	ops->debug_init = emu_debug_init;
+	ops->show_channel_cdma = emu_debug_show_channel_cdma;
+	ops->show_channel_fifo = emu_debug_show_channel_fifo;
+	ops->show_mlocks = emu_debug_show_mlocks;
+}
+
+/*** setup ***/
+
+static void emu_free(struct nvhost_emu *emu)
+{
+	if (emu->wq)
+		destroy_workqueue(emu->wq);
+	kfree(emu->engines);
+	kfree(emu->mlock);
+	kfree(emu->pending);
+	kfree(emu->enabled);
+	kfree(emu->asserted);
+	kfree(emu->thresh);
+	kfree(emu->value);
+	kfree(emu);
+}
+
+/**
+ * nvhost_emu_init - run host1x in software
+ * @host: the host1x being probed
+ * @op: chip ops, already set up for the real hardware
+ *
+ * Replaces the syncpoint, interrupt, channel DMA and debug ops that touch
+ * host1x registers with ones working on an in-memory model, and sets up
+ * one emulated engine per channel.
+ */
+int nvhost_emu_init(struct nvhost_master *host,
+		    struct nvhost_chip_support *op)
+{
+	int nb_pts = host->info.nb_hw_pts;
+	int nb_channels = nvhost_channel_nb_channels(host);
+	struct nvhost_emu *emu;
+	int i;
+
+	emu = kzalloc(sizeof(*emu), GFP_KERNEL);
+	if (!emu)
+		return -ENOMEM;
+
+	emu->host = host;
+	emu->latency_us = NVHOST_EMU_DEFAULT_LATENCY_US;
+	spin_lock_init(&emu->lock);
+	mutex_init(&emu->bench_lock);
+	INIT_WORK(&emu->thresh_work, nvhost_emu_thresh_work);
+
+	emu->value = kcalloc(nb_pts, sizeof(*emu->value), GFP_KERNEL);
+	emu->thresh = kcalloc(nb_pts, sizeof(*emu->thresh), GFP_KERNEL);
+	emu->asserted = kcalloc(nb_pts, sizeof(*emu->asserted), GFP_KERNEL);
+	emu->enabled = kcalloc(BITS_TO_LONGS(nb_pts), sizeof(long),
+			       GFP_KERNEL);
+	emu->pending = kcalloc(BITS_TO_LONGS(nb_pts), sizeof(long),
+			       GFP_KERNEL);
+	emu->mlock = kcalloc(max_t(int, host->info.nb_mlocks, 1),
+			     sizeof(*emu->mlock), GFP_KERNEL);
+	emu->engines = kcalloc(nb_channels, sizeof(*emu->engines),
+			       GFP_KERNEL);
+	emu->wq = alloc_workqueue("nvhost_emu", WQ_HIGHPRI | WQ_UNBOUND, 1);
+	if (!emu->value || !emu->thresh || !emu->asserted || !emu->enabled ||
+	    !emu->pending || !emu->mlock || !emu->engines || !emu->wq) {
+		emu_free(emu);
+		return -ENOMEM;
+	}
+
+	emu->nb_engines = nb_channels;
+	for (i = 0; i < nb_channels; i++) {
+		struct nvhost_emu_engine *eng = &emu->engines[i];
+
+		eng->emu = emu;
+		spin_lock_init(&eng->lock);
+		INIT_LIST_HEAD(&eng->queue);
+		hrtimer_init(&eng->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+		eng->timer.function = emu_engine_timer;
+	}
+
+	emu_init_host1x_syncpt_ops(&op->syncpt);
+	emu_init_host1x_intr_ops(&op->intr);
+	emu_init_host1x_cdma_ops(&op->cdma);
+	emu_init_host1x_debug_ops(&op->debug);
+
+	host->emu = emu;
+	emu_debug = emu;
+
+	dev_info(&host->dev->dev, "emulating host1x, %d channels, %d syncpts\n",
+		 nb_channels, nb_pts);
+
+	return 0;
+}
+
+void nvhost_emu_deinit(struct nvhost_master *host)
+{
+	struct nvhost_emu *emu = host->emu;
+	int i;
+
+	if (!emu)
+		return;
+
+	debugfs_remove_recursive(emu->debugfs);
+	for (i = 0; i < emu->nb_engines; i++)
+		emu_engine_drain(&emu->engines[i]);
+	flush_workqueue(emu->wq);
+
+	if (emu_debug == emu)
+		emu_debug = NULL;
+	host->emu = NULL;
+	emu_free(emu);
+}
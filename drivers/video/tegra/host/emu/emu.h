@@ -0,0 +1,124 @@
+/*
+ * Tegra Graphics Host software emulation
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __NVHOST_EMU_H
+#define __NVHOST_EMU_H
+
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+
+#include "chip_support.h"
+
+struct nvhost_master;
+struct nvhost_job;
+struct dentry;
+
+/* Default time the emulated engines take to run one job */
+#define NVHOST_EMU_DEFAULT_LATENCY_US	100
+
+/*
+ * A job as the emulated engine sees it: when it completes, each of its
+ * syncpoints jumps to the fence host1x_channel_submit() computed for it.
+ */
+struct nvhost_emu_job {
+	struct list_head list;
+	ktime_t done;			/* when the engine finishes the job */
+	int num_syncpts;
+	struct {
+		u32 id;
+		u32 fence;
+	} sp[];
+};
+
+/*
+ * One engine per channel. Jobs run back to back in submission order, each
+ * taking the configured latency from the later of its kick and the end of
+ * the previous job; the timer fires at the end of the oldest one.
+ */
+struct nvhost_emu_engine {
+	struct nvhost_emu *emu;
+	spinlock_t lock;		/* protects queue and last_done */
+	struct list_head queue;
+	struct hrtimer timer;
+	ktime_t last_done;
+	unsigned int queued;
+};
+
+struct nvhost_emu {
+	struct nvhost_master *host;
+
+	/* syncpoint registers and threshold interrupt state */
+	spinlock_t lock;
+	u32 *value;
+	u32 *thresh;
+	ktime_t *asserted;		/* when a pending interrupt was raised */
+	unsigned long *enabled;
+	unsigned long *pending;
+	atomic_t *mlock;
+
+	/* runs the threshold interrupts, as the threaded irq would */
+	struct workqueue_struct *wq;
+	struct work_struct thresh_work;
+
+	struct nvhost_emu_engine *engines;
+	int nb_engines;
+	u32 latency_us;
+
+	struct dentry *debugfs;
+	struct mutex bench_lock;
+	char bench_result[512];
+};
+
+#ifdef CONFIG_TEGRA_GRHOST_EMU
+int nvhost_emu_init(struct nvhost_master *host,
+		    struct nvhost_chip_support *op);
+void nvhost_emu_deinit(struct nvhost_master *host);
+#else
+static inline int nvhost_emu_init(struct nvhost_master *host,
+				  struct nvhost_chip_support *op)
+{
+	return -ENODEV;
+}
+
+static inline void nvhost_emu_deinit(struct nvhost_master *host)
+{
+}
+#endif
+
+void emu_init_host1x_syncpt_ops(struct nvhost_syncpt_ops *ops);
+void emu_init_host1x_intr_ops(struct nvhost_intr_ops *ops);
+void emu_init_host1x_cdma_ops(struct nvhost_cdma_ops *ops);
+void emu_init_host1x_debug_ops(struct nvhost_debug_ops *ops);
+
+void nvhost_emu_syncpt_set(struct nvhost_emu *emu, u32 id, u32 val);
+void nvhost_emu_syncpt_advance(struct nvhost_emu *emu, u32 id, u32 fence);
+void nvhost_emu_raise_locked(struct nvhost_emu *emu, u32 id);
+void nvhost_emu_thresh_work(struct work_struct *work);
+
+struct nvhost_emu_engine *nvhost_emu_engine(struct nvhost_emu *emu,
+					    int chid);
+void nvhost_emu_engine_submit(struct nvhost_emu_engine *eng,
+			      struct nvhost_job *job);
+
+void nvhost_emu_bench_init(struct nvhost_emu *emu, struct dentry *de);
+
+#endif
@@ -0,0 +1,378 @@
+/*
+ * Tegra Graphics Host submit path benchmark on the emulated host1x
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Writing "COUNT [DEPTH [BUFS]]" to tegra_host/emu/bench submits COUNT jobs
+ * with one syncpoint increment each to an emulated channel, keeping at most
+ * DEPTH (default 1) of them in flight, the way a client double or triple
+ * buffering its work would. Each job gathers from BUFS (default 0) page
+ * sized buffers, the first of which holds a relocation to each of them, so
+ * the same buffers are pinned for every submit like a frame's would be.
+ * Reading the file returns the results of the last run:
+ *   submit:  time spent in nvhost_job_pin() and nvhost_channel_submit()
+ *   jobs/s:  submissions per second over the whole run
+ *   wakeup:  from the emulated engine raising the threshold interrupt to
+ *            the waiter running again, for waits that had to sleep
+ * tegra_host/emu/latency_us sets how long the engine takes per job, and
+ * tegra_host/pin_cache turns the submit path's pin cache off and on.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-mapping.h>
+#include <linux/file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/syscalls.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#include "emu.h"
+#include "../dev.h"
+#include "../nvhost_channel.h"
+#include "../nvhost_job.h"
+#include "../nvhost_syncpt.h"
+#include "../nvhost_vm.h"
+#include "../host1x/host1x.h"
+
+#define EMU_BENCH_MAX_JOBS	1000000
+#define EMU_BENCH_MAX_BUFS	64
+
+/*** buffers for the jobs to use: one page each, exported as a dma_buf ***/
+
+static struct sg_table *emu_buf_map(struct dma_buf_attachment *attach,
+				    enum dma_data_direction dir)
+{
+	struct page *page = attach->dmabuf->priv;
+	struct sg_table *sgt;
+
+	sgt = kzalloc(sizeof(*sgt), GFP_KERNEL);
+	if (!sgt)
+		return ERR_PTR(-ENOMEM);
+
+	if (sg_alloc_table(sgt, 1, GFP_KERNEL)) {
+		kfree(sgt);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	sg_set_page(sgt->sgl, page, PAGE_SIZE, 0);
+	if (!dma_map_sg(attach->dev, sgt->sgl, 1, dir)) {
+		sg_free_table(sgt);
+		kfree(sgt);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	return sgt;
+}
+
+static void emu_buf_unmap(struct dma_buf_attachment *attach,
+			  struct sg_table *sgt, enum dma_data_direction dir)
+{
+	dma_unmap_sg(attach->dev, sgt->sgl, 1, dir);
+	sg_free_table(sgt);
+	kfree(sgt);
+}
+
+static void emu_buf_release(struct dma_buf *buf)
+{
+	__free_page(buf->priv);
+}
+
+static void *emu_buf_kmap(struct dma_buf *buf, unsigned long page_num)
+{
+	return page_address(buf->priv);
+}
+
+static int emu_buf_mmap(struct dma_buf *buf, struct vm_area_struct *vma)
+{
+	return -EINVAL;
+}
+
+static const struct dma_buf_ops emu_buf_ops = {
+	.map_dma_buf	= emu_buf_map,
+	.unmap_dma_buf	= emu_buf_unmap,
+	.release	= emu_buf_release,
+	.kmap_atomic	= emu_buf_kmap,
+	.kmap		= emu_buf_kmap,
+	.mmap		= emu_buf_mmap,
+};
+
+/* Returns a file descriptor for a new buffer, as jobs take those. */
+static int emu_buf_alloc(void)
+{
+	struct dma_buf *buf;
+	struct page *page;
+	int fd;
+
+	page = alloc_page(GFP_KERNEL | __GFP_ZERO);
+	if (!page)
+		return -ENOMEM;
+
+	buf = dma_buf_export(page, &emu_buf_ops, PAGE_SIZE, O_RDWR);
+	if (IS_ERR(buf)) {
+		__free_page(page);
+		return PTR_ERR(buf);
+	}
+
+	fd = dma_buf_fd(buf, O_CLOEXEC);
+	if (fd < 0)
+		dma_buf_put(buf);
+
+	return fd;
+}
+
+/*** the benchmark ***/
+
+static int emu_bench_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int emu_bench_print(char *buf, size_t size, const char *name,
+			   u64 *ns, int nr)
+{
+	u64 total = 0;
+	int i;
+
+	if (!nr)
+		return scnprintf(buf, size, "%-8s no samples\n", name);
+
+	sort(ns, nr, sizeof(*ns), emu_bench_cmp, NULL);
+	for (i = 0; i < nr; i++)
+		total += ns[i];
+
+	return scnprintf(buf, size,
+			 "%-8s mean %llu p50 %llu p99 %llu max %llu ns\n",
+			 name, div_u64(total, nr), ns[nr / 2],
+			 ns[(u64)nr * 99 / 100], ns[nr - 1]);
+}
+
+/*
+ * Wait for @fence. Returns 1 and the wakeup latency in @wake_ns if the
+ * wait had to sleep, 0 if the fence had already passed.
+ */
+static int emu_bench_wait(struct nvhost_syncpt *sp, u32 id, u32 fence,
+			  u64 *wake_ns)
+{
+	struct timespec ts;
+	bool blocked;
+	int err;
+
+	nvhost_syncpt_update_min(sp, id);
+	blocked = !nvhost_syncpt_is_expired(sp, id, fence);
+
+	err = nvhost_syncpt_wait_timeout(sp, id, fence,
+					 (u32)MAX_SCHEDULE_TIMEOUT,
+					 NULL, &ts, false);
+	if (err)
+		return err;
+	if (!blocked)
+		return 0;
+
+	*wake_ns = ktime_to_ns(ktime_sub(ktime_get(), timespec_to_ktime(ts)));
+	return 1;
+}
+
+static void emu_bench_add_bufs(struct nvhost_job *job, int *fds, int nr_bufs)
+{
+	int i;
+
+	for (i = 0; i < nr_bufs; i++) {
+		struct nvhost_reloc *reloc = &job->relocarray[i];
+
+		nvhost_job_add_gather(job, fds[i], 1, 0, 0, -1);
+
+		reloc->cmdbuf_mem = fds[0];
+		reloc->cmdbuf_offset = (i + 1) * sizeof(u32);
+		reloc->target = fds[i];
+		reloc->target_offset = 0;
+		job->relocshiftarray[i].shift = 0;
+	}
+	job->num_relocs = nr_bufs;
+}
+
+static int emu_bench_run(struct nvhost_emu *emu, int count, int depth,
+			 int nr_bufs)
+{
+	struct platform_device *pdev = emu->host->dev;
+	struct nvhost_syncpt *sp = &emu->host->syncpt;
+	char *buf = emu->bench_result;
+	size_t size = sizeof(emu->bench_result);
+	u64 *submit_ns, *wake_ns, elapsed;
+	struct nvhost_channel *ch;
+	int i, nr_submitted = 0, nr_wake = 0, nr_fds = 0, len, err;
+	int fds[EMU_BENCH_MAX_BUFS];
+	ktime_t start;
+	u32 *fences;
+	u32 id;
+
+	submit_ns = vzalloc(count * sizeof(*submit_ns));
+	wake_ns = vzalloc(count * sizeof(*wake_ns));
+	fences = vzalloc(count * sizeof(*fences));
+	if (!submit_ns || !wake_ns || !fences) {
+		err = -ENOMEM;
+		goto out_free;
+	}
+
+	for (; nr_fds < nr_bufs; nr_fds++) {
+		fds[nr_fds] = emu_buf_alloc();
+		if (fds[nr_fds] < 0) {
+			err = fds[nr_fds];
+			goto out_free;
+		}
+	}
+
+	err = nvhost_channel_map(platform_get_drvdata(pdev), &ch, emu);
+	if (err)
+		goto out_free;
+
+	id = nvhost_get_syncpt_host_managed(pdev, 0, "emu_bench");
+	if (!id) {
+		err = -EBUSY;
+		goto out_channel;
+	}
+
+	start = ktime_get();
+	for (i = 0; i < count; i++) {
+		struct nvhost_job *job;
+		ktime_t t0;
+
+		if (i >= depth) {
+			err = emu_bench_wait(sp, id, fences[i - depth],
+					     &wake_ns[nr_wake]);
+			if (err < 0)
+				goto out_drain;
+			nr_wake += err;
+		}
+
+		t0 = ktime_get();
+		job = nvhost_job_alloc(ch, nr_bufs, nr_bufs, 0, 1);
+		if (!job) {
+			err = -ENOMEM;
+			goto out_drain;
+		}
+		emu_bench_add_bufs(job, fds, nr_bufs);
+		job->num_syncpts = 1;
+		job->sp[0].id = id;
+		job->sp[0].incrs = 1;
+
+		err = nvhost_job_pin(job, sp);
+		if (!err)
+			err = nvhost_channel_submit(job);
+		if (err) {
+			nvhost_job_unpin(job);
+			nvhost_job_put(job);
+			goto out_drain;
+		}
+		fences[nr_submitted++] = job->sp[0].fence;
+		nvhost_job_put(job);
+		submit_ns[i] = ktime_to_ns(ktime_sub(ktime_get(), t0));
+	}
+
+	for (i = max(count - depth, 0); i < count; i++) {
+		err = emu_bench_wait(sp, id, fences[i], &wake_ns[nr_wake]);
+		if (err < 0)
+			goto out_drain;
+		nr_wake += err;
+	}
+	elapsed = ktime_to_ns(ktime_sub(ktime_get(), start));
+	err = 0;
+
+	len = scnprintf(buf, size,
+			"%d jobs, depth %d, %d bufs, pin cache %s, latency %u us\n",
+			count, depth, nr_bufs,
+			nvhost_vm_pin_cache_enabled ? "on" : "off",
+			ACCESS_ONCE(emu->latency_us));
+	len += emu_bench_print(buf + len, size - len, "submit:",
+			       submit_ns, count);
+	len += scnprintf(buf + len, size - len, "%-8s %llu\n", "jobs/s:",
+			 div64_u64((u64)count * NSEC_PER_SEC, elapsed ?: 1));
+	emu_bench_print(buf + len, size - len, "wakeup:", wake_ns, nr_wake);
+
+out_drain:
+	/* don't drop the syncpoint with jobs still queued on it */
+	if (nr_submitted)
+		nvhost_syncpt_wait_timeout(sp, id, fences[nr_submitted - 1],
+					   (u32)MAX_SCHEDULE_TIMEOUT,
+					   NULL, NULL, false);
+	nvhost_syncpt_put_ref(sp, id);
+out_channel:
+	nvhost_putchannel(ch, 1);
+out_free:
+	vfree(fences);
+	vfree(wake_ns);
+	vfree(submit_ns);
+	while (nr_fds--)
+		sys_close(fds[nr_fds]);
+	if (err)
+		scnprintf(buf, size, "failed: %d\n", err);
+	return err;
+}
+
+static ssize_t emu_bench_write(struct file *file, const char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	struct nvhost_emu *emu = file->private_data;
+	int jobs, depth = 1, nr_bufs = 0, err;
+	char buf[32];
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sscanf(buf, "%d %d %d", &jobs, &depth, &nr_bufs) < 1)
+		return -EINVAL;
+	if (jobs < 1 || jobs > EMU_BENCH_MAX_JOBS || depth < 1 ||
+	    nr_bufs < 0 || nr_bufs > EMU_BENCH_MAX_BUFS)
+		return -EINVAL;
+
+	mutex_lock(&emu->bench_lock);
+	err = emu_bench_run(emu, jobs, min(depth, jobs), nr_bufs);
+	mutex_unlock(&emu->bench_lock);
+
+	return err ? err : count;
+}
+
+static ssize_t emu_bench_read(struct file *file, char __user *ubuf,
+			      size_t count, loff_t *ppos)
+{
+	struct nvhost_emu *emu = file->private_data;
+	ssize_t ret;
+
+	mutex_lock(&emu->bench_lock);
+	ret = simple_read_from_buffer(ubuf, count, ppos, emu->bench_result,
+				      strlen(emu->bench_result));
+	mutex_unlock(&emu->bench_lock);
+
+	return ret;
+}
+
+static const struct file_operations emu_bench_fops = {
+	.open		= simple_open,
+	.read		= emu_bench_read,
+	.write		= emu_bench_write,
+	.llseek		= default_llseek,
+};
+
+void nvhost_emu_bench_init(struct nvhost_emu *emu, struct dentry *de)
+{
+	debugfs_create_file("bench", S_IRUGO|S_IWUSR, de, emu,
+			    &emu_bench_fops);
+}
@@ -0,0 +1,147 @@
+/*
+ * Tegra Graphics Host command DMA emulation
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "emu.h"
+#include "../dev.h"
+#include "../nvhost_cdma.h"
+#include "../nvhost_channel.h"
+#include "../nvhost_job.h"
+#include "../host1x/host1x.h"
+
+static void emu_cdma_start(struct nvhost_cdma *cdma)
+{
+	if (cdma->running)
+		return;
+
+	cdma->last_put = nvhost_push_buffer_putptr(&cdma->push_buffer);
+	cdma->running = true;
+}
+
+static void emu_cdma_stop(struct nvhost_cdma *cdma)
+{
+	mutex_lock(&cdma->lock);
+	if (cdma->running) {
+		nvhost_cdma_wait_locked(cdma, CDMA_EVENT_SYNC_QUEUE_EMPTY);
+		cdma->running = false;
+	}
+	mutex_unlock(&cdma->lock);
+}
+
+/**
+ * Hand the job nvhost_cdma_end() just queued to the channel's engine.
+ * The push buffer itself is left alone: the engine completes the job by
+ * moving its syncpoints to their fences, whatever the gathers hold.
+ */
+static void emu_cdma_kick(struct nvhost_cdma *cdma)
+{
+	struct nvhost_channel *ch = cdma_to_channel(cdma);
+	struct nvhost_emu_engine *eng;
+	struct nvhost_job *job;
+
+	if (list_empty(&cdma->sync_queue))
+		return;
+
+	eng = nvhost_emu_engine(cdma_to_dev(cdma)->emu, ch->chid);
+	if (!eng)
+		return;
+
+	job = list_entry(cdma->sync_queue.prev, struct nvhost_job, list);
+	nvhost_emu_engine_submit(eng, job);
+	cdma->last_put = nvhost_push_buffer_putptr(&cdma->push_buffer);
+}
+
+/*
+ * A job outran its timeout, which with the emulated engines only happens
+ * when the latency is set above it: complete its increments from the CPU.
+ */
+static void emu_cdma_timeout_handler(struct work_struct *work)
+{
+	struct nvhost_cdma *cdma;
+	struct nvhost_master *dev;
+	struct nvhost_job *job;
+	int i;
+
+	cdma = container_of(to_delayed_work(work), struct nvhost_cdma,
+			    timeout.wq);
+	dev = cdma_to_dev(cdma);
+
+	mutex_lock(&cdma->lock);
+
+	job = list_first_entry_or_null(&cdma->sync_queue,
+					struct nvhost_job, list);
+	if (!job)
+		goto out;
+	/* set notifier to userspace about submit timeout */
+	nvhost_job_set_notifier(job, NVHOST_CHANNEL_SUBMIT_TIMEOUT);
+
+	for (i = 0; i < job->num_syncpts; ++i) {
+		struct nvhost_job_syncpt *sp = job->sp + i;
+		nvhost_syncpt_update_min(&dev->syncpt, sp->id);
+		if (nvhost_syncpt_is_expired(&dev->syncpt, sp->id, sp->fence))
+			continue;
+		nvhost_cdma_finalize_job_incrs(&dev->syncpt, sp);
+	}
+out:
+	mutex_unlock(&cdma->lock);
+}
+
+static int emu_cdma_timeout_init(struct nvhost_cdma *cdma,
+				 u32 syncpt_id)
+{
+	if (syncpt_id == NVSYNCPT_INVALID)
+		return -EINVAL;
+
+	INIT_DELAYED_WORK(&cdma->timeout.wq, emu_cdma_timeout_handler);
+	cdma->timeout.initialized = true;
+
+	return 0;
+}
+
+static void emu_cdma_timeout_destroy(struct nvhost_cdma *cdma)
+{
+	if (cdma->timeout.initialized)
+		cancel_delayed_work(&cdma->timeout.wq);
+	cdma->timeout.initialized = false;
+}
+
+static void emu_cdma_timeout_pb_cleanup(struct nvhost_cdma *cdma, u32 getptr,
+				u32 nr_slots)
+{
+}
+
+static void emu_cdma_timeout_teardown_begin(struct nvhost_cdma *cdma)
+{
+}
+
+static void emu_cdma_timeout_teardown_end(struct nvhost_cdma *cdma,
+				u32 getptr)
+{
+}
+
+void emu_init_host1x_cdma_ops(struct nvhost_cdma_ops *ops)
+{
+	ops->start = emu_cdma_start;
+	ops->stop = emu_cdma_stop;
+	ops->kick = emu_cdma_kick;
+
+	ops->timeout_init = emu_cdma_timeout_init;
+	ops->timeout_destroy = emu_cdma_timeout_destroy;
+	ops->timeout_teardown_begin = emu_cdma_timeout_teardown_begin;
+	ops->timeout_teardown_end = emu_cdma_timeout_teardown_end;
+	ops->timeout_pb_cleanup = emu_cdma_timeout_pb_cleanup;
+}
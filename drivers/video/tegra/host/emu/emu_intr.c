@@ -0,0 +1,189 @@
+/*
+ * Tegra Graphics Host interrupt emulation
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <linux/ktime.h>
+
+#include "nvhost_intr.h"
+#include "emu.h"
+#include "dev.h"
+#include "debug.h"
+
+/**
+ * Threshold interrupt handler. Runs in process context like the threaded
+ * syncpt_thresh_cascade_isr(), and acks the same way: the interrupt of a
+ * syncpoint is disabled before its waiters are processed.
+ */
+void nvhost_emu_thresh_work(struct work_struct *work)
+{
+	struct nvhost_emu *emu =
+		container_of(work, struct nvhost_emu, thresh_work);
+	struct nvhost_master *dev = emu->host;
+	struct nvhost_intr *intr = &dev->intr;
+	int nb_pts = nvhost_syncpt_nb_hw_pts(&dev->syncpt);
+	int graphics_host_sp = nvhost_syncpt_graphics_host_sp(&dev->syncpt);
+	unsigned long flags;
+	int id;
+
+	for (;;) {
+		struct nvhost_intr_syncpt *sp;
+
+		spin_lock_irqsave(&emu->lock, flags);
+		id = find_first_bit(emu->pending, nb_pts);
+		if (id >= nb_pts) {
+			spin_unlock_irqrestore(&emu->lock, flags);
+			break;
+		}
+		clear_bit(id, emu->pending);
+		if (id != graphics_host_sp)
+			clear_bit(id, emu->enabled);
+		sp = intr->syncpt + id;
+		sp->isr_recv = ktime_to_timespec(emu->asserted[id]);
+		spin_unlock_irqrestore(&emu->lock, flags);
+
+		/* handle graphics host syncpoint increments immediately */
+		if (id == graphics_host_sp) {
+			dev_warn(&dev->dev->dev, "%s(): syncpoint id %d incremented\n",
+				 __func__, graphics_host_sp);
+			nvhost_syncpt_patch_check(&dev->syncpt);
+		} else
+			nvhost_syncpt_thresh_fn(sp);
+	}
+}
+
+static void emu_intr_set_syncpt_threshold(struct nvhost_intr *intr,
+					  u32 id, u32 thresh)
+{
+	struct nvhost_emu *emu = intr_to_dev(intr)->emu;
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->lock, flags);
+	emu->thresh[id] = thresh;
+	nvhost_emu_raise_locked(emu, id);
+	spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+static void emu_intr_enable_syncpt_intr(struct nvhost_intr *intr, u32 id)
+{
+	struct nvhost_emu *emu = intr_to_dev(intr)->emu;
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->lock, flags);
+	set_bit(id, emu->enabled);
+	nvhost_emu_raise_locked(emu, id);
+	spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+static void emu_intr_disable_syncpt_intr(struct nvhost_intr *intr, u32 id)
+{
+	struct nvhost_emu *emu = intr_to_dev(intr)->emu;
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->lock, flags);
+	clear_bit(id, emu->enabled);
+	clear_bit(id, emu->pending);
+	spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+static void emu_intr_disable_all_syncpt_intrs(struct nvhost_intr *intr)
+{
+	struct nvhost_master *dev = intr_to_dev(intr);
+	struct nvhost_emu *emu = dev->emu;
+	int nb_pts = nvhost_syncpt_nb_hw_pts(&dev->syncpt);
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->lock, flags);
+	bitmap_zero(emu->enabled, nb_pts);
+	bitmap_zero(emu->pending, nb_pts);
+	spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+static void emu_intr_init_host_sync(struct nvhost_intr *intr)
+{
+	struct nvhost_master *dev = intr_to_dev(intr);
+
+	intr_op().disable_all_syncpt_intrs(intr);
+
+	/* enable graphics host syncpoint interrupt */
+	emu_intr_set_syncpt_threshold(intr,
+			nvhost_syncpt_graphics_host_sp(&dev->syncpt), 1);
+	emu_intr_enable_syncpt_intr(intr,
+			nvhost_syncpt_graphics_host_sp(&dev->syncpt));
+}
+
+static void emu_intr_set_host_clocks_per_usec(struct nvhost_intr *intr,
+					      u32 cpm)
+{
+}
+
+static int emu_intr_request_host_general_irq(struct nvhost_intr *intr)
+{
+	return 0;
+}
+
+static void emu_intr_free_host_general_irq(struct nvhost_intr *intr)
+{
+}
+
+static int emu_free_syncpt_irq(struct nvhost_intr *intr)
+{
+	struct nvhost_emu *emu = intr_to_dev(intr)->emu;
+
+	emu_intr_disable_all_syncpt_intrs(intr);
+	flush_workqueue(emu->wq);
+	return 0;
+}
+
+static int emu_intr_debug_dump(struct nvhost_intr *intr, struct output *o)
+{
+	struct nvhost_master *dev = intr_to_dev(intr);
+	struct nvhost_emu *emu = dev->emu;
+	int nb_pts = nvhost_syncpt_nb_hw_pts(&dev->syncpt);
+	int i;
+
+	nvhost_debug_output(o, "\n---- emulated syncpt thresh ----\n\n");
+	for_each_set_bit(i, emu->enabled, nb_pts)
+		nvhost_debug_output(o, "syncpt %d: value %u, thresh %u%s\n",
+			i, emu->value[i], emu->thresh[i],
+			test_bit(i, emu->pending) ? ", pending" : "");
+
+	return 0;
+}
+
+static void emu_intr_enable_host_irq(struct nvhost_intr *intr, int irq)
+{
+}
+
+static void emu_intr_disable_host_irq(struct nvhost_intr *intr, int irq)
+{
+}
+
+void emu_init_host1x_intr_ops(struct nvhost_intr_ops *ops)
+{
+	ops->init_host_sync = emu_intr_init_host_sync;
+	ops->set_host_clocks_per_usec = emu_intr_set_host_clocks_per_usec;
+	ops->set_syncpt_threshold = emu_intr_set_syncpt_threshold;
+	ops->enable_syncpt_intr = emu_intr_enable_syncpt_intr;
+	ops->disable_syncpt_intr = emu_intr_disable_syncpt_intr;
+	ops->disable_all_syncpt_intrs = emu_intr_disable_all_syncpt_intrs;
+	ops->request_host_general_irq = emu_intr_request_host_general_irq;
+	ops->free_host_general_irq = emu_intr_free_host_general_irq;
+	ops->free_syncpt_irq = emu_free_syncpt_irq;
+	ops->debug_dump = emu_intr_debug_dump;
+	ops->enable_host_irq = emu_intr_enable_host_irq;
+	ops->disable_host_irq = emu_intr_disable_host_irq;
+}
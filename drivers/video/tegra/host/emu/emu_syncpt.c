@@ -0,0 +1,102 @@
+/*
+ * Tegra Graphics Host syncpoint emulation
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "nvhost_syncpt.h"
+#include "emu.h"
+#include "../host1x/host1x.h"
+
+static void emu_syncpt_reset(struct nvhost_syncpt *sp, u32 id)
+{
+	struct nvhost_master *dev = syncpt_to_dev(sp);
+
+	nvhost_emu_syncpt_set(dev->emu, id, nvhost_syncpt_read_min(sp, id));
+}
+
+static u32 emu_syncpt_update_min(struct nvhost_syncpt *sp, u32 id)
+{
+	struct nvhost_emu *emu = syncpt_to_dev(sp)->emu;
+	u32 old, live;
+
+	do {
+		old = nvhost_syncpt_read_min(sp, id);
+		live = ACCESS_ONCE(emu->value[id]);
+	} while ((u32)atomic_cmpxchg(&sp->min_val[id], old, live) != old);
+
+	return live;
+}
+
+static void emu_syncpt_cpu_incr(struct nvhost_syncpt *sp, u32 id)
+{
+	struct nvhost_emu *emu = syncpt_to_dev(sp)->emu;
+	unsigned long flags;
+
+	if (!nvhost_syncpt_client_managed(sp, id)
+			&& nvhost_syncpt_min_eq_max(sp, id)) {
+		dev_err(&syncpt_to_dev(sp)->dev->dev,
+			"Trying to increment syncpoint id %d beyond max\n",
+			id);
+		nvhost_debug_dump(syncpt_to_dev(sp));
+		return;
+	}
+
+	spin_lock_irqsave(&emu->lock, flags);
+	emu->value[id]++;
+	nvhost_emu_raise_locked(emu, id);
+	spin_unlock_irqrestore(&emu->lock, flags);
+}
+
+/* Returns 0 when the lock is acquired, like the mlock registers */
+static int emu_syncpt_mutex_try_lock(struct nvhost_syncpt *sp,
+				     unsigned int idx)
+{
+	struct nvhost_emu *emu = syncpt_to_dev(sp)->emu;
+
+	return atomic_cmpxchg(&emu->mlock[idx], 0, 1) != 0;
+}
+
+static void emu_syncpt_mutex_unlock(struct nvhost_syncpt *sp,
+				    unsigned int idx)
+{
+	struct nvhost_emu *emu = syncpt_to_dev(sp)->emu;
+
+	atomic_set(&emu->mlock[idx], 0);
+}
+
+/* Channels never take mlocks here: the emulated engines don't parse
+ * the push buffer. */
+static void emu_syncpt_mutex_owner(struct nvhost_syncpt *sp,
+				   unsigned int idx,
+				   bool *cpu, bool *ch,
+				   unsigned int *chid)
+{
+	struct nvhost_emu *emu = syncpt_to_dev(sp)->emu;
+
+	*cpu = atomic_read(&emu->mlock[idx]);
+	*ch = false;
+	*chid = 0;
+}
+
+void emu_init_host1x_syncpt_ops(struct nvhost_syncpt_ops *ops)
+{
+	ops->reset = emu_syncpt_reset;
+	ops->update_min = emu_syncpt_update_min;
+	ops->cpu_incr = emu_syncpt_cpu_incr;
+	ops->mutex_try_lock = emu_syncpt_mutex_try_lock;
+	ops->mutex_unlock = emu_syncpt_mutex_unlock;
+	ops->mutex_owner = emu_syncpt_mutex_owner;
+}
@@ -45,6 +45,7 @@
 #include "nvhost_acm.h"
 #include "nvhost_channel.h"
 #include "nvhost_job.h"
+#include "nvhost_vm.h"
 #include "vhost/vhost.h"
 
 #ifdef CONFIG_TEGRA_GRHOST_SYNC
@@ -793,6 +794,10 @@ static int of_nvhost_parse_platform_data(struct platform_device *dev,
 			pdata->virtual_dev = true;
 	}
 
+	if (IS_ENABLED(CONFIG_TEGRA_GRHOST_EMU) &&
+	    of_property_read_bool(np, "nvidia,emulated"))
+		pdata->emulated_dev = true;
+
 	if (!of_property_read_u32(np, "nvidia,ch-base", &value))
 		host->info.ch_base = value;
 
@@ -928,7 +933,7 @@ static int nvhost_probe(struct platform_device *dev)
 			dev_err(&dev->dev, "failed to init virt support\n");
 			goto fail;
 		}
-	} else {
+	} else if (!pdata->emulated_dev) {
 		err = nvhost_device_get_resources(dev);
 		if (err) {
 			dev_err(&dev->dev, "failed to get resources\n");
@@ -980,8 +985,9 @@ static int nvhost_probe(struct platform_device *dev)
 		goto fail;
 
 	nvhost_syncpt_reset(&host->syncpt);
-	if (tegra_cpu_is_asim() || pdata->virtual_dev)
-		/* for simulation & virtualization, use a fake clock rate */
+	if (tegra_cpu_is_asim() || pdata->virtual_dev || pdata->emulated_dev)
+		/* for simulation, virtualization & emulation, use a fake
+		 * clock rate */
 		nvhost_intr_start(&host->intr, 12000000);
 	else
 		nvhost_intr_start(&host->intr, clk_get_rate(pdata->clk[0]));
@@ -1117,12 +1123,21 @@ static int __init nvhost_mod_init(void)
 	if (ret)
 		return ret;
 
-	return platform_driver_register(&platform_driver);
+	ret = nvhost_vm_pin_cache_init();
+	if (ret)
+		return ret;
+
+	ret = platform_driver_register(&platform_driver);
+	if (ret)
+		nvhost_vm_pin_cache_exit();
+
+	return ret;
 }
 
 static void __exit nvhost_mod_exit(void)
 {
 	platform_driver_unregister(&platform_driver);
+	nvhost_vm_pin_cache_exit();
 }
 
 /* host1x master device needs nvmap to be instantiated first.
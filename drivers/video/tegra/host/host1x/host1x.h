@@ -35,6 +35,7 @@
 struct nvhost_chip_support;
 struct nvhost_channel;
 struct mem_mgr;
+struct nvhost_emu;
 
 extern long linsim_cl;
 
@@ -104,6 +105,8 @@ struct nvhost_master {
 	struct list_head static_mappings_list;
 	struct list_head vm_list;
 	struct mutex vm_mutex;
+
+	struct nvhost_emu *emu;		/* software host1x, if emulated */
 };
 
 void nvhost_debug_init(struct nvhost_master *master);
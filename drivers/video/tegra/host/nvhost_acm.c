@@ -666,7 +666,7 @@ int nvhost_module_init(struct platform_device *dev)
 	pdata->num_clks = 0;
 	INIT_LIST_HEAD(&pdata->client_list);
 
-	if (nvhost_dev_is_virtual(dev)) {
+	if (nvhost_dev_is_virtual(dev) || nvhost_dev_is_emulated(dev)) {
 		pm_runtime_enable(&dev->dev);
 		return err;
 	}
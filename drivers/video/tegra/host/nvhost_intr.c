@@ -27,6 +27,8 @@
 #endif
 
 #include <linux/interrupt.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/irq.h>
 #include <trace/events/nvhost.h>
@@ -73,42 +75,80 @@ int nvhost_intr_release_time(void *ref, struct timespec *ts)
 	return 0;
 }
 
+static inline struct nvhost_waitlist *first_waiter(
+			struct nvhost_intr_syncpt *syncpt)
+{
+	if (!syncpt->wait_first)
+		return NULL;
+
+	return rb_entry(syncpt->wait_first, struct nvhost_waitlist, node);
+}
+
 /**
- * add a waiter to a waiter queue, sorted by threshold
- * returns true if it was added at the head of the queue
+ * add a waiter to a syncpoint's wait tree, sorted by threshold. Waiters
+ * with the same threshold are kept in the order they were added.
+ * returns true if it is now the waiter with the lowest threshold
  */
 static bool add_waiter_to_queue(struct nvhost_waitlist *waiter,
-				struct list_head *queue)
+				struct nvhost_intr_syncpt *syncpt)
 {
-	struct nvhost_waitlist *pos;
+	struct rb_node **p = &syncpt->wait_tree.rb_node;
+	struct rb_node *parent = NULL;
 	u32 thresh = waiter->thresh;
+	bool first = true;
+
+	while (*p) {
+		struct nvhost_waitlist *pos =
+			rb_entry(*p, struct nvhost_waitlist, node);
 
-	list_for_each_entry_reverse(pos, queue, list)
-		if ((s32)(pos->thresh - thresh) <= 0) {
-			list_add(&waiter->list, &pos->list);
-			return false;
+		parent = *p;
+		if ((s32)(thresh - pos->thresh) < 0) {
+			p = &parent->rb_left;
+		} else {
+			p = &parent->rb_right;
+			first = false;
 		}
+	}
+
+	rb_link_node(&waiter->node, parent, p);
+	rb_insert_color(&waiter->node, &syncpt->wait_tree);
+	if (first)
+		syncpt->wait_first = &waiter->node;
 
-	list_add(&waiter->list, queue);
-	return true;
+	if (++syncpt->nr_waiters > syncpt->max_waiters)
+		syncpt->max_waiters = syncpt->nr_waiters;
+
+	return first;
+}
+
+static void remove_waiter_from_queue(struct nvhost_waitlist *waiter,
+				     struct nvhost_intr_syncpt *syncpt)
+{
+	if (syncpt->wait_first == &waiter->node)
+		syncpt->wait_first = rb_next(&waiter->node);
+	rb_erase(&waiter->node, &syncpt->wait_tree);
+	syncpt->nr_waiters--;
 }
 
 /**
- * run through a waiter queue for a single sync point ID
- * and gather all completed waiters into lists by actions
+ * take the completed waiters off a single sync point's wait tree
+ * and gather them into lists by actions
+ * returns the number of waiters completed
  */
-static void remove_completed_waiters(struct list_head *head, u32 sync,
-			struct timespec isr_recv,
+static int remove_completed_waiters(struct nvhost_intr_syncpt *syncpt,
+			u32 sync,
 			struct list_head *completed[NVHOST_INTR_ACTION_COUNT])
 {
 	struct list_head *dest;
-	struct nvhost_waitlist *waiter, *next, *prev;
+	struct nvhost_waitlist *waiter, *prev;
+	int nr = 0;
 
-	list_for_each_entry_safe(waiter, next, head, list) {
-		if ((s32)(waiter->thresh - sync) > 0)
-			break;
+	while ((waiter = first_waiter(syncpt)) &&
+	       (s32)(waiter->thresh - sync) <= 0) {
+		remove_waiter_from_queue(waiter, syncpt);
+		nr++;
 
-		waiter->isr_recv = isr_recv;
+		waiter->isr_recv = syncpt->isr_recv;
 		dest = *(completed + waiter->action);
 
 		/* consolidate submit cleanups */
@@ -123,24 +163,22 @@ static void remove_completed_waiters(struct list_head *head, u32 sync,
 		}
 
 		/* PENDING->REMOVED or CANCELLED->HANDLED */
-		if (atomic_inc_return(&waiter->state) == WLS_HANDLED || !dest) {
-			list_del(&waiter->list);
+		if (atomic_inc_return(&waiter->state) == WLS_HANDLED || !dest)
 			kref_put(&waiter->refcount, waiter_release);
-		} else {
-			list_move_tail(&waiter->list, dest);
-		}
+		else
+			list_add_tail(&waiter->list, dest);
 	}
+
+	return nr;
 }
 
 static void reset_threshold_interrupt(struct nvhost_intr *intr,
-			       struct list_head *head,
-			       unsigned int id)
+			       struct nvhost_intr_syncpt *syncpt)
 {
-	u32 thresh = list_first_entry(head,
-				struct nvhost_waitlist, list)->thresh;
+	u32 thresh = first_waiter(syncpt)->thresh;
 
-	intr_op().set_syncpt_threshold(intr, id, thresh);
-	intr_op().enable_syncpt_intr(intr, id);
+	intr_op().set_syncpt_threshold(intr, syncpt->id, thresh);
+	intr_op().enable_syncpt_intr(intr, syncpt->id);
 }
 
 
@@ -223,13 +261,23 @@ static action_handler action_handlers[NVHOST_INTR_ACTION_COUNT] = {
 	action_notify,
 };
 
+static void run_handler(action_handler handler,
+			struct nvhost_waitlist *waiter)
+{
+	handler(waiter);
+	if (handler != action_wakeup_interruptible &&
+	    handler != action_wakeup)
+		WARN_ON(atomic_xchg(&waiter->state, WLS_HANDLED)
+			!= WLS_REMOVED);
+	kref_put(&waiter->refcount, waiter_release);
+}
+
 static void run_handlers(struct list_head *completed[NVHOST_INTR_ACTION_COUNT])
 {
 	int i;
 
 	for (i = 0; i < NVHOST_INTR_ACTION_COUNT; ++i) {
 		struct list_head *head = completed[i];
-		action_handler handler = action_handlers[i];
 		struct nvhost_waitlist *waiter, *next;
 
 		if (!head)
@@ -237,12 +285,7 @@ static void run_handlers(struct list_head *completed[NVHOST_INTR_ACTION_COUNT])
 
 		list_for_each_entry_safe(waiter, next, head, list) {
 			list_del(&waiter->list);
-			handler(waiter);
-			if (handler != action_wakeup_interruptible &&
-			    handler != action_wakeup)
-				WARN_ON(atomic_xchg(&waiter->state, WLS_HANDLED)
-					!= WLS_REMOVED);
-			kref_put(&waiter->refcount, waiter_release);
+			run_handler(action_handlers[i], waiter);
 		}
 	}
 }
@@ -254,50 +297,62 @@ static int process_wait_list(struct nvhost_intr *intr,
 			     struct nvhost_intr_syncpt *syncpt,
 			     u32 threshold)
 {
-	struct list_head *completed[NVHOST_INTR_ACTION_COUNT] = {NULL};
-	struct list_head high_prio_handlers[NVHOST_INTR_HIGH_PRIO_COUNT];
+	struct list_head *completed[NVHOST_INTR_ACTION_COUNT];
+	struct list_head handlers[NVHOST_INTR_ACTION_COUNT];
 	bool run_low_prio_work = false;
-	unsigned int i, j;
-	int empty;
-
-	/* take lock on waiter list */
-	spin_lock(&syncpt->lock);
+	ktime_t start;
+	unsigned int i;
+	int empty, nr;
+	u64 ns;
 
-	/* keep high priority workers in local list */
-	for (i = 0; i < NVHOST_INTR_HIGH_PRIO_COUNT; ++i) {
-		INIT_LIST_HEAD(high_prio_handlers + i);
-		completed[i] = high_prio_handlers + i;
+	for (i = 0; i < NVHOST_INTR_ACTION_COUNT; ++i) {
+		INIT_LIST_HEAD(handlers + i);
+		completed[i] = handlers + i;
 	}
 
-	/* .. and low priority workers in global list */
-	for (j = 0; i < NVHOST_INTR_ACTION_COUNT; ++i, ++j)
-		completed[i] = syncpt->low_prio_handlers + j;
+	/* take lock on waiter list */
+	start = ktime_get();
+	spin_lock(&syncpt->lock);
 
 	/* this functions fills completed data */
-	remove_completed_waiters(&syncpt->wait_head, threshold,
-		syncpt->isr_recv, completed);
+	nr = remove_completed_waiters(syncpt, threshold, completed);
 
 	/* check if there are still waiters left */
-	empty = list_empty(&syncpt->wait_head);
+	empty = !syncpt->wait_first;
 
-	/* if not, disable interrupt. If yes, update the inetrrupt */
+	/* if not, disable interrupt. If yes, program the lowest threshold
+	 * left, once for all the waiters this pass completed */
 	if (empty)
 		intr_op().disable_syncpt_intr(intr, syncpt->id);
 	else
-		reset_threshold_interrupt(intr, &syncpt->wait_head,
-					  syncpt->id);
+		reset_threshold_interrupt(intr, syncpt);
+
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	syncpt->nr_passes++;
+	syncpt->nr_completed += nr;
+	syncpt->pass_ns += ns;
+	if (ns > syncpt->max_pass_ns)
+		syncpt->max_pass_ns = ns;
 
-	/* remove low priority handlers from this list */
+	/* release waiter lock */
+	spin_unlock(&syncpt->lock);
+
+	/* hand low priority handlers over to the work, which takes them
+	 * without going through the waiter lock */
 	for (i = NVHOST_INTR_HIGH_PRIO_COUNT;
 	     i < NVHOST_INTR_ACTION_COUNT; ++i) {
-		if (!list_empty(completed[i]))
+		struct llist_head *low_prio = syncpt->low_prio_handlers +
+			(i - NVHOST_INTR_HIGH_PRIO_COUNT);
+		struct nvhost_waitlist *waiter, *next;
+
+		list_for_each_entry_safe(waiter, next, completed[i], list) {
+			list_del(&waiter->list);
+			llist_add(&waiter->llnode, low_prio);
 			run_low_prio_work = true;
+		}
 		completed[i] = NULL;
 	}
 
-	/* release waiter lock */
-	spin_unlock(&syncpt->lock);
-
 	run_handlers(completed);
 
 	/* schedule a separate task to handle low priority handlers */
@@ -312,30 +367,21 @@ static void nvhost_syncpt_low_prio_work(struct work_struct *work)
 	struct nvhost_intr_syncpt *syncpt = container_of(work,
 						     struct nvhost_intr_syncpt,
 						     low_prio_work);
-	struct list_head *completed[NVHOST_INTR_ACTION_COUNT] = {NULL};
-	struct list_head low_prio_handlers[NVHOST_INTR_LOW_PRIO_COUNT];
-	unsigned int i, j;
+	unsigned int i;
 
-	/* go through low priority handlers.. */
-	spin_lock(&syncpt->lock);
-	for (i = 0, j = NVHOST_INTR_HIGH_PRIO_COUNT;
-	     j < NVHOST_INTR_ACTION_COUNT;
-	     i++, j++) {
-		struct list_head *handler = low_prio_handlers + i;
-
-		/* move entries from low priority queue into local queue */
-		INIT_LIST_HEAD(handler);
-		list_cut_position(handler,
-				  &syncpt->low_prio_handlers[i],
-				  syncpt->low_prio_handlers[i].prev);
-
-		/* maintain local completed list */
-		completed[j] = handler;
-	}
-	spin_unlock(&syncpt->lock);
+	for (i = 0; i < NVHOST_INTR_LOW_PRIO_COUNT; i++) {
+		action_handler handler =
+			action_handlers[NVHOST_INTR_HIGH_PRIO_COUNT + i];
+		struct nvhost_waitlist *waiter, *next;
+		struct llist_node *first;
 
-	/* ..and run them */
-	run_handlers(completed);
+		/* llist hands the entries back newest first */
+		first = llist_del_all(&syncpt->low_prio_handlers[i]);
+		first = llist_reverse_order(first);
+
+		llist_for_each_entry_safe(waiter, next, first, llnode)
+			run_handler(handler, waiter);
+	}
 }
 
 /*** host syncpt interrupt service functions ***/
@@ -371,18 +417,20 @@ bool nvhost_intr_has_pending_jobs(struct nvhost_intr *intr, u32 id,
 {
 	struct nvhost_intr_syncpt *syncpt;
 	struct nvhost_waitlist *waiter;
+	struct rb_node *node;
 	bool res = false;
 
 	syncpt = intr->syncpt + id;
 	spin_lock(&syncpt->lock);
-	list_for_each_entry(waiter, &syncpt->wait_head, list)
+	for (node = syncpt->wait_first; node; node = rb_next(node)) {
+		waiter = rb_entry(node, struct nvhost_waitlist, node);
 		if (((waiter->action ==
 			NVHOST_INTR_ACTION_SUBMIT_COMPLETE) &&
 			(waiter->data != exclude_data))) {
 			res = true;
 			break;
 		}
-
+	}
 	spin_unlock(&syncpt->lock);
 
 	return res;
@@ -403,6 +451,7 @@ int nvhost_intr_add_action(struct nvhost_intr *intr, u32 id, u32 thresh,
 	}
 
 	/* initialize a new waiter */
+	RB_CLEAR_NODE(&waiter->node);
 	INIT_LIST_HEAD(&waiter->list);
 	init_waitqueue_head(&waiter->wq);
 	kref_init(&waiter->refcount);
@@ -418,10 +467,10 @@ int nvhost_intr_add_action(struct nvhost_intr *intr, u32 id, u32 thresh,
 
 	spin_lock(&syncpt->lock);
 
-	queue_was_empty = list_empty(&syncpt->wait_head);
+	queue_was_empty = !syncpt->wait_first;
 
-	if (add_waiter_to_queue(waiter, &syncpt->wait_head)) {
-		/* added at head of list - new threshold value */
+	if (add_waiter_to_queue(waiter, syncpt)) {
+		/* lowest threshold waiting - new threshold value */
 		intr_op().set_syncpt_threshold(intr, id, thresh);
 
 		/* added as first waiter - enable interrupt */
@@ -532,6 +581,66 @@ void nvhost_intr_put_ref(struct nvhost_intr *intr, u32 id, void *ref)
 	kref_put(&waiter->refcount, waiter_release);
 }
 
+#ifdef CONFIG_DEBUG_FS
+static int nvhost_intr_stats_show(struct seq_file *s, void *unused)
+{
+	struct nvhost_intr *intr = s->private;
+	u32 nb_pts = nvhost_syncpt_nb_hw_pts(&intr_to_dev(intr)->syncpt);
+	unsigned int id;
+
+	seq_printf(s, "%-4s %8s %8s %10s %10s %10s %10s\n", "id", "waiters",
+		   "max", "passes", "completed", "avg_ns", "max_ns");
+
+	for (id = 0; id < nb_pts; id++) {
+		struct nvhost_intr_syncpt *syncpt = intr->syncpt + id;
+		u32 nr_waiters, max_waiters;
+		u64 nr_passes, nr_completed, pass_ns, max_pass_ns;
+
+		spin_lock(&syncpt->lock);
+		nr_waiters = syncpt->nr_waiters;
+		max_waiters = syncpt->max_waiters;
+		nr_passes = syncpt->nr_passes;
+		nr_completed = syncpt->nr_completed;
+		pass_ns = syncpt->pass_ns;
+		max_pass_ns = syncpt->max_pass_ns;
+		spin_unlock(&syncpt->lock);
+
+		if (!max_waiters && !nr_passes)
+			continue;
+
+		seq_printf(s, "%-4u %8u %8u %10llu %10llu %10llu %10llu\n",
+			   id, nr_waiters, max_waiters, nr_passes,
+			   nr_completed,
+			   nr_passes ? div64_u64(pass_ns, nr_passes) : 0,
+			   max_pass_ns);
+	}
+
+	return 0;
+}
+
+static int nvhost_intr_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvhost_intr_stats_show, inode->i_private);
+}
+
+static const struct file_operations nvhost_intr_stats_fops = {
+	.open		= nvhost_intr_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+/**
+ * Per syncpoint wait tree statistics: waiters queued now and at most, and
+ * how many passes over the tree completed how many waiters, with the time
+ * each pass held the waiter lock.
+ */
+void nvhost_intr_debug_init(struct nvhost_intr *intr, struct dentry *de)
+{
+	debugfs_create_file("intr_stats", S_IRUGO, de, intr,
+			    &nvhost_intr_stats_fops);
+}
+#endif
 
 /*** Init & shutdown ***/
 
@@ -552,12 +661,13 @@ int nvhost_intr_init(struct nvhost_intr *intr, u32 irq_gen, u32 irq_sync)
 		syncpt->intr = &host->intr;
 		syncpt->id = id;
 		spin_lock_init(&syncpt->lock);
-		INIT_LIST_HEAD(&syncpt->wait_head);
+		syncpt->wait_tree = RB_ROOT;
+		syncpt->wait_first = NULL;
 		snprintf(syncpt->thresh_irq_name,
 			sizeof(syncpt->thresh_irq_name),
 			"host_sp_%02d", id);
 		for (i = 0; i < NVHOST_INTR_LOW_PRIO_COUNT; ++i)
-			INIT_LIST_HEAD(syncpt->low_prio_handlers + i);
+			init_llist_head(syncpt->low_prio_handlers + i);
 		INIT_WORK(&syncpt->low_prio_work,
 			  nvhost_syncpt_low_prio_work);
 	}
@@ -596,16 +706,21 @@ void nvhost_intr_stop(struct nvhost_intr *intr)
 	for (id = 0, syncpt = intr->syncpt;
 	     id < nb_pts;
 	     ++id, ++syncpt) {
-		struct nvhost_waitlist *waiter, *next;
-		list_for_each_entry_safe(waiter, next, &syncpt->wait_head, list) {
+		struct rb_node *node = syncpt->wait_first;
+
+		while (node) {
+			struct nvhost_waitlist *waiter =
+				rb_entry(node, struct nvhost_waitlist, node);
+
+			node = rb_next(node);
 			if (atomic_cmpxchg(&waiter->state, WLS_CANCELLED, WLS_HANDLED)
 				== WLS_CANCELLED) {
-				list_del(&waiter->list);
+				remove_waiter_from_queue(waiter, syncpt);
 				kref_put(&waiter->refcount, waiter_release);
 			}
 		}
 
-		if (!list_empty(&syncpt->wait_head)) {  /* output diagnostics */
+		if (syncpt->wait_first) {  /* output diagnostics */
 			mutex_unlock(&intr->mutex);
 			pr_warn("%s cannot stop syncpt intr id=%d\n",
 					__func__, id);
@@ -26,9 +26,12 @@
 #include <linux/interrupt.h>
 #include <linux/workqueue.h>
 #include <linux/spinlock.h>
+#include <linux/rbtree.h>
+#include <linux/llist.h>
 
 struct nvhost_channel;
 struct platform_device;
+struct dentry;
 
 enum nvhost_intr_action {
 	/**
@@ -79,7 +82,9 @@ enum nvhost_intr_action {
 struct nvhost_intr;
 
 struct nvhost_waitlist {
-	struct list_head list;
+	struct rb_node node;		/* in the syncpoint's wait tree */
+	struct list_head list;		/* on a completed list */
+	struct llist_node llnode;	/* handed to the low priority work */
 	struct kref refcount;
 	u32 thresh;
 	enum nvhost_intr_action action;
@@ -94,11 +99,21 @@ struct nvhost_intr_syncpt {
 	struct nvhost_intr *intr;
 	u8 id;
 	spinlock_t lock;
-	struct list_head wait_head;
+	/* pending waiters ordered by threshold; wait_first is the lowest */
+	struct rb_root wait_tree;
+	struct rb_node *wait_first;
 	char thresh_irq_name[12];
 	struct timespec isr_recv;
 	struct work_struct low_prio_work;
-	struct list_head low_prio_handlers[NVHOST_INTR_LOW_PRIO_COUNT];
+	struct llist_head low_prio_handlers[NVHOST_INTR_LOW_PRIO_COUNT];
+
+	/* statistics, under lock */
+	u32 nr_waiters;
+	u32 max_waiters;
+	u64 nr_passes;			/* wait list passes */
+	u64 nr_completed;		/* waiters completed by them */
+	u64 pass_ns;			/* total time they held the lock */
+	u64 max_pass_ns;
 };
 
 struct nvhost_intr {
@@ -156,6 +171,7 @@ void nvhost_intr_enable_host_irq(struct nvhost_intr *intr, int irq,
 void nvhost_intr_disable_host_irq(struct nvhost_intr *intr, int irq);
 
 irqreturn_t nvhost_syncpt_thresh_fn(void *dev_id);
+void nvhost_intr_debug_init(struct nvhost_intr *intr, struct dentry *de);
 irqreturn_t nvhost_intr_irq_fn(int irq, void *dev_id);
 void nvhost_scale_actmon_irq(struct platform_device *pdev, int type);
 
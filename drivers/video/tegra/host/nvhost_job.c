@@ -285,16 +285,30 @@ static int id_cmp(const void *_id1, const void *_id2)
 	return 0;
 }
 
-static int pin_array_ids(struct platform_device *dev,
+static void unpin_one(struct nvhost_job_unpin *unpin)
+{
+	if (unpin->pin) {
+		nvhost_vm_unpin_buffer(unpin->pin);
+	} else {
+		dma_buf_unmap_attachment(unpin->attach, unpin->sgt,
+						DMA_BIDIRECTIONAL);
+		dma_buf_detach(unpin->buf, unpin->attach);
+	}
+	dma_buf_put(unpin->buf);
+}
+
+static int pin_array_ids(struct nvhost_vm *vm,
+		struct platform_device *dev,
 		struct nvhost_pinid *ids,
 		dma_addr_t *phys_addr,
 		u32 count,
 		struct nvhost_job_unpin *unpin_data)
 {
-	int i, pin_count = 0;
+	int i, err, pin_count = 0;
 	struct sg_table *sgt;
 	struct dma_buf *buf;
 	struct dma_buf_attachment *attach;
+	struct nvhost_vm_pin *pin;
 	u32 prev_id = 0;
 	dma_addr_t prev_addr = 0;
 
@@ -310,16 +324,42 @@ static int pin_array_ids(struct platform_device *dev,
 		}
 
 		buf = dma_buf_get(ids[i].id);
-		if (IS_ERR(buf))
-			return -EINVAL;
+		if (IS_ERR(buf)) {
+			err = -EINVAL;
+			goto fail;
+		}
+
+		/* buffers pinned by earlier submits are a lookup */
+		if (nvhost_vm_pin_cache_enabled) {
+			pin = nvhost_vm_pin_buffer(vm, &dev->dev, buf,
+					&phys_addr[ids[i].index]);
+			if (IS_ERR(pin)) {
+				err = PTR_ERR(pin);
+				goto fail_put;
+			}
+
+			unpin_data[pin_count].buf = buf;
+			unpin_data[pin_count].attach = NULL;
+			unpin_data[pin_count].sgt = NULL;
+			unpin_data[pin_count++].pin = pin;
+
+			prev_id = ids[i].id;
+			prev_addr = phys_addr[ids[i].index];
+			continue;
+		}
 
 		attach = dma_buf_attach(buf, &dev->dev);
-		if (IS_ERR(attach))
-			return PTR_ERR(attach);
+		if (IS_ERR(attach)) {
+			err = PTR_ERR(attach);
+			goto fail_put;
+		}
 
 		sgt = dma_buf_map_attachment(attach, DMA_BIDIRECTIONAL);
-		if (IS_ERR(sgt))
-			return PTR_ERR(sgt);
+		if (IS_ERR(sgt)) {
+			err = PTR_ERR(sgt);
+			dma_buf_detach(buf, attach);
+			goto fail_put;
+		}
 
 		if (!sg_dma_address(sgt->sgl))
 			sg_dma_address(sgt->sgl) = sg_phys(sgt->sgl);
@@ -327,12 +367,21 @@ static int pin_array_ids(struct platform_device *dev,
 		phys_addr[ids[i].index] = sg_dma_address(sgt->sgl);
 		unpin_data[pin_count].buf = buf;
 		unpin_data[pin_count].attach = attach;
+		unpin_data[pin_count].pin = NULL;
 		unpin_data[pin_count++].sgt = sgt;
 
 		prev_id = ids[i].id;
 		prev_addr = phys_addr[ids[i].index];
 	}
 	return pin_count;
+
+fail_put:
+	dma_buf_put(buf);
+fail:
+	/* the caller only unpins what earlier calls pinned */
+	while (pin_count--)
+		unpin_one(&unpin_data[pin_count]);
+	return err;
 }
 
 static int pin_job_mem(struct nvhost_job *job)
@@ -349,7 +398,7 @@ static int pin_job_mem(struct nvhost_job *job)
 	}
 
 	/* validate array and pin unique ids, get refs for reloc unpinning */
-	result = pin_array_ids(job->ch->vm->pdev,
+	result = pin_array_ids(job->ch->vm, job->ch->vm->pdev,
 		job->pin_ids, job->addr_phys,
 		job->num_relocs,
 		job->unpins);
@@ -366,7 +415,8 @@ static int pin_job_mem(struct nvhost_job *job)
 	}
 
 	/* validate array and pin unique ids, get refs for gather unpinning */
-	result = pin_array_ids(nvhost_get_host(job->ch->dev)->dev,
+	result = pin_array_ids(job->ch->vm,
+		nvhost_get_host(job->ch->dev)->dev,
 		&job->pin_ids[job->num_relocs],
 		&job->addr_phys[job->num_relocs],
 		job->num_gathers,
@@ -508,14 +558,8 @@ void nvhost_job_unpin(struct nvhost_job *job)
 {
 	int i;
 
-	for (i = 0; i < job->num_unpins; i++) {
-		struct nvhost_job_unpin *unpin = &job->unpins[i];
-
-		dma_buf_unmap_attachment(unpin->attach, unpin->sgt,
-						DMA_BIDIRECTIONAL);
-		dma_buf_detach(unpin->buf, unpin->attach);
-		dma_buf_put(unpin->buf);
-	}
+	for (i = 0; i < job->num_unpins; i++)
+		unpin_one(&job->unpins[i]);
 	job->num_unpins = 0;
 }
 
@@ -28,6 +28,7 @@
 struct nvhost_channel;
 struct nvhost_waitchk;
 struct nvhost_syncpt;
+struct nvhost_vm_pin;
 struct sg_table;
 
 struct nvhost_job_gather {
@@ -56,6 +57,7 @@ struct nvhost_job_unpin {
 	struct sg_table *sgt;
 	struct dma_buf *buf;
 	struct dma_buf_attachment *attach;
+	struct nvhost_vm_pin *pin;	/* instead of sgt and attach if cached */
 };
 
 /*
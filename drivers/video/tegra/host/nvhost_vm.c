@@ -20,11 +20,231 @@
 #include <linux/list.h>
 #include <linux/slab.h>
 #include <linux/dma-buf.h>
+#include <linux/notifier.h>
+#include <linux/scatterlist.h>
 
 #include "chip_support.h"
 #include "nvhost_vm.h"
 #include "dev.h"
 
+/* number of buffers each vm keeps pinned once their jobs are done */
+#define NVHOST_VM_PIN_CACHE_SIZE	128
+
+struct nvhost_vm_pin {
+	struct rb_node node;		/* in vm->pin_tree, by buf and dev */
+	struct list_head lru;		/* on vm->pin_lru, most recent first */
+	struct kref kref;		/* held by the cache and by jobs */
+
+	struct dma_buf *buf;
+	struct device *dev;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+	dma_addr_t addr;
+};
+
+u32 nvhost_vm_pin_cache_enabled;
+
+static DEFINE_MUTEX(nvhost_vm_list_lock);
+static LIST_HEAD(nvhost_vm_list);
+
+static int pin_cmp(struct dma_buf *buf, struct device *dev,
+		   struct nvhost_vm_pin *pin)
+{
+	if (buf != pin->buf)
+		return buf < pin->buf ? -1 : 1;
+	if (dev != pin->dev)
+		return dev < pin->dev ? -1 : 1;
+
+	return 0;
+}
+
+/* returns the pin of @buf for @dev, or where to link it */
+static struct nvhost_vm_pin *find_pin(struct nvhost_vm *vm,
+				      struct dma_buf *buf, struct device *dev,
+				      struct rb_node ***link,
+				      struct rb_node **parent)
+{
+	struct rb_node **p = &vm->pin_tree.rb_node;
+
+	*parent = NULL;
+	while (*p) {
+		struct nvhost_vm_pin *pin =
+			rb_entry(*p, struct nvhost_vm_pin, node);
+		int cmp = pin_cmp(buf, dev, pin);
+
+		if (!cmp)
+			return pin;
+
+		*parent = *p;
+		p = cmp < 0 ? &(*p)->rb_left : &(*p)->rb_right;
+	}
+
+	*link = p;
+	return NULL;
+}
+
+/* returns the first pin of @buf, whatever the device */
+static struct nvhost_vm_pin *find_buf_pin(struct nvhost_vm *vm,
+					  struct dma_buf *buf)
+{
+	struct rb_node *n = vm->pin_tree.rb_node;
+	struct nvhost_vm_pin *found = NULL;
+
+	while (n) {
+		struct nvhost_vm_pin *pin =
+			rb_entry(n, struct nvhost_vm_pin, node);
+
+		if (pin->buf < buf) {
+			n = n->rb_right;
+		} else {
+			if (pin->buf == buf)
+				found = pin;
+			n = n->rb_left;
+		}
+	}
+
+	return found;
+}
+
+static void pin_release(struct kref *kref)
+{
+	struct nvhost_vm_pin *pin =
+		container_of(kref, struct nvhost_vm_pin, kref);
+
+	dma_buf_unmap_attachment(pin->attach, pin->sgt, DMA_BIDIRECTIONAL);
+	dma_buf_detach(pin->buf, pin->attach);
+	kfree(pin);
+}
+
+/* drops the cache's reference to @pin; vm->pin_lock must be held */
+static void evict_pin(struct nvhost_vm *vm, struct nvhost_vm_pin *pin)
+{
+	rb_erase(&pin->node, &vm->pin_tree);
+	list_del(&pin->lru);
+	vm->num_pins--;
+	kref_put(&pin->kref, pin_release);
+}
+
+static void flush_pins(struct nvhost_vm *vm)
+{
+	mutex_lock(&vm->pin_lock);
+	while (!list_empty(&vm->pin_lru))
+		evict_pin(vm, list_first_entry(&vm->pin_lru,
+					       struct nvhost_vm_pin, lru));
+	mutex_unlock(&vm->pin_lock);
+}
+
+struct nvhost_vm_pin *nvhost_vm_pin_buffer(struct nvhost_vm *vm,
+					   struct device *dev,
+					   struct dma_buf *buf,
+					   dma_addr_t *addr)
+{
+	struct rb_node **link, *parent;
+	struct nvhost_vm_pin *pin;
+	int err;
+
+	mutex_lock(&vm->pin_lock);
+
+	pin = find_pin(vm, buf, dev, &link, &parent);
+	if (pin) {
+		list_move(&pin->lru, &vm->pin_lru);
+		goto out;
+	}
+
+	pin = kzalloc(sizeof(*pin), GFP_KERNEL);
+	if (!pin) {
+		err = -ENOMEM;
+		goto err_alloc;
+	}
+
+	pin->attach = dma_buf_attach(buf, dev);
+	if (IS_ERR(pin->attach)) {
+		err = PTR_ERR(pin->attach);
+		goto err_attach;
+	}
+
+	pin->sgt = dma_buf_map_attachment(pin->attach, DMA_BIDIRECTIONAL);
+	if (IS_ERR(pin->sgt)) {
+		err = PTR_ERR(pin->sgt);
+		goto err_map;
+	}
+
+	if (!sg_dma_address(pin->sgt->sgl))
+		sg_dma_address(pin->sgt->sgl) = sg_phys(pin->sgt->sgl);
+
+	pin->buf = buf;
+	pin->dev = dev;
+	pin->addr = sg_dma_address(pin->sgt->sgl);
+	kref_init(&pin->kref);
+
+	rb_link_node(&pin->node, parent, link);
+	rb_insert_color(&pin->node, &vm->pin_tree);
+	list_add(&pin->lru, &vm->pin_lru);
+
+	/* the least recently used buffer is unpinned once no job uses it */
+	if (++vm->num_pins > NVHOST_VM_PIN_CACHE_SIZE)
+		evict_pin(vm, list_entry(vm->pin_lru.prev,
+					 struct nvhost_vm_pin, lru));
+
+out:
+	kref_get(&pin->kref);
+	*addr = pin->addr;
+	mutex_unlock(&vm->pin_lock);
+
+	return pin;
+
+err_map:
+	dma_buf_detach(buf, pin->attach);
+err_attach:
+	kfree(pin);
+err_alloc:
+	mutex_unlock(&vm->pin_lock);
+	return ERR_PTR(err);
+}
+
+void nvhost_vm_unpin_buffer(struct nvhost_vm_pin *pin)
+{
+	kref_put(&pin->kref, pin_release);
+}
+
+/*
+ * Cached pins don't hold a reference to their buffer, so drop them before
+ * the buffer goes away. Jobs do hold a reference, so none of them is using
+ * the pins at this point.
+ */
+static int nvhost_vm_buf_release(struct notifier_block *nb,
+				 unsigned long action, void *data)
+{
+	struct dma_buf *buf = data;
+	struct nvhost_vm_pin *pin;
+	struct nvhost_vm *vm;
+
+	mutex_lock(&nvhost_vm_list_lock);
+	list_for_each_entry(vm, &nvhost_vm_list, vm_list) {
+		mutex_lock(&vm->pin_lock);
+		while ((pin = find_buf_pin(vm, buf)))
+			evict_pin(vm, pin);
+		mutex_unlock(&vm->pin_lock);
+	}
+	mutex_unlock(&nvhost_vm_list_lock);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block nvhost_vm_buf_nb = {
+	.notifier_call = nvhost_vm_buf_release,
+};
+
+int nvhost_vm_pin_cache_init(void)
+{
+	return dma_buf_register_release_notifier(&nvhost_vm_buf_nb);
+}
+
+void nvhost_vm_pin_cache_exit(void)
+{
+	dma_buf_unregister_release_notifier(&nvhost_vm_buf_nb);
+}
+
 int nvhost_vm_init_device(struct platform_device *pdev)
 {
 	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
@@ -58,6 +278,12 @@ static void nvhost_vm_deinit(struct kref *kref)
 {
 	struct nvhost_vm *vm = container_of(kref, struct nvhost_vm, kref);
 
+	mutex_lock(&nvhost_vm_list_lock);
+	list_del(&vm->vm_list);
+	mutex_unlock(&nvhost_vm_list_lock);
+
+	flush_pins(vm);
+
 	if (vm_op().deinit && vm->enable_hw)
 		vm_op().deinit(vm);
 
@@ -89,6 +315,9 @@ struct nvhost_vm *nvhost_vm_allocate(struct platform_device *pdev)
 	kref_init(&vm->kref);
 	vm->pdev = pdev;
 	vm->enable_hw = pdata->isolate_contexts;
+	mutex_init(&vm->pin_lock);
+	vm->pin_tree = RB_ROOT;
+	INIT_LIST_HEAD(&vm->pin_lru);
 
 	if (vm_op().init && vm->enable_hw) {
 		err = vm_op().init(vm);
@@ -96,6 +325,10 @@ struct nvhost_vm *nvhost_vm_allocate(struct platform_device *pdev)
 			goto err_init;
 	}
 
+	mutex_lock(&nvhost_vm_list_lock);
+	list_add(&vm->vm_list, &nvhost_vm_list);
+	mutex_unlock(&nvhost_vm_list_lock);
+
 	return vm;
 
 err_init:
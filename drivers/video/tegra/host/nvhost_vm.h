@@ -20,12 +20,18 @@
 #define NVHOST_VM_H
 
 #include <linux/kref.h>
+#include <linux/mutex.h>
+#include <linux/rbtree.h>
 
 struct platform_device;
 struct nvhost_vm_pin;
 struct dma_buf;
 struct dma_buf_attachment;
 struct sg_table;
+struct device;
+
+/* off by default, set through tegra_host/pin_cache in debugfs */
+extern u32 nvhost_vm_pin_cache_enabled;
 
 struct nvhost_vm {
 	struct platform_device *pdev;
@@ -38,6 +44,15 @@ struct nvhost_vm {
 
 	/* marks if hardware isolation is enabled */
 	bool enable_hw;
+
+	/* buffers kept pinned between submits, see nvhost_vm_pin_buffer() */
+	struct mutex pin_lock;
+	struct rb_root pin_tree;
+	struct list_head pin_lru;
+	int num_pins;
+
+	/* entry in the list of all vms */
+	struct list_head vm_list;
 };
 
 struct nvhost_vm_static_buffer {
@@ -118,4 +133,38 @@ void nvhost_vm_get(struct nvhost_vm *vm);
  */
 struct nvhost_vm *nvhost_vm_allocate(struct platform_device *pdev);
 
+/**
+ * nvhost_vm_pin_buffer - pin a buffer through the vm's pin cache
+ *	@vm: Pointer to nvhost_vm structure
+ *	@dev: device the buffer is mapped for
+ *	@buf: buffer to pin; the caller holds a reference on it
+ *	@addr: returns the address of the buffer for @dev
+ *
+ * Buffers stay attached and mapped after the job using them is done, so
+ * that pinning them again for the next submit is a lookup. They are unpinned
+ * once the cache is full and they are the least recently used, when the
+ * buffer is released, or with the vm.
+ *
+ * Returns the pin to release with nvhost_vm_unpin_buffer() after the
+ * job completes, or an ERR_PTR.
+ */
+struct nvhost_vm_pin *nvhost_vm_pin_buffer(struct nvhost_vm *vm,
+					   struct device *dev,
+					   struct dma_buf *buf,
+					   dma_addr_t *addr);
+
+/**
+ * nvhost_vm_unpin_buffer - release a pin taken with nvhost_vm_pin_buffer()
+ *	@pin: Pointer to the pin
+ */
+void nvhost_vm_unpin_buffer(struct nvhost_vm_pin *pin);
+
+/**
+ * nvhost_vm_pin_cache_init - start tracking buffer releases
+ *
+ * Called once at driver initialization. Returns 0 on success.
+ */
+int nvhost_vm_pin_cache_init(void);
+void nvhost_vm_pin_cache_exit(void);
+
 #endif
@@ -40,6 +40,7 @@
 #include "chip_support.h"
 #include "nvhost_scale.h"
 #include "vhost/vhost.h"
+#include "emu/emu.h"
 
 #include "../../../../arch/arm/mach-tegra/iomap.h"
 
@@ -481,6 +482,10 @@ int nvhost_init_t124_channel_support(struct nvhost_master *host,
 
 static void t124_remove_support(struct nvhost_chip_support *op)
 {
+	struct t124 *t124 = op->priv;
+
+	if (t124)
+		nvhost_emu_deinit(t124->host);
 	kfree(op->priv);
 	op->priv = NULL;
 }
@@ -527,6 +532,13 @@ int nvhost_init_t124_support(struct nvhost_master *host,
 		vhost_init_host1x_debug_ops(&op->debug);
 	}
 
+	if (nvhost_dev_is_emulated(host->dev)) {
+		data->can_powergate = false;
+		err = nvhost_emu_init(host, op);
+		if (err)
+			return err;
+	}
+
 	t124 = kzalloc(sizeof(struct t124), GFP_KERNEL);
 	if (!t124) {
 		err = -ENOMEM;
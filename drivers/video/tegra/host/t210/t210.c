@@ -44,6 +44,7 @@
 
 #include "chip_support.h"
 #include "nvhost_scale.h"
+#include "emu/emu.h"
 
 #include "cg_regs.c"
 
@@ -390,6 +391,10 @@ static int nvhost_init_t210_channel_support(struct nvhost_master *host,
 
 static void t210_remove_support(struct nvhost_chip_support *op)
 {
+	struct t124 *t210 = op->priv;
+
+	if (t210)
+		nvhost_emu_deinit(t210->host);
 	kfree(op->priv);
 	op->priv = NULL;
 }
@@ -406,6 +411,7 @@ int nvhost_init_t210_support(struct nvhost_master *host,
 {
 	int err;
 	struct t124 *t210 = NULL;
+	struct nvhost_device_data *data = platform_get_drvdata(host->dev);
 
 	op->soc_name = "tegra21x";
 
@@ -422,6 +428,13 @@ int nvhost_init_t210_support(struct nvhost_master *host,
 	op->intr = host1x_intr_ops;
 	op->actmon = host1x_actmon_ops;
 
+	if (nvhost_dev_is_emulated(host->dev)) {
+		data->can_powergate = false;
+		err = nvhost_emu_init(host, op);
+		if (err)
+			return err;
+	}
+
 	t210 = kzalloc(sizeof(struct t124), GFP_KERNEL);
 	if (!t210) {
 		err = -ENOMEM;
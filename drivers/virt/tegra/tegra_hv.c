@@ -1014,6 +1014,42 @@ int tegra_hv_ivc_read_advance(struct tegra_hv_ivc_cookie *ivck)
 }
 EXPORT_SYMBOL(tegra_hv_ivc_read_advance);
 
+int tegra_hv_ivc_read_get_frames(struct tegra_hv_ivc_cookie *ivck,
+		void **frames, unsigned max)
+{
+	struct ivc *ivc = &cookie_to_ivc_dev(ivck)->ivc;
+
+	return tegra_ivc_read_get_frames(ivc, frames, max);
+}
+EXPORT_SYMBOL(tegra_hv_ivc_read_get_frames);
+
+int tegra_hv_ivc_read_advance_frames(struct tegra_hv_ivc_cookie *ivck,
+		unsigned count)
+{
+	struct ivc *ivc = &cookie_to_ivc_dev(ivck)->ivc;
+
+	return tegra_ivc_read_advance_frames(ivc, count);
+}
+EXPORT_SYMBOL(tegra_hv_ivc_read_advance_frames);
+
+int tegra_hv_ivc_write_get_frames(struct tegra_hv_ivc_cookie *ivck,
+		void **frames, unsigned max)
+{
+	struct ivc *ivc = &cookie_to_ivc_dev(ivck)->ivc;
+
+	return tegra_ivc_write_get_frames(ivc, frames, max);
+}
+EXPORT_SYMBOL(tegra_hv_ivc_write_get_frames);
+
+int tegra_hv_ivc_write_advance_frames(struct tegra_hv_ivc_cookie *ivck,
+		unsigned count)
+{
+	struct ivc *ivc = &cookie_to_ivc_dev(ivck)->ivc;
+
+	return tegra_ivc_write_advance_frames(ivc, count);
+}
+EXPORT_SYMBOL(tegra_hv_ivc_write_advance_frames);
+
 struct tegra_hv_ivm_cookie *tegra_hv_mempool_reserve(struct device_node *dn,
 		unsigned id)
 {
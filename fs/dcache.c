@@ -50,11 +50,13 @@
  *   - the s_anon list (see __d_drop)
  * dcache_lru_lock protects:
  *   - the dcache lru lists and counters
+ *   - DCACHE_LRU_NEGATIVE (only changed with d_lock held too)
  * d_lock protects:
  *   - d_flags
  *   - d_name
  *   - d_lru
- *   - d_count
+ *   - d_lockref.count (lockref updates it without d_lock only while
+ *     d_lock is free and the count stays above zero)
  *   - d_unhashed()
  *   - d_parent and d_subdirs
  *   - childrens' d_child and d_parent
@@ -114,6 +116,15 @@ struct dentry_stat_t dentry_stat = {
 	.age_limit = 45,
 };
 
+/*
+ * Cap on the unused negative dentries of each superblock, 0 for none.
+ * Going over it kicks the superblock's trim work, which frees the oldest
+ * of them until the count is back under NEGATIVE_TRIM_LOW of the limit.
+ */
+int sysctl_negative_dentry_limit __read_mostly;
+
+#define NEGATIVE_TRIM_LOW(limit)	((limit) - (limit) / 8)
+
 static DEFINE_PER_CPU(unsigned int, nr_dentry);
 
 #if defined(CONFIG_SYSCTL) && defined(CONFIG_PROC_FS)
@@ -130,7 +141,7 @@ int proc_nr_dentry(ctl_table *table, int write, void __user *buffer,
 		   size_t *lenp, loff_t *ppos)
 {
 	dentry_stat.nr_dentry = get_nr_dentry();
-	return proc_dointvec(table, write, buffer, lenp, ppos);
+	return proc_doulongvec_minmax(table, write, buffer, lenp, ppos);
 }
 #endif
 
@@ -226,7 +237,7 @@ static void __d_free(struct rcu_head *head)
 static void d_free(struct dentry *dentry)
 {
 	WARN_ON(!hlist_unhashed(&dentry->d_u.d_alias));
-	BUG_ON(dentry->d_count);
+	BUG_ON(dentry->d_lockref.count);
 	this_cpu_dec(nr_dentry);
 	if (dentry->d_op && dentry->d_op->d_release)
 		dentry->d_op->d_release(dentry);
@@ -300,6 +311,31 @@ static void dentry_unlink_inode(struct dentry * dentry)
 		iput(inode);
 }
 
+/*
+ * Negative dentries on the LRU are counted per superblock, so that the
+ * ones left behind by lookups of nonexistent names can be capped.  The
+ * count follows DCACHE_LRU_NEGATIVE rather than d_inode, which may change
+ * under a dentry lazily left on the LRU.  Called with dcache_lru_lock.
+ */
+static void __dentry_lru_negative(struct dentry *dentry)
+{
+	struct super_block *sb = dentry->d_sb;
+	int limit = sysctl_negative_dentry_limit;
+
+	dentry->d_flags |= DCACHE_LRU_NEGATIVE;
+	sb->s_nr_dentry_negative++;
+	dentry_stat.nr_negative++;
+	if (unlikely(limit) && sb->s_nr_dentry_negative > limit)
+		schedule_work(&sb->s_dentry_trim_work);
+}
+
+static void __dentry_lru_positive(struct dentry *dentry)
+{
+	dentry->d_flags &= ~DCACHE_LRU_NEGATIVE;
+	dentry->d_sb->s_nr_dentry_negative--;
+	dentry_stat.nr_negative--;
+}
+
 /*
  * dentry_lru_(add|del|prune|move_tail) must be called with d_lock held.
  */
@@ -310,6 +346,14 @@ static void dentry_lru_add(struct dentry *dentry)
 		list_add(&dentry->d_lru, &dentry->d_sb->s_dentry_lru);
 		dentry->d_sb->s_nr_dentry_unused++;
 		dentry_stat.nr_unused++;
+		if (!dentry->d_inode)
+			__dentry_lru_negative(dentry);
+		spin_unlock(&dcache_lru_lock);
+	} else if (!dentry->d_inode &&
+		   !(dentry->d_flags & DCACHE_LRU_NEGATIVE)) {
+		/* went negative while it was in use */
+		spin_lock(&dcache_lru_lock);
+		__dentry_lru_negative(dentry);
 		spin_unlock(&dcache_lru_lock);
 	}
 }
@@ -317,6 +361,8 @@ static void dentry_lru_add(struct dentry *dentry)
 static void __dentry_lru_del(struct dentry *dentry)
 {
 	list_del_init(&dentry->d_lru);
+	if (dentry->d_flags & DCACHE_LRU_NEGATIVE)
+		__dentry_lru_positive(dentry);
 	dentry->d_flags &= ~DCACHE_SHRINK_LIST;
 	dentry->d_sb->s_nr_dentry_unused--;
 	dentry_stat.nr_unused--;
@@ -464,7 +510,7 @@ relock:
 	}
 
 	if (ref)
-		dentry->d_count--;
+		dentry->d_lockref.count--;
 	/*
 	 * inform the fs via d_prune that this dentry is about to be
 	 * unhashed and destroyed.
@@ -510,15 +556,11 @@ void dput(struct dentry *dentry)
 		return;
 
 repeat:
-	if (dentry->d_count == 1)
+	if (d_count(dentry) == 1)
 		might_sleep();
-	spin_lock(&dentry->d_lock);
-	BUG_ON(!dentry->d_count);
-	if (dentry->d_count > 1) {
-		dentry->d_count--;
-		spin_unlock(&dentry->d_lock);
+	if (lockref_put_or_lock(&dentry->d_lockref))
 		return;
-	}
+	BUG_ON(!dentry->d_lockref.count);
 
 	if (unlikely(dentry->d_flags & DCACHE_DISCONNECTED))
 		goto kill_it;
@@ -532,10 +574,12 @@ repeat:
  	if (d_unhashed(dentry))
 		goto kill_it;
 
-	dentry->d_flags |= DCACHE_REFERENCED;
+	/* Don't dirty the flags word when it is already set */
+	if (!(dentry->d_flags & DCACHE_REFERENCED))
+		dentry->d_flags |= DCACHE_REFERENCED;
 	dentry_lru_add(dentry);
 
-	dentry->d_count--;
+	dentry->d_lockref.count--;
 	spin_unlock(&dentry->d_lock);
 	return;
 
@@ -546,6 +590,56 @@ kill_it:
 }
 EXPORT_SYMBOL(dput);
 
+/*
+ * Drop a reference taken by d_rcu_to_refcount() whose validation failed.
+ * This runs under rcu-walk, where killing the dentry (and with it the
+ * inode) is not allowed, so a last reference leaves the dentry on the LRU
+ * for the shrinker to reap instead.
+ */
+void d_rcu_put(struct dentry *dentry)
+{
+	if (lockref_put_or_lock(&dentry->d_lockref))
+		return;
+	dentry_lru_add(dentry);
+	dentry->d_lockref.count--;
+	spin_unlock(&dentry->d_lock);
+}
+
+/**
+ * d_rcu_to_refcount - take a reference on a dentry found in rcu-walk mode
+ * @dentry: dentry to take a reference on
+ * @validate: sequence count that must not have changed
+ * @seq: value of @validate sampled during the walk
+ *
+ * Returns 0 with a reference held, or -ECHILD without one if @validate
+ * moved on in the meantime.  The reference is taken without d_lock unless
+ * the dentry is unused, so concurrent walks through a shared directory
+ * don't serialise on it.  Never sleeps, callable from rcu-walk context.
+ */
+int d_rcu_to_refcount(struct dentry *dentry, seqcount_t *validate,
+		      unsigned seq)
+{
+	if (likely(lockref_get_or_lock(&dentry->d_lockref))) {
+		if (likely(!read_seqcount_retry(validate, seq)))
+			return 0;
+		d_rcu_put(dentry);
+		return -ECHILD;
+	}
+
+	/*
+	 * The dentry is unused and may be on its way out.  We hold d_lock,
+	 * so the count can't be raised behind our back, and any kill
+	 * unhashes it and bumps the sequence count before dropping d_lock.
+	 */
+	if (read_seqcount_retry(validate, seq)) {
+		spin_unlock(&dentry->d_lock);
+		return -ECHILD;
+	}
+	dentry->d_lockref.count++;
+	spin_unlock(&dentry->d_lock);
+	return 0;
+}
+
 /**
  * d_invalidate - invalidate a dentry
  * @dentry: dentry to invalidate
@@ -590,7 +684,7 @@ int d_invalidate(struct dentry * dentry)
 	 * We also need to leave mountpoints alone,
 	 * directory or not.
 	 */
-	if (dentry->d_count > 1 && dentry->d_inode) {
+	if (dentry->d_lockref.count > 1 && dentry->d_inode) {
 		if (S_ISDIR(dentry->d_inode->i_mode) || d_mountpoint(dentry)) {
 			spin_unlock(&dentry->d_lock);
 			return -EBUSY;
@@ -606,20 +700,34 @@ EXPORT_SYMBOL(d_invalidate);
 /* This must be called with d_lock held */
 static inline void __dget_dlock(struct dentry *dentry)
 {
-	dentry->d_count++;
+	dentry->d_lockref.count++;
 }
 
 static inline void __dget(struct dentry *dentry)
 {
-	spin_lock(&dentry->d_lock);
-	__dget_dlock(dentry);
-	spin_unlock(&dentry->d_lock);
+	lockref_get(&dentry->d_lockref);
 }
 
 struct dentry *dget_parent(struct dentry *dentry)
 {
+	int gotref;
 	struct dentry *ret;
 
+	/*
+	 * Do optimistic parent lookup without any locking.  The parent is
+	 * RCU-freed, and a rename racing with us is caught by re-checking
+	 * d_parent once the reference is held.
+	 */
+	rcu_read_lock();
+	ret = ACCESS_ONCE(dentry->d_parent);
+	gotref = lockref_get_not_zero(&ret->d_lockref);
+	rcu_read_unlock();
+	if (likely(gotref)) {
+		if (likely(ret == ACCESS_ONCE(dentry->d_parent)))
+			return ret;
+		dput(ret);
+	}
+
 repeat:
 	/*
 	 * Don't need rcu_dereference because we re-check it was correct under
@@ -634,8 +742,8 @@ repeat:
 		goto repeat;
 	}
 	rcu_read_unlock();
-	BUG_ON(!ret->d_count);
-	ret->d_count++;
+	BUG_ON(!ret->d_lockref.count);
+	ret->d_lockref.count++;
 	spin_unlock(&ret->d_lock);
 	return ret;
 }
@@ -718,7 +826,7 @@ restart:
 	spin_lock(&inode->i_lock);
 	hlist_for_each_entry(dentry, &inode->i_dentry, d_u.d_alias) {
 		spin_lock(&dentry->d_lock);
-		if (!dentry->d_count) {
+		if (!dentry->d_lockref.count) {
 			__dget_dlock(dentry);
 			__d_drop(dentry);
 			spin_unlock(&dentry->d_lock);
@@ -734,7 +842,7 @@ EXPORT_SYMBOL(d_prune_aliases);
 
 /*
  * Try to throw away a dentry - free the inode, dput the parent.
- * Requires dentry->d_lock is held, and dentry->d_count == 0.
+ * Requires dentry->d_lock is held, and dentry->d_lockref.count == 0.
  * Releases dentry->d_lock.
  *
  * This may fail if locks cannot be acquired no problem, just try again.
@@ -764,8 +872,8 @@ static void try_prune_one_dentry(struct dentry *dentry)
 	dentry = parent;
 	while (dentry) {
 		spin_lock(&dentry->d_lock);
-		if (dentry->d_count > 1) {
-			dentry->d_count--;
+		if (dentry->d_lockref.count > 1) {
+			dentry->d_lockref.count--;
 			spin_unlock(&dentry->d_lock);
 			return;
 		}
@@ -793,7 +901,7 @@ static void shrink_dentry_list(struct list_head *list)
 		 * the LRU because of laziness during lookup.  Do not free
 		 * it - just keep it off the LRU list.
 		 */
-		if (dentry->d_count) {
+		if (dentry->d_lockref.count) {
 			dentry_lru_del(dentry);
 			spin_unlock(&dentry->d_lock);
 			continue;
@@ -839,6 +947,7 @@ relock:
 			goto relock;
 		}
 
+		dentry_stat.nr_lru_scanned++;
 		if (dentry->d_flags & DCACHE_REFERENCED) {
 			dentry->d_flags &= ~DCACHE_REFERENCED;
 			list_move(&dentry->d_lru, &referenced);
@@ -859,6 +968,66 @@ relock:
 	shrink_dentry_list(&tmp);
 }
 
+/**
+ * d_trim_negative_work - enforce the negative dentry limit of a superblock
+ * @work: the superblock's s_dentry_trim_work
+ *
+ * Frees the oldest unused negative dentries of a superblock that went over
+ * sysctl_negative_dentry_limit.  Positive dentries and negative ones used
+ * since the last pass are left where they are, and the walk is bounded so
+ * that an LRU made mostly of those doesn't get scanned end to end.
+ */
+void d_trim_negative_work(struct work_struct *work)
+{
+	struct super_block *sb = container_of(work, struct super_block,
+					      s_dentry_trim_work);
+	int limit = ACCESS_ONCE(sysctl_negative_dentry_limit);
+	struct dentry *dentry;
+	LIST_HEAD(skipped);
+	LIST_HEAD(tmp);
+	int nr, scan;
+
+	if (!limit || !grab_super_passive(sb))
+		return;
+
+	spin_lock(&dcache_lru_lock);
+	nr = sb->s_nr_dentry_negative - NEGATIVE_TRIM_LOW(limit);
+	scan = max(4 * nr, 128);
+	while (nr > 0 && scan-- > 0 && !list_empty(&sb->s_dentry_lru)) {
+		dentry = list_entry(sb->s_dentry_lru.prev,
+				struct dentry, d_lru);
+
+		if (!spin_trylock(&dentry->d_lock)) {
+			spin_unlock(&dcache_lru_lock);
+			cpu_relax();
+			spin_lock(&dcache_lru_lock);
+			continue;
+		}
+
+		dentry_stat.nr_lru_scanned++;
+		if (!(dentry->d_flags & DCACHE_LRU_NEGATIVE) ||
+		    dentry->d_lockref.count) {
+			list_move(&dentry->d_lru, &skipped);
+		} else if (dentry->d_flags & DCACHE_REFERENCED) {
+			dentry->d_flags &= ~DCACHE_REFERENCED;
+			list_move(&dentry->d_lru, &skipped);
+		} else {
+			list_move_tail(&dentry->d_lru, &tmp);
+			dentry->d_flags |= DCACHE_SHRINK_LIST;
+			dentry_stat.nr_negative_trimmed++;
+			nr--;
+		}
+		spin_unlock(&dentry->d_lock);
+		cond_resched_lock(&dcache_lru_lock);
+	}
+	/* back to the cold end, in their original order */
+	list_splice_tail(&skipped, &sb->s_dentry_lru);
+	spin_unlock(&dcache_lru_lock);
+
+	shrink_dentry_list(&tmp);
+	drop_super(sb);
+}
+
 /**
  * shrink_dcache_sb - shrink dcache for a superblock
  * @sb: superblock
@@ -913,7 +1082,7 @@ static void shrink_dcache_for_umount_subtree(struct dentry *dentry)
 			dentry_lru_del(dentry);
 			__d_shrink(dentry);
 
-			if (dentry->d_count != 0) {
+			if (dentry->d_lockref.count != 0) {
 				printk(KERN_ERR
 				       "BUG: Dentry %p{i=%lx,n=%s}"
 				       " still in use (%d)"
@@ -922,7 +1091,7 @@ static void shrink_dcache_for_umount_subtree(struct dentry *dentry)
 				       dentry->d_inode ?
 				       dentry->d_inode->i_ino : 0UL,
 				       dentry->d_name.name,
-				       dentry->d_count,
+				       dentry->d_lockref.count,
 				       dentry->d_sb->s_type->name,
 				       dentry->d_sb->s_id);
 				BUG();
@@ -933,7 +1102,7 @@ static void shrink_dcache_for_umount_subtree(struct dentry *dentry)
 				list_del(&dentry->d_child);
 			} else {
 				parent = dentry->d_parent;
-				parent->d_count--;
+				parent->d_lockref.count--;
 				list_del(&dentry->d_child);
 			}
 
@@ -981,7 +1150,7 @@ void shrink_dcache_for_umount(struct super_block *sb)
 
 	dentry = sb->s_root;
 	sb->s_root = NULL;
-	dentry->d_count--;
+	dentry->d_lockref.count--;
 	shrink_dcache_for_umount_subtree(dentry);
 
 	while (!hlist_bl_empty(&sb->s_anon)) {
@@ -1136,7 +1305,7 @@ resume:
 		 * loop in shrink_dcache_parent() might not make any progress
 		 * and loop forever.
 		 */
-		if (dentry->d_count) {
+		if (dentry->d_lockref.count) {
 			dentry_lru_del(dentry);
 		} else if (!(dentry->d_flags & DCACHE_SHRINK_LIST)) {
 			dentry_lru_move_list(dentry, dispose);
@@ -1276,7 +1445,7 @@ struct dentry *__d_alloc(struct super_block *sb, const struct qstr *name)
 	smp_wmb();
 	dentry->d_name.name = dname;
 
-	dentry->d_count = 1;
+	dentry->d_lockref.count = 1;
 	dentry->d_flags = 0;
 	spin_lock_init(&dentry->d_lock);
 	seqcount_init(&dentry->d_seq);
@@ -1380,6 +1549,11 @@ static void __d_instantiate(struct dentry *dentry, struct inode *inode)
 		if (unlikely(IS_AUTOMOUNT(inode)))
 			dentry->d_flags |= DCACHE_NEED_AUTOMOUNT;
 		hlist_add_head(&dentry->d_u.d_alias, &inode->i_dentry);
+		if (unlikely(dentry->d_flags & DCACHE_LRU_NEGATIVE)) {
+			spin_lock(&dcache_lru_lock);
+			__dentry_lru_positive(dentry);
+			spin_unlock(&dcache_lru_lock);
+		}
 	}
 	dentry->d_inode = inode;
 	dentry_rcuwalk_barrier(dentry);
@@ -1787,7 +1961,7 @@ static noinline enum slow_d_compare slow_dentry_cmp(
  * without taking d_lock and checking d_seq sequence count against @seq
  * returned here.
  *
- * A refcount may be taken on the found dentry with the __d_rcu_to_refcount
+ * A refcount may be taken on the found dentry with the d_rcu_to_refcount
  * function.
  *
  * Alternatively, __d_lookup_rcu may be called again to look up the child of
@@ -1977,7 +2151,7 @@ struct dentry *__d_lookup(const struct dentry *parent, const struct qstr *name)
 				goto next;
 		}
 
-		dentry->d_count++;
+		dentry->d_lockref.count++;
 		found = dentry;
 		spin_unlock(&dentry->d_lock);
 		break;
@@ -2076,7 +2250,7 @@ again:
 	spin_lock(&dentry->d_lock);
 	inode = dentry->d_inode;
 	isdir = S_ISDIR(inode->i_mode);
-	if (dentry->d_count == 1) {
+	if (dentry->d_lockref.count == 1) {
 		if (!spin_trylock(&inode->i_lock)) {
 			spin_unlock(&dentry->d_lock);
 			cpu_relax();
@@ -2961,7 +3135,7 @@ resume:
 		}
 		if (!(dentry->d_flags & DCACHE_GENOCIDE)) {
 			dentry->d_flags |= DCACHE_GENOCIDE;
-			dentry->d_count--;
+			dentry->d_lockref.count--;
 		}
 		spin_unlock(&dentry->d_lock);
 	}
@@ -2971,7 +3145,7 @@ ascend:
 		struct dentry *child = this_parent;
 		if (!(this_parent->d_flags & DCACHE_GENOCIDE)) {
 			this_parent->d_flags |= DCACHE_GENOCIDE;
-			this_parent->d_count--;
+			this_parent->d_lockref.count--;
 		}
 		this_parent = child->d_parent;
 
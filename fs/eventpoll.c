@@ -37,6 +37,8 @@
 #include <linux/anon_inodes.h>
 #include <linux/device.h>
 #include <linux/freezer.h>
+#include <linux/llist.h>
+#include <linux/percpu.h>
 #include <asm/uaccess.h>
 #include <asm/io.h>
 #include <asm/mman.h>
@@ -54,11 +56,14 @@
  * 3) ep->lock (spinlock)
  *
  * The acquire order is the one listed above, from 1 to 3.
- * We need a spinlock (ep->lock) because we manipulate objects
- * from inside the poll callback, that might be triggered from
- * a wake_up() that in turn might be called from IRQ context.
- * So we can't sleep inside the poll callback and hence we need
- * a spinlock. During the event transfer loop (from kernel to
+ * We need a spinlock (ep->lock) to manipulate the ready list,
+ * which is also fed by the poll callback, that might be triggered
+ * from a wake_up() that in turn might be called from IRQ context.
+ * The poll callback itself takes no lock: it pushes the item on a
+ * per-CPU lockless list that is moved to the ready list, under
+ * ep->lock and ep->mtx, by the next event transfer (ep_drain_ready()).
+ * So we can't sleep while holding ep->lock and hence it is a
+ * spinlock. During the event transfer loop (from kernel to
  * user space) we could end up sleeping due a copy_to_user(), so
  * we need a lock that will allow us to sleep. This lock is a
  * mutex (ep->mtx). It is acquired during the event transfer loop,
@@ -94,15 +99,18 @@
  */
 
 /* Epoll private bits inside the event mask */
-#define EP_PRIVATE_BITS (EPOLLWAKEUP | EPOLLONESHOT | EPOLLET)
+#define EP_PRIVATE_BITS (EPOLLWAKEUP | EPOLLONESHOT | EPOLLET | EPOLLEXCLUSIVE)
+
+#define EPOLLINOUT_BITS (POLLIN | POLLOUT)
+
+#define EPOLLEXCLUSIVE_OK_BITS (EPOLLINOUT_BITS | POLLERR | POLLHUP | \
+				EPOLLWAKEUP | EPOLLET | EPOLLEXCLUSIVE)
 
 /* Maximum number of nesting allowed inside epoll sets */
 #define EP_MAX_NESTS 4
 
 #define EP_MAX_EVENTS (INT_MAX / sizeof(struct epoll_event))
 
-#define EP_UNACTIVE_PTR ((void *) -1L)
-
 #define EP_ITEM_COST (sizeof(struct epitem) + sizeof(struct eppoll_entry))
 
 struct epoll_filefd {
@@ -142,11 +150,8 @@ struct epitem {
 	/* List header used to link this structure to the eventpoll ready list */
 	struct list_head rdllink;
 
-	/*
-	 * Works together "struct eventpoll"->ovflist in keeping the
-	 * single linked chain of items.
-	 */
-	struct epitem *next;
+	/* Links the item to a "struct eventpoll"->rdllists per-CPU list */
+	struct llist_node llnode;
 
 	/* The file descriptor information this item refers to */
 	struct epoll_filefd ffd;
@@ -154,6 +159,9 @@ struct epitem {
 	/* Number of active wait queue attached to poll operations */
 	int nwait;
 
+	/* Set while the item sits on a per-CPU pending ready list */
+	int queued;
+
 	/* List containing poll wait queues */
 	struct list_head pwqlist;
 
@@ -200,11 +208,11 @@ struct eventpoll {
 	struct rb_root rbr;
 
 	/*
-	 * This is a single linked list that chains all the "struct epitem" that
-	 * happened while transferring ready events to userspace w/out
-	 * holding ->lock.
+	 * Per-CPU lockless lists of items reported ready by the poll callback
+	 * and not yet moved to rdllist. They keep wakeups on different CPUs
+	 * from bouncing ->lock between them.
 	 */
-	struct epitem *ovflist;
+	struct llist_head __percpu *rdllists;
 
 	/* wakeup_source used when ep_scan_ready_list is running */
 	struct wakeup_source *ws;
@@ -374,7 +382,37 @@ static void ep_nested_calls_init(struct nested_calls *ncalls)
  */
 static inline int ep_events_available(struct eventpoll *ep)
 {
-	return !list_empty(&ep->rdllist) || ep->ovflist != EP_UNACTIVE_PTR;
+	int cpu;
+
+	if (!list_empty(&ep->rdllist))
+		return 1;
+
+	for_each_possible_cpu(cpu)
+		if (!llist_empty(per_cpu_ptr(ep->rdllists, cpu)))
+			return 1;
+
+	return 0;
+}
+
+/**
+ * ep_wake_waiters - Wakes up one epoll_wait() caller, if there is any.
+ *
+ * @ep: Pointer to the eventpoll context.
+ *
+ * Waiters sleep on ep->wq without holding ep->lock, so the ready list
+ * update must be visible before the wait queue is checked. This pairs
+ * with set_current_state() in ep_poll().
+ *
+ * Returns: Returns a value different than zero if there was a waiter.
+ */
+static inline int ep_wake_waiters(struct eventpoll *ep)
+{
+	smp_mb();
+	if (!waitqueue_active(&ep->wq))
+		return 0;
+
+	wake_up(&ep->wq);
+	return 1;
 }
 
 /**
@@ -574,6 +612,46 @@ static inline void ep_pm_stay_awake_rcu(struct epitem *epi)
 	rcu_read_unlock();
 }
 
+/*
+ * Moves the items queued by the poll callback on the per-CPU lists to
+ * the ready list, in the order their wakeups happened on each CPU.
+ * Must be called with "mtx" and "ep->lock" held.
+ */
+static void ep_drain_ready(struct eventpoll *ep)
+{
+	struct llist_node *node, *next, *first;
+	struct epitem *epi;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		first = llist_del_all(per_cpu_ptr(ep->rdllists, cpu));
+
+		/* The lists are LIFO, reverse them */
+		for (node = NULL; first; first = next) {
+			next = first->next;
+			first->next = node;
+			node = first;
+		}
+
+		while (node) {
+			epi = llist_entry(node, struct epitem, llnode);
+			node = node->next;
+
+			/*
+			 * The callback may queue the item again as soon as
+			 * it sees ->queued cleared, so be done with llnode.
+			 */
+			smp_mb();
+			epi->queued = 0;
+
+			if (!ep_is_linked(&epi->rdllink)) {
+				list_add_tail(&epi->rdllink, &ep->rdllist);
+				ep_pm_stay_awake(epi);
+			}
+		}
+	}
+}
+
 /**
  * ep_scan_ready_list - Scans the ready list in a way that makes possible for
  *                      the scan code, to call f_op->poll(). Also allows for
@@ -594,7 +672,6 @@ static int ep_scan_ready_list(struct eventpoll *ep,
 {
 	int error, pwake = 0;
 	unsigned long flags;
-	struct epitem *epi, *nepi;
 	LIST_HEAD(txlist);
 
 	/*
@@ -604,16 +681,15 @@ static int ep_scan_ready_list(struct eventpoll *ep,
 	mutex_lock_nested(&ep->mtx, depth);
 
 	/*
-	 * Steal the ready list, and re-init the original one to the
-	 * empty list. Also, set ep->ovflist to NULL so that events
-	 * happening while looping w/out locks, are not lost. We cannot
-	 * have the poll callback to queue directly on ep->rdllist,
-	 * because we want the "sproc" callback to be able to do it
+	 * Collect the items queued by the poll callback, steal the ready
+	 * list, and re-init the original one to the empty list. Events
+	 * happening while looping w/out locks keep going to the per-CPU
+	 * lists, so the "sproc" callback can still modify ep->rdllist
 	 * in a lockless way.
 	 */
 	spin_lock_irqsave(&ep->lock, flags);
+	ep_drain_ready(ep);
 	list_splice_init(&ep->rdllist, &txlist);
-	ep->ovflist = NULL;
 	spin_unlock_irqrestore(&ep->lock, flags);
 
 	/*
@@ -625,27 +701,11 @@ static int ep_scan_ready_list(struct eventpoll *ep,
 	/*
 	 * During the time we spent inside the "sproc" callback, some
 	 * other events might have been queued by the poll callback.
-	 * We re-insert them inside the main ready-list here.
-	 */
-	for (nepi = ep->ovflist; (epi = nepi) != NULL;
-	     nepi = epi->next, epi->next = EP_UNACTIVE_PTR) {
-		/*
-		 * We need to check if the item is already in the list.
-		 * During the "sproc" callback execution time, items are
-		 * queued into ->ovflist but the "txlist" might already
-		 * contain them, and the list_splice() below takes care of them.
-		 */
-		if (!ep_is_linked(&epi->rdllink)) {
-			list_add_tail(&epi->rdllink, &ep->rdllist);
-			ep_pm_stay_awake(epi);
-		}
-	}
-	/*
-	 * We need to set back ep->ovflist to EP_UNACTIVE_PTR, so that after
-	 * releasing the lock, events will be queued in the normal way inside
-	 * ep->rdllist.
+	 * We insert them inside the main ready-list here. Items still
+	 * on "txlist" are skipped, the list_splice() below takes care
+	 * of them.
 	 */
-	ep->ovflist = EP_UNACTIVE_PTR;
+	ep_drain_ready(ep);
 
 	/*
 	 * Quickly re-inject items left on "txlist".
@@ -658,8 +718,7 @@ static int ep_scan_ready_list(struct eventpoll *ep,
 		 * Wake up (if active) both the eventpoll wait list and
 		 * the ->poll() wait list (delayed after we release the lock).
 		 */
-		if (waitqueue_active(&ep->wq))
-			wake_up_locked(&ep->wq);
+		ep_wake_waiters(ep);
 		if (waitqueue_active(&ep->poll_wait))
 			pwake++;
 	}
@@ -701,7 +760,13 @@ static int ep_remove(struct eventpoll *ep, struct epitem *epi)
 
 	rb_erase(&epi->rbn, &ep->rbr);
 
+	/*
+	 * No callback can queue the item anymore, but it may still sit on
+	 * a per-CPU list. Flush those first.
+	 */
 	spin_lock_irqsave(&ep->lock, flags);
+	if (epi->queued)
+		ep_drain_ready(ep);
 	if (ep_is_linked(&epi->rdllink))
 		list_del_init(&epi->rdllink);
 	spin_unlock_irqrestore(&ep->lock, flags);
@@ -763,6 +828,7 @@ static void ep_free(struct eventpoll *ep)
 	mutex_destroy(&ep->mtx);
 	free_uid(ep->user);
 	wakeup_source_unregister(ep->ws);
+	free_percpu(ep->rdllists);
 	kfree(ep);
 }
 
@@ -917,19 +983,24 @@ static int ep_alloc(struct eventpoll **pep)
 	if (unlikely(!ep))
 		goto free_uid;
 
+	ep->rdllists = alloc_percpu(struct llist_head);
+	if (unlikely(!ep->rdllists))
+		goto free_ep;
+
 	spin_lock_init(&ep->lock);
 	mutex_init(&ep->mtx);
 	init_waitqueue_head(&ep->wq);
 	init_waitqueue_head(&ep->poll_wait);
 	INIT_LIST_HEAD(&ep->rdllist);
 	ep->rbr = RB_ROOT;
-	ep->ovflist = EP_UNACTIVE_PTR;
 	ep->user = user;
 
 	*pep = ep;
 
 	return 0;
 
+free_ep:
+	kfree(ep);
 free_uid:
 	free_uid(user);
 	return error;
@@ -968,12 +1039,15 @@ static struct epitem *ep_find(struct eventpoll *ep, struct file *file, int fd)
  * This is the callback that is passed to the wait queue wakeup
  * mechanism. It is called by the stored file descriptors when they
  * have events to report.
+ *
+ * It runs without taking ep->lock: the item is pushed on this CPU's
+ * pending list, which the next event transfer merges into the ready
+ * list (see ep_drain_ready()).
  */
 static int ep_poll_callback(wait_queue_t *wait, unsigned mode, int sync,
 			    void *key)
 {
-	int pwake = 0;
-	unsigned long flags;
+	int pwake = 0, ewake = 0;
 	struct epitem *epi = ep_item_from_wait(wait);
 	struct eventpoll *ep = epi->ep;
 
@@ -988,8 +1062,6 @@ static int ep_poll_callback(wait_queue_t *wait, unsigned mode, int sync,
 		list_del_init(&wait->task_list);
 	}
 
-	spin_lock_irqsave(&ep->lock, flags);
-
 	/*
 	 * If the event mask does not contain any poll(2) event, we consider the
 	 * descriptor to be disabled. This condition is likely the effect of the
@@ -997,7 +1069,7 @@ static int ep_poll_callback(wait_queue_t *wait, unsigned mode, int sync,
 	 * until the next EPOLL_CTL_MOD will be issued.
 	 */
 	if (!(epi->event.events & ~EP_PRIVATE_BITS))
-		goto out_unlock;
+		goto out;
 
 	/*
 	 * Check the events coming with the callback. At this stage, not
@@ -1006,52 +1078,62 @@ static int ep_poll_callback(wait_queue_t *wait, unsigned mode, int sync,
 	 * test for "key" != NULL before the event match test.
 	 */
 	if (key && !((unsigned long) key & epi->event.events))
-		goto out_unlock;
+		goto out;
 
 	/*
-	 * If we are transferring events to userspace, we can hold no locks
-	 * (because we're accessing user memory, and because of linux f_op->poll()
-	 * semantics). All the events that happen during that period of time are
-	 * chained in ep->ovflist and requeued later on.
+	 * If this item is already pending we exit soon. Whether it is on
+	 * the ready list can only be told under ep->lock, so duplicates
+	 * are weeded out by ep_drain_ready().
 	 */
-	if (unlikely(ep->ovflist != EP_UNACTIVE_PTR)) {
-		if (epi->next == EP_UNACTIVE_PTR) {
-			epi->next = ep->ovflist;
-			ep->ovflist = epi;
-			if (epi->ws) {
-				/*
-				 * Activate ep->ws since epi->ws may get
-				 * deactivated at any time.
-				 */
-				__pm_stay_awake(ep->ws);
-			}
-
+	if (!xchg(&epi->queued, 1)) {
+		llist_add(&epi->llnode, this_cpu_ptr(ep->rdllists));
+		if (ep_has_wakeup_source(epi)) {
+			/*
+			 * Activate ep->ws since epi->ws may get deactivated
+			 * at any time by a concurrent event transfer.
+			 */
+			__pm_stay_awake(ep->ws);
+			ep_pm_stay_awake_rcu(epi);
 		}
-		goto out_unlock;
-	}
-
-	/* If this file is already in the ready list we exit soon */
-	if (!ep_is_linked(&epi->rdllink)) {
-		list_add_tail(&epi->rdllink, &ep->rdllist);
-		ep_pm_stay_awake_rcu(epi);
 	}
 
 	/*
 	 * Wake up ( if active ) both the eventpoll wait list and the ->poll()
 	 * wait list.
 	 */
-	if (waitqueue_active(&ep->wq))
-		wake_up_locked(&ep->wq);
+	if (ep_wake_waiters(ep)) {
+		/*
+		 * An exclusive item only counts as a wakeup if the waiter
+		 * is interested in the reported events, so that the wait
+		 * queue moves on to the next exclusive entry otherwise.
+		 */
+		if ((epi->event.events & EPOLLEXCLUSIVE) &&
+		    !((unsigned long)key & POLLFREE)) {
+			switch ((unsigned long)key & EPOLLINOUT_BITS) {
+			case POLLIN:
+				if (epi->event.events & POLLIN)
+					ewake = 1;
+				break;
+			case POLLOUT:
+				if (epi->event.events & POLLOUT)
+					ewake = 1;
+				break;
+			case 0:
+				ewake = 1;
+				break;
+			}
+		}
+	}
 	if (waitqueue_active(&ep->poll_wait))
 		pwake++;
 
-out_unlock:
-	spin_unlock_irqrestore(&ep->lock, flags);
-
-	/* We have to call this outside the lock */
+out:
 	if (pwake)
 		ep_poll_safewake(&ep->poll_wait);
 
+	if (epi->event.events & EPOLLEXCLUSIVE)
+		return ewake;
+
 	return 1;
 }
 
@@ -1069,7 +1151,10 @@ static void ep_ptable_queue_proc(struct file *file, wait_queue_head_t *whead,
 		init_waitqueue_func_entry(&pwq->wait, ep_poll_callback);
 		pwq->whead = whead;
 		pwq->base = epi;
-		add_wait_queue(whead, &pwq->wait);
+		if (epi->event.events & EPOLLEXCLUSIVE)
+			add_wait_queue_exclusive(whead, &pwq->wait);
+		else
+			add_wait_queue(whead, &pwq->wait);
 		list_add_tail(&pwq->llink, &epi->pwqlist);
 		epi->nwait++;
 	} else {
@@ -1255,7 +1340,7 @@ static int ep_insert(struct eventpoll *ep, struct epoll_event *event,
 	ep_set_ffd(&epi->ffd, tfile, fd);
 	epi->event = *event;
 	epi->nwait = 0;
-	epi->next = EP_UNACTIVE_PTR;
+	epi->queued = 0;
 	if (epi->event.events & EPOLLWAKEUP) {
 		error = ep_create_wakeup_source(epi);
 		if (error)
@@ -1311,8 +1396,7 @@ static int ep_insert(struct eventpoll *ep, struct epoll_event *event,
 		ep_pm_stay_awake(epi);
 
 		/* Notify waiting tasks that events are available */
-		if (waitqueue_active(&ep->wq))
-			wake_up_locked(&ep->wq);
+		ep_wake_waiters(ep);
 		if (waitqueue_active(&ep->poll_wait))
 			pwake++;
 	}
@@ -1340,11 +1424,12 @@ error_unregister:
 
 	/*
 	 * We need to do this because an event could have been arrived on some
-	 * allocated wait queue. Note that we don't care about the ep->ovflist
-	 * list, since that is used/cleaned only inside a section bound by "mtx".
-	 * And ep_insert() is called with "mtx" held.
+	 * allocated wait queue. The per-CPU lists are only drained inside a
+	 * section bound by "mtx", and ep_insert() is called with "mtx" held.
 	 */
 	spin_lock_irqsave(&ep->lock, flags);
+	if (epi->queued)
+		ep_drain_ready(ep);
 	if (ep_is_linked(&epi->rdllink))
 		list_del_init(&epi->rdllink);
 	spin_unlock_irqrestore(&ep->lock, flags);
@@ -1389,9 +1474,8 @@ static int ep_modify(struct eventpoll *ep, struct epitem *epi, struct epoll_even
 	 * 1) Flush epi changes above to other CPUs.  This ensures
 	 *    we do not miss events from ep_poll_callback if an
 	 *    event occurs immediately after we call f_op->poll().
-	 *    We need this because we did not take ep->lock while
-	 *    changing epi above (but ep_poll_callback does take
-	 *    ep->lock).
+	 *    We need this because neither we nor ep_poll_callback
+	 *    take ep->lock while accessing epi->event.
 	 *
 	 * 2) We also need to ensure we do not miss _past_ events
 	 *    when calling f_op->poll().  This barrier also
@@ -1420,8 +1504,7 @@ static int ep_modify(struct eventpoll *ep, struct epitem *epi, struct epoll_even
 			ep_pm_stay_awake(epi);
 
 			/* Notify waiting tasks that events are available */
-			if (waitqueue_active(&ep->wq))
-				wake_up_locked(&ep->wq);
+			ep_wake_waiters(ep);
 			if (waitqueue_active(&ep->poll_wait))
 				pwake++;
 		}
@@ -1504,7 +1587,7 @@ static int ep_send_events_proc(struct eventpoll *ep, struct list_head *head,
 				 * into ep->rdllist besides us. The epoll_ctl()
 				 * callers are locked out by
 				 * ep_scan_ready_list() holding "mtx" and the
-				 * poll callback will queue them in ep->ovflist.
+				 * poll callback queues on the per-CPU lists.
 				 */
 				list_add_tail(&epi->rdllink, &ep->rdllist);
 				ep_pm_stay_awake(epi);
@@ -1558,7 +1641,6 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 		   int maxevents, long timeout)
 {
 	int res = 0, eavail, timed_out = 0;
-	unsigned long flags;
 	long slack = 0;
 	wait_queue_t wait;
 	ktime_t expires, *to = NULL;
@@ -1575,21 +1657,21 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 		 * caller specified a non blocking operation.
 		 */
 		timed_out = 1;
-		spin_lock_irqsave(&ep->lock, flags);
 		goto check_events;
 	}
 
 fetch_events:
-	spin_lock_irqsave(&ep->lock, flags);
-
 	if (!ep_events_available(ep)) {
 		/*
 		 * We don't have any available event to return to the caller.
 		 * We need to sleep here, and we will be wake up by
 		 * ep_poll_callback() when events will become available.
+		 * The poll callback does not take ep->lock, so neither do we:
+		 * set_current_state() below orders our wait queue entry
+		 * against the ready list checks (see ep_wake_waiters()).
 		 */
 		init_waitqueue_entry(&wait, current);
-		__add_wait_queue_exclusive(&ep->wq, &wait);
+		add_wait_queue_exclusive(&ep->wq, &wait);
 
 		for (;;) {
 			/*
@@ -1605,14 +1687,11 @@ fetch_events:
 				break;
 			}
 
-			spin_unlock_irqrestore(&ep->lock, flags);
 			if (!freezable_schedule_hrtimeout_range(to, slack,
 								HRTIMER_MODE_ABS))
 				timed_out = 1;
-
-			spin_lock_irqsave(&ep->lock, flags);
 		}
-		__remove_wait_queue(&ep->wq, &wait);
+		remove_wait_queue(&ep->wq, &wait);
 
 		set_current_state(TASK_RUNNING);
 	}
@@ -1620,8 +1699,6 @@ check_events:
 	/* Is it worth to try to dig for events ? */
 	eavail = ep_events_available(ep);
 
-	spin_unlock_irqrestore(&ep->lock, flags);
-
 	/*
 	 * Try to transfer events to user space. In case we get 0 events and
 	 * there's still timeout left over, we go trying again in search of
@@ -1834,6 +1911,19 @@ SYSCALL_DEFINE4(epoll_ctl, int, epfd, int, op, int, fd,
 	if (file == tfile || !is_file_epoll(file))
 		goto error_tgt_fput;
 
+	/*
+	 * EPOLLEXCLUSIVE is only allowed for EPOLL_CTL_ADD, it cannot be
+	 * changed by EPOLL_CTL_MOD later, and it is not supported for nested
+	 * epoll files or combined with EPOLLONESHOT.
+	 */
+	if (ep_op_has_event(op) && (epds.events & EPOLLEXCLUSIVE)) {
+		if (op == EPOLL_CTL_MOD)
+			goto error_tgt_fput;
+		if (op == EPOLL_CTL_ADD && (is_file_epoll(tfile) ||
+				(epds.events & ~EPOLLEXCLUSIVE_OK_BITS)))
+			goto error_tgt_fput;
+	}
+
 	/*
 	 * At this point it is safe to assume that the "private_data" contains
 	 * our own data structure.
@@ -1894,8 +1984,10 @@ SYSCALL_DEFINE4(epoll_ctl, int, epfd, int, op, int, fd,
 		break;
 	case EPOLL_CTL_MOD:
 		if (epi) {
-			epds.events |= POLLERR | POLLHUP;
-			error = ep_modify(ep, epi, &epds);
+			if (!(epi->event.events & EPOLLEXCLUSIVE)) {
+				epds.events |= POLLERR | POLLHUP;
+				error = ep_modify(ep, epi, &epds);
+			}
 		} else
 			error = -ENOENT;
 		break;
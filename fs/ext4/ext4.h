@@ -822,6 +822,7 @@ do {									       \
 #endif /* defined(__KERNEL__) || defined(__linux__) */
 
 #include "extents_status.h"
+#include "fast_commit.h"
 
 /*
  * fourth extended file system inode data in memory
@@ -954,6 +955,15 @@ struct ext4_inode_info {
 	tid_t i_sync_tid;
 	tid_t i_datasync_tid;
 
+	/*
+	 * Fast commit tracking, protected by s_fc_lock: logical blocks
+	 * mapped by transaction i_fc_tid, and a count of tracked changes.
+	 */
+	tid_t i_fc_tid;
+	unsigned int i_fc_seq;
+	ext4_lblk_t i_fc_lblk_start;
+	ext4_lblk_t i_fc_lblk_len;
+
 	/* Precomputed uuid+inum+igen checksum for seeding inode checksums */
 	__u32 i_csum_seed;
 
@@ -1004,6 +1014,7 @@ struct ext4_inode_info {
 #define EXT4_MOUNT_DIOREAD_NOLOCK	0x400000 /* Enable support for dio read nolocking */
 #define EXT4_MOUNT_JOURNAL_CHECKSUM	0x800000 /* Journal checksums */
 #define EXT4_MOUNT_JOURNAL_ASYNC_COMMIT	0x1000000 /* Journal Async Commit */
+#define EXT4_MOUNT_JOURNAL_FAST_COMMIT	0x2000000 /* Fast commits for fsync */
 #define EXT4_MOUNT_DELALLOC		0x8000000 /* Delalloc support */
 #define EXT4_MOUNT_DATA_ERR_ABORT	0x10000000 /* Abort on file data write */
 #define EXT4_MOUNT_BLOCK_VALIDITY	0x20000000 /* Block validity checking */
@@ -1304,9 +1315,13 @@ struct ext4_sb_info {
 	unsigned int s_mb_order2_reqs;
 	unsigned int s_mb_group_prealloc;
 	unsigned int s_max_dir_size_kb;
+	unsigned int s_mb_optimize_scan;
 	/* where last allocation was done - for stream allocation */
-	unsigned long s_mb_last_group;
-	unsigned long s_mb_last_start;
+	struct ext4_mb_stream_goal __percpu *s_mb_stream_goals;
+	/* groups by the order of their largest free extent */
+	struct list_head *s_mb_largest_free_orders;
+	rwlock_t *s_mb_largest_free_orders_locks;
+	atomic_t s_mb_unindexed_groups;	/* not initialized yet */
 
 	/* stats for buddy allocator */
 	atomic_t s_bal_reqs;	/* number of reqs with len > 1 */
@@ -1372,6 +1387,12 @@ struct ext4_sb_info {
 	struct ratelimit_state s_err_ratelimit_state;
 	struct ratelimit_state s_warning_ratelimit_state;
 	struct ratelimit_state s_msg_ratelimit_state;
+
+	/* Fast commits */
+	spinlock_t s_fc_lock;
+	int s_fc_ineligible;		/* s_fc_ineligible_tid is valid */
+	tid_t s_fc_ineligible_tid;	/* latest tid that can't fast commit */
+	struct ext4_fc_replay_state s_fc_replay_state;
 };
 
 static inline struct ext4_sb_info *EXT4_SB(struct super_block *sb)
@@ -2217,6 +2238,19 @@ extern int ext4_check_all_de(struct inode *dir, struct buffer_head *bh,
 /* fsync.c */
 extern int ext4_sync_file(struct file *, loff_t, loff_t, int);
 
+/* fast_commit.c */
+extern void ext4_fc_track_handle(struct super_block *sb, handle_t *handle,
+				 int type);
+extern void ext4_fc_mark_ineligible(struct super_block *sb,
+				    handle_t *handle);
+extern void ext4_fc_track_inode(handle_t *handle, struct inode *inode);
+extern void ext4_fc_track_range(handle_t *handle, struct inode *inode,
+				struct ext4_map_blocks *map, int flags);
+extern int ext4_fc_commit(struct inode *inode, tid_t commit_tid);
+extern int ext4_fc_replay_scan(journal_t *journal, struct buffer_head *bh,
+			       int off, tid_t expected_tid);
+extern int ext4_fc_replay(struct super_block *sb);
+
 /* hash.c */
 extern int ext4fs_dirhash(const char *name, int len, struct
 			  dx_hash_info *hinfo);
@@ -2260,6 +2294,8 @@ extern void ext4_exit_mballoc(void);
 extern void ext4_free_blocks(handle_t *handle, struct inode *inode,
 			     struct buffer_head *bh, ext4_fsblk_t block,
 			     unsigned long count, int flags);
+extern int ext4_mb_mark_bb(handle_t *handle, struct super_block *sb,
+			   ext4_fsblk_t block, unsigned int len);
 extern int ext4_mb_alloc_groupinfo(struct super_block *sb,
 				   ext4_group_t ngroups);
 extern int ext4_mb_add_groupinfo(struct super_block *sb,
@@ -2672,6 +2708,8 @@ struct ext4_group_info {
 	ext4_grpblk_t	bb_free;	/* total free blocks */
 	ext4_grpblk_t	bb_fragments;	/* nr of freespace fragments */
 	ext4_grpblk_t	bb_largest_free_order;/* order of largest frag in BG */
+	ext4_group_t	bb_group;	/* group number */
+	struct          list_head bb_largest_free_order_node;
 	struct          list_head bb_prealloc_list;
 #ifdef DOUBLE_CHECK
 	void            *bb_bitmap;
@@ -2944,6 +2982,11 @@ extern int ext4_find_delalloc_range(struct inode *inode,
 				    ext4_lblk_t lblk_end);
 extern int ext4_find_delalloc_cluster(struct inode *inode, ext4_lblk_t lblk);
 extern ext4_lblk_t ext4_ext_next_allocated_block(struct ext4_ext_path *path);
+extern int ext4_ext_next_mapped_block(struct inode *inode, ext4_lblk_t lblk,
+				      ext4_lblk_t *next);
+extern int ext4_ext_replay_set_range(handle_t *handle, struct inode *inode,
+				     ext4_lblk_t lblk, ext4_fsblk_t pblk,
+				     unsigned int len, int unwritten);
 extern int ext4_fiemap(struct inode *inode, struct fiemap_extent_info *fieinfo,
 			__u64 start, __u64 len);
 extern int ext4_ext_precache(struct inode *inode);
@@ -342,9 +342,16 @@ static inline int ext4_journal_extend(handle_t *handle, int nblocks)
 
 static inline int ext4_journal_restart(handle_t *handle, int nblocks)
 {
-	if (ext4_handle_valid(handle))
-		return jbd2_journal_restart(handle, nblocks);
-	return 0;
+	int err;
+
+	if (!ext4_handle_valid(handle))
+		return 0;
+	err = jbd2_journal_restart(handle, nblocks);
+	/* The handle may have moved on to a new transaction */
+	if (!err)
+		ext4_fc_track_handle(handle->h_transaction->t_journal->j_private,
+				     handle, handle->h_type);
+	return err;
 }
 
 static inline int ext4_journal_blocks_per_page(struct inode *inode)
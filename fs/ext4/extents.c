@@ -4630,6 +4630,87 @@ out2:
 	return err ? err : allocated;
 }
 
+/*
+ * ext4_ext_next_mapped_block:
+ * finds the first logical block at or after @lblk that is mapped in the
+ * extent tree, EXT_MAX_BLOCKS if there is none.
+ */
+int ext4_ext_next_mapped_block(struct inode *inode, ext4_lblk_t lblk,
+			       ext4_lblk_t *next)
+{
+	struct ext4_ext_path *path;
+	struct ext4_extent *ex;
+	ext4_lblk_t ee_block;
+
+	down_read(&EXT4_I(inode)->i_data_sem);
+	path = ext4_find_extent(inode, lblk, NULL, 0);
+	if (IS_ERR(path)) {
+		up_read(&EXT4_I(inode)->i_data_sem);
+		return PTR_ERR(path);
+	}
+
+	ex = path[ext_depth(inode)].p_ext;
+	ee_block = ex ? le32_to_cpu(ex->ee_block) : 0;
+	if (ex && ee_block > lblk)
+		*next = ee_block;
+	else if (ex && lblk < ee_block + ext4_ext_get_actual_len(ex))
+		*next = lblk;
+	else
+		*next = ext4_ext_next_allocated_block(path);
+
+	ext4_ext_drop_refs(path);
+	kfree(path);
+	up_read(&EXT4_I(inode)->i_data_sem);
+	return 0;
+}
+
+/*
+ * ext4_ext_replay_set_range:
+ * maps the hole at @lblk to @pblk on for fast commit replay, which has
+ * already claimed the blocks.  The new extent stops at the next mapped
+ * block if that comes before @len blocks.  Returns the number of blocks
+ * mapped.
+ */
+int ext4_ext_replay_set_range(handle_t *handle, struct inode *inode,
+			      ext4_lblk_t lblk, ext4_fsblk_t pblk,
+			      unsigned int len, int unwritten)
+{
+	struct ext4_ext_path *path;
+	struct ext4_extent newex;
+	unsigned int max_len;
+	int err;
+
+	max_len = unwritten ? EXT_UNWRITTEN_MAX_LEN : EXT_INIT_MAX_LEN;
+	if (len > max_len)
+		len = max_len;
+
+	down_write(&EXT4_I(inode)->i_data_sem);
+	path = ext4_find_extent(inode, lblk, NULL, 0);
+	if (IS_ERR(path)) {
+		err = PTR_ERR(path);
+		goto out;
+	}
+
+	newex.ee_block = cpu_to_le32(lblk);
+	newex.ee_len = cpu_to_le16(len);
+	ext4_ext_check_overlap(EXT4_SB(inode->i_sb), inode, &newex, path);
+	len = ext4_ext_get_actual_len(&newex);
+	ext4_ext_store_pblock(&newex, pblk);
+	if (unwritten)
+		ext4_ext_mark_unwritten(&newex);
+
+	err = ext4_ext_insert_extent(handle, inode, &path, &newex, 0);
+	if (!err)
+		err = ext4_es_insert_extent(inode, lblk, len, pblk, unwritten ?
+					    EXTENT_STATUS_UNWRITTEN :
+					    EXTENT_STATUS_WRITTEN);
+	ext4_ext_drop_refs(path);
+	kfree(path);
+out:
+	up_write(&EXT4_I(inode)->i_data_sem);
+	return err ? err : len;
+}
+
 void ext4_ext_truncate(handle_t *handle, struct inode *inode)
 {
 	struct super_block *sb = inode->i_sb;
@@ -0,0 +1,797 @@
+/*
+ *  fs/ext4/fast_commit.c
+ *
+ * Fast commits: make fsync() durable without committing the running
+ * transaction.
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+/*
+ * A full commit writes every metadata block the running transaction
+ * touched, plus a descriptor and a commit block, and waits for all of it.
+ * For a workload that appends to or overwrites a file and fsyncs it, most
+ * of that is bitmap, group descriptor and extent tree blocks that can be
+ * recomputed from what actually changed: the inode's attributes and which
+ * of its logical blocks got mapped where.
+ *
+ * With the fast_commit mount option, ext4_sync_file() logs just that, in
+ * the format described in fast_commit.h, to the fast commit area jbd2 sets
+ * aside at the end of the journal.  Every fast commit is self contained
+ * and logs the fsynced inode and every extent mapped in its span of logical
+ * blocks touched by the running transaction.  The next full commit makes
+ * them obsolete.  After a crash, recovery first replays the log as usual
+ * and then hands the fast commit area to ext4_fc_replay_scan(), which
+ * validates the fast commits of the transaction that never made it to the
+ * log; ext4_fc_replay() applies them once the filesystem is set up.  jbd2
+ * keeps handing the same fast commits to recovery until their replay has
+ * been committed, so a crash or a failed mount before that replays them
+ * again on the next mount.
+ *
+ * Only inode attribute updates and block mapping are logged.  Any other
+ * change makes the running transaction ineligible, and fsync() falls back
+ * to a full commit until the transaction is committed:
+ *
+ *  - handles of any type but EXT4_HT_INODE, EXT4_HT_WRITE_PAGE,
+ *    EXT4_HT_MAP_BLOCKS and EXT4_HT_EXT_CONVERT (namespace operations,
+ *    truncate, xattrs, quota, resize, ...),
+ *  - changes to inodes that aren't extent mapped regular files, or have
+ *    inline or journalled data,
+ *  - orphan list updates, unwritten conversion of written extents,
+ *    in-inode xattr moves and generation changes.
+ */
+
+#include <linux/fs.h>
+#include <linux/crc32.h>
+#include <linux/quotaops.h>
+#include "ext4.h"
+#include "ext4_jbd2.h"
+
+/* Attempts at catching the inode between two of its updates */
+#define EXT4_FC_MAX_TRIES	3
+
+/* Passes of ext4_fc_replay() */
+#define EXT4_FC_REPLAY_ALLOC	0	/* claim the blocks of all ranges */
+#define EXT4_FC_REPLAY_APPLY	1	/* update inodes and extent trees */
+
+static int ext4_fc_tracking(struct super_block *sb, handle_t *handle)
+{
+	return test_opt(sb, JOURNAL_FAST_COMMIT) &&
+	       ext4_handle_valid(handle) && handle->h_transaction;
+}
+
+static int ext4_fc_eligible_inode(struct inode *inode)
+{
+	return S_ISREG(inode->i_mode) &&
+	       ext4_test_inode_flag(inode, EXT4_INODE_EXTENTS) &&
+	       !ext4_has_inline_data(inode) &&
+	       !ext4_should_journal_data(inode);
+}
+
+static void __ext4_fc_mark_ineligible(struct ext4_sb_info *sbi, tid_t tid)
+{
+	spin_lock(&sbi->s_fc_lock);
+	if (!sbi->s_fc_ineligible || tid_gt(tid, sbi->s_fc_ineligible_tid)) {
+		sbi->s_fc_ineligible = 1;
+		sbi->s_fc_ineligible_tid = tid;
+	}
+	spin_unlock(&sbi->s_fc_lock);
+}
+
+static int ext4_fc_is_ineligible(struct ext4_sb_info *sbi, tid_t tid)
+{
+	int ret;
+
+	spin_lock(&sbi->s_fc_lock);
+	ret = sbi->s_fc_ineligible && tid_geq(sbi->s_fc_ineligible_tid, tid);
+	spin_unlock(&sbi->s_fc_lock);
+	return ret;
+}
+
+/**
+ * ext4_fc_mark_ineligible() - keep the transaction of @handle from being
+ * fast committed
+ * @sb: Filesystem.
+ * @handle: Handle making a change fast commits can't log.
+ */
+void ext4_fc_mark_ineligible(struct super_block *sb, handle_t *handle)
+{
+	if (ext4_fc_tracking(sb, handle))
+		__ext4_fc_mark_ineligible(EXT4_SB(sb),
+					  handle->h_transaction->t_tid);
+}
+
+/**
+ * ext4_fc_track_handle() - note a handle being started
+ * @sb: Filesystem.
+ * @handle: The handle, started or restarted.
+ * @type: Its EXT4_HT_* type.
+ */
+void ext4_fc_track_handle(struct super_block *sb, handle_t *handle, int type)
+{
+	switch (type) {
+	case EXT4_HT_INODE:
+	case EXT4_HT_WRITE_PAGE:
+	case EXT4_HT_MAP_BLOCKS:
+	case EXT4_HT_EXT_CONVERT:
+		return;
+	}
+	ext4_fc_mark_ineligible(sb, handle);
+}
+
+/* Forget what was tracked for an already committed transaction. */
+static void ext4_fc_reset(struct ext4_inode_info *ei, tid_t tid)
+{
+	if (ei->i_fc_tid != tid) {
+		ei->i_fc_tid = tid;
+		ei->i_fc_lblk_len = 0;
+	}
+}
+
+/**
+ * ext4_fc_track_inode() - note an inode update
+ * @handle: Handle the inode was updated under.
+ * @inode: The inode.
+ */
+void ext4_fc_track_inode(handle_t *handle, struct inode *inode)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(inode->i_sb);
+	struct ext4_inode_info *ei = EXT4_I(inode);
+
+	if (!ext4_fc_tracking(inode->i_sb, handle))
+		return;
+	if (!ext4_fc_eligible_inode(inode)) {
+		ext4_fc_mark_ineligible(inode->i_sb, handle);
+		return;
+	}
+
+	spin_lock(&sbi->s_fc_lock);
+	ext4_fc_reset(ei, handle->h_transaction->t_tid);
+	ei->i_fc_seq++;
+	spin_unlock(&sbi->s_fc_lock);
+}
+
+/**
+ * ext4_fc_track_range() - note blocks being mapped
+ * @handle: Handle the blocks were mapped under.
+ * @inode: The inode.
+ * @map: What ext4_map_blocks() mapped.
+ * @flags: The EXT4_GET_BLOCKS_* flags it was called with.
+ */
+void ext4_fc_track_range(handle_t *handle, struct inode *inode,
+			 struct ext4_map_blocks *map, int flags)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(inode->i_sb);
+	struct ext4_inode_info *ei = EXT4_I(inode);
+	u64 start, end;
+
+	if (!ext4_fc_tracking(inode->i_sb, handle))
+		return;
+	if (!ext4_fc_eligible_inode(inode) ||
+	    (flags & EXT4_GET_BLOCKS_CONVERT_UNWRITTEN)) {
+		ext4_fc_mark_ineligible(inode->i_sb, handle);
+		return;
+	}
+
+	start = map->m_lblk;
+	end = min_t(u64, start + map->m_len, EXT_MAX_BLOCKS);
+
+	spin_lock(&sbi->s_fc_lock);
+	ext4_fc_reset(ei, handle->h_transaction->t_tid);
+	if (ei->i_fc_lblk_len) {
+		start = min_t(u64, start, ei->i_fc_lblk_start);
+		end = max_t(u64, end,
+			    (u64)ei->i_fc_lblk_start + ei->i_fc_lblk_len);
+	}
+	ei->i_fc_lblk_start = start;
+	ei->i_fc_lblk_len = end - start;
+	ei->i_fc_seq++;
+	spin_unlock(&sbi->s_fc_lock);
+}
+
+/*
+ * Writing fast commits.  Records are laid out in the blocks jbd2 hands
+ * out, which are only written once the whole fast commit is laid out, so
+ * that updates can be let in again before the I/O.
+ */
+struct ext4_fc_writer {
+	journal_t *journal;
+	struct buffer_head *bh;		/* block being filled */
+	int off;			/* bytes of it used */
+	int nblks;			/* blocks handed out */
+	u32 crc;			/* of the blocks written so far */
+};
+
+static void ext4_fc_close_block(struct ext4_fc_writer *wr)
+{
+	wr->crc = crc32_le(wr->crc, wr->bh->b_data, wr->off);
+	wr->bh = NULL;
+}
+
+/* Returns where the @len bytes of a @tag record go. */
+static void *ext4_fc_reserve(struct ext4_fc_writer *wr, u16 tag, u16 len)
+{
+	int bsize = wr->journal->j_blocksize;
+	struct ext4_fc_tl *tl;
+	int err;
+
+	if (wr->bh && wr->off + sizeof(*tl) + len > bsize) {
+		/* a block the last record filled exactly has no room for a PAD */
+		if (bsize - wr->off >= sizeof(*tl)) {
+			tl = (struct ext4_fc_tl *)(wr->bh->b_data + wr->off);
+			tl->fc_tag = cpu_to_le16(EXT4_FC_TAG_PAD);
+			tl->fc_len = cpu_to_le16(bsize - wr->off - sizeof(*tl));
+			wr->off = bsize;
+		}
+		ext4_fc_close_block(wr);
+	}
+	if (!wr->bh) {
+		err = jbd2_fc_get_buf(wr->journal, &wr->bh);
+		if (err)
+			return ERR_PTR(err);
+		memset(wr->bh->b_data, 0, bsize);
+		wr->off = 0;
+		wr->nblks++;
+	}
+
+	tl = (struct ext4_fc_tl *)(wr->bh->b_data + wr->off);
+	tl->fc_tag = cpu_to_le16(tag);
+	tl->fc_len = cpu_to_le16(len);
+	wr->off += sizeof(*tl) + len;
+	return tl + 1;
+}
+
+static int ext4_fc_add(struct ext4_fc_writer *wr, u16 tag, void *val,
+		       u16 len)
+{
+	void *dst = ext4_fc_reserve(wr, tag, len);
+
+	if (IS_ERR(dst))
+		return PTR_ERR(dst);
+	memcpy(dst, val, len);
+	return 0;
+}
+
+static void ext4_fc_fill_inode(struct inode *inode, struct ext4_fc_inode *fi)
+{
+	struct ext4_inode_info *ei = EXT4_I(inode);
+
+	memset(fi, 0, sizeof(*fi));
+	fi->fc_ino = cpu_to_le32(inode->i_ino);
+	fi->fc_generation = cpu_to_le32(inode->i_generation);
+	fi->fc_flags = cpu_to_le32(ei->i_flags & EXT4_FL_USER_MODIFIABLE);
+	fi->fc_mode = cpu_to_le16(inode->i_mode);
+	fi->fc_uid = cpu_to_le32(i_uid_read(inode));
+	fi->fc_gid = cpu_to_le32(i_gid_read(inode));
+	fi->fc_size = cpu_to_le64(ei->i_disksize);
+	fi->fc_atime = cpu_to_le64(inode->i_atime.tv_sec);
+	fi->fc_ctime = cpu_to_le64(inode->i_ctime.tv_sec);
+	fi->fc_mtime = cpu_to_le64(inode->i_mtime.tv_sec);
+	fi->fc_atime_nsec = cpu_to_le32(inode->i_atime.tv_nsec);
+	fi->fc_ctime_nsec = cpu_to_le32(inode->i_ctime.tv_nsec);
+	fi->fc_mtime_nsec = cpu_to_le32(inode->i_mtime.tv_nsec);
+}
+
+/*
+ * Lay out the fast commit of @inode and what is mapped in its tracked span
+ * in @wr's blocks, with updates locked out so that both stay put.
+ */
+static int ext4_fc_write(struct inode *inode, tid_t tid,
+			 struct ext4_fc_writer *wr)
+{
+	struct ext4_inode_info *ei = EXT4_I(inode);
+	struct ext4_fc_head head;
+	struct ext4_fc_inode fi;
+	struct ext4_fc_add_range range;
+	struct ext4_fc_tail tail, *dst;
+	struct ext4_map_blocks map;
+	ext4_lblk_t lblk, next;
+	u64 end;
+	int ret;
+
+	head.fc_features = 0;
+	head.fc_tid = cpu_to_le32(tid);
+	ret = ext4_fc_add(wr, EXT4_FC_TAG_HEAD, &head, sizeof(head));
+	if (ret)
+		return ret;
+
+	ext4_fc_fill_inode(inode, &fi);
+	ret = ext4_fc_add(wr, EXT4_FC_TAG_INODE, &fi, sizeof(fi));
+	if (ret)
+		return ret;
+
+	spin_lock(&EXT4_SB(inode->i_sb)->s_fc_lock);
+	lblk = ei->i_fc_lblk_start;
+	end = (u64)lblk + ei->i_fc_lblk_len;
+	spin_unlock(&EXT4_SB(inode->i_sb)->s_fc_lock);
+
+	while (lblk < end) {
+		map.m_lblk = lblk;
+		map.m_len = min_t(u64, end - lblk, INT_MAX);
+		ret = ext4_map_blocks(NULL, inode, &map, 0);
+		if (ret < 0)
+			return ret;
+		if (!ret) {
+			ret = ext4_ext_next_mapped_block(inode, lblk, &next);
+			if (ret)
+				return ret;
+			lblk = next > lblk ? next : lblk + 1;
+			continue;
+		}
+
+		range.fc_ino = cpu_to_le32(inode->i_ino);
+		range.fc_lblk = cpu_to_le32(lblk);
+		range.fc_len = cpu_to_le32(ret);
+		range.fc_flags = cpu_to_le32(map.m_flags & EXT4_MAP_UNWRITTEN ?
+					     EXT4_FC_RANGE_UNWRITTEN : 0);
+		range.fc_pblk = cpu_to_le64(map.m_pblk);
+		lblk += ret;
+		ret = ext4_fc_add(wr, EXT4_FC_TAG_ADD_RANGE, &range,
+				  sizeof(range));
+		if (ret)
+			return ret;
+	}
+
+	dst = ext4_fc_reserve(wr, EXT4_FC_TAG_TAIL, sizeof(tail));
+	if (IS_ERR(dst))
+		return PTR_ERR(dst);
+	tail.fc_tid = cpu_to_le32(tid);
+	tail.fc_crc = cpu_to_le32(crc32_le(wr->crc, wr->bh->b_data,
+				(char *)dst - wr->bh->b_data +
+				offsetof(struct ext4_fc_tail, fc_crc)));
+	memcpy(dst, &tail, sizeof(tail));
+	ext4_fc_close_block(wr);
+	return 0;
+}
+
+/*
+ * Write the blocks ext4_fc_write() laid out, unless it failed with @ret,
+ * and make them durable.  Updates may run meanwhile.
+ */
+static int ext4_fc_sync(struct ext4_fc_writer *wr, int ret)
+{
+	journal_t *journal = wr->journal;
+
+	if (wr->nblks) {
+		int err;
+
+		if (!ret)
+			jbd2_fc_submit_bufs(journal, wr->nblks);
+		/* also drops the blocks of a fast commit that wasn't written */
+		err = jbd2_fc_wait_bufs(journal, wr->nblks);
+		if (!ret)
+			ret = err;
+	}
+	if (!ret && (journal->j_flags & JBD2_BARRIER)) {
+		/* Make the fast commit and the data it points at durable */
+		if (journal->j_fs_dev != journal->j_dev)
+			blkdev_issue_flush(journal->j_fs_dev, GFP_NOFS, NULL);
+		ret = blkdev_issue_flush(journal->j_dev, GFP_NOFS, NULL);
+	}
+	return ret;
+}
+
+/**
+ * ext4_fc_commit() - fsync an inode through a fast commit
+ * @inode: Inode to make durable.
+ * @commit_tid: Transaction holding its latest changes.
+ *
+ * Returns 0 once the changes to @inode are durable, or -EAGAIN if the
+ * caller has to commit @commit_tid in full instead.
+ */
+int ext4_fc_commit(struct inode *inode, tid_t commit_tid)
+{
+	struct super_block *sb = inode->i_sb;
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	struct ext4_inode_info *ei = EXT4_I(inode);
+	journal_t *journal = sbi->s_journal;
+	struct ext4_fc_writer wr = { .journal = journal, .crc = ~0 };
+	unsigned int seq;
+	int tries = 0;
+	int ret;
+
+retry:
+	if (ext4_fc_is_ineligible(sbi, commit_tid))
+		return -EAGAIN;
+
+	spin_lock(&sbi->s_fc_lock);
+	seq = ei->i_fc_seq;
+	spin_unlock(&sbi->s_fc_lock);
+
+	/*
+	 * Whatever blocks get logged must hold their data first.  Do that
+	 * before owning the fast commit area: writeback may need the
+	 * running transaction to commit.
+	 */
+	ret = filemap_write_and_wait(inode->i_mapping);
+	if (ret)
+		return ret;
+
+	if (jbd2_fc_begin_commit(journal, commit_tid))
+		return -EAGAIN;
+	jbd2_journal_lock_updates(journal);
+
+	ret = -EAGAIN;
+	if (ext4_fc_is_ineligible(sbi, commit_tid))
+		goto out;
+	spin_lock(&sbi->s_fc_lock);
+	if (ei->i_fc_tid != commit_tid) {
+		spin_unlock(&sbi->s_fc_lock);
+		goto out;
+	}
+	if (ei->i_fc_seq != seq) {
+		/* Updated again since writeback: there may be new blocks */
+		spin_unlock(&sbi->s_fc_lock);
+		jbd2_journal_unlock_updates(journal);
+		jbd2_fc_end_commit(journal);
+		if (++tries < EXT4_FC_MAX_TRIES)
+			goto retry;
+		return -EAGAIN;
+	}
+	spin_unlock(&sbi->s_fc_lock);
+
+	/*
+	 * Only lay the fast commit out with updates locked out: its records
+	 * are a snapshot of the inode and its mapping by then, and running
+	 * handles needn't wait for the I/O and the cache flush.
+	 */
+	ret = ext4_fc_write(inode, commit_tid, &wr);
+	jbd2_journal_unlock_updates(journal);
+	ret = ext4_fc_sync(&wr, ret);
+	if (ret) {
+		/*
+		 * A partial fast commit ends replay of the transaction's fast
+		 * commits: the transaction has to be committed in full now.
+		 */
+		__ext4_fc_mark_ineligible(sbi, commit_tid);
+		ret = -EAGAIN;
+	}
+	jbd2_fc_end_commit(journal);
+	return ret;
+
+out:
+	jbd2_journal_unlock_updates(journal);
+	jbd2_fc_end_commit(journal);
+	return ret;
+}
+
+/**
+ * ext4_fc_replay_scan() - jbd2 j_fc_replay_callback
+ * @journal: Journal being recovered.
+ * @bh: Block @off of the fast commit area.
+ * @off: Offset of @bh in the fast commit area.
+ * @expected_tid: Transaction fast commits have to belong to.
+ *
+ * Validates fast commits block by block, up to the first one that isn't
+ * complete or doesn't belong to @expected_tid.
+ */
+int ext4_fc_replay_scan(journal_t *journal, struct buffer_head *bh,
+			int off, tid_t expected_tid)
+{
+	struct super_block *sb = journal->j_private;
+	struct ext4_fc_replay_state *state = &EXT4_SB(sb)->s_fc_replay_state;
+	char *start = bh->b_data, *end = start + journal->j_blocksize;
+	struct ext4_fc_head head;
+	struct ext4_fc_tail tail;
+	struct ext4_fc_tl tl;
+	char *cur;
+	int len;
+
+	if (off == 0)
+		memset(state, 0, sizeof(*state));
+
+	for (cur = start; cur + sizeof(tl) <= end; cur += sizeof(tl) + len) {
+		memcpy(&tl, cur, sizeof(tl));
+		len = le16_to_cpu(tl.fc_len);
+		if (cur + sizeof(tl) + len > end)
+			return JBD2_FC_REPLAY_STOP;
+
+		switch (le16_to_cpu(tl.fc_tag)) {
+		case EXT4_FC_TAG_HEAD:
+			if (state->fc_in_commit || cur != start ||
+			    len != sizeof(head))
+				return JBD2_FC_REPLAY_STOP;
+			memcpy(&head, cur + sizeof(tl), sizeof(head));
+			if (head.fc_features ||
+			    le32_to_cpu(head.fc_tid) != expected_tid)
+				return JBD2_FC_REPLAY_STOP;
+			state->fc_in_commit = 1;
+			state->fc_crc = crc32_le(~0, cur, sizeof(tl) + len);
+			break;
+		case EXT4_FC_TAG_INODE:
+		case EXT4_FC_TAG_ADD_RANGE:
+		case EXT4_FC_TAG_PAD:
+			if (!state->fc_in_commit)
+				return JBD2_FC_REPLAY_STOP;
+			state->fc_crc = crc32_le(state->fc_crc, cur,
+						 sizeof(tl) + len);
+			break;
+		case EXT4_FC_TAG_TAIL:
+			if (!state->fc_in_commit || len != sizeof(tail))
+				return JBD2_FC_REPLAY_STOP;
+			memcpy(&tail, cur + sizeof(tl), sizeof(tail));
+			state->fc_crc = crc32_le(state->fc_crc, cur,
+				sizeof(tl) + offsetof(struct ext4_fc_tail, fc_crc));
+			if (le32_to_cpu(tail.fc_tid) != expected_tid ||
+			    le32_to_cpu(tail.fc_crc) != state->fc_crc)
+				return JBD2_FC_REPLAY_STOP;
+			state->fc_in_commit = 0;
+			state->fc_valid_blks = off + 1;
+			state->fc_commits++;
+			/* The next fast commit starts on a fresh block */
+			return JBD2_FC_REPLAY_VALID;
+		default:
+			return JBD2_FC_REPLAY_STOP;
+		}
+	}
+	return JBD2_FC_REPLAY_CONTINUE;
+}
+
+static struct inode *ext4_fc_replay_iget(struct super_block *sb,
+					 unsigned long ino, u32 generation)
+{
+	struct inode *inode;
+
+	inode = ext4_iget(sb, ino);
+	if (IS_ERR(inode)) {
+		ext4_warning(sb, "fast commit replay: can't read inode %lu",
+			     ino);
+		return inode;
+	}
+	if (inode->i_generation != generation || !S_ISREG(inode->i_mode) ||
+	    !ext4_test_inode_flag(inode, EXT4_INODE_EXTENTS)) {
+		ext4_warning(sb, "fast commit replay: inode %lu changed, "
+			     "skipping it", ino);
+		iput(inode);
+		return ERR_PTR(-ESTALE);
+	}
+	return inode;
+}
+
+static int ext4_fc_replay_inode(struct super_block *sb, char *val)
+{
+	struct ext4_fc_inode fi;
+	struct ext4_inode_info *ei;
+	struct inode *inode;
+	handle_t *handle;
+	u32 flags;
+	int ret;
+
+	memcpy(&fi, val, sizeof(fi));
+	inode = ext4_fc_replay_iget(sb, le32_to_cpu(fi.fc_ino),
+				    le32_to_cpu(fi.fc_generation));
+	if (IS_ERR(inode))
+		return 0;
+	ei = EXT4_I(inode);
+
+	handle = ext4_journal_start(inode, EXT4_HT_INODE, 2);
+	if (IS_ERR(handle)) {
+		iput(inode);
+		return PTR_ERR(handle);
+	}
+
+	inode->i_mode = (inode->i_mode & S_IFMT) |
+			(le16_to_cpu(fi.fc_mode) & ~S_IFMT);
+	i_uid_write(inode, le32_to_cpu(fi.fc_uid));
+	i_gid_write(inode, le32_to_cpu(fi.fc_gid));
+	ei->i_disksize = le64_to_cpu(fi.fc_size);
+	i_size_write(inode, ei->i_disksize);
+	inode->i_atime.tv_sec = le64_to_cpu(fi.fc_atime);
+	inode->i_ctime.tv_sec = le64_to_cpu(fi.fc_ctime);
+	inode->i_mtime.tv_sec = le64_to_cpu(fi.fc_mtime);
+	inode->i_atime.tv_nsec = le32_to_cpu(fi.fc_atime_nsec);
+	inode->i_ctime.tv_nsec = le32_to_cpu(fi.fc_ctime_nsec);
+	inode->i_mtime.tv_nsec = le32_to_cpu(fi.fc_mtime_nsec);
+	flags = le32_to_cpu(fi.fc_flags) & EXT4_FL_USER_MODIFIABLE;
+	ei->i_flags = (ei->i_flags & ~EXT4_FL_USER_MODIFIABLE) | flags;
+	ext4_set_inode_flags(inode);
+
+	ret = ext4_mark_inode_dirty(handle, inode);
+	ext4_journal_stop(handle);
+	iput(inode);
+	return ret;
+}
+
+/* Claim the blocks of a range, a group at a time. */
+static int ext4_fc_replay_alloc(struct super_block *sb, ext4_fsblk_t pblk,
+				unsigned int len)
+{
+	ext4_group_t group;
+	ext4_grpblk_t offset;
+	handle_t *handle;
+	unsigned int n;
+	int ret = 0;
+
+	if (!ext4_data_block_valid(EXT4_SB(sb), pblk, len)) {
+		ext4_warning(sb, "fast commit replay: bad blocks %llu-%llu",
+			     pblk, pblk + len - 1);
+		return 0;
+	}
+
+	while (len && !ret) {
+		ext4_get_group_no_and_offset(sb, pblk, &group, &offset);
+		n = min_t(unsigned int, len,
+			  EXT4_BLOCKS_PER_GROUP(sb) - offset);
+
+		/* block bitmap and group descriptor */
+		handle = ext4_journal_start_sb(sb, EXT4_HT_MISC, 2);
+		if (IS_ERR(handle))
+			return PTR_ERR(handle);
+		ret = ext4_mb_mark_bb(handle, sb, pblk, n);
+		ext4_journal_stop(handle);
+
+		pblk += n;
+		len -= n;
+	}
+	return ret;
+}
+
+/* Map a range into its inode. */
+static int ext4_fc_replay_map(struct inode *inode, ext4_lblk_t lblk,
+			      ext4_fsblk_t pblk, unsigned int len,
+			      int unwritten)
+{
+	struct ext4_map_blocks map;
+	handle_t *handle;
+	int ret = 0, err;
+
+	while (len) {
+		handle = ext4_journal_start(inode, EXT4_HT_MAP_BLOCKS,
+				ext4_chunk_trans_blocks(inode,
+							EXT_INIT_MAX_LEN));
+		if (IS_ERR(handle))
+			return PTR_ERR(handle);
+
+		map.m_lblk = lblk;
+		map.m_len = len;
+		ret = ext4_map_blocks(handle, inode, &map, 0);
+		if (ret == 0) {
+			ret = ext4_ext_replay_set_range(handle, inode, lblk,
+							pblk, len, unwritten);
+			if (ret > 0)
+				dquot_alloc_block_nofail(inode, ret);
+		} else if (ret > 0 && map.m_pblk != pblk) {
+			ext4_warning(inode->i_sb, "fast commit replay: inode "
+				     "%lu block %u is mapped elsewhere",
+				     inode->i_ino, lblk);
+		} else if (ret > 0 && (map.m_flags & EXT4_MAP_UNWRITTEN) &&
+			   !unwritten) {
+			ret = ext4_map_blocks(handle, inode, &map,
+					      EXT4_GET_BLOCKS_IO_CONVERT_EXT);
+		}
+
+		err = ext4_mark_inode_dirty(handle, inode);
+		ext4_journal_stop(handle);
+		if (ret == 0)
+			ret = -EIO;
+		if (ret < 0)
+			return ret;
+		if (err)
+			return err;
+
+		lblk += ret;
+		pblk += ret;
+		len -= min_t(unsigned int, len, ret);
+	}
+	return 0;
+}
+
+static int ext4_fc_replay_range(struct super_block *sb, char *val, int pass)
+{
+	struct ext4_fc_add_range range;
+	struct inode *inode;
+	int ret;
+
+	memcpy(&range, val, sizeof(range));
+	if (pass == EXT4_FC_REPLAY_ALLOC)
+		return ext4_fc_replay_alloc(sb, le64_to_cpu(range.fc_pblk),
+					    le32_to_cpu(range.fc_len));
+
+	inode = ext4_iget(sb, le32_to_cpu(range.fc_ino));
+	if (IS_ERR(inode))
+		return 0;
+	if (!S_ISREG(inode->i_mode) ||
+	    !ext4_test_inode_flag(inode, EXT4_INODE_EXTENTS)) {
+		iput(inode);
+		return 0;
+	}
+	ret = ext4_fc_replay_map(inode, le32_to_cpu(range.fc_lblk),
+				 le64_to_cpu(range.fc_pblk),
+				 le32_to_cpu(range.fc_len),
+				 le32_to_cpu(range.fc_flags) &
+				 EXT4_FC_RANGE_UNWRITTEN);
+	iput(inode);
+	return ret;
+}
+
+static int ext4_fc_replay_pass(struct super_block *sb, int pass)
+{
+	journal_t *journal = EXT4_SB(sb)->s_journal;
+	int nblks = EXT4_SB(sb)->s_fc_replay_state.fc_valid_blks;
+	unsigned long long pblock;
+	struct buffer_head *bh;
+	struct ext4_fc_tl tl;
+	char *cur, *end;
+	int i, len, ret = 0;
+
+	for (i = 0; i < nblks && !ret; i++) {
+		ret = jbd2_journal_bmap(journal, journal->j_fc_first + i,
+					&pblock);
+		if (ret)
+			break;
+		bh = __bread(journal->j_dev, pblock, journal->j_blocksize);
+		if (!bh)
+			return -EIO;
+
+		end = bh->b_data + journal->j_blocksize;
+		for (cur = bh->b_data; cur + sizeof(tl) <= end && !ret;
+		     cur += sizeof(tl) + len) {
+			memcpy(&tl, cur, sizeof(tl));
+			len = le16_to_cpu(tl.fc_len);
+			if (cur + sizeof(tl) + len > end)
+				break;
+
+			switch (le16_to_cpu(tl.fc_tag)) {
+			case EXT4_FC_TAG_INODE:
+				if (pass == EXT4_FC_REPLAY_APPLY)
+					ret = ext4_fc_replay_inode(sb,
+							cur + sizeof(tl));
+				break;
+			case EXT4_FC_TAG_ADD_RANGE:
+				ret = ext4_fc_replay_range(sb,
+						cur + sizeof(tl), pass);
+				break;
+			}
+		}
+		brelse(bh);
+	}
+	return ret;
+}
+
+/**
+ * ext4_fc_replay() - apply the fast commits found by recovery
+ * @sb: Filesystem being mounted.
+ *
+ * Blocks of all logged ranges are claimed before any of them gets mapped,
+ * so that extent tree blocks allocated while mapping one can't take the
+ * blocks of another.
+ */
+int ext4_fc_replay(struct super_block *sb)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	struct ext4_fc_replay_state *state = &sbi->s_fc_replay_state;
+	unsigned long s_flags = sb->s_flags;
+	int ret;
+
+	if (!state->fc_valid_blks)
+		return 0;
+
+	if (s_flags & MS_RDONLY) {
+		ext4_msg(sb, KERN_INFO, "write access will be enabled "
+			 "during fast commit replay");
+		sb->s_flags &= ~MS_RDONLY;
+	}
+
+	ret = ext4_fc_replay_pass(sb, EXT4_FC_REPLAY_ALLOC);
+	if (!ret)
+		ret = ext4_fc_replay_pass(sb, EXT4_FC_REPLAY_APPLY);
+	/*
+	 * The fast commit area gets reused from here on: get what it held
+	 * into the log first.
+	 */
+	if (!ret)
+		ret = jbd2_journal_force_commit(sbi->s_journal);
+	if (!ret)
+		jbd2_fc_replay_done(sbi->s_journal);
+	if (!ret)
+		ext4_msg(sb, KERN_INFO, "replayed %d fast commits",
+			 state->fc_commits);
+
+	memset(state, 0, sizeof(*state));
+	sb->s_flags = s_flags;
+	return ret;
+}
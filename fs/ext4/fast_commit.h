@@ -0,0 +1,87 @@
+/*
+ *  fs/ext4/fast_commit.h
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef _EXT4_FAST_COMMIT_H
+#define _EXT4_FAST_COMMIT_H
+
+/*
+ * On-disk format of fast commits.
+ *
+ * A fast commit is a stream of tag-length-value records written to the
+ * jbd2 fast commit area, starting at a block boundary with a HEAD and
+ * ending with a TAIL that carries a crc32 of everything from the HEAD on.
+ * Records never straddle blocks: the rest of a block that can't hold the
+ * next record is covered by a PAD.  Values follow their ext4_fc_tl
+ * directly and are little endian; all sizes are multiples of four.
+ */
+#define EXT4_FC_TAG_HEAD	0x0001
+#define EXT4_FC_TAG_INODE	0x0002
+#define EXT4_FC_TAG_ADD_RANGE	0x0003
+#define EXT4_FC_TAG_PAD		0x0004
+#define EXT4_FC_TAG_TAIL	0x0005
+
+struct ext4_fc_tl {
+	__le16 fc_tag;
+	__le16 fc_len;			/* length of the value */
+};
+
+struct ext4_fc_head {
+	__le32 fc_features;		/* none defined yet */
+	__le32 fc_tid;
+};
+
+/* Inode attributes as of the fast commit */
+struct ext4_fc_inode {
+	__le32 fc_ino;
+	__le32 fc_generation;
+	__le32 fc_flags;		/* EXT4_FL_USER_MODIFIABLE only */
+	__le16 fc_mode;
+	__le16 fc_reserved;
+	__le32 fc_uid;
+	__le32 fc_gid;
+	__le64 fc_size;			/* i_disksize */
+	__le64 fc_atime;
+	__le64 fc_ctime;
+	__le64 fc_mtime;
+	__le32 fc_atime_nsec;
+	__le32 fc_ctime_nsec;
+	__le32 fc_mtime_nsec;
+	__le32 fc_reserved2;
+};
+
+#define EXT4_FC_RANGE_UNWRITTEN	0x0001
+
+/* Logical blocks fc_lblk..fc_lblk + fc_len - 1 map to fc_pblk on */
+struct ext4_fc_add_range {
+	__le32 fc_ino;
+	__le32 fc_lblk;
+	__le32 fc_len;
+	__le32 fc_flags;		/* EXT4_FC_RANGE_* */
+	__le64 fc_pblk;
+};
+
+struct ext4_fc_tail {
+	__le32 fc_tid;
+	__le32 fc_crc;
+};
+
+/*
+ * What recovery found in the fast commit area, for ext4_fc_replay() to
+ * apply once the filesystem is set up: fc_valid_blks blocks holding
+ * fc_commits complete fast commits.
+ */
+struct ext4_fc_replay_state {
+	int fc_valid_blks;
+	int fc_commits;
+	int fc_in_commit;		/* scanning past a HEAD */
+	u32 fc_crc;
+};
+
+#endif /* _EXT4_FAST_COMMIT_H */
@@ -82,7 +82,8 @@ static int ext4_sync_parent(struct inode *inode)
  * state in the journalling system.
  *
  * What we do is just kick off a commit and wait on it.  This will snapshot the
- * inode to disk.
+ * inode to disk.  With fast_commit, the inode is logged to the journal's
+ * fast commit area instead whenever the running transaction allows it.
  */
 
 int ext4_sync_file(struct file *file, loff_t start, loff_t end, int datasync)
@@ -136,6 +137,12 @@ int ext4_sync_file(struct file *file, loff_t start, loff_t end, int datasync)
 	}
 
 	commit_tid = datasync ? ei->i_datasync_tid : ei->i_sync_tid;
+	if (test_opt(inode->i_sb, JOURNAL_FAST_COMMIT)) {
+		ret = ext4_fc_commit(inode, commit_tid);
+		if (ret != -EAGAIN)
+			goto out;
+		ret = 0;
+	}
 	if (journal->j_flags & JBD2_BARRIER &&
 	    !jbd2_trans_will_send_data_barrier(journal, commit_tid))
 		needs_barrier = true;
@@ -655,6 +655,8 @@ found:
 	}
 
 has_zeroout:
+	if (retval > 0)
+		ext4_fc_track_range(handle, inode, map, flags);
 	up_write((&EXT4_I(inode)->i_data_sem));
 	if (retval > 0 && map->m_flags & EXT4_MAP_MAPPED) {
 		ret = check_block_validity(inode, map);
@@ -4982,6 +4984,8 @@ int ext4_mark_inode_dirty(handle_t *handle, struct inode *inode)
 		 */
 		if ((jbd2_journal_extend(handle,
 			     EXT4_DATA_TRANS_BLOCKS(inode->i_sb))) == 0) {
+			/* Fast commits don't log moved xattrs */
+			ext4_fc_mark_ineligible(inode->i_sb, handle);
 			ret = ext4_expand_extra_isize(inode,
 						      sbi->s_want_extra_isize,
 						      iloc, handle);
@@ -5002,6 +5006,8 @@ int ext4_mark_inode_dirty(handle_t *handle, struct inode *inode)
 	}
 	if (!err)
 		err = ext4_mark_iloc_dirty(handle, inode, &iloc);
+	if (!err)
+		ext4_fc_track_inode(handle, inode);
 	return err;
 }
 
@@ -5023,6 +5029,9 @@ void ext4_dirty_inode(struct inode *inode, int flags)
 {
 	handle_t *handle;
 
+	/* Lazy timestamps get journalled once they turn I_DIRTY_SYNC */
+	if (flags == I_DIRTY_TIME)
+		return;
 	handle = ext4_journal_start(inode, EXT4_HT_INODE, 2);
 	if (IS_ERR(handle))
 		goto out;
@@ -5133,6 +5142,7 @@ int ext4_change_inode_journal_flag(struct inode *inode, int val)
 	if (IS_ERR(handle))
 		return PTR_ERR(handle);
 
+	ext4_fc_mark_ineligible(inode->i_sb, handle);
 	err = ext4_mark_inode_dirty(handle, inode);
 	ext4_handle_sync(handle);
 	ext4_journal_stop(handle);
@@ -362,6 +362,8 @@ flags_out:
 			err = PTR_ERR(handle);
 			goto unlock_out;
 		}
+		/* Fast commit replay matches inodes by generation */
+		ext4_fc_mark_ineligible(sb, handle);
 		err = ext4_reserve_inode_write(handle, inode, &iloc);
 		if (err == 0) {
 			inode->i_ctime = ext4_current_time(inode);
@@ -166,6 +166,18 @@ MODULE_PARM_DESC(mballoc_debug, "Debugging level for ext4's mballoc");
  * can be used for allocation. ext4_mb_good_group explains how the groups are
  * checked.
  *
+ * With /sys/fs/ext4/<partition>/mb_optimize_scan set (the default), the
+ * first two criteria don't walk the groups from the goal.  Every
+ * initialized group sits on the list of the order of its largest free
+ * buddy (sbi->s_mb_largest_free_orders), so once the goal group itself
+ * has failed the allocator picks groups from the smallest order that fits
+ * the request upward, and rotates each
+ * group it picks to the tail of its list so that concurrent allocations
+ * land in different groups.  Only groups not initialized yet are still
+ * found by the linear scan.  Stream allocations likewise start from a
+ * per-CPU goal (sbi->s_mb_stream_goals) spread over the filesystem rather
+ * than from one global goal.
+ *
  * Both the prealloc space are getting populated as above. So for the first
  * request we will hit the buddy cache which will result in this prealloc
  * space getting filled. The prealloc space is then later used for the
@@ -698,23 +710,41 @@ static void ext4_mb_mark_free_simple(struct super_block *sb,
 
 /*
  * Cache the order of the largest free extent we have available in this block
- * group.
+ * group, and keep the group on the list of its order so that the allocator
+ * can go straight to a group able to satisfy a request.
+ * Must be called with the group lock held.
  */
 static void
 mb_set_largest_free_order(struct super_block *sb, struct ext4_group_info *grp)
 {
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	int old = grp->bb_largest_free_order;
+	int new = -1; /* uninit */
 	int i;
-	int bits;
 
-	grp->bb_largest_free_order = -1; /* uninit */
-
-	bits = sb->s_blocksize_bits + 1;
-	for (i = bits; i >= 0; i--) {
+	for (i = MB_NUM_ORDERS(sb) - 1; i >= 0; i--) {
 		if (grp->bb_counters[i] > 0) {
-			grp->bb_largest_free_order = i;
+			new = i;
 			break;
 		}
 	}
+
+	if (new == old && (new < 0 ||
+			   !list_empty(&grp->bb_largest_free_order_node)))
+		return;
+
+	if (old >= 0 && !list_empty(&grp->bb_largest_free_order_node)) {
+		write_lock(&sbi->s_mb_largest_free_orders_locks[old]);
+		list_del_init(&grp->bb_largest_free_order_node);
+		write_unlock(&sbi->s_mb_largest_free_orders_locks[old]);
+	}
+	grp->bb_largest_free_order = new;
+	if (new >= 0) {
+		write_lock(&sbi->s_mb_largest_free_orders_locks[new]);
+		list_add_tail(&grp->bb_largest_free_order_node,
+			      &sbi->s_mb_largest_free_orders[new]);
+		write_unlock(&sbi->s_mb_largest_free_orders_locks[new]);
+	}
 }
 
 static noinline_for_stack
@@ -767,7 +797,8 @@ void ext4_mb_generate_buddy(struct super_block *sb,
 	}
 	mb_set_largest_free_order(sb, grp);
 
-	clear_bit(EXT4_GROUP_INFO_NEED_INIT_BIT, &(grp->bb_state));
+	if (test_and_clear_bit(EXT4_GROUP_INFO_NEED_INIT_BIT, &grp->bb_state))
+		atomic_dec(&EXT4_SB(sb)->s_mb_unindexed_groups);
 
 	period = get_cycles() - period;
 	spin_lock(&EXT4_SB(sb)->s_bal_lock);
@@ -1652,10 +1683,12 @@ static void ext4_mb_use_best_found(struct ext4_allocation_context *ac,
 	get_page(ac->ac_buddy_page);
 	/* store last allocated for subsequent stream allocation */
 	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC) {
-		spin_lock(&sbi->s_md_lock);
-		sbi->s_mb_last_group = ac->ac_f_ex.fe_group;
-		sbi->s_mb_last_start = ac->ac_f_ex.fe_start;
-		spin_unlock(&sbi->s_md_lock);
+		struct ext4_mb_stream_goal *goal;
+
+		goal = per_cpu_ptr(sbi->s_mb_stream_goals,
+				   raw_smp_processor_id());
+		goal->group = ac->ac_f_ex.fe_group;
+		goal->start = ac->ac_f_ex.fe_start;
 	}
 }
 
@@ -2073,11 +2106,224 @@ static int ext4_mb_good_group(struct ext4_allocation_context *ac,
 	return 0;
 }
 
+/*
+ * Check @group at criteria @cr and scan it for the request if it is good.
+ * The group may be initialized, so this must not be called under a lock.
+ */
+static int ext4_mb_scan_group(struct ext4_allocation_context *ac,
+			      ext4_group_t group, int cr)
+{
+	struct super_block *sb = ac->ac_sb;
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	struct ext4_buddy e4b;
+	int err;
+
+	/* This now checks without needing the buddy page */
+	if (!ext4_mb_good_group(ac, group, cr))
+		return 0;
+
+	err = ext4_mb_load_buddy(sb, group, &e4b);
+	if (err)
+		return err;
+
+	ext4_lock_group(sb, group);
+
+	/*
+	 * We need to check again after locking the
+	 * block group
+	 */
+	if (!ext4_mb_good_group(ac, group, cr)) {
+		ext4_unlock_group(sb, group);
+		ext4_mb_unload_buddy(&e4b);
+		return 0;
+	}
+
+	ac->ac_groups_scanned++;
+	if (cr == 0 && ac->ac_2order < sb->s_blocksize_bits+2)
+		ext4_mb_simple_scan_group(ac, &e4b);
+	else if (cr == 1 && sbi->s_stripe &&
+			!(ac->ac_g_ex.fe_len % sbi->s_stripe))
+		ext4_mb_scan_aligned(ac, &e4b);
+	else
+		ext4_mb_complex_scan_group(ac, &e4b);
+
+	ext4_unlock_group(sb, group);
+	ext4_mb_unload_buddy(&e4b);
+	return 0;
+}
+
+/*
+ * Order a group's largest free buddy must have for the group to be sure to
+ * satisfy the request at criteria @cr, or -1 if the largest free order
+ * lists can't be used.
+ */
+static int ext4_mb_index_order(struct ext4_allocation_context *ac, int cr)
+{
+	struct super_block *sb = ac->ac_sb;
+	int order;
+
+	if (!EXT4_SB(sb)->s_mb_optimize_scan || cr > 1)
+		return -1;
+
+	order = cr == 0 ? ac->ac_2order :
+			  order_base_2(ac->ac_g_ex.fe_len);
+	return order < MB_NUM_ORDERS(sb) ? order : -1;
+}
+
+/*
+ * ext4_mb_good_group() for groups on the largest free order lists.  Called
+ * under the lists' rwlocks, so it must not sleep: a group that still needs
+ * its buddy initialized may be listed already by ext4_mb_generate_buddy(),
+ * and is skipped rather than initialized here.
+ */
+static int ext4_mb_indexed_good_group(struct ext4_allocation_context *ac,
+				      struct ext4_group_info *grp,
+				      int cr, int order)
+{
+	int flex_size = ext4_flex_bg_size(EXT4_SB(ac->ac_sb));
+
+	if (grp->bb_largest_free_order < order ||
+	    grp->bb_free < ac->ac_g_ex.fe_len ||
+	    grp->bb_fragments == 0 ||
+	    EXT4_MB_GRP_BBITMAP_CORRUPT(grp) ||
+	    EXT4_MB_GRP_NEED_INIT(grp))
+		return 0;
+
+	/* Same as ext4_mb_good_group(): leave the first bg of a flexgroup */
+	if (cr == 0 && (ac->ac_flags & EXT4_MB_HINT_DATA) &&
+	    flex_size >= EXT4_FLEX_SIZE_DIR_ALLOC_SCHEME &&
+	    (grp->bb_group % flex_size) == 0)
+		return 0;
+
+	return 1;
+}
+
+/*
+ * Find a group with a free buddy of at least @order, trying the smallest
+ * such order first so that large free extents are kept for large requests.
+ * The group found is rotated to the tail of its list, so that concurrent
+ * allocations spread over the groups of the same order instead of all
+ * contending on the first one.
+ */
+static ext4_group_t
+ext4_mb_find_indexed_group(struct ext4_allocation_context *ac, int cr,
+			   int order, ext4_group_t ngroups,
+			   ext4_group_t *tried, int nr_tried)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(ac->ac_sb);
+	struct ext4_group_info *grp;
+	ext4_group_t group = ngroups;
+	rwlock_t *lock;
+	int i, j;
+
+	for (i = order; i < MB_NUM_ORDERS(ac->ac_sb); i++) {
+		if (list_empty(&sbi->s_mb_largest_free_orders[i]))
+			continue;
+		lock = &sbi->s_mb_largest_free_orders_locks[i];
+		read_lock(lock);
+		list_for_each_entry(grp, &sbi->s_mb_largest_free_orders[i],
+				    bb_largest_free_order_node) {
+			if (grp->bb_group >= ngroups ||
+			    !ext4_mb_indexed_good_group(ac, grp, cr, order))
+				continue;
+			for (j = 0; j < nr_tried; j++)
+				if (tried[j] == grp->bb_group)
+					break;
+			if (j == nr_tried) {
+				group = grp->bb_group;
+				break;
+			}
+		}
+		read_unlock(lock);
+
+		if (group < ngroups) {
+			/* Leave it alone if it is being moved to another list */
+			if (write_trylock(lock)) {
+				if (grp->bb_largest_free_order == i &&
+				    !list_empty(&grp->bb_largest_free_order_node))
+					list_move_tail(
+					    &grp->bb_largest_free_order_node,
+					    &sbi->s_mb_largest_free_orders[i]);
+				write_unlock(lock);
+			}
+			break;
+		}
+	}
+
+	return group;
+}
+
+/*
+ * Criteria 0 and 1 through the largest free order lists: if the goal
+ * group can't satisfy the request, rather than checking group descriptors
+ * one by one from the goal, go straight to groups that are known to have a
+ * free extent large enough.  Groups that haven't been initialized yet
+ * aren't on the lists; the caller scans for those linearly.
+ */
+static int ext4_mb_indexed_allocator(struct ext4_allocation_context *ac,
+				     int cr, int order, ext4_group_t ngroups)
+{
+	struct super_block *sb = ac->ac_sb;
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	ext4_group_t tried[MB_INDEXED_TRIES + 1];
+	struct ext4_buddy e4b;
+	ext4_group_t group;
+	int i, err;
+
+	/* The goal group first, as the linear scan would */
+	group = ac->ac_g_ex.fe_group;
+	if (group >= ngroups)
+		group = 0;
+	err = ext4_mb_scan_group(ac, group, cr);
+	if (err || ac->ac_status != AC_STATUS_CONTINUE)
+		return err;
+	tried[0] = group;
+
+	for (i = 1; i <= MB_INDEXED_TRIES; i++) {
+		cond_resched();
+		group = ext4_mb_find_indexed_group(ac, cr, order, ngroups,
+						   tried, i);
+		if (group >= ngroups)
+			break;
+		tried[i] = group;
+
+		err = ext4_mb_load_buddy(sb, group, &e4b);
+		if (err)
+			return err;
+
+		ext4_lock_group(sb, group);
+
+		/* It may have been allocated from since we found it */
+		if (!ext4_mb_indexed_good_group(ac, e4b.bd_info, cr, order)) {
+			ext4_unlock_group(sb, group);
+			ext4_mb_unload_buddy(&e4b);
+			continue;
+		}
+
+		ac->ac_groups_scanned++;
+		if (cr == 0 && ac->ac_2order < sb->s_blocksize_bits+2)
+			ext4_mb_simple_scan_group(ac, &e4b);
+		else if (cr == 1 && sbi->s_stripe &&
+				!(ac->ac_g_ex.fe_len % sbi->s_stripe))
+			ext4_mb_scan_aligned(ac, &e4b);
+		else
+			ext4_mb_complex_scan_group(ac, &e4b);
+
+		ext4_unlock_group(sb, group);
+		ext4_mb_unload_buddy(&e4b);
+
+		if (ac->ac_status != AC_STATUS_CONTINUE)
+			break;
+	}
+
+	return 0;
+}
+
 static noinline_for_stack int
 ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 {
 	ext4_group_t ngroups, group, i;
-	int cr;
+	int cr, order;
 	int err = 0;
 	struct ext4_sb_info *sbi;
 	struct super_block *sb;
@@ -2120,13 +2366,20 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 			ac->ac_2order = i - 1;
 	}
 
-	/* if stream allocation is enabled, use global goal */
+	/*
+	 * If stream allocation is enabled, continue where the last stream
+	 * allocation on this CPU left off.  The goals start spread over the
+	 * filesystem, so concurrent streams don't all pile into one group.
+	 */
 	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC) {
-		/* TBD: may be hot point */
-		spin_lock(&sbi->s_md_lock);
-		ac->ac_g_ex.fe_group = sbi->s_mb_last_group;
-		ac->ac_g_ex.fe_start = sbi->s_mb_last_start;
-		spin_unlock(&sbi->s_md_lock);
+		struct ext4_mb_stream_goal *goal;
+
+		goal = per_cpu_ptr(sbi->s_mb_stream_goals,
+				   raw_smp_processor_id());
+		ac->ac_g_ex.fe_group = ACCESS_ONCE(goal->group);
+		ac->ac_g_ex.fe_start = ACCESS_ONCE(goal->start);
+		if (ac->ac_g_ex.fe_group >= ngroups)
+			ac->ac_g_ex.fe_group = 0;
 	}
 
 	/* Let's just scan groups to find more-less suitable blocks */
@@ -2138,6 +2391,17 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 repeat:
 	for (; cr < 4 && ac->ac_status == AC_STATUS_CONTINUE; cr++) {
 		ac->ac_criteria = cr;
+
+		order = ext4_mb_index_order(ac, cr);
+		if (order >= 0) {
+			err = ext4_mb_indexed_allocator(ac, cr, order, ngroups);
+			if (err)
+				goto out;
+			if (ac->ac_status != AC_STATUS_CONTINUE ||
+			    !atomic_read(&sbi->s_mb_unindexed_groups))
+				continue;
+		}
+
 		/*
 		 * searching for the right group start
 		 * from the goal value specified
@@ -2153,38 +2417,14 @@ repeat:
 			if (group >= ngroups)
 				group = 0;
 
-			/* This now checks without needing the buddy page */
-			if (!ext4_mb_good_group(ac, group, cr))
+			/* The lists already covered initialized groups */
+			if (order >= 0 && !EXT4_MB_GRP_NEED_INIT(
+					ext4_get_group_info(sb, group)))
 				continue;
 
-			err = ext4_mb_load_buddy(sb, group, &e4b);
+			err = ext4_mb_scan_group(ac, group, cr);
 			if (err)
 				goto out;
-
-			ext4_lock_group(sb, group);
-
-			/*
-			 * We need to check again after locking the
-			 * block group
-			 */
-			if (!ext4_mb_good_group(ac, group, cr)) {
-				ext4_unlock_group(sb, group);
-				ext4_mb_unload_buddy(&e4b);
-				continue;
-			}
-
-			ac->ac_groups_scanned++;
-			if (cr == 0 && ac->ac_2order < sb->s_blocksize_bits+2)
-				ext4_mb_simple_scan_group(ac, &e4b);
-			else if (cr == 1 && sbi->s_stripe &&
-					!(ac->ac_g_ex.fe_len % sbi->s_stripe))
-				ext4_mb_scan_aligned(ac, &e4b);
-			else
-				ext4_mb_complex_scan_group(ac, &e4b);
-
-			ext4_unlock_group(sb, group);
-			ext4_mb_unload_buddy(&e4b);
-
 			if (ac->ac_status != AC_STATUS_CONTINUE)
 				break;
 		}
@@ -2406,6 +2646,7 @@ int ext4_mb_add_groupinfo(struct super_block *sb, ext4_group_t group,
 	}
 	set_bit(EXT4_GROUP_INFO_NEED_INIT_BIT,
 		&(meta_group_info[i]->bb_state));
+	atomic_inc(&sbi->s_mb_unindexed_groups);
 
 	/*
 	 * initialize bb_free to be able to skip
@@ -2423,6 +2664,8 @@ int ext4_mb_add_groupinfo(struct super_block *sb, ext4_group_t group,
 	init_rwsem(&meta_group_info[i]->alloc_sem);
 	meta_group_info[i]->bb_free_root = RB_ROOT;
 	meta_group_info[i]->bb_largest_free_order = -1;  /* uninit */
+	meta_group_info[i]->bb_group = group;
+	INIT_LIST_HEAD(&meta_group_info[i]->bb_largest_free_order_node);
 
 #ifdef DOUBLE_CHECK
 	{
@@ -2572,6 +2815,25 @@ int ext4_mb_init(struct super_block *sb)
 		goto out;
 	}
 
+	i = MB_NUM_ORDERS(sb) * sizeof(*sbi->s_mb_largest_free_orders);
+	sbi->s_mb_largest_free_orders = kmalloc(i, GFP_KERNEL);
+	if (sbi->s_mb_largest_free_orders == NULL) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	i = MB_NUM_ORDERS(sb) * sizeof(*sbi->s_mb_largest_free_orders_locks);
+	sbi->s_mb_largest_free_orders_locks = kmalloc(i, GFP_KERNEL);
+	if (sbi->s_mb_largest_free_orders_locks == NULL) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	for (i = 0; i < MB_NUM_ORDERS(sb); i++) {
+		INIT_LIST_HEAD(&sbi->s_mb_largest_free_orders[i]);
+		rwlock_init(&sbi->s_mb_largest_free_orders_locks[i]);
+	}
+	atomic_set(&sbi->s_mb_unindexed_groups, 0);
+
 	ret = ext4_groupinfo_create_slab(sb->s_blocksize);
 	if (ret < 0)
 		goto out;
@@ -2599,6 +2861,7 @@ int ext4_mb_init(struct super_block *sb)
 	sbi->s_mb_stats = MB_DEFAULT_STATS;
 	sbi->s_mb_stream_request = MB_DEFAULT_STREAM_THRESHOLD;
 	sbi->s_mb_order2_reqs = MB_DEFAULT_ORDER2_REQS;
+	sbi->s_mb_optimize_scan = MB_DEFAULT_OPTIMIZE_SCAN;
 	/*
 	 * The default group preallocation is 512, which for 4k block
 	 * sizes translates to 2 megabytes.  However for bigalloc file
@@ -2640,10 +2903,27 @@ int ext4_mb_init(struct super_block *sb)
 		spin_lock_init(&lg->lg_prealloc_lock);
 	}
 
+	/*
+	 * Start each CPU's stream allocations in a different part of the
+	 * filesystem, so that concurrent streaming writers don't all chase
+	 * the same goal group.
+	 */
+	sbi->s_mb_stream_goals = alloc_percpu(struct ext4_mb_stream_goal);
+	if (sbi->s_mb_stream_goals == NULL) {
+		ret = -ENOMEM;
+		goto out_free_locality_groups;
+	}
+	for_each_possible_cpu(i) {
+		struct ext4_mb_stream_goal *goal;
+		goal = per_cpu_ptr(sbi->s_mb_stream_goals, i);
+		goal->group = (u64)ext4_get_groups_count(sb) * i / nr_cpu_ids;
+		goal->start = 0;
+	}
+
 	/* init file for buddy data */
 	ret = ext4_mb_init_backend(sb);
 	if (ret != 0)
-		goto out_free_locality_groups;
+		goto out_free_stream_goals;
 
 	if (sbi->s_proc)
 		proc_create_data("mb_groups", S_IRUGO, sbi->s_proc,
@@ -2651,10 +2931,17 @@ int ext4_mb_init(struct super_block *sb)
 
 	return 0;
 
+out_free_stream_goals:
+	free_percpu(sbi->s_mb_stream_goals);
+	sbi->s_mb_stream_goals = NULL;
 out_free_locality_groups:
 	free_percpu(sbi->s_locality_groups);
 	sbi->s_locality_groups = NULL;
 out:
+	kfree(sbi->s_mb_largest_free_orders);
+	sbi->s_mb_largest_free_orders = NULL;
+	kfree(sbi->s_mb_largest_free_orders_locks);
+	sbi->s_mb_largest_free_orders_locks = NULL;
 	kfree(sbi->s_mb_offsets);
 	sbi->s_mb_offsets = NULL;
 	kfree(sbi->s_mb_maxs);
@@ -2710,6 +2997,8 @@ int ext4_mb_release(struct super_block *sb)
 			kfree(sbi->s_group_info[i]);
 		ext4_kvfree(sbi->s_group_info);
 	}
+	kfree(sbi->s_mb_largest_free_orders);
+	kfree(sbi->s_mb_largest_free_orders_locks);
 	kfree(sbi->s_mb_offsets);
 	kfree(sbi->s_mb_maxs);
 	if (sbi->s_buddy_cache)
@@ -2738,6 +3027,7 @@ int ext4_mb_release(struct super_block *sb)
 				atomic_read(&sbi->s_mb_discarded));
 	}
 
+	free_percpu(sbi->s_mb_stream_goals);
 	free_percpu(sbi->s_locality_groups);
 
 	return 0;
@@ -2975,6 +3265,104 @@ out_err:
 	return err;
 }
 
+/*
+ * Mark whichever blocks of @block .. @block + @len - 1 are still free as
+ * in use.  Fast commit replay uses this to claim the blocks of extents
+ * allocated by a transaction that never got committed.  The range must
+ * not cross a group boundary.
+ */
+int ext4_mb_mark_bb(handle_t *handle, struct super_block *sb,
+		    ext4_fsblk_t block, unsigned int len)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	struct buffer_head *bitmap_bh = NULL;
+	struct buffer_head *gdp_bh;
+	struct ext4_group_desc *gdp;
+	struct ext4_free_extent ex;
+	struct ext4_buddy e4b;
+	ext4_group_t group;
+	ext4_grpblk_t start, end, i;
+	int marked = 0;
+	int err;
+
+	ext4_get_group_no_and_offset(sb, block, &group, &start);
+	end = start + len;
+	if (WARN_ON(end > EXT4_BLOCKS_PER_GROUP(sb)))
+		return -EINVAL;
+	if (!ext4_data_block_valid(sbi, block, len)) {
+		ext4_error(sb, "Marking blocks %llu-%llu which overlap "
+			   "fs metadata", block, block + len);
+		return -EIO;
+	}
+
+	bitmap_bh = ext4_read_block_bitmap(sb, group);
+	if (!bitmap_bh)
+		return -EIO;
+
+	BUFFER_TRACE(bitmap_bh, "getting write access");
+	err = ext4_journal_get_write_access(handle, bitmap_bh);
+	if (err)
+		goto out_err;
+
+	err = -EIO;
+	gdp = ext4_get_group_desc(sb, group, &gdp_bh);
+	if (!gdp)
+		goto out_err;
+
+	BUFFER_TRACE(gdp_bh, "get_write_access");
+	err = ext4_journal_get_write_access(handle, gdp_bh);
+	if (err)
+		goto out_err;
+
+	err = ext4_mb_load_buddy(sb, group, &e4b);
+	if (err)
+		goto out_err;
+
+	ext4_lock_group(sb, group);
+	for (i = start; i < end; i = ex.fe_start + ex.fe_len) {
+		ex.fe_start = mb_find_next_zero_bit(bitmap_bh->b_data, end, i);
+		if (ex.fe_start >= end)
+			break;
+		ex.fe_len = mb_find_next_bit(bitmap_bh->b_data, end,
+					     ex.fe_start) - ex.fe_start;
+		ex.fe_group = group;
+		ext4_set_bits(bitmap_bh->b_data, ex.fe_start, ex.fe_len);
+		mb_mark_used(&e4b, &ex);
+		marked += ex.fe_len;
+	}
+	if (marked) {
+		if (gdp->bg_flags & cpu_to_le16(EXT4_BG_BLOCK_UNINIT)) {
+			gdp->bg_flags &= cpu_to_le16(~EXT4_BG_BLOCK_UNINIT);
+			ext4_free_group_clusters_set(sb, gdp,
+				ext4_free_clusters_after_init(sb, group, gdp));
+		}
+		ext4_free_group_clusters_set(sb, gdp,
+				ext4_free_group_clusters(sb, gdp) - marked);
+		ext4_block_bitmap_csum_set(sb, group, gdp, bitmap_bh);
+		ext4_group_desc_csum_set(sb, group, gdp);
+	}
+	ext4_unlock_group(sb, group);
+	ext4_mb_unload_buddy(&e4b);
+
+	if (!marked)
+		goto out_err;
+
+	percpu_counter_sub(&sbi->s_freeclusters_counter, marked);
+	if (sbi->s_log_groups_per_flex) {
+		ext4_group_t flex_group = ext4_flex_group(sbi, group);
+		atomic64_sub(marked,
+			     &sbi->s_flex_groups[flex_group].free_clusters);
+	}
+
+	err = ext4_handle_dirty_metadata(handle, NULL, bitmap_bh);
+	if (!err)
+		err = ext4_handle_dirty_metadata(handle, NULL, gdp_bh);
+
+out_err:
+	brelse(bitmap_bh);
+	return err;
+}
+
 /*
  * here we normalize request for locality group
  * Group request are normalized to s_mb_group_prealloc, which goes to
@@ -89,6 +89,28 @@ extern ushort ext4_mballoc_debug;
  */
 #define MB_DEFAULT_GROUP_PREALLOC	512
 
+/*
+ * Pick groups for 2^N and average sized requests from the lists of groups
+ * indexed by their largest free order rather than by scanning from the
+ * goal. Tunable via /sys/fs/ext4/<partition>/mb_optimize_scan
+ */
+#define MB_DEFAULT_OPTIMIZE_SCAN	1
+
+/*
+ * Number of groups picked from the largest free order lists before an
+ * allocation gives up on the current criteria
+ */
+#define MB_INDEXED_TRIES		8
+
+/* Number of buddy orders, order 0 being the block bitmap itself */
+#define MB_NUM_ORDERS(sb)		((sb)->s_blocksize_bits + 2)
+
+/* Goal of stream allocations, one per CPU to spread concurrent streams */
+struct ext4_mb_stream_goal {
+	ext4_group_t	group;
+	ext4_grpblk_t	start;
+};
+
 
 struct ext4_free_data {
 	/* MUST be the first member */
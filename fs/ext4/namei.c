@@ -2762,6 +2762,8 @@ int ext4_orphan_add(handle_t *handle, struct inode *inode)
 
 	WARN_ON_ONCE(!(inode->i_state & (I_NEW | I_FREEING)) &&
 		     !mutex_is_locked(&inode->i_mutex));
+	/* The orphan list isn't part of fast commits */
+	ext4_fc_mark_ineligible(sb, handle);
 	/*
 	 * Exit early if inode already is on orphan list. This is a big speedup
 	 * since we don't have to contend on the global s_orphan_lock.
@@ -2848,6 +2850,8 @@ int ext4_orphan_del(handle_t *handle, struct inode *inode)
 	if (list_empty(&ei->i_orphan))
 		return 0;
 
+	ext4_fc_mark_ineligible(inode->i_sb, handle);
+
 	if (handle) {
 		/* Grab inode buffer early before taking global s_orphan_lock */
 		err = ext4_reserve_inode_write(handle, inode, &iloc);
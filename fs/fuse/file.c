@@ -2541,6 +2541,99 @@ out:
 	return err;
 }
 
+/*
+ * Have the server copy the range, which might not have to move the data
+ * at all.  Dirty pages of either file are written back first so that the
+ * server sees them, and the page cache of the destination is dropped
+ * over the range afterwards.
+ */
+static ssize_t fuse_copy_file_range(struct file *file_in, loff_t pos_in,
+				    struct file *file_out, loff_t pos_out,
+				    size_t len, unsigned int flags)
+{
+	struct fuse_file *ff_in = file_in->private_data;
+	struct fuse_file *ff_out = file_out->private_data;
+	struct inode *inode_in = file_inode(file_in);
+	struct inode *inode_out = file_inode(file_out);
+	struct fuse_inode *fi_out = get_fuse_inode(inode_out);
+	struct fuse_conn *fc = ff_in->fc;
+	struct fuse_req *req;
+	struct fuse_copy_file_range_in inarg = {
+		.fh_in = ff_in->fh,
+		.off_in = pos_in,
+		.nodeid_out = ff_out->nodeid,
+		.fh_out = ff_out->fh,
+		.off_out = pos_out,
+		.len = len,
+		.flags = flags
+	};
+	struct fuse_write_out outarg;
+	ssize_t err;
+
+	if (fc->no_copy_file_range)
+		return -EOPNOTSUPP;
+
+	err = filemap_write_and_wait_range(inode_in->i_mapping, pos_in,
+					   pos_in + len - 1);
+	if (err)
+		return err;
+	if (inode_in != inode_out) {
+		mutex_lock(&inode_in->i_mutex);
+		fuse_sync_writes(inode_in);
+		mutex_unlock(&inode_in->i_mutex);
+	}
+
+	mutex_lock(&inode_out->i_mutex);
+	err = filemap_write_and_wait_range(inode_out->i_mapping, pos_out,
+					   pos_out + len - 1);
+	if (err)
+		goto out;
+	fuse_sync_writes(inode_out);
+
+	set_bit(FUSE_I_SIZE_UNSTABLE, &fi_out->state);
+
+	req = fuse_get_req_nopages(fc);
+	if (IS_ERR(req)) {
+		err = PTR_ERR(req);
+		goto out_unstable;
+	}
+
+	memset(&outarg, 0, sizeof(outarg));
+	req->in.h.opcode = FUSE_COPY_FILE_RANGE;
+	req->in.h.nodeid = ff_in->nodeid;
+	req->in.numargs = 1;
+	req->in.args[0].size = sizeof(inarg);
+	req->in.args[0].value = &inarg;
+	req->out.numargs = 1;
+	req->out.args[0].size = sizeof(outarg);
+	req->out.args[0].value = &outarg;
+	fuse_request_send(fc, req);
+	err = req->out.h.error;
+	if (err == -ENOSYS) {
+		fc->no_copy_file_range = 1;
+		err = -EOPNOTSUPP;
+	}
+	fuse_put_request(fc, req);
+
+	if (err)
+		goto out_unstable;
+
+	if (outarg.size) {
+		truncate_pagecache_range(inode_out, pos_out,
+					 pos_out + outarg.size - 1);
+		fuse_write_update_size(inode_out, pos_out + outarg.size);
+	}
+	fuse_invalidate_attr(inode_out);
+	err = outarg.size;
+
+out_unstable:
+	clear_bit(FUSE_I_SIZE_UNSTABLE, &fi_out->state);
+out:
+	mutex_unlock(&inode_out->i_mutex);
+
+	return err;
+}
+
 static const struct file_operations fuse_file_operations = {
 	.llseek		= fuse_file_llseek,
 	.read		= do_sync_read,
@@ -2559,6 +2652,7 @@ static const struct file_operations fuse_file_operations = {
 	.compat_ioctl	= fuse_file_compat_ioctl,
 	.poll		= fuse_file_poll,
 	.fallocate	= fuse_file_fallocate,
+	.copy_file_range = fuse_copy_file_range,
 };
 
 static const struct file_operations fuse_direct_io_file_operations = {
@@ -2576,6 +2670,7 @@ static const struct file_operations fuse_direct_io_file_operations = {
 	.compat_ioctl	= fuse_file_compat_ioctl,
 	.poll		= fuse_file_poll,
 	.fallocate	= fuse_file_fallocate,
+	.copy_file_range = fuse_copy_file_range,
 	/* no splice_read */
 };
 
@@ -16,6 +16,7 @@ struct file_system_type;
 struct linux_binprm;
 struct path;
 struct mount;
+struct work_struct;
 
 /*
  * block_dev.c
@@ -122,6 +123,9 @@ extern int invalidate_inodes(struct super_block *, bool);
  * dcache.c
  */
 extern struct dentry *__d_alloc(struct super_block *, const struct qstr *);
+extern int d_rcu_to_refcount(struct dentry *, seqcount_t *, unsigned);
+extern void d_rcu_put(struct dentry *);
+extern void d_trim_negative_work(struct work_struct *);
 
 /*
  * read_write.c
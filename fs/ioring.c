@@ -0,0 +1,782 @@
+/*
+ *  linux/fs/ioring.c
+ *
+ * Shared submission/completion ring interface for asynchronous I/O.
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Unlike io_submit(2), which only runs O_DIRECT requests asynchronously and
+ * costs a system call and two lock round trips per event, an ioring
+ * instance shares its submission and completion rings with the application
+ * through mmap().  Any number of queued entries is consumed by a single
+ * IORING_ENTER call and handed to a per-instance unbound workqueue, so
+ * buffered reads and writes and fsync never block the submitter.  Poll
+ * requests do not occupy a worker: they sit on the file's wait queue and
+ * are only requeued once an event arrives.
+ *
+ * Locking: uring_lock serializes consumers of the SQ ring (IORING_SETUP and
+ * IORING_ENTER), completion_lock serializes producers of the CQ ring and
+ * protects the list of pending poll requests.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/fs.h>
+#include <linux/file.h>
+#include <linux/mm.h>
+#include <linux/mman.h>
+#include <linux/mmu_context.h>
+#include <linux/sched.h>
+#include <linux/cred.h>
+#include <linux/slab.h>
+#include <linux/poll.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
+#include <linux/miscdevice.h>
+#include <linux/uaccess.h>
+#include <linux/log2.h>
+
+#include <linux/ioring.h>
+
+struct ioring_sq_ring {
+	u32			head ____cacheline_aligned_in_smp;
+	u32			tail ____cacheline_aligned_in_smp;
+	u32			ring_mask;
+	u32			ring_entries;
+	u32			dropped;
+	u32			array[];
+};
+
+struct ioring_cq_ring {
+	u32			head ____cacheline_aligned_in_smp;
+	u32			tail ____cacheline_aligned_in_smp;
+	u32			ring_mask;
+	u32			ring_entries;
+	u32			overflow;
+	struct ioring_cqe	cqes[] ____cacheline_aligned_in_smp;
+};
+
+struct ioring_ctx {
+	struct mutex		uring_lock;
+	struct ioring_sq_ring	*sq_ring;
+	size_t			sq_ring_size;
+	struct ioring_sqe	*sq_sqes;
+	size_t			sq_sqes_size;
+	unsigned		sq_entries;
+	unsigned		sq_mask;
+
+	spinlock_t		completion_lock;
+	struct ioring_cq_ring	*cq_ring;
+	size_t			cq_ring_size;
+	unsigned		cq_entries;
+	unsigned		cq_mask;
+	wait_queue_head_t	cq_wait;
+	struct list_head	poll_list;
+	bool			dying;
+
+	atomic_t		inflight;
+	struct workqueue_struct	*wq;
+	struct mm_struct	*mm;
+};
+
+struct ioring_req {
+	struct ioring_ctx	*ctx;
+	struct file		*file;
+	const struct cred	*cred;		/* of the submitter */
+	unsigned long		fsize_limit;	/* RLIMIT_FSIZE of the submitter */
+	struct work_struct	work;
+	struct ioring_sqe	sqe;
+
+	/* IORING_OP_POLL */
+	struct list_head	poll_list;
+	wait_queue_t		poll_wait;
+	wait_queue_head_t	*poll_head;
+	poll_table		poll_pt;
+	int			poll_error;
+};
+
+static struct kmem_cache *ioring_req_cachep;
+static const struct file_operations ioring_fops;
+
+static unsigned ioring_cq_ready(struct ioring_ctx *ctx)
+{
+	struct ioring_cq_ring *ring = ctx->cq_ring;
+
+	return ACCESS_ONCE(ring->tail) - ACCESS_ONCE(ring->head);
+}
+
+static void ioring_cqring_fill(struct ioring_ctx *ctx, u64 user_data, s32 res)
+{
+	struct ioring_cq_ring *ring = ctx->cq_ring;
+	struct ioring_cqe *cqe;
+	unsigned tail = ring->tail;
+
+	/*
+	 * The application may be slow to consume completions. Rather than
+	 * overwrite entries it has not seen yet, drop the event and let it
+	 * find out through the overflow counter.
+	 */
+	if (tail - ACCESS_ONCE(ring->head) == ctx->cq_entries) {
+		ring->overflow++;
+		return;
+	}
+
+	cqe = &ring->cqes[tail & ctx->cq_mask];
+	cqe->user_data = user_data;
+	cqe->res = res;
+	cqe->flags = 0;
+	/* order the cqe stores before publishing the new tail */
+	smp_wmb();
+	ring->tail = tail + 1;
+}
+
+static void ioring_complete(struct ioring_ctx *ctx, u64 user_data, s32 res)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&ctx->completion_lock, flags);
+	ioring_cqring_fill(ctx, user_data, res);
+	spin_unlock_irqrestore(&ctx->completion_lock, flags);
+
+	if (waitqueue_active(&ctx->cq_wait))
+		wake_up(&ctx->cq_wait);
+}
+
+static void ioring_req_complete(struct ioring_req *req, s32 res)
+{
+	struct ioring_ctx *ctx = req->ctx;
+	unsigned long flags;
+
+	if (req->sqe.opcode == IORING_OP_POLL) {
+		spin_lock_irqsave(&ctx->completion_lock, flags);
+		list_del(&req->poll_list);
+		spin_unlock_irqrestore(&ctx->completion_lock, flags);
+	}
+
+	ioring_complete(ctx, req->sqe.user_data, res);
+
+	put_cred(req->cred);
+	fput(req->file);
+	kmem_cache_free(ioring_req_cachep, req);
+	atomic_dec(&ctx->inflight);
+}
+
+/*
+ * Run a read or write in the address space of the task that set up the
+ * ring. The mm may already be gone if that task exited meanwhile.
+ *
+ * generic_write_checks() applies the file size limit of current, which is
+ * the worker, so the submitter's limit is applied here.  Unlike write(2),
+ * exceeding it fails with -EFBIG without raising SIGXFSZ.
+ */
+static ssize_t ioring_rw(struct ioring_req *req)
+{
+	struct mm_struct *mm = req->ctx->mm;
+	struct ioring_sqe *sqe = &req->sqe;
+	char __user *buf = (char __user *)(unsigned long)sqe->addr;
+	size_t len = sqe->len;
+	loff_t pos = sqe->off;
+	mm_segment_t oldfs;
+	ssize_t ret;
+
+	if (sqe->opcode == IORING_OP_WRITE &&
+	    S_ISREG(file_inode(req->file)->i_mode) &&
+	    req->fsize_limit != RLIM_INFINITY) {
+		if (pos >= req->fsize_limit)
+			return -EFBIG;
+		if (len > req->fsize_limit - pos)
+			len = req->fsize_limit - pos;
+	}
+
+	if (!atomic_inc_not_zero(&mm->mm_users))
+		return -EFAULT;
+
+	oldfs = get_fs();
+	set_fs(USER_DS);
+	use_mm(mm);
+
+	if (sqe->opcode == IORING_OP_READ)
+		ret = vfs_read(req->file, buf, len, &pos);
+	else
+		ret = vfs_write(req->file, buf, len, &pos);
+
+	unuse_mm(mm);
+	set_fs(oldfs);
+	mmput(mm);
+
+	return ret;
+}
+
+static int ioring_fsync(struct ioring_req *req)
+{
+	struct ioring_sqe *sqe = &req->sqe;
+	loff_t end = sqe->len ? sqe->off + sqe->len - 1 : LLONG_MAX;
+
+	return vfs_fsync_range(req->file, sqe->off, end,
+			       sqe->fsync_flags & IORING_FSYNC_DATASYNC);
+}
+
+static int ioring_poll_wake(wait_queue_t *wait, unsigned mode, int sync,
+			    void *key)
+{
+	struct ioring_req *req = container_of(wait, struct ioring_req,
+					      poll_wait);
+	unsigned long mask = (unsigned long)key;
+
+	if (mask && !(mask & (req->sqe.poll_events | POLLERR | POLLHUP)))
+		return 0;
+
+	/* Called with the wait queue lock held */
+	list_del_init(&wait->task_list);
+	queue_work(req->ctx->wq, &req->work);
+	return 1;
+}
+
+static void ioring_poll_queue_proc(struct file *file, wait_queue_head_t *head,
+				   poll_table *pt)
+{
+	struct ioring_req *req = container_of(pt, struct ioring_req, poll_pt);
+
+	/* Files waiting on more than one queue are not supported */
+	if (unlikely(req->poll_head)) {
+		req->poll_error = -EINVAL;
+		return;
+	}
+
+	req->poll_head = head;
+	add_wait_queue(head, &req->poll_wait);
+}
+
+/*
+ * Poll requests are (re)armed from the worker and only complete once the
+ * worker sees a requested event while its wait entry is still queued. If a
+ * wakeup removed the entry in the meantime, the work has been requeued and
+ * the next run takes over.
+ */
+static void ioring_poll_work(struct ioring_req *req)
+{
+	struct file *file = req->file;
+	unsigned events = req->sqe.poll_events | POLLERR | POLLHUP;
+	wait_queue_head_t *head;
+	unsigned mask;
+	int res;
+
+	if (!file->f_op || !file->f_op->poll) {
+		ioring_req_complete(req, DEFAULT_POLLMASK & events);
+		return;
+	}
+
+	if (!req->poll_head) {
+		mask = file->f_op->poll(file, &req->poll_pt);
+	} else {
+		if (list_empty(&req->poll_wait.task_list))
+			add_wait_queue(req->poll_head, &req->poll_wait);
+		mask = file->f_op->poll(file, NULL);
+	}
+	mask &= events;
+
+	if (!mask && !req->poll_error && !ACCESS_ONCE(req->ctx->dying))
+		return;
+
+	head = req->poll_head;
+	if (head) {
+		spin_lock_irq(&head->lock);
+		if (list_empty(&req->poll_wait.task_list)) {
+			spin_unlock_irq(&head->lock);
+			return;
+		}
+		list_del_init(&req->poll_wait.task_list);
+		spin_unlock_irq(&head->lock);
+	}
+
+	if (req->poll_error)
+		res = req->poll_error;
+	else if (mask)
+		res = mask;
+	else
+		res = -ECANCELED;
+	ioring_req_complete(req, res);
+}
+
+static void ioring_work(struct work_struct *work)
+{
+	struct ioring_req *req = container_of(work, struct ioring_req, work);
+	const struct cred *old_cred;
+	long ret;
+
+	if (req->sqe.opcode == IORING_OP_POLL) {
+		ioring_poll_work(req);
+		return;
+	}
+
+	/* permission and suid checks are against the submitter */
+	old_cred = override_creds(req->cred);
+	switch (req->sqe.opcode) {
+	case IORING_OP_READ:
+	case IORING_OP_WRITE:
+		ret = ioring_rw(req);
+		break;
+	case IORING_OP_FSYNC:
+		ret = ioring_fsync(req);
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+	revert_creds(old_cred);
+
+	ioring_req_complete(req, ret);
+}
+
+static int ioring_submit_sqe(struct ioring_ctx *ctx,
+			     const struct ioring_sqe *sqe)
+{
+	struct ioring_req *req;
+	struct file *file;
+
+	if (sqe->flags)
+		return -EINVAL;
+
+	switch (sqe->opcode) {
+	case IORING_OP_NOP:
+		ioring_complete(ctx, sqe->user_data, 0);
+		return 0;
+	case IORING_OP_READ:
+	case IORING_OP_WRITE:
+	case IORING_OP_FSYNC:
+	case IORING_OP_POLL:
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	file = fget(sqe->fd);
+	if (!file)
+		return -EBADF;
+
+	/* A request pinning its own ring would keep it alive forever */
+	if (file->f_op == &ioring_fops) {
+		fput(file);
+		return -EBADF;
+	}
+
+	req = kmem_cache_zalloc(ioring_req_cachep, GFP_KERNEL);
+	if (!req) {
+		fput(file);
+		return -EAGAIN;
+	}
+
+	req->ctx = ctx;
+	req->file = file;
+	req->cred = get_current_cred();
+	req->fsize_limit = rlimit(RLIMIT_FSIZE);
+	req->sqe = *sqe;
+	INIT_WORK(&req->work, ioring_work);
+	atomic_inc(&ctx->inflight);
+
+	if (sqe->opcode == IORING_OP_POLL) {
+		init_waitqueue_func_entry(&req->poll_wait, ioring_poll_wake);
+		INIT_LIST_HEAD(&req->poll_wait.task_list);
+		init_poll_funcptr(&req->poll_pt, ioring_poll_queue_proc);
+		req->poll_pt._key = sqe->poll_events | POLLERR | POLLHUP;
+
+		spin_lock_irq(&ctx->completion_lock);
+		list_add_tail(&req->poll_list, &ctx->poll_list);
+		spin_unlock_irq(&ctx->completion_lock);
+	}
+
+	queue_work(ctx->wq, &req->work);
+	return 0;
+}
+
+static int ioring_submit(struct ioring_ctx *ctx, unsigned to_submit)
+{
+	struct ioring_sq_ring *ring = ctx->sq_ring;
+	struct ioring_sqe sqe;
+	unsigned head, tail;
+	int submitted = 0;
+	int ret = 0;
+
+	head = ring->head;
+	tail = ACCESS_ONCE(ring->tail);
+	/* read the entries only after seeing the tail */
+	smp_rmb();
+
+	while (submitted < to_submit && head != tail) {
+		unsigned idx = ACCESS_ONCE(ring->array[head & ctx->sq_mask]);
+
+		if (unlikely(idx >= ctx->sq_entries)) {
+			ring->dropped++;
+			head++;
+			continue;
+		}
+
+		/* Don't let the completions overrun the CQ ring */
+		if (atomic_read(&ctx->inflight) >= ctx->cq_entries) {
+			ret = -EBUSY;
+			break;
+		}
+
+		/* The application may rewrite the entry, work on a copy */
+		sqe = ctx->sq_sqes[idx];
+		ret = ioring_submit_sqe(ctx, &sqe);
+		if (ret == -EAGAIN)
+			break;
+		if (ret)
+			ioring_complete(ctx, sqe.user_data, ret);
+
+		head++;
+		submitted++;
+	}
+
+	/* finish reading the entries before handing their slots back */
+	smp_mb();
+	ring->head = head;
+
+	return submitted ? submitted : ret;
+}
+
+static void *ioring_alloc_mem(size_t size)
+{
+	gfp_t gfp = GFP_KERNEL | __GFP_ZERO | __GFP_NOWARN | __GFP_COMP |
+		    __GFP_NORETRY;
+
+	return (void *)__get_free_pages(gfp, get_order(size));
+}
+
+static void ioring_free_mem(void *ptr, size_t size)
+{
+	if (ptr)
+		free_pages((unsigned long)ptr, get_order(size));
+}
+
+static int ioring_setup(struct ioring_ctx *ctx, struct ioring_params *p)
+{
+	struct workqueue_struct *wq;
+	unsigned sq_entries, cq_entries;
+	int i;
+
+	if (p->flags)
+		return -EINVAL;
+	for (i = 0; i < ARRAY_SIZE(p->resv); i++)
+		if (p->resv[i])
+			return -EINVAL;
+
+	if (!p->sq_entries || p->sq_entries > IORING_MAX_ENTRIES)
+		return -EINVAL;
+	sq_entries = roundup_pow_of_two(p->sq_entries);
+
+	cq_entries = p->cq_entries ? p->cq_entries : 2 * sq_entries;
+	if (cq_entries < sq_entries || cq_entries > 2 * IORING_MAX_ENTRIES)
+		return -EINVAL;
+	cq_entries = roundup_pow_of_two(cq_entries);
+
+	ctx->sq_ring_size = sizeof(struct ioring_sq_ring) +
+			    sq_entries * sizeof(u32);
+	ctx->sq_sqes_size = sq_entries * sizeof(struct ioring_sqe);
+	ctx->cq_ring_size = sizeof(struct ioring_cq_ring) +
+			    cq_entries * sizeof(struct ioring_cqe);
+
+	ctx->sq_ring = ioring_alloc_mem(ctx->sq_ring_size);
+	ctx->sq_sqes = ioring_alloc_mem(ctx->sq_sqes_size);
+	ctx->cq_ring = ioring_alloc_mem(ctx->cq_ring_size);
+	if (!ctx->sq_ring || !ctx->sq_sqes || !ctx->cq_ring)
+		goto err;
+
+	wq = alloc_workqueue("ioring", WQ_UNBOUND,
+			     min_t(unsigned, sq_entries, WQ_UNBOUND_MAX_ACTIVE));
+	if (!wq)
+		goto err;
+
+	ctx->sq_entries = sq_entries;
+	ctx->sq_mask = sq_entries - 1;
+	ctx->sq_ring->ring_mask = ctx->sq_mask;
+	ctx->sq_ring->ring_entries = sq_entries;
+	ctx->cq_entries = cq_entries;
+	ctx->cq_mask = cq_entries - 1;
+	ctx->cq_ring->ring_mask = ctx->cq_mask;
+	ctx->cq_ring->ring_entries = cq_entries;
+
+	ctx->mm = current->mm;
+	atomic_inc(&ctx->mm->mm_count);
+
+	memset(&p->sq_off, 0, sizeof(p->sq_off));
+	p->sq_entries = sq_entries;
+	p->sq_off.head = offsetof(struct ioring_sq_ring, head);
+	p->sq_off.tail = offsetof(struct ioring_sq_ring, tail);
+	p->sq_off.ring_mask = offsetof(struct ioring_sq_ring, ring_mask);
+	p->sq_off.ring_entries = offsetof(struct ioring_sq_ring, ring_entries);
+	p->sq_off.dropped = offsetof(struct ioring_sq_ring, dropped);
+	p->sq_off.array = offsetof(struct ioring_sq_ring, array);
+
+	memset(&p->cq_off, 0, sizeof(p->cq_off));
+	p->cq_entries = cq_entries;
+	p->cq_off.head = offsetof(struct ioring_cq_ring, head);
+	p->cq_off.tail = offsetof(struct ioring_cq_ring, tail);
+	p->cq_off.ring_mask = offsetof(struct ioring_cq_ring, ring_mask);
+	p->cq_off.ring_entries = offsetof(struct ioring_cq_ring, ring_entries);
+	p->cq_off.overflow = offsetof(struct ioring_cq_ring, overflow);
+	p->cq_off.cqes = offsetof(struct ioring_cq_ring, cqes);
+
+	/* ->wq marks the instance as set up, publish it last */
+	smp_wmb();
+	ctx->wq = wq;
+
+	return 0;
+
+err:
+	ioring_free_mem(ctx->sq_ring, ctx->sq_ring_size);
+	ioring_free_mem(ctx->sq_sqes, ctx->sq_sqes_size);
+	ioring_free_mem(ctx->cq_ring, ctx->cq_ring_size);
+	ctx->sq_ring = NULL;
+	ctx->sq_sqes = NULL;
+	ctx->cq_ring = NULL;
+	return -ENOMEM;
+}
+
+static long ioring_enter(struct ioring_ctx *ctx, struct ioring_enter *e)
+{
+	unsigned min_complete;
+	int submitted = 0;
+	int ret;
+
+	if (e->flags || e->resv)
+		return -EINVAL;
+
+	if (e->to_submit) {
+		mutex_lock(&ctx->uring_lock);
+		submitted = ioring_submit(ctx, e->to_submit);
+		mutex_unlock(&ctx->uring_lock);
+		if (submitted < 0)
+			return submitted;
+	}
+
+	min_complete = min(e->min_complete, ctx->cq_entries);
+	if (min_complete) {
+		ret = wait_event_interruptible(ctx->cq_wait,
+				ioring_cq_ready(ctx) >= min_complete);
+		if (ret && !submitted)
+			return ret;
+	}
+
+	return submitted;
+}
+
+static long ioring_ioctl(struct file *file, unsigned int cmd,
+			 unsigned long arg)
+{
+	struct ioring_ctx *ctx = file->private_data;
+	void __user *argp = (void __user *)arg;
+	struct ioring_params p;
+	struct ioring_enter e;
+	long ret;
+
+	switch (cmd) {
+	case IORING_SETUP:
+		if (copy_from_user(&p, argp, sizeof(p)))
+			return -EFAULT;
+
+		mutex_lock(&ctx->uring_lock);
+		if (ctx->sq_ring)
+			ret = -EBUSY;
+		else
+			ret = ioring_setup(ctx, &p);
+		mutex_unlock(&ctx->uring_lock);
+
+		if (!ret && copy_to_user(argp, &p, sizeof(p)))
+			ret = -EFAULT;
+		return ret;
+
+	case IORING_ENTER:
+		if (copy_from_user(&e, argp, sizeof(e)))
+			return -EFAULT;
+		if (!ACCESS_ONCE(ctx->wq))
+			return -EINVAL;
+		/* Paired with the smp_wmb() in ioring_setup() */
+		smp_rmb();
+		return ioring_enter(ctx, &e);
+	}
+
+	return -ENOTTY;
+}
+
+static int ioring_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct ioring_ctx *ctx = file->private_data;
+	loff_t offset = (loff_t)vma->vm_pgoff << PAGE_SHIFT;
+	unsigned long sz = vma->vm_end - vma->vm_start;
+	void *ptr;
+	size_t size;
+	int ret = -EINVAL;
+
+	mutex_lock(&ctx->uring_lock);
+	if (!ctx->wq)
+		goto out;
+
+	switch (offset) {
+	case IORING_OFF_SQ_RING:
+		ptr = ctx->sq_ring;
+		size = ctx->sq_ring_size;
+		break;
+	case IORING_OFF_SQES:
+		ptr = ctx->sq_sqes;
+		size = ctx->sq_sqes_size;
+		break;
+	case IORING_OFF_CQ_RING:
+		ptr = ctx->cq_ring;
+		size = ctx->cq_ring_size;
+		break;
+	default:
+		goto out;
+	}
+
+	if (sz > PAGE_ALIGN(size))
+		goto out;
+
+	ret = remap_pfn_range(vma, vma->vm_start,
+			      virt_to_phys(ptr) >> PAGE_SHIFT, sz,
+			      vma->vm_page_prot);
+out:
+	mutex_unlock(&ctx->uring_lock);
+	return ret;
+}
+
+static unsigned int ioring_poll(struct file *file, poll_table *wait)
+{
+	struct ioring_ctx *ctx = file->private_data;
+	unsigned int mask = 0;
+
+	if (!ACCESS_ONCE(ctx->wq))
+		return POLLERR;
+	smp_rmb();
+
+	poll_wait(file, &ctx->cq_wait, wait);
+	if (ioring_cq_ready(ctx))
+		mask |= POLLIN | POLLRDNORM;
+	if (ACCESS_ONCE(ctx->sq_ring->tail) - ACCESS_ONCE(ctx->sq_ring->head) !=
+	    ctx->sq_entries)
+		mask |= POLLOUT | POLLWRNORM;
+
+	return mask;
+}
+
+/*
+ * Pending polls would never finish on their own. Kick every one of them
+ * that is parked on a wait queue; its worker sees ->dying and completes it
+ * with -ECANCELED. Workers that were running concurrently may re-arm, so
+ * repeat until the list is empty.
+ *
+ * A request whose file did not wait on any queue has nothing to wake it and
+ * is requeued directly. Only wakeups requeue a request behind the worker's
+ * back, and they need a wait queue, so such a request is idle once the
+ * workqueue has been flushed with ->dying set.
+ */
+static void ioring_cancel_polls(struct ioring_ctx *ctx)
+{
+	struct ioring_req *req;
+	wait_queue_head_t *head;
+
+	spin_lock_irq(&ctx->completion_lock);
+	ctx->dying = true;
+	spin_unlock_irq(&ctx->completion_lock);
+
+	flush_workqueue(ctx->wq);
+
+	spin_lock_irq(&ctx->completion_lock);
+	while (!list_empty(&ctx->poll_list)) {
+		list_for_each_entry(req, &ctx->poll_list, poll_list) {
+			head = ACCESS_ONCE(req->poll_head);
+			if (!head) {
+				queue_work(ctx->wq, &req->work);
+				continue;
+			}
+
+			spin_lock(&head->lock);
+			if (!list_empty(&req->poll_wait.task_list)) {
+				list_del_init(&req->poll_wait.task_list);
+				queue_work(ctx->wq, &req->work);
+			}
+			spin_unlock(&head->lock);
+		}
+		spin_unlock_irq(&ctx->completion_lock);
+
+		flush_workqueue(ctx->wq);
+
+		spin_lock_irq(&ctx->completion_lock);
+	}
+	spin_unlock_irq(&ctx->completion_lock);
+}
+
+static int ioring_open(struct inode *inode, struct file *file)
+{
+	struct ioring_ctx *ctx;
+
+	ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+	if (!ctx)
+		return -ENOMEM;
+
+	mutex_init(&ctx->uring_lock);
+	spin_lock_init(&ctx->completion_lock);
+	init_waitqueue_head(&ctx->cq_wait);
+	INIT_LIST_HEAD(&ctx->poll_list);
+	atomic_set(&ctx->inflight, 0);
+
+	file->private_data = ctx;
+	return nonseekable_open(inode, file);
+}
+
+static int ioring_release(struct inode *inode, struct file *file)
+{
+	struct ioring_ctx *ctx = file->private_data;
+
+	if (ctx->wq) {
+		ioring_cancel_polls(ctx);
+		destroy_workqueue(ctx->wq);
+		WARN_ON(atomic_read(&ctx->inflight));
+		mmdrop(ctx->mm);
+	}
+
+	ioring_free_mem(ctx->sq_ring, ctx->sq_ring_size);
+	ioring_free_mem(ctx->sq_sqes, ctx->sq_sqes_size);
+	ioring_free_mem(ctx->cq_ring, ctx->cq_ring_size);
+	kfree(ctx);
+
+	return 0;
+}
+
+static const struct file_operations ioring_fops = {
+	.owner		= THIS_MODULE,
+	.open		= ioring_open,
+	.release	= ioring_release,
+	.unlocked_ioctl	= ioring_ioctl,
+	.compat_ioctl	= ioring_ioctl,
+	.mmap		= ioring_mmap,
+	.poll		= ioring_poll,
+	.llseek		= no_llseek,
+};
+
+static struct miscdevice ioring_miscdevice = {
+	.minor		= MISC_DYNAMIC_MINOR,
+	.name		= "ioring",
+	.fops		= &ioring_fops,
+	.mode		= S_IRUGO | S_IWUGO,
+};
+
+static int __init ioring_init(void)
+{
+	int err;
+
+	ioring_req_cachep = KMEM_CACHE(ioring_req, SLAB_PANIC);
+
+	err = misc_register(&ioring_miscdevice);
+	if (err)
+		pr_err("ioring: failed to register misc device: %d\n", err);
+
+	return err;
+}
+module_init(ioring_init);
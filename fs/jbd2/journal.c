@@ -98,10 +98,18 @@ EXPORT_SYMBOL(jbd2_journal_file_inode);
 EXPORT_SYMBOL(jbd2_journal_init_jbd_inode);
 EXPORT_SYMBOL(jbd2_journal_release_jbd_inode);
 EXPORT_SYMBOL(jbd2_journal_begin_ordered_truncate);
+EXPORT_SYMBOL(jbd2_fc_init);
+EXPORT_SYMBOL(jbd2_fc_begin_commit);
+EXPORT_SYMBOL(jbd2_fc_end_commit);
+EXPORT_SYMBOL(jbd2_fc_get_buf);
+EXPORT_SYMBOL(jbd2_fc_submit_bufs);
+EXPORT_SYMBOL(jbd2_fc_wait_bufs);
+EXPORT_SYMBOL(jbd2_fc_replay_done);
 EXPORT_SYMBOL(jbd2_inode_cache);
 
 static void __journal_abort_soft (journal_t *journal, int errno);
 static int jbd2_journal_create_slab(size_t slab_size);
+static int jbd2_write_superblock(journal_t *journal, int write_op);
 
 #ifdef CONFIG_JBD2_DEBUG
 void __jbd2_debug(int level, const char *file, const char *func,
@@ -804,6 +812,274 @@ int jbd2_journal_bmap(journal_t *journal, unsigned long blocknr,
 	return err;
 }
 
+/*
+ * Fast commits.
+ *
+ * A fast commit lets the client filesystem make the changes of the running
+ * transaction it cares about durable without committing the transaction:
+ * it writes a compact description of them of its own format to the fast
+ * commit area, which is replayed by the filesystem after recovery (see
+ * j_fc_replay_callback) as long as the transaction it belongs to never
+ * got committed.  Once it is, the area is reused from the start.
+ *
+ * Only one fast commit can be in flight, and never while a transaction is
+ * being committed.
+ */
+
+/**
+ * int jbd2_fc_init() - set up a journal for fast commits
+ * @journal: Journal to act on.
+ * @num_fc_blks: Size of the fast commit area if the journal has none yet.
+ *
+ * Carves the fast commit area out of the end of the log if needed, which
+ * is only safe while the log is empty, i.e. right after jbd2_journal_load().
+ */
+int jbd2_fc_init(journal_t *journal, int num_fc_blks)
+{
+	journal_superblock_t *sb = journal->j_superblock;
+
+	if (!JBD2_HAS_INCOMPAT_FEATURE(journal,
+				       JBD2_FEATURE_INCOMPAT_FAST_COMMIT)) {
+		if (journal->j_head != journal->j_tail ||
+		    journal->j_running_transaction)
+			return -EBUSY;
+		if (journal->j_last - journal->j_first <
+		    JBD2_MIN_JOURNAL_BLOCKS + num_fc_blks)
+			return -ENOSPC;
+		if (!jbd2_journal_set_features(journal, 0, 0,
+				JBD2_FEATURE_INCOMPAT_FAST_COMMIT))
+			return -EINVAL;
+
+		write_lock(&journal->j_state_lock);
+		sb->s_num_fc_blks = cpu_to_be32(num_fc_blks);
+		journal->j_fc_last = journal->j_last;
+		journal->j_last -= num_fc_blks;
+		journal->j_fc_first = journal->j_last;
+		journal->j_free -= num_fc_blks;
+		write_unlock(&journal->j_state_lock);
+
+		/* Recovery has to know about the area before it is used */
+		mutex_lock(&journal->j_checkpoint_mutex);
+		jbd2_write_superblock(journal, WRITE_FUA);
+		mutex_unlock(&journal->j_checkpoint_mutex);
+
+		printk(KERN_INFO "JBD2: %s: fast commit area of %d blocks set "
+		       "up, the journal now needs a kernel with fast commit "
+		       "support to be recovered\n", journal->j_devname,
+		       num_fc_blks);
+	}
+
+	if (!journal->j_fc_wbuf) {
+		journal->j_fc_wbuf = kcalloc(journal->j_fc_last -
+					     journal->j_fc_first,
+					     sizeof(struct buffer_head *),
+					     GFP_KERNEL);
+		if (!journal->j_fc_wbuf)
+			return -ENOMEM;
+	}
+	return 0;
+}
+
+/**
+ * int jbd2_fc_begin_commit() - start a fast commit
+ * @journal: Journal to act on.
+ * @tid: Transaction the changes to fast commit belong to.
+ *
+ * Returns 0 once the caller owns the fast commit area, -EALREADY if @tid
+ * has already been committed, or another error if @tid can't be fast
+ * committed and the caller should wait for its commit instead.
+ */
+int jbd2_fc_begin_commit(journal_t *journal, tid_t tid)
+{
+	transaction_t *committing;
+	tid_t committing_tid;
+
+	if (!journal->j_fc_wbuf)
+		return -EOPNOTSUPP;
+
+	write_lock(&journal->j_state_lock);
+	for (;;) {
+		if (is_journal_aborted(journal)) {
+			write_unlock(&journal->j_state_lock);
+			return -EIO;
+		}
+		/* The area still holds fast commits to replay */
+		if (journal->j_flags & JBD2_FC_REPLAY) {
+			write_unlock(&journal->j_state_lock);
+			return -EBUSY;
+		}
+		if (tid_geq(journal->j_commit_sequence, tid)) {
+			write_unlock(&journal->j_state_lock);
+			return -EALREADY;
+		}
+		if (!journal->j_running_transaction ||
+		    journal->j_running_transaction->t_tid != tid) {
+			write_unlock(&journal->j_state_lock);
+			return -EINVAL;
+		}
+
+		/*
+		 * Fast commits are only valid on top of a fully committed
+		 * previous transaction.
+		 */
+		committing = journal->j_committing_transaction;
+		if (committing) {
+			committing_tid = committing->t_tid;
+			write_unlock(&journal->j_state_lock);
+			jbd2_log_wait_commit(journal, committing_tid);
+			write_lock(&journal->j_state_lock);
+			continue;
+		}
+
+		if (!(journal->j_flags & (JBD2_FAST_COMMIT_ONGOING |
+					  JBD2_FULL_COMMIT_ONGOING)))
+			break;
+
+		write_unlock(&journal->j_state_lock);
+		wait_event(journal->j_fc_wait, !(journal->j_flags &
+				(JBD2_FAST_COMMIT_ONGOING |
+				 JBD2_FULL_COMMIT_ONGOING)));
+		write_lock(&journal->j_state_lock);
+	}
+	journal->j_flags |= JBD2_FAST_COMMIT_ONGOING;
+	write_unlock(&journal->j_state_lock);
+
+	/*
+	 * As for a regular commit, erase the effects of a prior
+	 * jbd2_journal_flush(): recovery must find the log tail for the
+	 * fast commit to be replayed.
+	 */
+	if (journal->j_flags & JBD2_FLUSHED) {
+		mutex_lock(&journal->j_checkpoint_mutex);
+		jbd2_journal_update_sb_log_tail(journal,
+						journal->j_tail_sequence,
+						journal->j_tail,
+						WRITE_SYNC);
+		mutex_unlock(&journal->j_checkpoint_mutex);
+	}
+	return 0;
+}
+
+/**
+ * void jbd2_fc_end_commit() - finish a fast commit
+ * @journal: Journal to act on.
+ *
+ * Releases the fast commit area, whether or not the fast commit succeeded.
+ */
+void jbd2_fc_end_commit(journal_t *journal)
+{
+	write_lock(&journal->j_state_lock);
+	journal->j_flags &= ~JBD2_FAST_COMMIT_ONGOING;
+	write_unlock(&journal->j_state_lock);
+	wake_up(&journal->j_fc_wait);
+}
+
+/**
+ * void jbd2_fc_replay_done() - forget the fast commits found by recovery
+ * @journal: Journal to act on.
+ *
+ * To be called once the changes replayed from the fast commit area have
+ * been committed.  Until then, every recovery hands the same fast commits to
+ * j_fc_replay_callback again, and the area can't be reused.
+ */
+void jbd2_fc_replay_done(journal_t *journal)
+{
+	journal_superblock_t *sb = journal->j_superblock;
+
+	if (!(journal->j_flags & JBD2_FC_REPLAY))
+		return;
+
+	mutex_lock(&journal->j_checkpoint_mutex);
+	sb->s_fc_replay = 0;
+	sb->s_fc_replay_tid = 0;
+	jbd2_write_superblock(journal, WRITE_FUA);
+	mutex_unlock(&journal->j_checkpoint_mutex);
+
+	write_lock(&journal->j_state_lock);
+	journal->j_flags &= ~JBD2_FC_REPLAY;
+	write_unlock(&journal->j_state_lock);
+}
+
+/**
+ * int jbd2_fc_get_buf() - get the next block of the fast commit area
+ * @journal: Journal to act on.
+ * @bh_out: Where to return the buffer.
+ *
+ * Returns -ENOSPC once the area is full, in which case the caller has to
+ * fall back to a full commit.
+ */
+int jbd2_fc_get_buf(journal_t *journal, struct buffer_head **bh_out)
+{
+	unsigned long long pblock;
+	struct buffer_head *bh;
+	int err;
+
+	if (journal->j_fc_first + journal->j_fc_off >= journal->j_fc_last)
+		return -ENOSPC;
+
+	err = jbd2_journal_bmap(journal,
+				journal->j_fc_first + journal->j_fc_off,
+				&pblock);
+	if (err)
+		return err;
+
+	bh = __getblk(journal->j_dev, pblock, journal->j_blocksize);
+	if (!bh)
+		return -ENOMEM;
+
+	journal->j_fc_wbuf[journal->j_fc_off++] = bh;
+	*bh_out = bh;
+	return 0;
+}
+
+/**
+ * void jbd2_fc_submit_bufs() - write fast commit blocks
+ * @journal: Journal to act on.
+ * @num_blks: Number of blocks, counting back from the last one handed out.
+ *
+ * The blocks have to be filled in by then; jbd2_fc_wait_bufs() waits for
+ * them.
+ */
+void jbd2_fc_submit_bufs(journal_t *journal, int num_blks)
+{
+	struct buffer_head *bh;
+	int i;
+
+	for (i = journal->j_fc_off - num_blks; i < journal->j_fc_off; i++) {
+		bh = journal->j_fc_wbuf[i];
+		lock_buffer(bh);
+		clear_buffer_dirty(bh);
+		set_buffer_uptodate(bh);
+		/* end_buffer_write_sync() drops this one */
+		get_bh(bh);
+		bh->b_end_io = end_buffer_write_sync;
+		submit_bh(WRITE_SYNC, bh);
+	}
+}
+
+/**
+ * int jbd2_fc_wait_bufs() - wait for fast commit blocks to be written
+ * @journal: Journal to act on.
+ * @num_blks: Number of blocks, counting back from the last one handed out.
+ *
+ * Also drops the references taken by jbd2_fc_get_buf().
+ */
+int jbd2_fc_wait_bufs(journal_t *journal, int num_blks)
+{
+	struct buffer_head *bh;
+	int i, err = 0;
+
+	for (i = journal->j_fc_off - num_blks; i < journal->j_fc_off; i++) {
+		bh = journal->j_fc_wbuf[i];
+		wait_on_buffer(bh);
+		if (unlikely(!buffer_uptodate(bh)))
+			err = -EIO;
+		put_bh(bh);
+		journal->j_fc_wbuf[i] = NULL;
+	}
+	return err;
+}
+
 /*
  * We play buffer_head aliasing tricks to write data/metadata blocks to
  * the journal without copying their contents, but for journal
@@ -1089,6 +1365,7 @@ static journal_t * journal_init_common (void)
 	init_waitqueue_head(&journal->j_wait_commit);
 	init_waitqueue_head(&journal->j_wait_updates);
 	init_waitqueue_head(&journal->j_wait_reserved);
+	init_waitqueue_head(&journal->j_fc_wait);
 	mutex_init(&journal->j_barrier);
 	mutex_init(&journal->j_checkpoint_mutex);
 	spin_lock_init(&journal->j_revoke_lock);
@@ -1274,6 +1551,28 @@ static void journal_fail_superblock (journal_t *journal)
 	journal->j_sb_buffer = NULL;
 }
 
+/*
+ * Set aside the fast commit area at the end of the journal: the log proper
+ * ends where it begins.
+ */
+static void journal_fc_layout(journal_t *journal)
+{
+	journal_superblock_t *sb = journal->j_superblock;
+	unsigned long num_fc_blks;
+
+	if (!JBD2_HAS_INCOMPAT_FEATURE(journal,
+				       JBD2_FEATURE_INCOMPAT_FAST_COMMIT))
+		return;
+
+	num_fc_blks = be32_to_cpu(sb->s_num_fc_blks);
+	if (!num_fc_blks)
+		num_fc_blks = JBD2_DEFAULT_FAST_COMMIT_BLOCKS;
+	journal->j_fc_last = journal->j_last;
+	journal->j_last -= num_fc_blks;
+	journal->j_fc_first = journal->j_last;
+	journal->j_fc_off = 0;
+}
+
 /*
  * Given a journal_t structure, initialise the various fields for
  * startup of a new journaling session.  We use this both when creating
@@ -1286,8 +1585,12 @@ static int journal_reset(journal_t *journal)
 	journal_superblock_t *sb = journal->j_superblock;
 	unsigned long long first, last;
 
-	first = be32_to_cpu(sb->s_first);
-	last = be32_to_cpu(sb->s_maxlen);
+	journal->j_first = be32_to_cpu(sb->s_first);
+	journal->j_last = be32_to_cpu(sb->s_maxlen);
+	journal_fc_layout(journal);
+
+	first = journal->j_first;
+	last = journal->j_last;
 	if (first + JBD2_MIN_JOURNAL_BLOCKS > last + 1) {
 		printk(KERN_ERR "JBD2: Journal too short (blocks %llu-%llu).\n",
 		       first, last);
@@ -1295,9 +1598,6 @@ static int journal_reset(journal_t *journal)
 		return -EINVAL;
 	}
 
-	journal->j_first = first;
-	journal->j_last = last;
-
 	journal->j_head = first;
 	journal->j_tail = first;
 	journal->j_free = last - first;
@@ -1611,6 +1911,7 @@ static int load_superblock(journal_t *journal)
 	journal->j_first = be32_to_cpu(sb->s_first);
 	journal->j_last = be32_to_cpu(sb->s_maxlen);
 	journal->j_errno = be32_to_cpu(sb->s_errno);
+	journal_fc_layout(journal);
 
 	return 0;
 }
@@ -1736,6 +2037,7 @@ int jbd2_journal_destroy(journal_t *journal)
 		jbd2_journal_destroy_revoke(journal);
 	if (journal->j_chksum_driver)
 		crypto_free_shash(journal->j_chksum_driver);
+	kfree(journal->j_fc_wbuf);
 	kfree(journal->j_wbuf);
 	kfree(journal);
 
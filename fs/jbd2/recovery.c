@@ -233,6 +233,63 @@ do {									\
 		var -= ((journal)->j_last - (journal)->j_first);	\
 } while (0)
 
+/*
+ * Hand the fast commit area to the filesystem once the log has been
+ * replayed.  Fast commits only apply if they were written on top of the
+ * last transaction recovered, i.e. by the transaction that never made it
+ * to the log, or if an earlier recovery found them and they haven't been
+ * replayed since.
+ *
+ * The log restarts at a new tid after recovery, and the filesystem only
+ * replays fast commits later in the mount.  Until it has committed them
+ * with jbd2_fc_replay_done(), their tid is kept in the superblock, which
+ * journal_reset() writes out before the new tid can get committed.
+ */
+static int fc_do_one_pass(journal_t *journal, tid_t tid)
+{
+	journal_superblock_t *sb = journal->j_superblock;
+	unsigned long next_fc_block = journal->j_fc_first;
+	struct buffer_head *bh;
+	int found = 0;
+	int err = 0;
+
+	if (!journal->j_fc_replay_callback)
+		return 0;
+
+	while (next_fc_block < journal->j_fc_last) {
+		err = jread(&bh, journal, next_fc_block);
+		if (err)
+			break;
+
+		jbd_debug(3, "Fast commit replay: block %lu\n", next_fc_block);
+		err = journal->j_fc_replay_callback(journal, bh,
+				next_fc_block - journal->j_fc_first, tid);
+		brelse(bh);
+		if (err == JBD2_FC_REPLAY_VALID)
+			found = 1;
+		else if (err != JBD2_FC_REPLAY_CONTINUE)
+			break;
+		next_fc_block++;
+	}
+
+	if (err < 0) {
+		printk(KERN_ERR "JBD2: fast commit replay failed, error %d\n",
+		       err);
+		return err;
+	}
+
+	if (found) {
+		journal->j_flags |= JBD2_FC_REPLAY;
+		journal->j_fc_replay_tid = tid;
+		sb->s_fc_replay = 1;
+		sb->s_fc_replay_tid = cpu_to_be32(tid);
+	} else {
+		sb->s_fc_replay = 0;
+		sb->s_fc_replay_tid = 0;
+	}
+	return 0;
+}
+
 /**
  * jbd2_journal_recover - recovers a on-disk journal
  * @journal: the journal to recover
@@ -243,7 +300,8 @@ do {									\
  * Recovery is done in three passes.  In the first pass, we look for the
  * end of the log.  In the second, we assemble the list of revoke
  * blocks.  In the third and final pass, we replay any un-revoked blocks
- * in the log.
+ * in the log.  Fast commits on top of the log are then handed to the
+ * filesystem.
  */
 int jbd2_journal_recover(journal_t *journal)
 {
@@ -265,6 +323,11 @@ int jbd2_journal_recover(journal_t *journal)
 		jbd_debug(1, "No recovery required, last transaction %d\n",
 			  be32_to_cpu(sb->s_sequence));
 		journal->j_transaction_sequence = be32_to_cpu(sb->s_sequence) + 1;
+		/* The journal was emptied by a mount that failed to replay */
+		if (sb->s_fc_replay && JBD2_HAS_INCOMPAT_FEATURE(journal,
+					JBD2_FEATURE_INCOMPAT_FAST_COMMIT))
+			return fc_do_one_pass(journal,
+					      be32_to_cpu(sb->s_fc_replay_tid));
 		return 0;
 	}
 
@@ -273,6 +336,11 @@ int jbd2_journal_recover(journal_t *journal)
 		err = do_one_pass(journal, &info, PASS_REVOKE);
 	if (!err)
 		err = do_one_pass(journal, &info, PASS_REPLAY);
+	if (!err && JBD2_HAS_INCOMPAT_FEATURE(journal,
+				JBD2_FEATURE_INCOMPAT_FAST_COMMIT))
+		err = fc_do_one_pass(journal, sb->s_fc_replay ?
+				be32_to_cpu(sb->s_fc_replay_tid) :
+				info.end_transaction);
 
 	jbd_debug(1, "JBD2: recovery, exit status %d, "
 		  "recovered transactions %u to %u\n",
@@ -202,7 +202,8 @@
 	VMLINUX_SYMBOL(__stop___verbose) = .;				\
 	LIKELY_PROFILE()		       				\
 	BRANCH_PROFILE()						\
-	TRACE_PRINTKS()
+	TRACE_PRINTKS()							\
+	DEFERRED_INITCALLS()
 
 /*
  * Data section helpers
@@ -645,7 +646,15 @@
 		*(.initcall##level##.init)				\
 		*(.initcall##level##s.init)				\
 
+/*
+ * Async initcalls are kept out of the level ranges, and the device level
+ * exports where its sync subsection starts, so that init/main.c can wait for
+ * the async ones before running it.
+ */
 #define INIT_CALLS							\
+		VMLINUX_SYMBOL(__initcall_async_start) = .;		\
+		*(.initcall6a.init)					\
+		VMLINUX_SYMBOL(__initcall_async_end) = .;		\
 		VMLINUX_SYMBOL(__initcall_start) = .;			\
 		*(.initcallearly.init)					\
 		INIT_CALLS_LEVEL(0)					\
@@ -655,10 +664,19 @@
 		INIT_CALLS_LEVEL(4)					\
 		INIT_CALLS_LEVEL(5)					\
 		INIT_CALLS_LEVEL(rootfs)				\
-		INIT_CALLS_LEVEL(6)					\
+		VMLINUX_SYMBOL(__initcall6_start) = .;			\
+		*(.initcall6.init)					\
+		VMLINUX_SYMBOL(__initcall6s_start) = .;		\
+		*(.initcall6s.init)					\
 		INIT_CALLS_LEVEL(7)					\
 		VMLINUX_SYMBOL(__initcall_end) = .;
 
+#define DEFERRED_INITCALLS()						\
+	. = ALIGN(8);							\
+	VMLINUX_SYMBOL(__deferred_initcall_start) = .;			\
+	*(.deferred_initcall)						\
+	VMLINUX_SYMBOL(__deferred_initcall_end) = .;
+
 #define CON_INITCALL							\
 		VMLINUX_SYMBOL(__con_initcall_start) = .;		\
 		*(.con_initcall.init)					\
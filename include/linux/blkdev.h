@@ -149,6 +149,10 @@ struct request {
 	struct request_list *rl;		/* rl this rq is alloced from */
 	unsigned long long start_time_ns;
 	unsigned long long io_start_time_ns;    /* when passed to hardware */
+#endif
+#ifdef CONFIG_BLK_WBT
+	unsigned long long wbt_issue_ns;	/* reads: when started */
+	bool wbt_tracked;			/* counted by writeback throttling */
 #endif
 	/* Number of scatter-gather DMA addr+len pairs after
 	 * physical address coalescing is performed.
@@ -443,6 +447,10 @@ struct request_queue {
 #ifdef CONFIG_BLK_DEV_THROTTLING
 	/* Throttle data */
 	struct throtl_data *td;
+#endif
+#ifdef CONFIG_BLK_WBT
+	/* Writeback throttling */
+	struct rq_wb *rq_wb;
 #endif
 	struct rcu_head		rcu_head;
 };
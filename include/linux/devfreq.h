@@ -20,6 +20,13 @@
 
 #define DEVFREQ_NAME_LEN 16
 
+/* DEVFREQ notifier interface */
+#define DEVFREQ_TRANSITION_NOTIFIER	(0)
+
+/* Transition notifiers of DEVFREQ_TRANSITION_NOTIFIER */
+#define	DEVFREQ_PRECHANGE		(0)
+#define DEVFREQ_POSTCHANGE		(1)
+
 struct devfreq;
 
 /**
@@ -48,6 +55,39 @@ struct devfreq_dev_status {
 	bool busy;
 };
 
+/**
+ * struct devfreq_freqs - Data given to DEVFREQ_TRANSITION_NOTIFIER
+ *			  notifiers.
+ * @old:	The frequency before the transition.
+ * @new:	The frequency after (or, for DEVFREQ_PRECHANGE, requested by)
+ *		the transition.
+ */
+struct devfreq_freqs {
+	unsigned long old;
+	unsigned long new;
+};
+
+/**
+ * struct devfreq_load_history - Exponentially weighted device load history.
+ * @shift:	Weight of a new sample is 1 / 2^shift. 0 disables averaging.
+ * @avg_load:	Averaged load, scaled by 1000 << DEVFREQ_LOAD_HISTORY_FRAC.
+ * @last_load:	Load of the last sample, scaled between 0 and 1000.
+ * @valid:	True once the first sample has been accounted.
+ *
+ * Governors may embed this in their private data and feed it with the
+ * devfreq_dev_status of every sample (see devfreq_load_history_update()),
+ * so that scaling decisions are based on recent history rather than on a
+ * single, possibly noisy, sample.
+ */
+#define DEVFREQ_LOAD_HISTORY_FRAC	8
+
+struct devfreq_load_history {
+	unsigned int shift;
+	unsigned long avg_load;
+	unsigned int last_load;
+	bool valid;
+};
+
 /*
  * The resulting frequency should be at most this. (this bound is the
  * least upper bound; thus, the resulting freq should be lower or same)
@@ -156,6 +196,7 @@ struct devfreq_governor {
  * @trans_table:	Statistics of devfreq transitions
  * @time_in_state:	Statistics of devfreq states
  * @last_stat_updated:	The last time stat updated
+ * @transition_notifier_list: list head of DEVFREQ_TRANSITION_NOTIFIER notifier
  *
  * This structure stores the devfreq information for a give device.
  *
@@ -190,6 +231,8 @@ struct devfreq {
 	unsigned long *time_in_state;
 	unsigned long last_stat_updated;
 	bool suspended;
+
+	struct srcu_notifier_head transition_notifier_list;
 };
 
 #if defined(CONFIG_PM_DEVFREQ)
@@ -202,6 +245,19 @@ extern int devfreq_suspend_device(struct devfreq *devfreq);
 extern int devfreq_resume_device(struct devfreq *devfreq);
 extern int devfreq_watermark_event(struct devfreq *devfreq,
 				  int type);
+extern int devfreq_register_notifier(struct devfreq *devfreq,
+				     struct notifier_block *nb,
+				     unsigned int list);
+extern int devfreq_unregister_notifier(struct devfreq *devfreq,
+				       struct notifier_block *nb,
+				       unsigned int list);
+
+/* Load history helpers for governors and devfreq user device drivers. */
+extern void devfreq_load_history_init(struct devfreq_load_history *history,
+				      unsigned int shift);
+extern unsigned int devfreq_load_history_update(
+				struct devfreq_load_history *history,
+				struct devfreq_dev_status *stat);
 
 /* Helper functions for devfreq user device driver with OPP. */
 extern struct opp *devfreq_recommended_opp(struct device *dev,
@@ -231,6 +287,37 @@ struct devfreq_simple_ondemand_data {
 };
 #endif
 
+#if IS_ENABLED(CONFIG_DEVFREQ_GOV_PASSIVE)
+/**
+ * struct devfreq_passive_data - void *data fed to struct devfreq
+ *	and devfreq_add_device
+ * @parent:	the devfreq instance of the parent device.
+ * @get_target_freq:	Optional callback, returns the frequency of the
+ *			passive device for @parent_freq. If NULL, the
+ *			governor maps the position of the parent frequency
+ *			in its freq_table proportionally onto the freq_table
+ *			of the passive device.
+ * @parent_freq:	Frequency the parent is switching to (owned by the
+ *			governor).
+ * @this:	the devfreq instance of own device (owned by the governor).
+ * @nb:		the notifier block for DEVFREQ_TRANSITION_NOTIFIER list
+ *		(owned by the governor).
+ *
+ * The passive governor does not poll. The passive device is scaled up
+ * before the parent scales up and scaled down after the parent scales down,
+ * so that e.g. a memory clock always satisfies its client's demand.
+ */
+struct devfreq_passive_data {
+	struct devfreq *parent;
+	int (*get_target_freq)(struct devfreq *this, unsigned long parent_freq,
+			       unsigned long *freq);
+
+	unsigned long parent_freq;
+	struct devfreq *this;
+	struct notifier_block nb;
+};
+#endif
+
 #else /* !CONFIG_PM_DEVFREQ */
 static inline struct devfreq *devfreq_add_device(struct device *dev,
 					  struct devfreq_dev_profile *profile,
@@ -278,6 +365,33 @@ static inline int devfreq_watermark_event(struct devfreq *devfreq,
 {
 	return 0;
 }
+
+static inline int devfreq_register_notifier(struct devfreq *devfreq,
+					    struct notifier_block *nb,
+					    unsigned int list)
+{
+	return 0;
+}
+
+static inline int devfreq_unregister_notifier(struct devfreq *devfreq,
+					      struct notifier_block *nb,
+					      unsigned int list)
+{
+	return 0;
+}
+
+static inline void devfreq_load_history_init(
+				struct devfreq_load_history *history,
+				unsigned int shift)
+{
+}
+
+static inline unsigned int devfreq_load_history_update(
+				struct devfreq_load_history *history,
+				struct devfreq_dev_status *stat)
+{
+	return 0;
+}
 #endif /* CONFIG_PM_DEVFREQ */
 
 #endif /* __LINUX_DEVFREQ_H__ */
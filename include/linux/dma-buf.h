@@ -197,6 +197,10 @@ int dma_buf_set_drvdata(struct dma_buf *, struct device *,
 			void *, void (*destroy)(void *));
 void *dma_buf_get_drvdata(struct dma_buf *, struct device *);
 
+struct notifier_block;
+int dma_buf_register_release_notifier(struct notifier_block *nb);
+void dma_buf_unregister_release_notifier(struct notifier_block *nb);
+
 struct sg_table *dma_buf_map_attachment(struct dma_buf_attachment *,
 					enum dma_data_direction);
 void dma_buf_unmap_attachment(struct dma_buf_attachment *, struct sg_table *,
@@ -159,6 +159,10 @@ extern void (*late_time_init)(void);
 
 extern bool initcall_debug;
 
+/* Defined in init/main.c */
+extern int async_initcall_barrier_fn(void);
+extern void deferred_initcalls_trigger(void);
+
 #endif
   
 #ifndef MODULE
@@ -213,6 +217,33 @@ extern bool initcall_debug;
 
 #define __initcall(fn) device_initcall(fn)
 
+/*
+ * Async initcalls are started at the beginning of the device level and run
+ * in parallel with each other and with the regular device initcalls. All of
+ * them have returned before the device_initcall_sync level starts.
+ *
+ * async_initcall_barrier() orders async initcalls: the ones linked after the
+ * barrier start only once all the ones linked before it have returned. Link
+ * order follows the order in the file and in the Makefiles.
+ */
+#define async_initcall(fn)		__define_initcall(fn, 6a)
+#define async_initcall_barrier()					\
+	static initcall_t __UNIQUE_ID(async_initcall_barrier) __used	\
+	__attribute__((__section__(".initcall6a.init"))) =		\
+		async_initcall_barrier_fn
+
+/*
+ * Deferred initcalls run from a workqueue once deferred_initcalls_trigger()
+ * has been called (e.g. when the first frame has been displayed), when
+ * /proc/deferred_initcalls is read, or after deferred_initcall_timeout
+ * seconds.  They are meant for drivers that are not needed to boot or to
+ * show the first frame.  The function must not be marked __init, since it
+ * runs after the init sections have been freed.
+ */
+#define deferred_initcall(fn) \
+	static initcall_t __initcall_##fn##_deferred \
+	__used __section(.deferred_initcall) = fn
+
 #define __exitcall(fn) \
 	static exitcall_t __exitcall_##fn __exit_call = fn
 
@@ -290,6 +321,9 @@ void __init parse_early_options(char *cmdline);
 #define fs_initcall(fn)			module_init(fn)
 #define device_initcall(fn)		module_init(fn)
 #define late_initcall(fn)		module_init(fn)
+#define async_initcall(fn)		module_init(fn)
+#define async_initcall_barrier()
+#define deferred_initcall(fn)		module_init(fn)
 
 #define security_initcall(fn)		module_init(fn)
 
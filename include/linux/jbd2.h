@@ -268,8 +268,12 @@ typedef struct journal_superblock_s
 
 /* 0x0050 */
 	__u8	s_checksum_type;	/* checksum type */
-	__u8	s_padding2[3];
-	__u32	s_padding[42];
+	__u8	s_fc_replay;		/* Fast commits wait to be replayed */
+	__u8	s_padding2[2];
+/* 0x0054 */
+	__be32	s_num_fc_blks;		/* Number of fast commit blocks */
+	__be32	s_fc_replay_tid;	/* Transaction they belong to */
+	__u32	s_padding[40];
 	__be32	s_checksum;		/* crc32c(superblock) */
 
 /* 0x0100 */
@@ -294,6 +298,11 @@ typedef struct journal_superblock_s
 #define JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT	0x00000004
 #define JBD2_FEATURE_INCOMPAT_CSUM_V2		0x00000008
 #define JBD2_FEATURE_INCOMPAT_CSUM_V3		0x00000010
+/*
+ * Not the 0x20 of mainline kernels: the fast commit area holds ext4 records
+ * of a format of its own, which must not be taken for theirs.
+ */
+#define JBD2_FEATURE_INCOMPAT_FAST_COMMIT	0x00000040
 
 /* Features known to this kernel version: */
 #define JBD2_KNOWN_COMPAT_FEATURES	JBD2_FEATURE_COMPAT_CHECKSUM
@@ -302,7 +311,20 @@ typedef struct journal_superblock_s
 					JBD2_FEATURE_INCOMPAT_64BIT | \
 					JBD2_FEATURE_INCOMPAT_ASYNC_COMMIT | \
 					JBD2_FEATURE_INCOMPAT_CSUM_V2 | \
-					JBD2_FEATURE_INCOMPAT_CSUM_V3)
+					JBD2_FEATURE_INCOMPAT_CSUM_V3 | \
+					JBD2_FEATURE_INCOMPAT_FAST_COMMIT)
+
+/*
+ * Fast commits go to an area of their own at the end of the journal, so
+ * that they can be written without allocating log space.  Default size of
+ * that area when s_num_fc_blks is zero.
+ */
+#define JBD2_DEFAULT_FAST_COMMIT_BLOCKS	256
+
+/* Return values of j_fc_replay_callback */
+#define JBD2_FC_REPLAY_STOP	0
+#define JBD2_FC_REPLAY_CONTINUE	1
+#define JBD2_FC_REPLAY_VALID	2	/* block ends a fast commit */
 
 #ifdef __KERNEL__
 
@@ -751,6 +773,13 @@ jbd2_time_diff(unsigned long start, unsigned long end)
  * @j_proc_entry: procfs entry for the jbd statistics directory
  * @j_stats: Overall statistics
  * @j_private: An opaque pointer to fs-private information.
+ * @j_fc_first: The block number of the first fast commit block
+ * @j_fc_last: The block number one beyond the last fast commit block
+ * @j_fc_off: Number of fast commit blocks used by the running transaction
+ * @j_fc_wbuf: array of buffer_heads for the fast commit being written
+ * @j_fc_wait: Wait queue to wait for a fast or full commit to finish
+ * @j_fc_replay_callback: Called for each fast commit block during recovery
+ * @j_fc_replay_tid: Transaction the fast commits to replay belong to
  */
 
 struct journal_s
@@ -993,6 +1022,38 @@ struct journal_s
 
 	/* Precomputed journal UUID checksum for seeding other checksums */
 	__u32 j_csum_seed;
+
+	/*
+	 * Fast commit area: blocks j_fc_first to j_fc_last - 1 of the
+	 * journal, j_fc_off of which hold fast commits of the running
+	 * transaction.  j_fc_off and j_fc_wbuf are owned by whoever set
+	 * JBD2_FAST_COMMIT_ONGOING.
+	 */
+	unsigned long		j_fc_first;
+	unsigned long		j_fc_last;
+	unsigned long		j_fc_off;
+	struct buffer_head	**j_fc_wbuf;
+	wait_queue_head_t	j_fc_wait;
+
+	/*
+	 * Called during recovery for each block of the fast commit area,
+	 * @off blocks into it, with the tid fast commits must carry to
+	 * apply on top of the recovered journal.  Returns
+	 * JBD2_FC_REPLAY_CONTINUE to be handed the next block,
+	 * JBD2_FC_REPLAY_VALID if the block also completes a fast commit,
+	 * JBD2_FC_REPLAY_STOP or a negative error.
+	 */
+	int			(*j_fc_replay_callback)(journal_t *journal,
+							struct buffer_head *bh,
+							int off, tid_t tid);
+
+	/*
+	 * Set with JBD2_FC_REPLAY, and kept in the superblock until
+	 * jbd2_fc_replay_done(): the log is restarted at a new tid right
+	 * away, so a later recovery has to be told which tid the fast
+	 * commits carry.
+	 */
+	tid_t			j_fc_replay_tid;
 };
 
 /*
@@ -1007,6 +1068,13 @@ struct journal_s
 #define JBD2_ABORT_ON_SYNCDATA_ERR	0x040	/* Abort the journal on file
 						 * data write error in ordered
 						 * mode */
+#define JBD2_FAST_COMMIT_ONGOING	0x080	/* A fast commit is being
+						 * written */
+#define JBD2_FULL_COMMIT_ONGOING	0x100	/* A transaction is being
+						 * committed */
+#define JBD2_FC_REPLAY		0x200	/* Fast commits found by
+						 * recovery aren't replayed
+						 * yet */
 
 /*
  * Function declarations for the journaling transaction and buffer
@@ -1168,6 +1236,13 @@ extern int	   jbd2_journal_bmap(journal_t *, unsigned long, unsigned long long *
 extern int	   jbd2_journal_force_commit(journal_t *);
 extern int	   jbd2_journal_force_commit_nested(journal_t *);
 extern int	   jbd2_journal_file_inode(handle_t *handle, struct jbd2_inode *inode);
+extern int	   jbd2_fc_init(journal_t *, int);
+extern int	   jbd2_fc_begin_commit(journal_t *, tid_t);
+extern void	   jbd2_fc_end_commit(journal_t *);
+extern int	   jbd2_fc_get_buf(journal_t *, struct buffer_head **);
+extern void	   jbd2_fc_submit_bufs(journal_t *, int);
+extern int	   jbd2_fc_wait_bufs(journal_t *, int);
+extern void	   jbd2_fc_replay_done(journal_t *);
 extern int	   jbd2_journal_begin_ordered_truncate(journal_t *journal,
 				struct jbd2_inode *inode, loff_t new_size);
 extern void	   jbd2_journal_init_jbd_inode(struct jbd2_inode *jinode, struct inode *inode);
@@ -168,6 +168,7 @@ struct nvhost_device_data {
 	bool		push_work_done;	/* Push_op done into push buffer */
 	bool		poweron_reset;	/* Reset the engine before powerup */
 	bool		virtual_dev;	/* True if virtualized device */
+	bool		emulated_dev;	/* True if host1x runs in software */
 	char		*devfs_name;	/* Name in devfs */
 
 	char		*firmware_name;	/* Name of firmware */
@@ -333,6 +334,13 @@ static inline bool nvhost_dev_is_virtual(struct platform_device *pdev)
 	return pdata->virtual_dev;
 }
 
+static inline bool nvhost_dev_is_emulated(struct platform_device *pdev)
+{
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+
+	return pdata->emulated_dev;
+}
+
 struct nvhost_device_power_attr {
 	struct platform_device *ndev;
 	struct kobj_attribute power_attr[NVHOST_POWER_SYSFS_ATTRIB_MAX];
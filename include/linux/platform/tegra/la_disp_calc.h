@@ -0,0 +1,139 @@
+/*
+ * include/linux/platform/tegra/la_disp_calc.h
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _LINUX_PLATFORM_TEGRA_LA_DISP_CALC_H
+#define _LINUX_PLATFORM_TEGRA_LA_DISP_CALC_H
+
+#include <linux/types.h>
+#include <linux/spinlock.h>
+#include <linux/platform/tegra/latency_allowance.h>
+
+/*
+ * Display window bandwidth and latency allowance calculations. Everything
+ * here works on plain values copied out of the dc and la state, touches no
+ * hardware and keeps no global state, so that it can be cached and tested
+ * on its own.
+ */
+
+/* color format properties, indexed by TEGRA_WIN_FMT_* */
+#define TEGRA_LA_DISP_FMT_YUV		(1 << 0)
+#define TEGRA_LA_DISP_FMT_PLANAR	(1 << 1)
+#define TEGRA_LA_DISP_FMT_PACKED422	(1 << 2)
+#define TEGRA_LA_DISP_FMT_420		(1 << 3)
+#define TEGRA_LA_DISP_FMT_422		(1 << 4)
+#define TEGRA_LA_DISP_FMT_422R		(1 << 5)
+#define TEGRA_LA_DISP_FMT_444		(1 << 6)
+
+struct tegra_la_disp_fmt {
+	u8 bpp;		/* of the Y plane for planar formats */
+	u8 flags;
+};
+
+/* a window, as the memory client sees it */
+struct tegra_la_disp_win {
+	u32 fmt;		/* TEGRA_WIN_FMT_* and byte order */
+	u32 flags;		/* TEGRA_WIN_FLAG_* */
+	u32 w;			/* source size in whole pixels, not rotated */
+	u32 h;
+	u32 out_w;
+	u32 out_h;
+};
+
+struct tegra_la_disp_mode {
+	u32 pclk;		/* Hz */
+	u32 h_active;
+	u32 v_active;
+	u32 h_total;
+	u32 v_total;
+};
+
+/* what tegra_la_disp_calc_params() depends on besides la_to_dc_params */
+struct tegra_la_disp_in {
+	struct tegra_la_disp_win win;
+	struct tegra_la_disp_mode mode;
+	struct disp_client client;
+	unsigned long emc_freq_hz;
+	unsigned int bw_mbps;
+	/* MBps of the enabled windows sharing the client's buffer */
+	unsigned int total_active_space_bw;
+	unsigned int num_active_wins;
+	unsigned int dvfs_time_nsec;
+};
+
+/* chip constants of the display latency allowance */
+struct tegra_la_disp_chip {
+	int ns_per_tick;
+	int fp_factor;
+	int catchup_factor_fp;
+	int st_la_minus_snap_arb_to_row_srt_emcclks_fp;
+	int exp_time_emcclks_fp;
+	int max_la_nsec;
+	int la_max_value;
+};
+
+/*
+ * Results for the last few inputs of one window. A flip usually asks for
+ * the same window at the same EMC rate as the one before it; the LA search
+ * in bandwidth.c walks up the EMC rates and repeats that walk every flip.
+ */
+#define TEGRA_LA_DISP_CACHE_SIZE	4
+
+struct tegra_la_disp_cache {
+	spinlock_t lock;
+
+	struct tegra_la_disp_win bw_win;
+	struct tegra_la_disp_mode bw_mode;
+	unsigned int bw_tiled_mult;
+	unsigned long bw_kbps;
+	bool bw_valid;
+
+	struct {
+		struct tegra_la_disp_in in;
+		struct dc_to_la_params params;
+	} ent[TEGRA_LA_DISP_CACHE_SIZE];
+	unsigned int nr_ent;
+	unsigned int next;
+
+	unsigned long hits;
+	unsigned long misses;
+};
+
+const struct tegra_la_disp_fmt *tegra_la_disp_fmt(u32 fmt);
+
+unsigned long tegra_la_disp_win_bw(const struct tegra_la_disp_mode *mode,
+				   const struct tegra_la_disp_win *win,
+				   unsigned int tiled_mult);
+void tegra_la_disp_calc_params(const struct la_to_dc_params *la,
+			       const struct tegra_la_disp_in *in,
+			       struct dc_to_la_params *disp_params);
+long long tegra_la_disp_calc_la(const struct tegra_la_disp_chip *chip,
+				const struct disp_client *client,
+				unsigned long emc_freq_hz,
+				unsigned int bw_mbps,
+				unsigned int dvfs_time_nsec,
+				const struct dc_to_la_params *disp_params);
+
+void tegra_la_disp_cache_init(struct tegra_la_disp_cache *cache);
+unsigned long tegra_la_disp_win_bw_cached(struct tegra_la_disp_cache *cache,
+				const struct tegra_la_disp_mode *mode,
+				const struct tegra_la_disp_win *win,
+				unsigned int tiled_mult);
+void tegra_la_disp_calc_params_cached(struct tegra_la_disp_cache *cache,
+				const struct la_to_dc_params *la,
+				const struct tegra_la_disp_in *in,
+				struct dc_to_la_params *disp_params);
+
+#endif /* _LINUX_PLATFORM_TEGRA_LA_DISP_CALC_H */
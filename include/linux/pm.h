@@ -537,6 +537,10 @@ struct dev_pm_info {
 	struct wakeup_source	*wakeup;
 	bool			wakeup_path:1;
 	bool			syscore:1;
+	struct list_head	suppliers;	/* dpm_link.s_node, owned by PM core */
+	struct list_head	consumers;	/* dpm_link.c_node, ditto */
+	ktime_t			suspend_time;	/* Last "suspend" callback duration */
+	ktime_t			resume_time;	/* Last "resume" callback duration */
 #else
 	unsigned int		should_wakeup:1;
 #endif
@@ -672,6 +676,9 @@ extern void __suspend_report_result(const char *function, void *fn, int ret);
 
 extern int device_pm_wait_for_dev(struct device *sub, struct device *dev);
 extern void dpm_for_each_dev(void *data, void (*fn)(struct device *, void *));
+extern int device_pm_add_link(struct device *consumer, struct device *supplier);
+extern void device_pm_remove_link(struct device *consumer,
+				  struct device *supplier);
 
 extern int pm_generic_prepare(struct device *dev);
 extern int pm_generic_suspend_late(struct device *dev);
@@ -715,6 +722,17 @@ static inline void dpm_for_each_dev(void *data, void (*fn)(struct device *, void
 {
 }
 
+static inline int device_pm_add_link(struct device *consumer,
+				     struct device *supplier)
+{
+	return 0;
+}
+
+static inline void device_pm_remove_link(struct device *consumer,
+					 struct device *supplier)
+{
+}
+
 #define pm_generic_prepare	NULL
 #define pm_generic_suspend	NULL
 #define pm_generic_resume	NULL
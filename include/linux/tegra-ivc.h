@@ -255,6 +255,65 @@ void *tegra_ivc_write_get_next_frame(struct ivc *ivc);
 int tegra_hv_ivc_write_advance(struct tegra_hv_ivc_cookie *ivck);
 int tegra_ivc_write_advance(struct ivc *ivc);
 
+/**
+ * ivc_hv_ivc_read_get_frames - Peek at several frames to receive
+ * @ivck	IVC cookie of the queue
+ * @frames	Array receiving pointers to the frames, in queue order
+ * @max		Number of frames wanted
+ *
+ * Get access to as many received frames as are available, up to @max,
+ * without removing them from the queue. Release them with
+ * ivc_hv_ivc_read_advance_frames().
+ *
+ * Returns the number of frames, or a negative error value if failed.
+ */
+int tegra_hv_ivc_read_get_frames(struct tegra_hv_ivc_cookie *ivck,
+		void **frames, unsigned max);
+int tegra_ivc_read_get_frames(struct ivc *ivc, void **frames, unsigned max);
+
+/**
+ * ivc_hv_ivc_read_advance_frames - Advance the read queue by several frames
+ * @ivck	IVC cookie of the queue
+ * @count	Number of frames to release
+ *
+ * Advance the read queue past @count frames returned by
+ * ivc_hv_ivc_read_get_frames(), with a single counter update.
+ *
+ * Returns 0, or a negative error value if failed.
+ */
+int tegra_hv_ivc_read_advance_frames(struct tegra_hv_ivc_cookie *ivck,
+		unsigned count);
+int tegra_ivc_read_advance_frames(struct ivc *ivc, unsigned count);
+
+/**
+ * ivc_hv_ivc_write_get_frames - Reserve several frames to transmit
+ * @ivck	IVC cookie of the queue
+ * @frames	Array receiving pointers to the frames, in queue order
+ * @max		Number of frames wanted
+ *
+ * Get access to as many free frames as are available, up to @max, to be
+ * written in place. Publish them with ivc_hv_ivc_write_advance_frames().
+ *
+ * Returns the number of frames, or a negative error value if failed.
+ */
+int tegra_hv_ivc_write_get_frames(struct tegra_hv_ivc_cookie *ivck,
+		void **frames, unsigned max);
+int tegra_ivc_write_get_frames(struct ivc *ivc, void **frames, unsigned max);
+
+/**
+ * ivc_hv_ivc_write_advance_frames - Advance the write queue by several frames
+ * @ivck	IVC cookie of the queue
+ * @count	Number of frames to publish
+ *
+ * Publish the first @count frames returned by ivc_hv_ivc_write_get_frames()
+ * with a single barrier and counter update, notifying the peer at most once.
+ *
+ * Returns 0, or a negative error value if failed.
+ */
+int tegra_hv_ivc_write_advance_frames(struct tegra_hv_ivc_cookie *ivck,
+		unsigned count);
+int tegra_ivc_write_advance_frames(struct ivc *ivc, unsigned count);
+
 struct tegra_hv_ivm_cookie {
 	uint64_t ipa;
 	uint64_t size;
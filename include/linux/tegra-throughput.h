@@ -19,8 +19,59 @@
 #define TEGRA_THROUGHPUT
 
 #include <linux/notifier.h>
+#include <linux/types.h>
+
+/*
+ * Frame pacing state of the app that set the throughput target. Clients on
+ * throughput_notifier_list get a snapshot of it as the notifier data. All
+ * times are in usec.
+ */
+struct tegra_throughput_frame_hint {
+	int hint;		/* target / last frame time, in permille */
+	u32 target_us;		/* frame deadline */
+	u32 last_us;		/* last frame time */
+	u32 predicted_us;	/* predicted next frame time */
+	s32 slack_us;		/* target_us - predicted_us */
+	u32 miss_permille;	/* recent frames that missed the deadline */
+	u32 scale;		/* predicted_us / target_us, in permille */
+};
+
+/*
+ * Frame time estimator behind the frame hint. It keeps the last
+ * TEGRA_THROUGHPUT_WINDOW frame times and a histogram of them. Buckets are
+ * 1/TEGRA_THROUGHPUT_TARGET_BUCKET of the target frame time wide, so a frame
+ * that takes exactly the target time lands in the middle of bucket
+ * TEGRA_THROUGHPUT_TARGET_BUCKET; the last bucket also takes anything
+ * longer.
+ */
+#define TEGRA_THROUGHPUT_WINDOW		64
+#define TEGRA_THROUGHPUT_TARGET_BUCKET	16
+#define TEGRA_THROUGHPUT_BUCKETS	(2 * TEGRA_THROUGHPUT_TARGET_BUCKET)
+#define TEGRA_THROUGHPUT_PERCENTILE	95
+
+struct tegra_throughput_est {
+	u32 target_us;
+	u32 bucket_us;
+	u32 last_us;
+	u32 window[TEGRA_THROUGHPUT_WINDOW];
+	unsigned int head;
+	unsigned int count;
+	u16 hist[TEGRA_THROUGHPUT_BUCKETS];
+};
+
+void tegra_throughput_est_init(struct tegra_throughput_est *est,
+			       u32 target_us);
+void tegra_throughput_est_set_target(struct tegra_throughput_est *est,
+				     u32 target_us);
+void tegra_throughput_est_add(struct tegra_throughput_est *est, u32 frame_us);
+void tegra_throughput_est_hint(struct tegra_throughput_est *est,
+			       struct tegra_throughput_frame_hint *fh);
+unsigned long tegra_throughput_hint_rate(
+		const struct tegra_throughput_frame_hint *fh,
+		unsigned long rate, unsigned int busy);
 
 extern struct blocking_notifier_head throughput_notifier_list;
 int tegra_throughput_get_hint(void);
+int tegra_throughput_get_frame_hint(struct tegra_throughput_frame_hint *fh);
 
 #endif
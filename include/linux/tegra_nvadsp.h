@@ -97,6 +97,8 @@ struct nvadsp_mbox {
 
 #define NVADSP_MBOX_SMSG       0x1
 #define NVADSP_MBOX_LMSG       0x2
+/* drop the message if the same one is already waiting to be sent */
+#define NVADSP_MBOX_COALESCE   0x4
 
 status_t nvadsp_mbox_open(struct nvadsp_mbox *mbox, uint16_t *mid,
 			  const char *name, nvadsp_mbox_handler_t handler,
@@ -138,6 +140,10 @@ typedef struct _msgq_t {
 void msgq_init(msgq_t *msgq, int32_t size);
 int32_t msgq_queue_message(msgq_t *msgq, const msgq_message_t *message);
 int32_t msgq_dequeue_message(msgq_t *msgq, msgq_message_t *message);
+int32_t msgq_queue_messages(msgq_t *msgq, const msgq_message_t * const *messages,
+			    int32_t count, bool *signal);
+int32_t msgq_dequeue_messages(msgq_t *msgq, msgq_message_t **messages,
+			      int32_t count);
 #define msgq_discard_message(msgq) msgq_dequeue_message(msgq, NULL)
 
 /*
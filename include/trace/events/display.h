@@ -112,6 +112,60 @@ DEFINE_EVENT(display_basic_template, underflow,
 	TP_ARGS(dc)
 );
 
+DECLARE_EVENT_CLASS(display_bw_template,
+	TP_PROTO(struct tegra_dc *dc, unsigned long kbps),
+	TP_ARGS(dc, kbps),
+	TP_STRUCT__entry(
+		__field(	u8,		dev_id)
+		__field(	unsigned long,	kbps)
+		__field(	int,		bw_rate)
+	),
+	TP_fast_assign(
+		__entry->dev_id = dc->ndev->id;
+		__entry->kbps = kbps;
+		__entry->bw_rate = dc->bw_kbps;
+	),
+	TP_printk("dc%u kbps=%lu bw_rate=%d",
+		__entry->dev_id, __entry->kbps, __entry->bw_rate)
+);
+
+DEFINE_EVENT(display_bw_template, bandwidth_ahead,
+	TP_PROTO(struct tegra_dc *dc, unsigned long kbps),
+	TP_ARGS(dc, kbps)
+);
+
+DEFINE_EVENT(display_bw_template, bandwidth_raise,
+	TP_PROTO(struct tegra_dc *dc, unsigned long kbps),
+	TP_ARGS(dc, kbps)
+);
+
+DEFINE_EVENT(display_bw_template, bandwidth_release,
+	TP_PROTO(struct tegra_dc *dc, unsigned long kbps),
+	TP_ARGS(dc, kbps)
+);
+
+/*
+ * Latencies of a flip from the FLIP ioctl: until the windows were programmed,
+ * after the flip waited for its fences, and until the update was latched.
+ */
+TRACE_EVENT(flip_latency,
+	TP_PROTO(struct tegra_dc *dc, ktime_t request, ktime_t program,
+		 ktime_t latch),
+	TP_ARGS(dc, request, program, latch),
+	TP_STRUCT__entry(
+		__field(	u8,		dev_id)
+		__field(	s64,		program_us)
+		__field(	s64,		latch_us)
+	),
+	TP_fast_assign(
+		__entry->dev_id = dc->ndev->id;
+		__entry->program_us = ktime_us_delta(program, request);
+		__entry->latch_us = ktime_us_delta(latch, request);
+	),
+	TP_printk("dc%u program_us=%lld latch_us=%lld",
+		__entry->dev_id, __entry->program_us, __entry->latch_us)
+);
+
 TRACE_EVENT(display_syncpt_flush,
 	TP_PROTO(struct tegra_dc *dc, u32 id, u32 min, u32 max),
 	TP_ARGS(dc, id, min, max),
@@ -291,6 +291,52 @@ TRACE_EVENT(tegra_isomgr_scatter,
 		__entry->name, __entry->msg)
 );
 
+TRACE_EVENT(tegra_isomgr_latency,
+	TP_PROTO(tegra_isomgr_handle handle,
+		 char *op,
+		 s64 us),
+
+	TP_ARGS(handle, op, us),
+
+	TP_STRUCT__entry(
+		__field(tegra_isomgr_handle, handle)
+		__field(char *, op)
+		__field(s64, us)
+	),
+
+	TP_fast_assign(
+		__entry->handle = handle;
+		__entry->op = op;
+		__entry->us = us;
+	),
+
+	TP_printk("handle=%p, %s took %lldus",
+		__entry->handle, __entry->op, __entry->us)
+);
+
+TRACE_EVENT(tegra_isomgr_clk_apply,
+	TP_PROTO(s32 lt_mf,
+		 u32 seq,
+		 s64 us),
+
+	TP_ARGS(lt_mf, seq, us),
+
+	TP_STRUCT__entry(
+		__field(s32, lt_mf)
+		__field(u32, seq)
+		__field(s64, us)
+	),
+
+	TP_fast_assign(
+		__entry->lt_mf = lt_mf;
+		__entry->seq = seq;
+		__entry->us = us;
+	),
+
+	TP_printk("lt_mf=%dKHz, seq=%u, applied in %lldus",
+		__entry->lt_mf, __entry->seq, __entry->us)
+);
+
 #endif /* _TRACE_ISOMGR_H */
 
 /* This part must be outside protection */
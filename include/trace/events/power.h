@@ -242,6 +242,42 @@ TRACE_EVENT(suspend_resume,
 		(__entry->start)?"begin":"end")
 );
 
+TRACE_EVENT(device_pm_phase_summary,
+
+	TP_PROTO(const char *phase, int event, unsigned int devices,
+		 unsigned int async_devices, s64 total_us, s64 max_us,
+		 s64 elapsed_us),
+
+	TP_ARGS(phase, event, devices, async_devices, total_us, max_us,
+		elapsed_us),
+
+	TP_STRUCT__entry(
+		__field(const char *, phase)
+		__field(int, event)
+		__field(unsigned int, devices)
+		__field(unsigned int, async_devices)
+		__field(s64, total_us)
+		__field(s64, max_us)
+		__field(s64, elapsed_us)
+	),
+
+	TP_fast_assign(
+		__entry->phase = phase;
+		__entry->event = event;
+		__entry->devices = devices;
+		__entry->async_devices = async_devices;
+		__entry->total_us = total_us;
+		__entry->max_us = max_us;
+		__entry->elapsed_us = elapsed_us;
+	),
+
+	TP_printk("%s[%s] devices=%u async=%u total=%lldus max=%lldus "
+		"elapsed=%lldus", __entry->phase,
+		pm_verb_symbolic(__entry->event), __entry->devices,
+		__entry->async_devices, __entry->total_us, __entry->max_us,
+		__entry->elapsed_us)
+);
+
 DECLARE_EVENT_CLASS(wakeup_source,
 
 	TP_PROTO(const char *name, unsigned int state),
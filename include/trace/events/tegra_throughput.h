@@ -63,6 +63,30 @@ TRACE_EVENT(tegra_throughput_hint,
 	TP_printk("issuing hint=%d", __entry->hint)
 );
 
+TRACE_EVENT(tegra_throughput_frame_hint,
+	TP_PROTO(u32 predicted_us, s32 slack_us, u32 miss_permille, u32 scale),
+
+	TP_ARGS(predicted_us, slack_us, miss_permille, scale),
+
+	TP_STRUCT__entry(
+		__field(u32, predicted_us)
+		__field(s32, slack_us)
+		__field(u32, miss_permille)
+		__field(u32, scale)
+	),
+
+	TP_fast_assign(
+		__entry->predicted_us = predicted_us;
+		__entry->slack_us = slack_us;
+		__entry->miss_permille = miss_permille;
+		__entry->scale = scale;
+	),
+
+	TP_printk("predicted %u us, slack %d us, missed %u/1000, scale %u",
+		__entry->predicted_us, __entry->slack_us,
+		__entry->miss_permille, __entry->scale)
+);
+
 TRACE_EVENT(tegra_throughput_flip,
 	TP_PROTO(long timediff),
 
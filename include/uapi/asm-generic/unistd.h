@@ -706,9 +706,23 @@ __SYSCALL(__NR_seccomp, sys_seccomp)
 __SYSCALL(__NR_getrandom, sys_getrandom)
 #define __NR_memfd_create 279
 __SYSCALL(__NR_memfd_create, sys_memfd_create)
+/* Backporting copy_file_range, skip a few ...
+ * #define __NR_bpf 280
+__SYSCALL(__NR_bpf, sys_bpf)
+ * #define __NR_execveat 281
+__SC_COMP(__NR_execveat, sys_execveat, compat_sys_execveat)
+ * #define __NR_userfaultfd 282
+__SYSCALL(__NR_userfaultfd, sys_userfaultfd)
+ * #define __NR_membarrier 283
+__SYSCALL(__NR_membarrier, sys_membarrier)
+ * #define __NR_mlock2 284
+__SYSCALL(__NR_mlock2, sys_mlock2)
+ */
+#define __NR_copy_file_range 285
+__SYSCALL(__NR_copy_file_range, sys_copy_file_range)
 
 #undef __NR_syscalls
-#define __NR_syscalls 280
+#define __NR_syscalls 286
 
 /*
  * All syscalls below here should go away really,
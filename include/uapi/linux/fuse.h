@@ -343,6 +343,8 @@ enum fuse_opcode {
 	FUSE_BATCH_FORGET  = 42,
 	FUSE_FALLOCATE     = 43,
 	FUSE_READDIRPLUS   = 44,
+	/* 45 and 46 are FUSE_RENAME2 and FUSE_LSEEK upstream */
+	FUSE_COPY_FILE_RANGE = 47,
 
 	/* CUSE specific operations */
 	CUSE_INIT          = 4096,
@@ -644,6 +646,16 @@ struct fuse_fallocate_in {
 	uint32_t	padding;
 };
 
+struct fuse_copy_file_range_in {
+	uint64_t	fh_in;
+	uint64_t	off_in;
+	uint64_t	nodeid_out;
+	uint64_t	fh_out;
+	uint64_t	off_out;
+	uint64_t	len;
+	uint64_t	flags;
+};
+
 struct fuse_in_header {
 	uint32_t	len;
 	uint32_t	opcode;
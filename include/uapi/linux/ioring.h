@@ -0,0 +1,135 @@
+/*
+ * include/uapi/linux/ioring.h
+ *
+ * Shared submission/completion ring interface for asynchronous I/O.
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#ifndef _UAPI_LINUX_IORING_H
+#define _UAPI_LINUX_IORING_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/*
+ * An instance is created by opening /dev/ioring and issuing IORING_SETUP.
+ * The submission queue (SQ) ring, the completion queue (CQ) ring and the
+ * array of submission queue entries are then mmap()ed at the offsets below.
+ *
+ * The application fills a free struct ioring_sqe, stores its index in the
+ * SQ ring array at 'tail' and advances the SQ tail.  IORING_ENTER consumes
+ * the new entries (advancing the SQ head) and optionally waits for a number
+ * of completions.  Completions are posted to the CQ ring at its tail; the
+ * application advances the CQ head once it has consumed them.
+ *
+ * Each side only ever writes its own index (tail for the producer, head for
+ * the consumer), so ring entries can be exchanged without a system call per
+ * operation.  poll() on the file reports POLLIN while completions are
+ * pending.
+ */
+
+/*
+ * I/O submission data structure (Submission Queue Entry)
+ */
+struct ioring_sqe {
+	__u8	opcode;		/* type of operation, IORING_OP_* */
+	__u8	flags;		/* IOSQE_* flags, none defined yet */
+	__u16	__pad1;
+	__s32	fd;		/* file descriptor to do I/O on */
+	__u64	off;		/* offset into file */
+	__u64	addr;		/* pointer to buffer */
+	__u32	len;		/* buffer size or number of bytes */
+	union {
+		__u32	fsync_flags;	/* IORING_FSYNC_* */
+		__u32	poll_events;	/* POLL* events to wait for */
+		__u32	op_flags;
+	};
+	__u64	user_data;	/* data to be passed back at completion time */
+};
+
+#define IORING_OP_NOP		0
+#define IORING_OP_READ		1
+#define IORING_OP_WRITE		2
+#define IORING_OP_FSYNC		3
+#define IORING_OP_POLL		4
+
+/* sqe->fsync_flags */
+#define IORING_FSYNC_DATASYNC	(1U << 0)
+
+/*
+ * I/O completion data structure (Completion Queue Entry)
+ */
+struct ioring_cqe {
+	__u64	user_data;	/* sqe->user_data copied back */
+	__s32	res;		/* result code for this event */
+	__u32	flags;
+};
+
+/*
+ * Magic offsets for the application to mmap the data it needs
+ */
+#define IORING_OFF_SQ_RING	0ULL
+#define IORING_OFF_CQ_RING	0x8000000ULL
+#define IORING_OFF_SQES		0x10000000ULL
+
+/*
+ * Filled with the offset for mmap(2)
+ */
+struct ioring_sqring_offsets {
+	__u32	head;
+	__u32	tail;
+	__u32	ring_mask;
+	__u32	ring_entries;
+	__u32	dropped;	/* invalid indexes skipped by the kernel */
+	__u32	array;
+	__u32	resv[2];
+};
+
+struct ioring_cqring_offsets {
+	__u32	head;
+	__u32	tail;
+	__u32	ring_mask;
+	__u32	ring_entries;
+	__u32	overflow;	/* completions lost to a full CQ ring */
+	__u32	cqes;
+	__u32	resv[2];
+};
+
+/*
+ * Passed in for IORING_SETUP, copied back with updated info on success.
+ * The entry counts are rounded up to a power of two; cq_entries defaults
+ * to twice the SQ size when zero.
+ */
+struct ioring_params {
+	__u32	sq_entries;
+	__u32	cq_entries;
+	__u32	flags;
+	__u32	resv[5];
+	struct ioring_sqring_offsets sq_off;
+	struct ioring_cqring_offsets cq_off;
+};
+
+#define IORING_MAX_ENTRIES	4096
+
+/*
+ * Consume up to to_submit new SQ entries, then wait until at least
+ * min_complete completions are available in the CQ ring.  Returns the
+ * number of entries consumed.
+ */
+struct ioring_enter {
+	__u32	to_submit;
+	__u32	min_complete;
+	__u32	flags;
+	__u32	resv;
+};
+
+#define IORING_IOC_MAGIC	0xB4
+
+#define IORING_SETUP		_IOWR(IORING_IOC_MAGIC, 1, struct ioring_params)
+#define IORING_ENTER		_IOW(IORING_IOC_MAGIC, 2, struct ioring_enter)
+
+#endif /* _UAPI_LINUX_IORING_H */
@@ -65,6 +65,8 @@
 #include <linux/kgdb.h>
 #include <linux/ftrace.h>
 #include <linux/async.h>
+#include <linux/seq_file.h>
+#include <linux/workqueue.h>
 #include <linux/kmemcheck.h>
 #include <linux/sfi.h>
 #include <linux/shmem_fs.h>
@@ -670,8 +672,6 @@ static void __init do_ctors(void)
 bool initcall_debug;
 core_param(initcall_debug, initcall_debug, bool, 0644);
 
-static char msgbuf[64];
-
 static int __init_or_module do_one_initcall_debug(initcall_t fn)
 {
 	ktime_t calltime, delta, rettime;
@@ -693,6 +693,7 @@ static int __init_or_module do_one_initcall_debug(initcall_t fn)
 int __init_or_module do_one_initcall(initcall_t fn)
 {
 	int count = preempt_count();
+	char msgbuf[64];	/* async initcalls may run concurrently */
 	int ret;
 
 	if (initcall_debug)
@@ -724,8 +725,11 @@ extern initcall_t __initcall3_start[];
 extern initcall_t __initcall4_start[];
 extern initcall_t __initcall5_start[];
 extern initcall_t __initcall6_start[];
+extern initcall_t __initcall6s_start[];
 extern initcall_t __initcall7_start[];
 extern initcall_t __initcall_end[];
+extern initcall_t __initcall_async_start[];
+extern initcall_t __initcall_async_end[];
 
 static initcall_t *initcall_levels[] __initdata = {
 	__initcall0_start,
@@ -751,10 +755,103 @@ static char *initcall_level_names[] __initdata = {
 	"late",
 };
 
+/* If unset, async initcalls run in link order at the start of the device level */
+static bool initcall_async = true;
+core_param(initcall_async, initcall_async, bool, 0444);
+
+/*
+ * Exclusive domains, so that async_synchronize_full() called from an async
+ * initcall does not wait for itself.
+ */
+static ASYNC_DOMAIN_EXCLUSIVE(async_initcall_domain);
+static ASYNC_DOMAIN_EXCLUSIVE(async_initcall_dispatch_domain);
+
+static unsigned int async_initcall_count __initdata;
+static atomic64_t async_initcall_busy_ns __initdata = ATOMIC64_INIT(0);
+static ktime_t async_initcall_calltime __initdata;
+
+int __init async_initcall_barrier_fn(void)
+{
+	return 0;
+}
+
+static void __init do_one_async_initcall(void *data, async_cookie_t cookie)
+{
+	initcall_t fn = (initcall_t)data;
+	ktime_t calltime = ktime_get();
+
+	do_one_initcall(fn);
+	atomic64_add(ktime_to_ns(ktime_sub(ktime_get(), calltime)),
+		     &async_initcall_busy_ns);
+}
+
+/*
+ * Schedule the async initcalls one by one, waiting at the barriers.  This
+ * runs asynchronously itself, so that the barriers don't hold up the regular
+ * device initcalls.
+ */
+static void __init async_initcall_dispatch(void *data, async_cookie_t cookie)
+{
+	initcall_t *fn;
+
+	for (fn = __initcall_async_start; fn < __initcall_async_end; fn++) {
+		if (*fn == async_initcall_barrier_fn) {
+			async_synchronize_full_domain(&async_initcall_domain);
+			continue;
+		}
+		async_initcall_count++;
+		async_schedule_domain(do_one_async_initcall, (void *)*fn,
+				      &async_initcall_domain);
+	}
+}
+
+static void __init do_async_initcalls_start(void)
+{
+	initcall_t *fn;
+
+	async_initcall_calltime = ktime_get();
+
+	if (initcall_async) {
+		async_schedule_domain(async_initcall_dispatch, NULL,
+				      &async_initcall_dispatch_domain);
+		return;
+	}
+
+	for (fn = __initcall_async_start; fn < __initcall_async_end; fn++)
+		if (*fn != async_initcall_barrier_fn)
+			do_one_initcall(*fn);
+}
+
+static void __init do_async_initcalls_sync(void)
+{
+	ktime_t calltime = ktime_get();
+
+	async_synchronize_full_domain(&async_initcall_dispatch_domain);
+	async_synchronize_full_domain(&async_initcall_domain);
+
+	if (initcall_debug && initcall_async)
+		pr_info("async initcalls: %u done in %lld usecs of work, "
+			"device level waited %lld usecs for them after "
+			"%lld usecs\n", async_initcall_count,
+			(long long)div_u64(
+				atomic64_read(&async_initcall_busy_ns),
+				NSEC_PER_USEC),
+			ktime_to_us(ktime_sub(ktime_get(), calltime)),
+			ktime_to_us(ktime_sub(calltime,
+					      async_initcall_calltime)));
+}
+
+static void __init do_initcall_range(initcall_t *start, initcall_t *end)
+{
+	initcall_t *fn;
+
+	for (fn = start; fn < end; fn++)
+		do_one_initcall(*fn);
+}
+
 static void __init do_initcall_level(int level)
 {
 	extern const struct kernel_param __start___param[], __stop___param[];
-	initcall_t *fn;
 
 	strcpy(static_command_line, saved_command_line);
 	parse_args(initcall_level_names[level],
@@ -763,8 +860,16 @@ static void __init do_initcall_level(int level)
 		   level, level,
 		   &repair_env_string);
 
-	for (fn = initcall_levels[level]; fn < initcall_levels[level+1]; fn++)
-		do_one_initcall(*fn);
+	/* Async initcalls run alongside the device level, before its sync part */
+	if (initcall_levels[level] == __initcall6_start) {
+		do_async_initcalls_start();
+		do_initcall_range(__initcall6_start, __initcall6s_start);
+		do_async_initcalls_sync();
+		do_initcall_range(__initcall6s_start, initcall_levels[level+1]);
+		return;
+	}
+
+	do_initcall_range(initcall_levels[level], initcall_levels[level+1]);
 }
 
 static void __init do_initcalls(void)
@@ -795,6 +900,97 @@ static void __init do_basic_setup(void)
 	random_int_secret_init();
 }
 
+extern initcall_t __deferred_initcall_start[], __deferred_initcall_end[];
+
+/* Seconds after which deferred initcalls run if nobody triggered them */
+static unsigned int deferred_initcall_timeout = 30;
+core_param(deferred_initcall_timeout, deferred_initcall_timeout, uint, 0644);
+
+static DEFINE_MUTEX(deferred_initcalls_lock);
+static bool deferred_initcalls_done;
+
+static void run_deferred_initcalls(struct work_struct *work)
+{
+	ktime_t calltime, delta;
+	initcall_t *fn;
+	int ret;
+
+	mutex_lock(&deferred_initcalls_lock);
+	if (deferred_initcalls_done)
+		goto out;
+
+	calltime = ktime_get();
+	for (fn = __deferred_initcall_start; fn < __deferred_initcall_end;
+	     fn++) {
+		if (initcall_debug)
+			pr_debug("calling  %pF @ %i (deferred)\n", *fn,
+				 task_pid_nr(current));
+		delta = ktime_get();
+		ret = (*fn)();
+		delta = ktime_sub(ktime_get(), delta);
+		if (initcall_debug)
+			pr_debug("initcall %pF returned %d after %lld usecs\n",
+				 *fn, ret, ktime_to_us(delta));
+	}
+	deferred_initcalls_done = true;
+
+	pr_info("deferred initcalls: %d done after %lld usecs\n",
+		(int)(__deferred_initcall_end - __deferred_initcall_start),
+		ktime_to_us(ktime_sub(ktime_get(), calltime)));
+out:
+	mutex_unlock(&deferred_initcalls_lock);
+}
+
+static DECLARE_WORK(deferred_initcalls_work, run_deferred_initcalls);
+static DECLARE_DELAYED_WORK(deferred_initcalls_timeout_work,
+			    run_deferred_initcalls);
+
+/**
+ * deferred_initcalls_trigger - run the deferred initcalls
+ *
+ * Called once the system is usable enough for the non-critical drivers to
+ * be probed, typically when the first frame has been displayed.  The
+ * initcalls run asynchronously from a workqueue, only the first call has
+ * an effect.
+ */
+void deferred_initcalls_trigger(void)
+{
+	schedule_work(&deferred_initcalls_work);
+}
+EXPORT_SYMBOL_GPL(deferred_initcalls_trigger);
+
+/* Reading /proc/deferred_initcalls runs them and waits for completion */
+static int deferred_initcalls_show(struct seq_file *m, void *v)
+{
+	deferred_initcalls_trigger();
+	flush_work(&deferred_initcalls_work);
+	seq_printf(m, "%d\n", deferred_initcalls_done);
+	return 0;
+}
+
+static int deferred_initcalls_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, deferred_initcalls_show, NULL);
+}
+
+static const struct file_operations deferred_initcalls_fops = {
+	.open		= deferred_initcalls_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init deferred_initcalls_init(void)
+{
+	proc_create("deferred_initcalls", S_IRUSR, NULL,
+		    &deferred_initcalls_fops);
+	if (deferred_initcall_timeout)
+		schedule_delayed_work(&deferred_initcalls_timeout_work,
+				      deferred_initcall_timeout * HZ);
+	return 0;
+}
+late_initcall(deferred_initcalls_init);
+
 static void __init do_pre_smp_initcalls(void)
 {
 	initcall_t *fn;
@@ -14,6 +14,65 @@
 
 #include "power.h"
 
+/*
+ * Pages queued on a bio chain are gathered into one bio for as long as they
+ * are contiguous on disk, so the image is transferred in large requests
+ * instead of one page at a time.  The bio under construction is submitted
+ * when the next page does not fit into it, before any synchronous I/O and
+ * before anybody waits on a bio chain.
+ */
+#define HIB_BIO_PAGES	64
+
+static struct bio *hib_batch;
+static struct bio **hib_batch_chain;
+static int hib_batch_rw;
+
+static void hib_submit_batch(void)
+{
+	if (!hib_batch)
+		return;
+
+	submit_bio(hib_batch_rw | REQ_SYNC, hib_batch);
+	hib_batch = NULL;
+	hib_batch_chain = NULL;
+}
+
+static bool hib_batch_fits(int rw, struct block_device *bdev,
+		sector_t sector, struct bio **bio_chain)
+{
+	return bio_chain == hib_batch_chain && rw == hib_batch_rw &&
+		bdev == hib_batch->bi_bdev &&
+		sector == hib_batch->bi_sector + (hib_batch->bi_size >> 9);
+}
+
+/*
+ * Like end_swap_bio_read(), but for bios carrying more than one page.
+ */
+static void hib_end_io(struct bio *bio, int err)
+{
+	const int uptodate = test_bit(BIO_UPTODATE, &bio->bi_flags);
+	struct bio_vec *bvec;
+	int i;
+
+	if (!uptodate)
+		printk(KERN_ALERT "PM: I/O error on image device (%u:%u)\n",
+			imajor(bio->bi_bdev->bd_inode),
+			iminor(bio->bi_bdev->bd_inode));
+
+	bio_for_each_segment_all(bvec, bio, i) {
+		struct page *page = bvec->bv_page;
+
+		if (uptodate) {
+			SetPageUptodate(page);
+		} else {
+			SetPageError(page);
+			ClearPageUptodate(page);
+		}
+		unlock_page(page);
+	}
+	bio_put(bio);
+}
+
 /**
  *	submit - submit BIO request.
  *	@rw:	READ or WRITE.
@@ -24,6 +83,9 @@
  *	Straight from the textbook - allocate and initialize the bio.
  *	If we're reading, make sure the page is marked as dirty.
  *	Then submit it and, if @bio_chain == NULL, wait.
+ *
+ *	With @bio_chain != NULL the page is appended to the bio being batched
+ *	if it directly follows it on disk, see hib_submit_batch().
  */
 static int submit(int rw, struct block_device *bdev, sector_t sector,
 		struct page *page, struct bio **bio_chain)
@@ -31,10 +93,21 @@ static int submit(int rw, struct block_device *bdev, sector_t sector,
 	const int bio_rw = rw | REQ_SYNC;
 	struct bio *bio;
 
-	bio = bio_alloc(__GFP_WAIT | __GFP_HIGH, 1);
+	if (hib_batch) {
+		if (bio_chain && hib_batch_fits(rw, bdev, sector, bio_chain) &&
+		    bio_add_page(hib_batch, page, PAGE_SIZE, 0) == PAGE_SIZE) {
+			lock_page(page);
+			if (rw == READ)
+				get_page(page);	/* These pages are freed later */
+			return 0;
+		}
+		hib_submit_batch();
+	}
+
+	bio = bio_alloc(__GFP_WAIT | __GFP_HIGH, bio_chain ? HIB_BIO_PAGES : 1);
 	bio->bi_sector = sector;
 	bio->bi_bdev = bdev;
-	bio->bi_end_io = end_swap_bio_read;
+	bio->bi_end_io = hib_end_io;
 
 	if (bio_add_page(bio, page, PAGE_SIZE, 0) < PAGE_SIZE) {
 		printk(KERN_ERR "PM: Adding page to bio failed at %llu\n",
@@ -57,7 +130,9 @@ static int submit(int rw, struct block_device *bdev, sector_t sector,
 			get_page(page);	/* These pages are freed later */
 		bio->bi_private = *bio_chain;
 		*bio_chain = bio;
-		submit_bio(bio_rw, bio);
+		hib_batch = bio;
+		hib_batch_chain = bio_chain;
+		hib_batch_rw = rw;
 	}
 	return 0;
 }
@@ -86,15 +161,22 @@ int hib_wait_on_bio_chain(struct bio **bio_chain)
 	bio = *bio_chain;
 	if (bio == NULL)
 		return 0;
+
+	hib_submit_batch();
+
 	while (bio) {
-		struct page *page;
+		struct bio_vec *bvec;
+		int i;
 
 		next_bio = bio->bi_private;
-		page = bio->bi_io_vec[0].bv_page;
-		wait_on_page_locked(page);
-		if (!PageUptodate(page) || PageError(page))
-			ret = -EIO;
-		put_page(page);
+		bio_for_each_segment_all(bvec, bio, i) {
+			struct page *page = bvec->bv_page;
+
+			wait_on_page_locked(page);
+			if (!PageUptodate(page) || PageError(page))
+				ret = -EIO;
+			put_page(page);
+		}
 		bio_put(bio);
 		bio = next_bio;
 	}
@@ -34,6 +34,7 @@
 
 
 static int nocompress;
+static int compress_lz4;
 static int noresume;
 static int resume_wait;
 static int resume_delay;
@@ -679,6 +680,8 @@ int hibernate(void)
 			flags |= SF_NOCOMPRESS_MODE;
 		else
 		        flags |= SF_CRC32_MODE;
+		if (compress_lz4)
+			flags |= SF_LZ4_MODE;
 
 		pr_debug("PM: writing image.\n");
 		error = swsusp_write(flags);
@@ -1097,6 +1100,8 @@ static int __init hibernate_setup(char *str)
 		noresume = 1;
 	else if (!strncmp(str, "nocompress", 10))
 		nocompress = 1;
+	else if (!strncmp(str, "lz4", 3))
+		compress_lz4 = 1;
 	return 1;
 }
 
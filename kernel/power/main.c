@@ -71,6 +71,44 @@ static ssize_t pm_async_store(struct kobject *kobj, struct kobj_attribute *attr,
 
 power_attr(pm_async);
 
+/*
+ * If set, every device is suspended and resumed asynchronously, not only the
+ * ones whose drivers set power.async_suspend.  Ordering is still enforced
+ * between parents and children and along links added by device_pm_add_link().
+ */
+int pm_async_all_enabled;
+
+static ssize_t pm_async_all_show(struct kobject *kobj,
+				 struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%d\n", pm_async_all_enabled);
+}
+
+static ssize_t pm_async_all_store(struct kobject *kobj,
+				  struct kobj_attribute *attr,
+				  const char *buf, size_t n)
+{
+	unsigned long val;
+
+	if (kstrtoul(buf, 10, &val))
+		return -EINVAL;
+
+	if (val > 1)
+		return -EINVAL;
+
+	pm_async_all_enabled = val;
+	return n;
+}
+
+power_attr(pm_async_all);
+
+static int __init pm_async_all_setup(char *str)
+{
+	pm_async_all_enabled = 1;
+	return 1;
+}
+__setup("pm_async_all", pm_async_all_setup);
+
 #ifdef CONFIG_PM_DEBUG
 int pm_test_level = TEST_NONE;
 
@@ -586,6 +624,7 @@ static struct attribute * g[] = {
 #endif
 #ifdef CONFIG_PM_SLEEP
 	&pm_async_attr.attr,
+	&pm_async_all_attr.attr,
 	&wakeup_count_attr.attr,
 #ifdef CONFIG_PM_AUTOSLEEP
 	&autosleep_attr.attr,
@@ -25,6 +25,7 @@
 #include <linux/pm.h>
 #include <linux/slab.h>
 #include <linux/lzo.h>
+#include <linux/lz4.h>
 #include <linux/vmalloc.h>
 #include <linux/cpumask.h>
 #include <linux/atomic.h>
@@ -419,17 +420,27 @@ static int swap_writer_finish(struct swap_map_handle *handle,
 #define LZO_UNC_PAGES	32
 #define LZO_UNC_SIZE	(LZO_UNC_PAGES * PAGE_SIZE)
 
-/* Number of pages/bytes we need for compressed data (worst case). */
+/*
+ * Number of pages/bytes we need for compressed data (worst case). The LZO
+ * bound also covers LZ4, whose worst case is smaller for these block sizes.
+ */
 #define LZO_CMP_PAGES	DIV_ROUND_UP(lzo1x_worst_compress(LZO_UNC_SIZE) + \
 			             LZO_HEADER, PAGE_SIZE)
 #define LZO_CMP_SIZE	(LZO_CMP_PAGES * PAGE_SIZE)
 
-/* Maximum number of threads for compression/decompression. */
-#define LZO_THREADS	3
+/* Compression workspace, large enough for either compressor. */
+#define LZO_WRK_SIZE	(LZO1X_1_MEM_COMPRESS > LZ4_MEM_COMPRESS ? \
+			 LZO1X_1_MEM_COMPRESS : LZ4_MEM_COMPRESS)
+
+/*
+ * Maximum number of threads for compression/decompression. One CPU is left
+ * to the thread doing the I/O, the rest get a compression thread each.
+ */
+#define LZO_THREADS	8
 
 /* Minimum/maximum number of pages for read buffering. */
 #define LZO_MIN_RD_PAGES	1024
-#define LZO_MAX_RD_PAGES	8192
+#define LZO_MAX_RD_PAGES	32768
 
 
 /**
@@ -521,7 +532,7 @@ static int crc32_threadfn(void *data)
 	return 0;
 }
 /**
- * Structure used for LZO data compression.
+ * Structure used for LZO/LZ4 data compression.
  */
 struct cmp_data {
 	struct task_struct *thr;                  /* thread */
@@ -534,7 +545,8 @@ struct cmp_data {
 	size_t cmp_len;                           /* compressed length */
 	unsigned char unc[LZO_UNC_SIZE];          /* uncompressed buffer */
 	unsigned char cmp[LZO_CMP_SIZE];          /* compressed buffer */
-	unsigned char wrk[LZO1X_1_MEM_COMPRESS];  /* compression workspace */
+	bool lz4;                                 /* use LZ4 instead of LZO */
+	unsigned char wrk[LZO_WRK_SIZE];          /* compression workspace */
 };
 
 /**
@@ -556,9 +568,14 @@ static int lzo_compress_threadfn(void *data)
 		}
 		atomic_set(&d->ready, 0);
 
-		d->ret = lzo1x_1_compress(d->unc, d->unc_len,
-		                          d->cmp + LZO_HEADER, &d->cmp_len,
-		                          d->wrk);
+		if (d->lz4)
+			d->ret = lz4_compress(d->unc, d->unc_len,
+			                      d->cmp + LZO_HEADER, &d->cmp_len,
+			                      d->wrk);
+		else
+			d->ret = lzo1x_1_compress(d->unc, d->unc_len,
+			                          d->cmp + LZO_HEADER,
+			                          &d->cmp_len, d->wrk);
 		atomic_set(&d->stop, 1);
 		wake_up(&d->done);
 	}
@@ -566,15 +583,17 @@ static int lzo_compress_threadfn(void *data)
 }
 
 /**
- * save_image_lzo - Save the suspend image data compressed with LZO.
+ * save_image_lzo - Save the suspend image data compressed with LZO or LZ4.
  * @handle: Swap mam handle to use for saving the image.
  * @snapshot: Image to read data from.
  * @nr_to_write: Number of pages to save.
+ * @flags: Image flags, SF_LZ4_MODE selects LZ4.
  */
 static int save_image_lzo(struct swap_map_handle *handle,
                           struct snapshot_handle *snapshot,
-                          unsigned int nr_to_write)
+                          unsigned int nr_to_write, unsigned int flags)
 {
+	const char *cmp_name = flags & SF_LZ4_MODE ? "LZ4" : "LZO";
 	unsigned int m;
 	int ret = 0;
 	int nr_pages;
@@ -608,8 +627,10 @@ static int save_image_lzo(struct swap_map_handle *handle,
 		ret = -ENOMEM;
 		goto out_clean;
 	}
-	for (thr = 0; thr < nr_threads; thr++)
+	for (thr = 0; thr < nr_threads; thr++) {
 		memset(&data[thr], 0, offsetof(struct cmp_data, go));
+		data[thr].lz4 = !!(flags & SF_LZ4_MODE);
+	}
 
 	crc = kmalloc(sizeof(*crc), GFP_KERNEL);
 	if (!crc) {
@@ -666,9 +687,9 @@ static int save_image_lzo(struct swap_map_handle *handle,
 	handle->reqd_free_pages = reqd_free_pages();
 
 	printk(KERN_INFO
-		"PM: Using %u thread(s) for compression.\n"
+		"PM: Using %u thread(s) for %s compression.\n"
 		"PM: Compressing and saving image data (%u pages)...\n",
-		nr_threads, nr_to_write);
+		nr_threads, cmp_name, nr_to_write);
 	m = nr_to_write / 10;
 	if (!m)
 		m = 1;
@@ -719,7 +740,8 @@ static int save_image_lzo(struct swap_map_handle *handle,
 			ret = data[thr].ret;
 
 			if (ret < 0) {
-				printk(KERN_ERR "PM: LZO compression failed\n");
+				printk(KERN_ERR "PM: %s compression failed\n",
+				       cmp_name);
 				goto out_finish;
 			}
 
@@ -727,7 +749,8 @@ static int save_image_lzo(struct swap_map_handle *handle,
 			             data[thr].cmp_len >
 			             lzo1x_worst_compress(data[thr].unc_len))) {
 				printk(KERN_ERR
-				       "PM: Invalid LZO compressed length\n");
+				       "PM: Invalid %s compressed length\n",
+				       cmp_name);
 				ret = -1;
 				goto out_finish;
 			}
@@ -844,7 +867,7 @@ int swsusp_write(unsigned int flags)
 	if (!error) {
 		error = (flags & SF_NOCOMPRESS_MODE) ?
 			save_image(&handle, &snapshot, pages - 1) :
-			save_image_lzo(&handle, &snapshot, pages - 1);
+			save_image_lzo(&handle, &snapshot, pages - 1, flags);
 	}
 out_finish:
 	error = swap_writer_finish(&handle, flags, error);
@@ -1010,7 +1033,7 @@ static int load_image(struct swap_map_handle *handle,
 }
 
 /**
- * Structure used for LZO data decompression.
+ * Structure used for LZO/LZ4 data decompression.
  */
 struct dec_data {
 	struct task_struct *thr;                  /* thread */
@@ -1023,6 +1046,7 @@ struct dec_data {
 	size_t cmp_len;                           /* compressed length */
 	unsigned char unc[LZO_UNC_SIZE];          /* uncompressed buffer */
 	unsigned char cmp[LZO_CMP_SIZE];          /* compressed buffer */
+	bool lz4;                                 /* use LZ4 instead of LZO */
 };
 
 /**
@@ -1045,8 +1069,14 @@ static int lzo_decompress_threadfn(void *data)
 		atomic_set(&d->ready, 0);
 
 		d->unc_len = LZO_UNC_SIZE;
-		d->ret = lzo1x_decompress_safe(d->cmp + LZO_HEADER, d->cmp_len,
-		                               d->unc, &d->unc_len);
+		if (d->lz4)
+			d->ret = lz4_decompress_unknownoutputsize(
+					d->cmp + LZO_HEADER, d->cmp_len,
+					d->unc, &d->unc_len);
+		else
+			d->ret = lzo1x_decompress_safe(d->cmp + LZO_HEADER,
+			                               d->cmp_len,
+			                               d->unc, &d->unc_len);
 		atomic_set(&d->stop, 1);
 		wake_up(&d->done);
 	}
@@ -1054,15 +1084,18 @@ static int lzo_decompress_threadfn(void *data)
 }
 
 /**
- * load_image_lzo - Load compressed image data and decompress them with LZO.
+ * load_image_lzo - Load compressed image data and decompress them with LZO
+ * or LZ4.
  * @handle: Swap map handle to use for loading data.
  * @snapshot: Image to copy uncompressed data into.
  * @nr_to_read: Number of pages to load.
+ * @flags: Image flags, SF_LZ4_MODE selects LZ4.
  */
 static int load_image_lzo(struct swap_map_handle *handle,
                           struct snapshot_handle *snapshot,
-                          unsigned int nr_to_read)
+                          unsigned int nr_to_read, unsigned int flags)
 {
+	const char *cmp_name = flags & SF_LZ4_MODE ? "LZ4" : "LZO";
 	unsigned int m;
 	int ret = 0;
 	int eof = 0;
@@ -1099,8 +1132,10 @@ static int load_image_lzo(struct swap_map_handle *handle,
 		ret = -ENOMEM;
 		goto out_clean;
 	}
-	for (thr = 0; thr < nr_threads; thr++)
+	for (thr = 0; thr < nr_threads; thr++) {
 		memset(&data[thr], 0, offsetof(struct dec_data, go));
+		data[thr].lz4 = !!(flags & SF_LZ4_MODE);
+	}
 
 	crc = kmalloc(sizeof(*crc), GFP_KERNEL);
 	if (!crc) {
@@ -1182,9 +1217,9 @@ static int load_image_lzo(struct swap_map_handle *handle,
 	want = ring_size = i;
 
 	printk(KERN_INFO
-		"PM: Using %u thread(s) for decompression.\n"
+		"PM: Using %u thread(s) for %s decompression.\n"
 		"PM: Loading and decompressing image data (%u pages)...\n",
-		nr_threads, nr_to_read);
+		nr_threads, cmp_name, nr_to_read);
 	m = nr_to_read / 10;
 	if (!m)
 		m = 1;
@@ -1246,7 +1281,8 @@ static int load_image_lzo(struct swap_map_handle *handle,
 			             data[thr].cmp_len >
 			             lzo1x_worst_compress(LZO_UNC_SIZE))) {
 				printk(KERN_ERR
-				       "PM: Invalid LZO compressed length\n");
+				       "PM: Invalid %s compressed length\n",
+				       cmp_name);
 				ret = -1;
 				goto out_finish;
 			}
@@ -1298,7 +1334,8 @@ static int load_image_lzo(struct swap_map_handle *handle,
 
 			if (ret < 0) {
 				printk(KERN_ERR
-				       "PM: LZO decompression failed\n");
+				       "PM: %s decompression failed\n",
+				       cmp_name);
 				goto out_finish;
 			}
 
@@ -1306,7 +1343,8 @@ static int load_image_lzo(struct swap_map_handle *handle,
 			             data[thr].unc_len > LZO_UNC_SIZE ||
 			             data[thr].unc_len & (PAGE_SIZE - 1))) {
 				printk(KERN_ERR
-				       "PM: Invalid LZO uncompressed length\n");
+				       "PM: Invalid %s uncompressed length\n",
+				       cmp_name);
 				ret = -1;
 				goto out_finish;
 			}
@@ -1343,6 +1381,8 @@ out_finish:
 		wait_event(crc->done, atomic_read(&crc->stop));
 		atomic_set(&crc->stop, 0);
 	}
+	/* Don't free the ring while read-ahead is still in flight */
+	hib_wait_on_bio_chain(&bio);
 	do_gettimeofday(&stop);
 	if (!ret) {
 		printk(KERN_INFO "PM: Image loading done.\n");
@@ -1405,7 +1445,8 @@ int swsusp_read(unsigned int *flags_p)
 	if (!error) {
 		error = (*flags_p & SF_NOCOMPRESS_MODE) ?
 			load_image(&handle, &snapshot, header->pages - 1) :
-			load_image_lzo(&handle, &snapshot, header->pages - 1);
+			load_image_lzo(&handle, &snapshot, header->pages - 1,
+				       *flags_p);
 	}
 	swap_reader_finish(&handle);
 end:
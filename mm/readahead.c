@@ -19,6 +19,7 @@
 #include <linux/pagemap.h>
 #include <linux/syscalls.h>
 #include <linux/file.h>
+#include <linux/math64.h>
 
 /*
  * Initialise a struct file's readahead state.  Assumes that the caller has
@@ -336,7 +337,133 @@ static unsigned long get_next_ra_size(struct file_ra_state *ra,
  *
  * The code ramps up the readahead size aggressively at first, but slow down as
  * it approaches max_readhead.
+ *
+ * Several streams reading one file at once each get a window: when a read
+ * starts a window somewhere else, the one it replaces is kept in
+ * ra->streams[], and a later read that continues a kept window resumes it
+ * at the size it had ramped up to.  Cache misses at a constant distance
+ * from each other that is larger than the reads, e.g. a reader walking
+ * one column of a table, are detected as well and have the next few of
+ * them read ahead.
+ *
+ * Across opens, mapping->ra_hint remembers which parts of the file were
+ * streamed through with full-sized readahead windows: each bit stands for
+ * 1/BITS_PER_LONG of the file.  Only sequential ramp-up sets it, so the
+ * initial windows of random reads leave it alone.  A read that starts a
+ * new stream in such a part gets the full window at once instead of
+ * ramping up to it.  Truncation and invalidation clear the hint.
+ */
+
+static bool ra_next_in_window(pgoff_t start, unsigned int size,
+			      unsigned int async_size, pgoff_t offset)
+{
+	return offset == start + size - async_size || offset == start + size;
+}
+
+/*
+ * Save the current window in ra->streams[] before another stream takes
+ * over, dropping the one that was interrupted longest ago.
+ */
+static void ra_save_stream(struct file_ra_state *ra)
+{
+	if (!ra->size)
+		return;
+
+	memmove(&ra->streams[1], &ra->streams[0],
+		(RA_STREAMS - 1) * sizeof(ra->streams[0]));
+	ra->streams[0].start = ra->start;
+	ra->streams[0].size = ra->size;
+	ra->streams[0].async_size = ra->async_size;
+}
+
+/*
+ * If @offset continues a saved stream, make its window the current one
+ * and save the current one in its place.
  */
+static bool ra_resume_stream(struct file_ra_state *ra, pgoff_t offset)
+{
+	struct file_ra_stream s;
+	int i;
+
+	for (i = 0; i < RA_STREAMS; i++) {
+		s = ra->streams[i];
+		if (!s.size ||
+		    !ra_next_in_window(s.start, s.size, s.async_size, offset))
+			continue;
+
+		memmove(&ra->streams[i], &ra->streams[i + 1],
+			(RA_STREAMS - 1 - i) * sizeof(ra->streams[0]));
+		memset(&ra->streams[RA_STREAMS - 1], 0,
+		       sizeof(ra->streams[0]));
+		ra_save_stream(ra);
+		ra->start = s.start;
+		ra->size = s.size;
+		ra->async_size = s.async_size;
+		count_vm_event(READAHEAD_STREAM);
+		return true;
+	}
+	return false;
+}
+
+/*
+ * Which bit of mapping->ra_hint covers @index.  The parts scale with the
+ * file, so a hint recorded before the file grew is only approximate.
+ */
+static unsigned int ra_hint_bit(struct address_space *mapping, pgoff_t index)
+{
+	loff_t isize = i_size_read(mapping->host);
+	u64 nr = (isize + PAGE_CACHE_SIZE - 1) >> PAGE_CACHE_SHIFT;
+
+	if (index >= nr)
+		return BITS_PER_LONG - 1;
+	return div64_u64((u64)index * BITS_PER_LONG, nr);
+}
+
+static void ra_hint_mark(struct address_space *mapping,
+			 struct file_ra_state *ra)
+{
+	unsigned int bit = ra_hint_bit(mapping, ra->start);
+	unsigned int last = ra_hint_bit(mapping, ra->start + ra->size - 1);
+
+	for (; bit <= last; bit++)
+		if (!test_bit(bit, &mapping->ra_hint))
+			set_bit(bit, &mapping->ra_hint);
+}
+
+/*
+ * Read ahead for strided cache misses: if @offset is as far from the
+ * previous miss as that one was from the miss before, read the next
+ * strided chunks of @req_size pages, up to @max pages in all.  Returns
+ * the number of pages submitted, or 0 if this is not a strided read.
+ */
+static unsigned long ra_stride_readahead(struct address_space *mapping,
+					 struct file_ra_state *ra,
+					 struct file *filp, pgoff_t offset,
+					 unsigned long req_size,
+					 unsigned long max)
+{
+	unsigned long nr, i, ret = 0;
+	pgoff_t stride = offset - ra->stride_prev;
+
+	if (offset <= ra->stride_prev || stride != ra->stride ||
+	    stride <= req_size) {
+		ra->stride = offset > ra->stride_prev ? stride : 0;
+		ra->stride_prev = offset;
+		return 0;
+	}
+
+	nr = max(max / req_size, 1UL);
+	for (i = 0; i < nr; i++)
+		ret += __do_page_cache_readahead(mapping, filp,
+						 offset + i * stride,
+						 req_size, 0);
+
+	/* the next miss is expected right after the last chunk read */
+	ra->stride_prev = offset + (nr - 1) * stride;
+	count_vm_event(READAHEAD_STRIDE);
+
+	return ret;
+}
 
 /*
  * Count contiguously cached pages from @offset-1 to @offset-@max,
@@ -384,6 +511,7 @@ static int try_context_readahead(struct address_space *mapping,
 	if (size >= offset)
 		size *= 2;
 
+	ra_save_stream(ra);
 	ra->start = offset;
 	ra->size = get_init_ra_size(size + req_size, max);
 	ra->async_size = ra->size;
@@ -401,22 +529,27 @@ ondemand_readahead(struct address_space *mapping,
 		   unsigned long req_size)
 {
 	unsigned long max = max_sane_readahead(ra->ra_pages);
+	unsigned long ret;
 
 	/*
 	 * start of file
 	 */
 	if (!offset)
-		goto initial_readahead;
+		goto new_stream;
 
 	/*
-	 * It's the expected callback offset, assume sequential access.
+	 * It's the expected callback offset, or that of another stream
+	 * reading this file, assume sequential access.
 	 * Ramp up sizes, and push forward the readahead window.
 	 */
-	if ((offset == (ra->start + ra->size - ra->async_size) ||
-	     offset == (ra->start + ra->size))) {
+	if (ra_next_in_window(ra->start, ra->size, ra->async_size, offset) ||
+	    ra_resume_stream(ra, offset)) {
 		ra->start += ra->size;
 		ra->size = get_next_ra_size(ra, max);
 		ra->async_size = ra->size;
+		/* only a stream that ramped up to the full window is a hint */
+		if (ra->size >= max)
+			ra_hint_mark(mapping, ra);
 		goto readit;
 	}
 
@@ -436,6 +569,7 @@ ondemand_readahead(struct address_space *mapping,
 		if (!start || start - offset > max)
 			return 0;
 
+		ra_save_stream(ra);
 		ra->start = start;
 		ra->size = start - offset;	/* old async_size */
 		ra->size += req_size;
@@ -463,15 +597,25 @@ ondemand_readahead(struct address_space *mapping,
 	if (try_context_readahead(mapping, ra, offset, req_size, max))
 		goto readit;
 
+	ret = ra_stride_readahead(mapping, ra, filp, offset, req_size, max);
+	if (ret)
+		return ret;
+
 	/*
 	 * standalone, small random read
 	 * Read as is, and do not pollute the readahead state.
 	 */
 	return __do_page_cache_readahead(mapping, filp, offset, req_size, 0);
 
+new_stream:
+	ra_save_stream(ra);
 initial_readahead:
 	ra->start = offset;
-	ra->size = get_init_ra_size(req_size, max);
+	/* start where earlier opens left off if they streamed through here */
+	if (test_bit(ra_hint_bit(mapping, offset), &mapping->ra_hint))
+		ra->size = max;
+	else
+		ra->size = get_init_ra_size(req_size, max);
 	ra->async_size = ra->size > req_size ? ra->size - req_size : ra->size;
 
 readit:
@@ -485,7 +629,10 @@ readit:
 		ra->size += ra->async_size;
 	}
 
-	return ra_submit(ra, mapping, filp);
+	ret = ra_submit(ra, mapping, filp);
+	count_vm_events(READAHEAD_PAGES, ret);
+
+	return ret;
 }
 
 /**
@@ -516,6 +663,8 @@ void page_cache_sync_readahead(struct address_space *mapping,
 		return;
 	}
 
+	count_vm_event(READAHEAD_MISS);
+
 	/* do read-ahead */
 	ondemand_readahead(mapping, ra, filp, false, offset, req_size);
 }
@@ -560,6 +709,8 @@ page_cache_async_readahead(struct address_space *mapping,
 	if (bdi_read_congested(mapping->backing_dev_info))
 		return;
 
+	count_vm_event(READAHEAD_HIT);
+
 	/* do read-ahead */
 	ondemand_readahead(mapping, ra, filp, true, offset, req_size);
 }
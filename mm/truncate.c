@@ -212,6 +212,8 @@ void truncate_inode_pages_range(struct address_space *mapping,
 	pgoff_t end;
 	int i;
 
+	/* the parts the hint covers no longer hold what was streamed */
+	mapping->ra_hint = 0;
 	cleancache_invalidate_inode(mapping);
 	if (mapping->nrpages == 0)
 		return;
@@ -343,6 +345,8 @@ unsigned long invalidate_mapping_pages(struct address_space *mapping,
 	 * (most pages are dirty), and already skips over any difficulties.
 	 */
 
+	mapping->ra_hint = 0;
+
 	pagevec_init(&pvec, 0);
 	while (index <= end && pagevec_lookup(&pvec, mapping, index,
 			min(end - index, (pgoff_t)PAGEVEC_SIZE - 1) + 1)) {
@@ -442,6 +446,7 @@ int invalidate_inode_pages2_range(struct address_space *mapping,
 	int ret2 = 0;
 	int did_range_unmap = 0;
 
+	mapping->ra_hint = 0;
 	cleancache_invalidate_inode(mapping);
 	pagevec_init(&pvec, 0);
 	index = start;
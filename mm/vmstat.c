@@ -777,6 +777,12 @@ const char * const vmstat_text[] = {
 
 	"pgrotated",
 
+	"readahead_hit",
+	"readahead_miss",
+	"readahead_pages",
+	"readahead_stream",
+	"readahead_stride",
+
 #ifdef CONFIG_NUMA_BALANCING
 	"numa_pte_updates",
 	"numa_huge_pte_updates",
@@ -428,7 +428,7 @@ static int tegra210_adsp_send_msg(struct tegra210_adsp_app *app,
 	if (ret < 0) {
 		/* Wakeup APM to consume messages and give it some time */
 		ret = nvadsp_mbox_send(&app->apm_mbox, apm_cmd_msg_ready,
-			NVADSP_MBOX_SMSG, false, 0);
+			NVADSP_MBOX_SMSG | NVADSP_MBOX_COALESCE, false, 0);
 		if (ret) {
 			pr_err("%s: Failed to send mailbox message id %d ret %d\n",
 				__func__, app->apm->mbox_id, ret);
@@ -448,7 +448,7 @@ static int tegra210_adsp_send_msg(struct tegra210_adsp_app *app,
 		return 0;
 
 	ret = nvadsp_mbox_send(&app->apm_mbox, apm_cmd_msg_ready,
-		NVADSP_MBOX_SMSG, false, 0);
+		NVADSP_MBOX_SMSG | NVADSP_MBOX_COALESCE, false, 0);
 	if (ret) {
 		pr_err("%s: Failed to send mailbox message id %d ret %d\n",
 			__func__, app->apm->mbox_id, ret);
@@ -970,14 +970,18 @@ static status_t tegra210_adsp_msg_handler(uint32_t msg, void *data)
 
 	switch (msg) {
 	case apm_cmd_msg_ready: {
-		ret = tegra210_adsp_get_msg(app->apm, &apm_msg);
-		if (ret < 0) {
-			pr_err("Dequeue failed %d.", ret);
-			break;
+		/*
+		 * Drain the queue: a signal may stand for several messages,
+		 * and find none left when an earlier one took them all.
+		 */
+		while ((ret = tegra210_adsp_get_msg(app->apm, &apm_msg)) == 0) {
+			if (app->msg_handler)
+				app->msg_handler(app, &apm_msg);
 		}
-
-		if (app->msg_handler)
-			ret = app->msg_handler(app, &apm_msg);
+		if (ret == -ENOMSG)
+			ret = 0;
+		else
+			pr_err("Dequeue failed %d.", ret);
 	}
 	break;
 	default:
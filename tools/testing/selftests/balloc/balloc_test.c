@@ -0,0 +1,322 @@
+/*
+ * balloc_test.c - gk20a buddy allocator test and trace-replay benchmark
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Builds drivers/gpu/nvgpu/gk20a/gk20a_allocator.c and lib/rbtree.c against
+ * the shims in include/ and drives a GVA allocator set up the way
+ * mm_gk20a.c sets up the small page VA space.
+ *
+ * Usage:
+ *   balloc_test [TRACE]
+ *       Check that allocations never overlap and that freed space can be
+ *       had back in one piece, with and without the free buddy caches and
+ *       slabs. Then replay TRACE, a file of "a ID LEN" (map LEN bytes as
+ *       ID) and "f ID" (unmap ID) lines, or without TRACE a synthetic
+ *       trace of an app that maps and unmaps buffers, mostly small, every
+ *       frame. Reports the time per operation and the buddy meta data
+ *       allocations (two per split) in both configurations.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "gk20a_allocator.h"
+
+#define VA_BASE		(1ULL << 20)
+#define PAGE		SZ_4K
+
+#define TRACE_MAX_IDS	(1 << 20)
+
+unsigned long shim_kmem_cache_allocs;
+
+static struct vm_gk20a vm = { .big_page_size = 128 << 10 };
+
+static const struct {
+	const char *name;
+	u64 flags;
+} modes[] = {
+	{ "nocache", GPU_BALLOC_NO_CACHE },
+	{ "cache", 0 },
+};
+
+static int init(struct gk20a_allocator *a, u64 size, u64 flags)
+{
+	return __gk20a_allocator_init(a, &vm, "balloc_test", VA_BASE, size,
+				      PAGE, GPU_BALLOC_MAX_ORDER,
+				      GPU_BALLOC_GVA_SPACE | flags);
+}
+
+/* Mostly single pages, some mid sized buffers and a few big ones. */
+static u64 random_len(void)
+{
+	int r = rand() % 100;
+
+	if (r < 50)
+		return PAGE;
+	if (r < 75)
+		return PAGE << (1 + rand() % 4);
+	if (r < 90)
+		return PAGE * (16 + rand() % 48);
+	return (1 << 20) << (rand() % 3);
+}
+
+/* functional test */
+#define CHECK(cond)							\
+do {									\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%d: %s failed\n", __FILE__,		\
+			__LINE__, #cond);				\
+		return -1;						\
+	}								\
+} while (0)
+
+#define CHECK_SIZE	(64ULL << 20)
+#define CHECK_LIVE	2048
+
+static unsigned char page_map[CHECK_SIZE / PAGE];
+
+static struct {
+	u64 addr, len;
+} live[CHECK_LIVE];
+static int nr_live;
+
+static int check_alloc(struct gk20a_allocator *a, u64 len)
+{
+	u64 addr = gk20a_balloc(a, len), p;
+
+	if (!addr)
+		return 0;
+	CHECK(addr >= VA_BASE && addr + len <= VA_BASE + CHECK_SIZE);
+	CHECK(!(addr & (PAGE - 1)));
+
+	for (p = (addr - VA_BASE) / PAGE; p < (addr - VA_BASE + len) / PAGE; p++) {
+		CHECK(!page_map[p]);
+		page_map[p] = 1;
+	}
+
+	live[nr_live].addr = addr;
+	live[nr_live].len = len;
+	nr_live++;
+	return 0;
+}
+
+static void check_free(struct gk20a_allocator *a, int i)
+{
+	u64 p;
+
+	gk20a_bfree(a, live[i].addr);
+	for (p = (live[i].addr - VA_BASE) / PAGE;
+	     p < (live[i].addr - VA_BASE + live[i].len) / PAGE; p++)
+		page_map[p] = 0;
+	live[i] = live[--nr_live];
+}
+
+static int check(u64 flags)
+{
+	struct gk20a_allocator a;
+	u64 addr, freed;
+	int i;
+
+	CHECK(!init(&a, CHECK_SIZE, flags));
+	memset(page_map, 0, sizeof(page_map));
+	nr_live = 0;
+
+	for (i = 0; i < 200000; i++) {
+		if (nr_live < CHECK_LIVE && (!nr_live || rand() % 2))
+			CHECK(!check_alloc(&a, random_len()));
+		else
+			check_free(&a, rand() % nr_live);
+	}
+
+	/* double frees and addresses inside an allocation are ignored */
+	CHECK(!check_alloc(&a, PAGE));
+	addr = live[nr_live - 1].addr;
+	check_free(&a, nr_live - 1);
+	freed = a.bytes_freed;
+	gk20a_bfree(&a, addr);
+	gk20a_bfree(&a, addr + 1);
+	CHECK(a.bytes_freed == freed);
+
+	while (nr_live)
+		check_free(&a, nr_live - 1);
+
+	/* everything coalesces back */
+	addr = gk20a_balloc(&a, CHECK_SIZE);
+	CHECK(addr == VA_BASE);
+	gk20a_bfree(&a, addr);
+
+	/* a fixed alloc over space that was just freed */
+	for (i = 0; i < 64; i++)
+		CHECK(!check_alloc(&a, PAGE << (i % 3)));
+	while (nr_live)
+		check_free(&a, nr_live - 1);
+	CHECK(gk20a_balloc_fixed(&a, VA_BASE, 1 << 20) == VA_BASE);
+
+	/* destroy with slab objects and buddies outstanding */
+	for (i = 0; i < 100; i++)
+		CHECK(gk20a_balloc(&a, PAGE << (i % 2)));
+	gk20a_allocator_destroy(&a);
+
+	printf("check %-8s [PASS]\n", flags ? "nocache" : "cache");
+	return 0;
+}
+
+/* trace replay */
+struct op {
+	u32 id;		/* ~0 for an unmap */
+	u32 unmap_id;
+	u64 len;
+};
+
+static struct op *ops;
+static unsigned long nr_ops, max_ops;
+static u64 *addrs;
+
+static void add_op(u32 id, u32 unmap_id, u64 len)
+{
+	if (nr_ops == max_ops) {
+		max_ops = max_ops ? max_ops * 2 : 4096;
+		ops = realloc(ops, max_ops * sizeof(*ops));
+		if (!ops)
+			exit(1);
+	}
+	ops[nr_ops].id = id;
+	ops[nr_ops].unmap_id = unmap_id;
+	ops[nr_ops].len = len;
+	nr_ops++;
+}
+
+static int load_trace(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	unsigned long long len;
+	unsigned id;
+	char c;
+
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+
+	while (fscanf(f, " %c %u", &c, &id) == 2) {
+		if (id >= TRACE_MAX_IDS)
+			goto bad;
+		if (c == 'a' && fscanf(f, " %llu", &len) == 1)
+			add_op(id, ~0, len);
+		else if (c == 'f')
+			add_op(~0, id, 0);
+		else
+			goto bad;
+	}
+	fclose(f);
+	return 0;
+bad:
+	fprintf(stderr, "%s: bad trace line at op %lu\n", path, nr_ops);
+	fclose(f);
+	return -1;
+}
+
+/*
+ * 256 long lived buffers, then 20000 frames that each map 48 buffers that
+ * stay mapped for one to three frames.
+ */
+#define GEN_FRAMES	20000
+#define GEN_PER_FRAME	48
+#define GEN_LIFE	4
+
+static void gen_trace(void)
+{
+	static u32 frame_ids[GEN_LIFE][GEN_PER_FRAME * GEN_LIFE];
+	int nr_frame_ids[GEN_LIFE] = { 0 };
+	u32 id = 0;
+	int f, i, slot;
+
+	for (i = 0; i < 256; i++)
+		add_op(id++, ~0, random_len());
+
+	for (f = 0; f < GEN_FRAMES; f++) {
+		slot = f % GEN_LIFE;
+		for (i = 0; i < nr_frame_ids[slot]; i++)
+			add_op(~0, frame_ids[slot][i], 0);
+		nr_frame_ids[slot] = 0;
+
+		for (i = 0; i < GEN_PER_FRAME; i++) {
+			int end = (f + 1 + rand() % (GEN_LIFE - 1)) % GEN_LIFE;
+
+			id = 256 + (id - 256 + 1) % (TRACE_MAX_IDS - 256);
+			frame_ids[end][nr_frame_ids[end]++] = id;
+			add_op(id, ~0, random_len());
+		}
+	}
+}
+
+static int replay(u64 flags, const char *name)
+{
+	struct gk20a_allocator a;
+	unsigned long i, failed = 0, meta;
+	struct timespec t0, t1;
+	double ns;
+
+	if (init(&a, 16ULL << 30, flags))
+		return -1;
+	memset(addrs, 0, TRACE_MAX_IDS * sizeof(*addrs));
+	meta = shim_kmem_cache_allocs;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < nr_ops; i++) {
+		struct op *op = &ops[i];
+
+		if (op->id != ~0U) {
+			addrs[op->id] = gk20a_balloc(&a, op->len);
+			failed += !addrs[op->id];
+		} else {
+			gk20a_bfree(&a, addrs[op->unmap_id]);
+			addrs[op->unmap_id] = 0;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+	meta = shim_kmem_cache_allocs - meta;
+	printf("replay %-8s %lu ops  %6.1f ns/op  %9lu buddy allocs"
+	       "  %9llu cache hits  %9llu slab allocs  %lu failed\n",
+	       name, nr_ops, ns / nr_ops, meta, a.free_cache_hits,
+	       a.slab_allocs, failed);
+
+	gk20a_allocator_destroy(&a);
+	return failed ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+	int i, ret = 0;
+
+	srand(1);
+	for (i = 0; i < ARRAY_SIZE(modes); i++)
+		ret |= check(modes[i].flags);
+	if (ret)
+		return 1;
+
+	if (argc > 1) {
+		if (load_trace(argv[1]))
+			return 1;
+	} else {
+		gen_trace();
+	}
+
+	addrs = calloc(TRACE_MAX_IDS, sizeof(*addrs));
+	if (!addrs)
+		return 1;
+
+	for (i = 0; i < ARRAY_SIZE(modes); i++)
+		ret |= replay(modes[i].flags, modes[i].name);
+
+	return ret ? 1 : 0;
+}
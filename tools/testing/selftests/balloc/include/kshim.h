@@ -0,0 +1,242 @@
+/*
+ * Just enough of the kernel environment to build gk20a_allocator.c and
+ * lib/rbtree.c in userspace. This header is included ahead of everything
+ * else, which also keeps the GPU driver headers gk20a_allocator.c includes
+ * out: the little they provide to the allocator is defined here instead.
+ */
+#ifndef _BALLOC_TEST_KSHIM_H
+#define _BALLOC_TEST_KSHIM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef int32_t s32;
+typedef uint32_t u32;
+typedef int64_t s64;
+typedef unsigned long long u64;
+typedef unsigned int gfp_t;
+typedef unsigned short umode_t;
+
+#define GFP_KERNEL	0
+#define S_IRUGO		0444
+#define SZ_4K		0x1000
+
+#define likely(x)		__builtin_expect(!!(x), 1)
+#define unlikely(x)		__builtin_expect(!!(x), 0)
+#define EXPORT_SYMBOL(sym)
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+struct hlist_head {
+	struct hlist_node *first;
+};
+
+struct hlist_node {
+	struct hlist_node *next, **pprev;
+};
+
+#define LIST_POISON1	((void *)0x00100100)
+#define LIST_POISON2	((void *)0x00200200)
+
+#define BUG()		abort()
+#define BUG_ON(c)	do { if (c) abort(); } while (0)
+#define pr_info(...)	printf(__VA_ARGS__)
+#define trace_printk(...)	do { } while (0)
+
+#define ALIGN(x, a)	(((x) + (a) - 1) & ~((__typeof__(x))(a) - 1))
+#define min_t(type, x, y)	((type)(x) < (type)(y) ? (type)(x) : (type)(y))
+
+static inline int fls(int x)
+{
+	return x ? 32 - __builtin_clz(x) : 0;
+}
+
+static inline unsigned long __ffs(unsigned long word)
+{
+	return __builtin_ctzl(word);
+}
+
+static inline unsigned long __fls(unsigned long word)
+{
+	return 63 - __builtin_clzl(word);
+}
+
+#define ilog2(n)	(63 - __builtin_clzll(n))
+
+/* bitmaps */
+#define BITS_PER_LONG		64
+#define BITS_TO_LONGS(nr)	(((nr) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+#define DECLARE_BITMAP(name, bits)	unsigned long name[BITS_TO_LONGS(bits)]
+
+static inline void __set_bit(int nr, unsigned long *addr)
+{
+	addr[nr / BITS_PER_LONG] |= 1UL << (nr % BITS_PER_LONG);
+}
+
+static inline void __clear_bit(int nr, unsigned long *addr)
+{
+	addr[nr / BITS_PER_LONG] &= ~(1UL << (nr % BITS_PER_LONG));
+}
+
+static inline int test_bit(int nr, const unsigned long *addr)
+{
+	return (addr[nr / BITS_PER_LONG] >> (nr % BITS_PER_LONG)) & 1;
+}
+
+static inline unsigned long find_first_zero_bit(const unsigned long *addr,
+						unsigned long size)
+{
+	unsigned long i;
+
+	for (i = 0; i < size; i += BITS_PER_LONG)
+		if (~addr[i / BITS_PER_LONG])
+			return i + __builtin_ctzl(~addr[i / BITS_PER_LONG]);
+	return size;
+}
+
+/* locking */
+struct mutex {
+	pthread_mutex_t m;
+};
+
+#define mutex_init(l)		pthread_mutex_init(&(l)->m, NULL)
+#define mutex_lock(l)		pthread_mutex_lock(&(l)->m)
+#define mutex_unlock(l)		pthread_mutex_unlock(&(l)->m)
+
+/* memory; the test counts the buddy meta data allocations */
+struct kmem_cache {
+	size_t size;
+};
+
+extern unsigned long shim_kmem_cache_allocs;
+
+static inline struct kmem_cache *kmem_cache_create(size_t size)
+{
+	struct kmem_cache *c = calloc(1, sizeof(*c));
+
+	if (c)
+		c->size = size;
+	return c;
+}
+
+#define KMEM_CACHE(s, flags)	kmem_cache_create(sizeof(struct s))
+
+static inline void *kmem_cache_alloc(struct kmem_cache *c, gfp_t flags)
+{
+	shim_kmem_cache_allocs++;
+	return malloc(c->size);
+}
+
+static inline void kmem_cache_free(struct kmem_cache *c, void *p)
+{
+	free(p);
+}
+
+#define kmalloc(size, flags)	malloc(size)
+#define kzalloc(size, flags)	calloc(1, size)
+#define kfree(p)		free(p)
+
+#define IS_ERR_OR_NULL(p) \
+	(!(p) || (unsigned long)(p) >= (unsigned long)-4095)
+
+/* debugfs and seq_file, never set up by the test */
+struct inode {
+	void *i_private;
+};
+struct file;
+struct dentry;
+
+struct seq_file {
+	void *private;
+};
+
+struct file_operations {
+	int (*open)(struct inode *, struct file *);
+	long (*read)(struct file *, char *, size_t, long long *);
+	long long (*llseek)(struct file *, long long, int);
+	int (*release)(struct inode *, struct file *);
+};
+
+#define seq_printf(s, ...)	printf(__VA_ARGS__)
+#define seq_read		NULL
+#define seq_lseek		NULL
+#define single_release		NULL
+
+static inline int single_open(struct file *file,
+			      int (*show)(struct seq_file *, void *),
+			      void *data)
+{
+	return -ENODEV;
+}
+
+static inline struct dentry *debugfs_create_dir(const char *name,
+						struct dentry *parent)
+{
+	return NULL;
+}
+
+static inline struct dentry *debugfs_create_file(const char *name,
+		umode_t mode, struct dentry *parent, void *data,
+		const struct file_operations *fops)
+{
+	return NULL;
+}
+
+static inline struct dentry *debugfs_create_u32(const char *name,
+		umode_t mode, struct dentry *parent, u32 *value)
+{
+	return NULL;
+}
+
+static inline void debugfs_remove(struct dentry *dentry)
+{
+}
+
+/* platform_gk20a.h */
+#define _GK20A_PLATFORM_H_
+
+struct platform_device {
+	void *drvdata;
+};
+
+struct gk20a_platform {
+	struct dentry *debugfs;
+};
+
+#define platform_get_drvdata(pdev)	((pdev)->drvdata)
+
+/* mm_gk20a.h: one VM whose VA space is all small pages */
+#define MM_GK20A_H
+
+enum gmmu_pgsz_gk20a {
+	gmmu_page_size_small  = 0,
+	gmmu_page_size_big    = 1,
+	gmmu_page_size_kernel = 2,
+	gmmu_nr_page_sizes    = 3,
+};
+
+struct vm_gk20a {
+	u32 big_page_size;
+};
+
+static inline enum gmmu_pgsz_gk20a __get_pte_size(struct vm_gk20a *vm,
+						  u64 base, u64 size)
+{
+	return gmmu_page_size_small;
+}
+
+#endif
@@ -0,0 +1 @@
+#include "../../../../../../include/linux/list.h"
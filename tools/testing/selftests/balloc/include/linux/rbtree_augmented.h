@@ -0,0 +1 @@
+#include "../../../../../../include/linux/rbtree_augmented.h"
@@ -0,0 +1,279 @@
+/*
+ * history_test.c - history cpuidle governor test
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Builds drivers/cpuidle/governors/history.c against the shims in include/
+ * and drives it like the cpuidle core does, with a fake driver of three
+ * states. Each idle period has a known time to the next timer event and a
+ * known residency, so the state the governor selects and the hits, misses
+ * and shallow entries it reports in debugfs are checked exactly.
+ *
+ * Usage:
+ *   history_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include <kshim.h>
+
+#define INTERVALS	8	/* as in history.c */
+
+enum { WFI, GATED, OFF, NR_STATES };
+
+static struct cpuidle_driver drv = {
+	.name = "fake_idle",
+	.states = {
+		[WFI] = {
+			.name = "wfi",
+			.flags = CPUIDLE_FLAG_TIME_VALID,
+			.exit_latency = 1,
+			.target_residency = 1,
+		},
+		[GATED] = {
+			.name = "cpu-gated",
+			.flags = CPUIDLE_FLAG_TIME_VALID,
+			.exit_latency = 50,
+			.target_residency = 200,
+		},
+		[OFF] = {
+			.name = "cluster-off",
+			.flags = CPUIDLE_FLAG_TIME_VALID,
+			.exit_latency = 500,
+			.target_residency = 2000,
+		},
+	},
+	.state_count = NR_STATES,
+};
+
+static struct cpuidle_device dev;
+
+/* the cpuidle core, time and PM QoS */
+struct cpuidle_device *cpuidle_devices[NR_CPUS] = { &dev };
+static struct cpuidle_governor *gov;
+static ktime_t sleep_length;
+static int latency_req = 2000000000;
+
+extern int (*shim_postcore_initcall)(void);
+extern int (*shim_late_initcall)(void);
+
+int cpuidle_register_governor(struct cpuidle_governor *g)
+{
+	gov = g;
+	return 0;
+}
+
+struct cpuidle_driver *cpuidle_get_cpu_driver(struct cpuidle_device *d)
+{
+	return &drv;
+}
+
+ktime_t tick_nohz_get_sleep_length(void)
+{
+	return sleep_length;
+}
+
+int pm_qos_request(int pm_qos_class)
+{
+	return latency_req;
+}
+
+/* debugfs */
+static const struct file_operations *stats_fops;
+static struct seq_file stats_seq;
+
+struct dentry *debugfs_create_dir(const char *name, struct dentry *parent)
+{
+	return (struct dentry *)&stats_fops;
+}
+
+struct dentry *debugfs_create_file(const char *name, int mode,
+		struct dentry *parent, void *data,
+		const struct file_operations *fops)
+{
+	stats_fops = fops;
+	return (struct dentry *)&stats_fops;
+}
+
+void debugfs_remove_recursive(struct dentry *dentry)
+{
+}
+
+int seq_printf(struct seq_file *m, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsnprintf(m->buf + m->len, sizeof(m->buf) - m->len, fmt, ap);
+	va_end(ap);
+	m->len += n;
+	return 0;
+}
+
+int single_open(struct file *file, int (*show)(struct seq_file *, void *),
+		void *data)
+{
+	stats_seq.len = 0;
+	file->private_data = &stats_seq;
+	return show(&stats_seq, data);
+}
+
+/*
+ * One idle period: select a state with the next timer @sleep_us away, and
+ * wake up @idle_us later, plus the exit latency of the state.
+ */
+static int idle(unsigned int sleep_us, unsigned int idle_us)
+{
+	int idx;
+
+	sleep_length = (ktime_t)sleep_us * 1000;
+	idx = gov->select(&drv, &dev);
+	dev.last_residency = idle_us;
+	if (idx >= 0)
+		dev.last_residency += drv.states[idx].exit_latency;
+	gov->reflect(&dev, idx);
+	return idx;
+}
+
+/* forget everything, then idle for @idle_us INTERVALS times */
+static void history(unsigned int idle_us)
+{
+	int i;
+
+	gov->enable(&drv, &dev);
+	for (i = 0; i < INTERVALS; i++)
+		idle(100000, idle_us);
+}
+
+struct stats {
+	unsigned long long hits, misses, shallow;
+};
+
+static int read_stats(struct stats *st)
+{
+	struct inode inode = { NULL };
+	struct file file;
+	char name[16];
+	char *line;
+	int cpu, i;
+
+	memset(st, 0, NR_STATES * sizeof(*st));
+	if (stats_fops->open(&inode, &file))
+		return -1;
+
+	line = strchr(stats_seq.buf, '\n');
+	for (i = 0; i < NR_STATES && line; i++) {
+		if (sscanf(line + 1, "%d %15s %llu %llu %llu", &cpu, name,
+			   &st[i].hits, &st[i].misses, &st[i].shallow) != 5 ||
+		    strcmp(name, drv.states[i].name))
+			return -1;
+		line = strchr(line + 1, '\n');
+	}
+	return i == NR_STATES ? 0 : -1;
+}
+
+#define CHECK(cond)							\
+do {									\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%d: %s failed\n", __FILE__,		\
+			__LINE__, #cond);				\
+		return -1;						\
+	}								\
+} while (0)
+
+static int test_select(void)
+{
+	int i;
+
+	/* no history yet: only wfi, until most periods reach a residency */
+	gov->enable(&drv, &dev);
+	for (i = 0; i < 5; i++)
+		CHECK(idle(100000, 5000) == WFI);
+	CHECK(idle(100000, 5000) == OFF);
+
+	/* the next timer event bounds the state */
+	history(5000);
+	CHECK(idle(1000, 900) == GATED);
+	CHECK(idle(150, 100) == WFI);
+	CHECK(idle(5, 5) == CPUIDLE_DRIVER_STATE_START - 1);
+
+	/* and so do the latency requirement and disabled states */
+	history(5000);
+	latency_req = 100;
+	CHECK(idle(100000, 5000) == GATED);
+	latency_req = 0;
+	CHECK(idle(100000, 5000) == WFI);
+	latency_req = 2000000000;
+	dev.states_usage[GATED].disable = 1;
+	CHECK(idle(100000, 5000) == OFF);
+	dev.states_usage[GATED].disable = 0;
+	drv.states[OFF].disabled = true;
+	CHECK(idle(100000, 5000) == GATED);
+	drv.states[OFF].disabled = false;
+
+	/*
+	 * shorter wakeups: a state is left once fewer than 5 of the last 8
+	 * periods reached its target residency, i.e. after the 4th short one
+	 */
+	history(5000);
+	for (i = 0; i < 4; i++)
+		CHECK(idle(100000, 300) == OFF);
+	CHECK(idle(100000, 300) == GATED);
+	for (i = 0; i < 4; i++)
+		CHECK(idle(100000, 100) == GATED);
+	CHECK(idle(100000, 100) == WFI);
+
+	printf("selection [PASS]\n");
+	return 0;
+}
+
+static int test_stats(void)
+{
+	struct stats st[NR_STATES];
+	int i;
+
+	gov->enable(&drv, &dev);
+	/* 5 periods in wfi that cluster-off would have made: shallow */
+	for (i = 0; i < 5; i++)
+		CHECK(idle(100000, 5000) == WFI);
+	/* 3 in cluster-off that made it: hits */
+	for (i = 0; i < 3; i++)
+		CHECK(idle(100000, 5000) == OFF);
+	/* bounded by the timer, cpu-gated made it: hit */
+	CHECK(idle(1000, 900) == GATED);
+	/* cluster-off, woken after 300us: miss */
+	CHECK(idle(100000, 300) == OFF);
+	/* the last period is accounted at the next selection */
+	sleep_length = 100000 * 1000;
+	gov->select(&drv, &dev);
+
+	CHECK(!read_stats(st));
+	CHECK(st[WFI].hits == 0 && st[WFI].misses == 0 &&
+	      st[WFI].shallow == 5);
+	CHECK(st[GATED].hits == 1 && st[GATED].misses == 0 &&
+	      st[GATED].shallow == 0);
+	CHECK(st[OFF].hits == 3 && st[OFF].misses == 1 &&
+	      st[OFF].shallow == 0);
+
+	printf("stats [PASS]\n");
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (shim_postcore_initcall() || !gov)
+		return 1;
+	if (shim_late_initcall() || !stats_fops)
+		return 1;
+
+	if (test_select() || test_stats())
+		return 1;
+	return 0;
+}
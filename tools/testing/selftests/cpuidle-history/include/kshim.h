@@ -0,0 +1,152 @@
+/*
+ * Just enough of the kernel environment to build
+ * drivers/cpuidle/governors/history.c in userspace for one CPU. The next
+ * timer event, the PM QoS latency, the cpuidle core and debugfs are
+ * implemented by history_test.c.
+ */
+#ifndef _CPUIDLE_HISTORY_TEST_KSHIM_H
+#define _CPUIDLE_HISTORY_TEST_KSHIM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+
+typedef int64_t s64;
+typedef unsigned long long u64;
+
+#define __init
+#define unlikely(x)	__builtin_expect(!!(x), 0)
+#define S_IRUGO		0444
+
+/* one CPU */
+#define NR_CPUS				1
+#define DEFINE_PER_CPU(type, name)	__typeof__(type) name[NR_CPUS]
+#define per_cpu(var, cpu)		((var)[cpu])
+#define __get_cpu_var(var)		((var)[0])
+#define for_each_online_cpu(cpu)	for ((cpu) = 0; (cpu) < NR_CPUS; (cpu)++)
+
+/* initcalls are called by the test */
+#define postcore_initcall(fn)	int (*shim_postcore_initcall)(void) = fn
+#define late_initcall(fn)	int (*shim_late_initcall)(void) = fn
+
+struct module;
+#define THIS_MODULE	((struct module *)NULL)
+
+/* time */
+typedef s64 ktime_t;
+
+static inline s64 ktime_to_us(ktime_t kt)
+{
+	return kt / 1000;
+}
+
+extern ktime_t tick_nohz_get_sleep_length(void);
+
+/* PM QoS */
+#define PM_QOS_CPU_DMA_LATENCY	1
+
+extern int pm_qos_request(int pm_qos_class);
+
+/* cpuidle */
+#define CPUIDLE_STATE_MAX		10
+#define CPUIDLE_NAME_LEN		16
+#define CPUIDLE_DESC_LEN		32
+#define CPUIDLE_DRIVER_STATE_START	0
+#define CPUIDLE_FLAG_TIME_VALID		(0x01)
+
+struct cpuidle_state_usage {
+	unsigned long long	disable;
+	unsigned long long	usage;
+	unsigned long long	time;
+};
+
+struct cpuidle_state {
+	char		name[CPUIDLE_NAME_LEN];
+	char		desc[CPUIDLE_DESC_LEN];
+
+	unsigned int	flags;
+	unsigned int	exit_latency;
+	int		power_usage;
+	unsigned int	target_residency;
+	bool		disabled;
+};
+
+struct cpuidle_device {
+	unsigned int		cpu;
+	int			last_residency;
+	struct cpuidle_state_usage	states_usage[CPUIDLE_STATE_MAX];
+};
+
+struct cpuidle_driver {
+	const char		*name;
+	struct cpuidle_state	states[CPUIDLE_STATE_MAX];
+	int			state_count;
+};
+
+struct cpuidle_governor {
+	char			name[CPUIDLE_NAME_LEN];
+	unsigned int		rating;
+
+	int  (*enable)		(struct cpuidle_driver *drv,
+					struct cpuidle_device *dev);
+	int  (*select)		(struct cpuidle_driver *drv,
+					struct cpuidle_device *dev);
+	void (*reflect)		(struct cpuidle_device *dev, int index);
+
+	struct module		*owner;
+};
+
+extern struct cpuidle_device *cpuidle_devices[NR_CPUS];
+
+static inline int cpuidle_get_last_residency(struct cpuidle_device *dev)
+{
+	return dev->last_residency;
+}
+
+extern struct cpuidle_driver *cpuidle_get_cpu_driver(
+		struct cpuidle_device *dev);
+extern int cpuidle_register_governor(struct cpuidle_governor *gov);
+
+/* seq_file and debugfs, a shown file is kept in a buffer */
+struct inode {
+	void *i_private;
+};
+
+struct file {
+	void *private_data;
+};
+
+struct seq_file {
+	char buf[4096];
+	size_t len;
+};
+
+struct file_operations {
+	int (*open)(struct inode *, struct file *);
+	int (*read)(void);
+	int (*llseek)(void);
+	int (*release)(void);
+};
+
+#define seq_read	NULL
+#define seq_lseek	NULL
+#define single_release	NULL
+
+extern int seq_printf(struct seq_file *m, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+#define seq_puts(m, s)	seq_printf(m, "%s", s)
+extern int single_open(struct file *file,
+		       int (*show)(struct seq_file *, void *), void *data);
+
+struct dentry;
+extern struct dentry *debugfs_create_dir(const char *name,
+					 struct dentry *parent);
+extern struct dentry *debugfs_create_file(const char *name, int mode,
+		struct dentry *parent, void *data,
+		const struct file_operations *fops);
+extern void debugfs_remove_recursive(struct dentry *dentry);
+
+#endif
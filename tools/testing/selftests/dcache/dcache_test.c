@@ -0,0 +1,235 @@
+/*
+ * dcache_test.c - negative dentry limit test and file-probe stress
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Usage:
+ *   dcache_test                        run the functional test (needs root)
+ *   dcache_test stress [THREADS] [SECONDS]
+ *       THREADS threads stat() names that don't exist in a scratch
+ *       directory in the current directory, the way linker search paths
+ *       and class loaders do, never repeating a name.  Reports the probe
+ *       rate and how /proc/sys/fs/dentry-state moved meanwhile.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define DENTRY_STATE	"/proc/sys/fs/dentry-state"
+#define NEGATIVE_LIMIT	"/proc/sys/fs/negative-dentry-limit"
+
+enum {
+	NR_DENTRY,
+	NR_UNUSED,
+	AGE_LIMIT,
+	WANT_PAGES,
+	NR_NEGATIVE,
+	NR_LRU_SCANNED,
+	NR_NEGATIVE_TRIMMED,
+	NR_STATS,
+};
+
+static const char * const stat_names[NR_STATS] = {
+	"nr_dentry", "nr_unused", "age_limit", "want_pages",
+	"nr_negative", "nr_lru_scanned", "nr_negative_trimmed",
+};
+
+static char dir[] = "dcache.XXXXXX";
+static volatile int stop;
+
+static int read_state(long *st)
+{
+	FILE *f = fopen(DENTRY_STATE, "r");
+	int i;
+
+	if (!f) {
+		perror(DENTRY_STATE);
+		return -1;
+	}
+	for (i = 0; i < NR_STATS; i++)
+		if (fscanf(f, "%ld", &st[i]) != 1)
+			break;
+	fclose(f);
+
+	return i == NR_STATS ? 0 : -1;
+}
+
+static long read_limit(void)
+{
+	FILE *f = fopen(NEGATIVE_LIMIT, "r");
+	long val = -1;
+
+	if (f) {
+		if (fscanf(f, "%ld", &val) != 1)
+			val = -1;
+		fclose(f);
+	}
+
+	return val;
+}
+
+static int write_limit(long val)
+{
+	FILE *f = fopen(NEGATIVE_LIMIT, "w");
+	int ret;
+
+	if (!f)
+		return -1;
+	ret = fprintf(f, "%ld\n", val) > 0 ? 0 : -1;
+	if (fclose(f))
+		ret = -1;
+
+	return ret;
+}
+
+struct prober {
+	pthread_t thr;
+	int id;
+	unsigned long probes;
+};
+
+static void *prober_fn(void *arg)
+{
+	struct prober *p = arg;
+	char path[64];
+	struct stat st;
+
+	while (!stop) {
+		snprintf(path, sizeof(path), "%s/p%d.%lu", dir, p->id,
+			 p->probes);
+		if (!stat(path, &st) || errno != ENOENT)
+			fprintf(stderr, "%s: unexpected lookup result\n", path);
+		p->probes++;
+	}
+
+	return NULL;
+}
+
+static int probe(int nr, int seconds, unsigned long *total)
+{
+	struct prober *p = calloc(nr, sizeof(*p));
+	int i;
+
+	if (!p)
+		return -1;
+
+	stop = 0;
+	for (i = 0; i < nr; i++) {
+		p[i].id = i;
+		if (pthread_create(&p[i].thr, NULL, prober_fn, &p[i])) {
+			perror("pthread_create");
+			return -1;
+		}
+	}
+	sleep(seconds);
+	stop = 1;
+
+	*total = 0;
+	for (i = 0; i < nr; i++) {
+		pthread_join(p[i].thr, NULL);
+		*total += p[i].probes;
+	}
+	free(p);
+
+	return 0;
+}
+
+/*
+ * Probing a stream of fresh names with a limit in place must not leave
+ * more unused negative dentries behind than the limit allows, give or
+ * take what the trim work hasn't caught up with yet.
+ */
+static int test_limit(void)
+{
+	long before[NR_STATS], after[NR_STATS];
+	long old_limit, limit = 1000;
+	unsigned long probes;
+	int ret = 1;
+
+	if (read_state(before)) {
+		fprintf(stderr, "limit: no negative dentry stats [SKIP]\n");
+		return 0;
+	}
+	old_limit = read_limit();
+	if (old_limit < 0 || write_limit(limit)) {
+		fprintf(stderr, "limit: can't set %s [SKIP]\n", NEGATIVE_LIMIT);
+		return 0;
+	}
+
+	if (probe(2, 2, &probes))
+		goto out;
+	/* give the trim work a moment to catch up */
+	sleep(1);
+	if (read_state(after))
+		goto out;
+
+	if (after[NR_NEGATIVE] - before[NR_NEGATIVE] > 2 * limit ||
+	    after[NR_NEGATIVE_TRIMMED] == before[NR_NEGATIVE_TRIMMED]) {
+		fprintf(stderr, "limit: %lu probes left %ld negative dentries, %ld trimmed\n",
+			probes, after[NR_NEGATIVE] - before[NR_NEGATIVE],
+			after[NR_NEGATIVE_TRIMMED] - before[NR_NEGATIVE_TRIMMED]);
+		goto out;
+	}
+	printf("limit: %lu probes, %ld trimmed [PASS]\n", probes,
+	       after[NR_NEGATIVE_TRIMMED] - before[NR_NEGATIVE_TRIMMED]);
+	ret = 0;
+out:
+	write_limit(old_limit);
+	return ret;
+}
+
+static int stress(int nr, int seconds)
+{
+	long before[NR_STATS], after[NR_STATS];
+	unsigned long probes;
+	int i;
+
+	if (read_state(before)) {
+		fprintf(stderr, "%s has no negative dentry stats\n",
+			DENTRY_STATE);
+		return 1;
+	}
+	if (probe(nr, seconds, &probes) || read_state(after))
+		return 1;
+
+	printf("%d threads, %ds, negative-dentry-limit %ld\n", nr, seconds,
+	       read_limit());
+	printf("probes: %12.0f/s\n", (double)probes / seconds);
+	for (i = 0; i < NR_STATS; i++) {
+		if (i == AGE_LIMIT || i == WANT_PAGES)
+			continue;
+		printf("%-20s %12ld (%+ld)\n", stat_names[i], after[i],
+		       after[i] - before[i]);
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+
+	if (!mkdtemp(dir)) {
+		perror("mkdtemp");
+		return 1;
+	}
+
+	if (argc > 1 && !strcmp(argv[1], "stress"))
+		ret = stress(argc > 2 ? atoi(argv[2]) : 4,
+			     argc > 3 ? atoi(argv[3]) : 10);
+	else
+		ret = test_limit();
+
+	rmdir(dir);
+	return ret;
+}
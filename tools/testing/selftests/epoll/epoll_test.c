@@ -0,0 +1,252 @@
+/*
+ * epoll_test.c - EPOLLEXCLUSIVE test and a many-producer epoll benchmark
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Usage:
+ *   epoll_test                              run the functional tests
+ *   epoll_test bench [PRODUCERS] [FDS] [SECONDS]
+ *       PRODUCERS threads, pinned round robin to the online CPUs, each
+ *       signal FDS eventfds of their own as fast as they can; one
+ *       consumer drains them with epoll_wait(). Reports the rate of
+ *       events and of epoll_wait() returns.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/time.h>
+
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE (1 << 28)
+#endif
+
+#define NR_WAITERS	4
+
+static int shared_fd;
+static volatile int woken;
+
+static void *waiter_fn(void *arg)
+{
+	int epfd = (long)arg;
+	struct epoll_event ev;
+
+	if (epoll_wait(epfd, &ev, 1, 1000) == 1)
+		__sync_fetch_and_add(&woken, 1);
+
+	return NULL;
+}
+
+/* Returns the number of waiters woken by a single event */
+static int count_wakeups(unsigned int flags)
+{
+	pthread_t thr[NR_WAITERS];
+	int epfd[NR_WAITERS];
+	struct epoll_event ev;
+	uint64_t val = 1;
+	int i;
+
+	shared_fd = eventfd(0, EFD_NONBLOCK);
+	woken = 0;
+
+	for (i = 0; i < NR_WAITERS; i++) {
+		epfd[i] = epoll_create1(0);
+		ev.events = EPOLLIN | EPOLLET | flags;
+		ev.data.fd = shared_fd;
+		if (epoll_ctl(epfd[i], EPOLL_CTL_ADD, shared_fd, &ev)) {
+			perror("epoll_ctl");
+			return -1;
+		}
+		pthread_create(&thr[i], NULL, waiter_fn, (void *)(long)epfd[i]);
+	}
+
+	/* Let every waiter block */
+	usleep(200000);
+	if (write(shared_fd, &val, sizeof(val)) != sizeof(val))
+		return -1;
+
+	for (i = 0; i < NR_WAITERS; i++) {
+		pthread_join(thr[i], NULL);
+		close(epfd[i]);
+	}
+	close(shared_fd);
+
+	return woken;
+}
+
+static int test_exclusive(void)
+{
+	struct epoll_event ev = { .events = EPOLLIN | EPOLLEXCLUSIVE };
+	int shared, exclusive, epfd, efd;
+
+	shared = count_wakeups(0);
+	exclusive = count_wakeups(EPOLLEXCLUSIVE);
+	if (shared != NR_WAITERS || exclusive != 1) {
+		fprintf(stderr, "exclusive: %d/%d waiters woken, expected %d/1\n",
+			shared, exclusive, NR_WAITERS);
+		return 1;
+	}
+
+	/* The flag can't be changed later on */
+	epfd = epoll_create1(0);
+	efd = eventfd(0, 0);
+	epoll_ctl(epfd, EPOLL_CTL_ADD, efd, &ev);
+	if (!epoll_ctl(epfd, EPOLL_CTL_MOD, efd, &ev) || errno != EINVAL) {
+		fprintf(stderr, "exclusive: EPOLL_CTL_MOD accepted\n");
+		return 1;
+	}
+	close(efd);
+	close(epfd);
+
+	printf("exclusive: one of %d waiters woken [PASS]\n", NR_WAITERS);
+	return 0;
+}
+
+static int test_ready_order(void)
+{
+	struct epoll_event ev[8];
+	uint64_t val = 1;
+	int epfd, efd[8], i, n;
+
+	/* Every signalled fd is reported exactly once */
+	epfd = epoll_create1(0);
+	for (i = 0; i < 8; i++) {
+		efd[i] = eventfd(0, EFD_NONBLOCK);
+		ev[0].events = EPOLLIN | EPOLLET;
+		ev[0].data.u32 = i;
+		epoll_ctl(epfd, EPOLL_CTL_ADD, efd[i], &ev[0]);
+	}
+	for (i = 0; i < 8; i++) {
+		if (write(efd[i], &val, sizeof(val)) != sizeof(val) ||
+		    write(efd[i], &val, sizeof(val)) != sizeof(val))
+			return 1;
+	}
+
+	n = epoll_wait(epfd, ev, 8, 0);
+	if (n != 8) {
+		fprintf(stderr, "ready: %d of 8 events\n", n);
+		return 1;
+	}
+	if (epoll_wait(epfd, ev, 8, 0) != 0) {
+		fprintf(stderr, "ready: duplicate edge triggered events\n");
+		return 1;
+	}
+
+	for (i = 0; i < 8; i++)
+		close(efd[i]);
+	close(epfd);
+
+	printf("ready: edge triggered events reported once [PASS]\n");
+	return 0;
+}
+
+static volatile int stop;
+
+struct producer {
+	pthread_t thr;
+	int cpu;
+	int nr_fds;
+	int *fds;
+	unsigned long writes;
+};
+
+static void *producer_fn(void *arg)
+{
+	struct producer *p = arg;
+	uint64_t val = 1;
+	cpu_set_t set;
+	int i;
+
+	CPU_ZERO(&set);
+	CPU_SET(p->cpu, &set);
+	sched_setaffinity(0, sizeof(set), &set);
+
+	while (!stop) {
+		for (i = 0; i < p->nr_fds; i++)
+			if (write(p->fds[i], &val, sizeof(val)) == sizeof(val))
+				p->writes++;
+	}
+
+	return NULL;
+}
+
+static int bench(int nr_producers, int nr_fds, int seconds)
+{
+	struct producer *prod = calloc(nr_producers, sizeof(*prod));
+	int ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	struct epoll_event ev[256];
+	unsigned long events = 0, waits = 0, writes = 0;
+	struct timeval start, now;
+	uint64_t val;
+	double t;
+	int epfd, i, j, n;
+
+	epfd = epoll_create1(0);
+	for (i = 0; i < nr_producers; i++) {
+		prod[i].cpu = i % ncpus;
+		prod[i].nr_fds = nr_fds;
+		prod[i].fds = calloc(nr_fds, sizeof(int));
+		for (j = 0; j < nr_fds; j++) {
+			struct epoll_event e = { .events = EPOLLIN | EPOLLET };
+
+			prod[i].fds[j] = eventfd(0, EFD_NONBLOCK);
+			e.data.fd = prod[i].fds[j];
+			if (epoll_ctl(epfd, EPOLL_CTL_ADD, prod[i].fds[j], &e)) {
+				perror("epoll_ctl");
+				return 1;
+			}
+		}
+	}
+
+	for (i = 0; i < nr_producers; i++)
+		pthread_create(&prod[i].thr, NULL, producer_fn, &prod[i]);
+
+	gettimeofday(&start, NULL);
+	do {
+		n = epoll_wait(epfd, ev, 256, 100);
+		waits++;
+		for (j = 0; j < n; j++) {
+			if (read(ev[j].data.fd, &val, sizeof(val)) > 0)
+				events++;
+		}
+		gettimeofday(&now, NULL);
+		t = (now.tv_sec - start.tv_sec) +
+		    (now.tv_usec - start.tv_usec) / 1e6;
+	} while (t < seconds);
+
+	stop = 1;
+	for (i = 0; i < nr_producers; i++) {
+		pthread_join(prod[i].thr, NULL);
+		writes += prod[i].writes;
+	}
+
+	printf("%d producers x %d fds, %d CPUs, %.1fs\n",
+	       nr_producers, nr_fds, ncpus, t);
+	printf("wakeup writes: %12.0f/s\n", writes / t);
+	printf("events:        %12.0f/s\n", events / t);
+	printf("epoll_wait():  %12.0f/s (%.1f events per call)\n",
+	       waits / t, waits ? (double)events / waits : 0.0);
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && !strcmp(argv[1], "bench"))
+		return bench(argc > 2 ? atoi(argv[2]) : 8,
+			     argc > 3 ? atoi(argv[3]) : 64,
+			     argc > 4 ? atoi(argv[4]) : 5);
+
+	return test_ready_order() || test_exclusive();
+}
@@ -0,0 +1,118 @@
+#!/bin/bash
+#
+# Check that data fsync()ed through an ext4 fast commit survives a crash.
+#
+# A scratch filesystem is built on a loop device behind a device-mapper
+# target. After the fsync() the target is switched to dm-flakey dropping all
+# writes, so that nothing but the fast commit reaches the device, and the
+# filesystem is then unmounted and mounted again: the data must be back and
+# the kernel must report that it replayed fast commits.
+#
+# The second case uses 2K blocks and 70 single block extents, which fill a
+# fast commit block exactly: head, inode and 70 add_range records.
+#
+# Needs root, losetup, mkfs.ext4 and dmsetup with the flakey target.
+
+DEV=fc-replay-$$
+MNT=$(mktemp -d)
+IMG=$MNT.img
+SIZE=$((64 * 1024 * 2))		# sectors
+loop=
+
+cleanup()
+{
+	mountpoint -q $MNT && umount $MNT
+	[ -e /dev/mapper/$DEV ] && dmsetup remove $DEV
+	[ -n "$loop" ] && losetup -d $loop
+	rm -f $IMG
+	rmdir $MNT
+}
+
+skip()
+{
+	echo "fc-replay: $1 [SKIP]"
+	cleanup
+	exit 0
+}
+
+fail()
+{
+	echo "fc-replay: $1 [FAIL]"
+	cleanup
+	exit 1
+}
+
+[ "$(id -u)" = 0 ] || skip "must be run as root"
+for cmd in losetup mkfs.ext4 dmsetup; do
+	which $cmd > /dev/null 2>&1 || skip "no $cmd"
+done
+modprobe dm-flakey 2>/dev/null
+dmsetup targets | grep -qw flakey || skip "no dm-flakey target"
+
+truncate -s $((SIZE * 512)) $IMG
+loop=$(losetup -f --show $IMG) || fail "losetup failed"
+
+# load TABLE into the device, creating it on first use
+table()
+{
+	if dmsetup info $DEV > /dev/null 2>&1; then
+		dmsetup suspend --nolockfs $DEV &&
+		dmsetup load $DEV --table "$1" &&
+		dmsetup resume $DEV
+	else
+		dmsetup create $DEV --table "$1"
+	fi
+}
+
+# mkfs with BLOCKSIZE, run WRITER on an empty synced file, crash and check
+replay()
+{
+	local name=$1 bsize=$2 writer=$3 sum
+
+	table "0 $SIZE linear $loop 0" || fail "$name: dmsetup failed"
+	mkfs.ext4 -q -F -b $bsize /dev/mapper/$DEV ||
+		fail "$name: mkfs.ext4 failed"
+	# no periodic full commit between the fsync and the crash
+	mount -o fast_commit,commit=600 /dev/mapper/$DEV $MNT ||
+		skip "no fast_commit mount option"
+
+	# creating the file would make the fast commit ineligible
+	touch $MNT/file && sync
+	$writer $MNT/file || fail "$name: write failed"
+	sum=$(md5sum < $MNT/file)
+
+	table "0 $SIZE flakey $loop 0 0 180 1 drop_writes" ||
+		fail "$name: dmsetup failed"
+	umount $MNT
+	table "0 $SIZE linear $loop 0" || fail "$name: dmsetup failed"
+
+	dmesg -c > /dev/null
+	mount /dev/mapper/$DEV $MNT || fail "$name: mount after crash failed"
+	dmesg | grep -q "replayed [1-9][0-9]* fast commits" ||
+		fail "$name: no fast commit replayed"
+	[ "$(md5sum < $MNT/file)" = "$sum" ] ||
+		fail "$name: data lost"
+	umount $MNT
+	echo "fc-replay: $name [PASS]"
+}
+
+append()
+{
+	dd if=/dev/urandom of=$1 bs=4k count=16 conv=notrunc,fsync 2>/dev/null
+}
+
+# blocks 0, 2, ..., 138: 70 extents, all logged by one fsync
+extents()
+{
+	local i
+
+	for i in $(seq 0 2 138); do
+		dd if=/dev/urandom of=$1 bs=2k count=1 seek=$i conv=notrunc \
+			2>/dev/null || return 1
+	done
+	dd if=/dev/null of=$1 conv=notrunc,fsync 2>/dev/null
+}
+
+replay append 4096 append
+replay full-block 2048 extents
+cleanup
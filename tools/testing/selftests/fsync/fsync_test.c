@@ -0,0 +1,220 @@
+/*
+ * fsync_test.c - fsync consistency test and fsync latency benchmark
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Usage:
+ *   fsync_test                         run the functional test
+ *   fsync_test bench [COUNT] [SIZE] [append|overwrite]
+ *       COUNT times, write SIZE bytes to a scratch file in the current
+ *       directory and fsync() it, appending (the default) or overwriting
+ *       the start of the file.  Reports fsync() latency percentiles and
+ *       how many bytes the device holding the file wrote meanwhile, as
+ *       read from /sys/dev/block/MAJ:MIN/stat.
+ *
+ * To compare ext4 full and fast commits, run the benchmark on a scratch
+ * filesystem mounted with and without the fast_commit option, e.g.
+ *   mkfs.ext4 -q /dev/loop0 && mount -o fast_commit /dev/loop0 /mnt
+ *   cd /mnt && fsync_test bench 2000 4096 append
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/time.h>
+
+#define SECTOR_SIZE	512
+
+static char path[] = "fsync.XXXXXX";
+
+static double now_us(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+static void fill(char *buf, size_t len, unsigned int seed)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (char)(seed * 31 + i);
+}
+
+/*
+ * Sectors written by the device holding @fd, or -1 if unknown.  The stat
+ * file of a partition sits under the whole disk's directory as well, so
+ * the MAJ:MIN link covers both.
+ */
+static long long sectors_written(int fd)
+{
+	char name[64];
+	unsigned long long st[7];
+	struct stat sb;
+	FILE *f;
+	int i;
+
+	if (fstat(fd, &sb))
+		return -1;
+	snprintf(name, sizeof(name), "/sys/dev/block/%u:%u/stat",
+		 major(sb.st_dev), minor(sb.st_dev));
+	f = fopen(name, "r");
+	if (!f)
+		return -1;
+	for (i = 0; i < 7; i++)
+		if (fscanf(f, "%llu", &st[i]) != 1)
+			break;
+	fclose(f);
+
+	/* fields: reads, merges, sectors, ticks, writes, merges, sectors */
+	return i == 7 ? (long long)st[6] : -1;
+}
+
+/*
+ * Appends and overwrites, each made durable with fsync() or fdatasync(),
+ * must read back as written, through a fresh descriptor and after the
+ * size-changing appends have been followed by overwrites of the tail.
+ */
+static int test_consistency(void)
+{
+	size_t chunk = 6000, nr = 64, i;
+	char *buf = malloc(chunk), *rd = malloc(chunk);
+	struct stat st;
+	int fd, ret = 1;
+
+	if (!buf || !rd)
+		return 1;
+	fd = mkstemp(path);
+	if (fd < 0) {
+		perror("mkstemp");
+		return 1;
+	}
+
+	for (i = 0; i < nr; i++) {
+		fill(buf, chunk, i);
+		if (write(fd, buf, chunk) != chunk ||
+		    (i & 1 ? fdatasync(fd) : fsync(fd))) {
+			perror("append");
+			goto out;
+		}
+	}
+	for (i = 0; i < nr; i += 3) {
+		fill(buf, chunk, nr + i);
+		if (pwrite(fd, buf, chunk, i * chunk) != chunk || fsync(fd)) {
+			perror("overwrite");
+			goto out;
+		}
+	}
+	close(fd);
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st)) {
+		perror(path);
+		goto out;
+	}
+	if (st.st_size != chunk * nr) {
+		fprintf(stderr, "consistency: size %lld, expected %zu\n",
+			(long long)st.st_size, chunk * nr);
+		goto out;
+	}
+	for (i = 0; i < nr; i++) {
+		fill(buf, chunk, i % 3 ? i : nr + i);
+		if (pread(fd, rd, chunk, i * chunk) != chunk ||
+		    memcmp(buf, rd, chunk)) {
+			fprintf(stderr, "consistency: chunk %zu differs\n", i);
+			goto out;
+		}
+	}
+	printf("consistency: %zu appends, %zu overwrites [PASS]\n", nr,
+	       (nr + 2) / 3);
+	ret = 0;
+out:
+	if (fd >= 0)
+		close(fd);
+	unlink(path);
+	free(buf);
+	free(rd);
+	return ret;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int bench(int count, size_t size, int overwrite)
+{
+	double *lat = calloc(count, sizeof(*lat));
+	char *buf = malloc(size);
+	long long before, after;
+	double start, total = 0;
+	int i, fd, ret = 1;
+
+	if (!lat || !buf || count < 1 || !size)
+		return 1;
+	fd = mkstemp(path);
+	if (fd < 0) {
+		perror("mkstemp");
+		return 1;
+	}
+	fill(buf, size, 0);
+
+	before = sectors_written(fd);
+	for (i = 0; i < count; i++) {
+		if ((overwrite ? pwrite(fd, buf, size, 0) :
+				 write(fd, buf, size)) != size) {
+			perror("write");
+			goto out;
+		}
+		start = now_us();
+		if (fsync(fd)) {
+			perror("fsync");
+			goto out;
+		}
+		lat[i] = now_us() - start;
+		total += lat[i];
+	}
+	after = sectors_written(fd);
+
+	qsort(lat, count, sizeof(*lat), cmp_double);
+	printf("%d %s fsyncs of %zu bytes\n", count,
+	       overwrite ? "overwrite" : "append", size);
+	printf("mean:  %10.1f us\n", total / count);
+	printf("p50:   %10.1f us\n", lat[count / 2]);
+	printf("p99:   %10.1f us\n", lat[count * 99 / 100]);
+	printf("max:   %10.1f us\n", lat[count - 1]);
+	if (before >= 0 && after >= 0)
+		printf("device writes: %.0f bytes/fsync, %.2fx the data\n",
+		       (double)(after - before) * SECTOR_SIZE / count,
+		       (double)(after - before) * SECTOR_SIZE / count / size);
+	ret = 0;
+out:
+	close(fd);
+	unlink(path);
+	free(buf);
+	free(lat);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && !strcmp(argv[1], "bench"))
+		return bench(argc > 2 ? atoi(argv[2]) : 1000,
+			     argc > 3 ? atoi(argv[3]) : 4096,
+			     argc > 4 && !strcmp(argv[4], "overwrite"));
+
+	return test_consistency();
+}
@@ -0,0 +1,282 @@
+/*
+ * compress_bench.c - hibernation image compression benchmark
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Builds lib/lzo and lib/lz4 against the shims in include/ and compresses
+ * an image the way kernel/power/swap.c does: in chunks of LZO_UNC_PAGES
+ * pages handed round robin to the compression threads.  Every chunk must
+ * decompress back to itself.  Reports compression and decompression
+ * throughput and the compressed size with LZO and LZ4, on one thread, on
+ * the 3 threads swap.c used to be limited to and on the
+ * num_online_cpus() - 1 threads (at most 8) it uses now, the best of
+ * three runs each.  Image I/O is not part of the measurement.
+ *
+ * Usage:
+ *   compress_bench [IMAGE]
+ *       Use the file IMAGE as the image, e.g. a dump of some memory.
+ *       Without IMAGE, a 256MB image is made up of zero pages (1/4),
+ *       random pages (1/4) and copies of this program's file (1/2).
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <linux/lzo.h>
+#include <linux/lz4.h>
+
+#define PAGE_SIZE	4096
+#define LZO_UNC_PAGES	32		/* as in swap.c */
+#define LZO_UNC_SIZE	(LZO_UNC_PAGES * PAGE_SIZE)
+#define LZO_CMP_SIZE	lzo1x_worst_compress(LZO_UNC_SIZE)
+#define LZO_THREADS	8		/* as in swap.c */
+#define SYNTH_PAGES	((256 << 20) / PAGE_SIZE)
+#define RUNS		3
+
+static unsigned char *image;
+static size_t image_size, nr_chunks;
+
+/* the compressed image: chunk i at cmp + i * LZO_CMP_SIZE */
+static unsigned char *cmp;
+static size_t *cmp_len;
+
+struct job {
+	pthread_t thread;
+	int lz4;
+	unsigned int thr, nr_threads;
+	int ret;
+};
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static size_t chunk_len(size_t i)
+{
+	size_t off = i * LZO_UNC_SIZE;
+
+	return image_size - off < LZO_UNC_SIZE ? image_size - off :
+						 LZO_UNC_SIZE;
+}
+
+static void *compress_thread(void *arg)
+{
+	struct job *job = arg;
+	void *wrk = malloc(LZO1X_1_MEM_COMPRESS > LZ4_MEM_COMPRESS ?
+			   LZO1X_1_MEM_COMPRESS : LZ4_MEM_COMPRESS);
+	size_t i;
+
+	for (i = job->thr; i < nr_chunks && !job->ret; i += job->nr_threads) {
+		cmp_len[i] = LZO_CMP_SIZE;
+		if (job->lz4)
+			job->ret = lz4_compress(image + i * LZO_UNC_SIZE,
+						chunk_len(i),
+						cmp + i * LZO_CMP_SIZE,
+						&cmp_len[i], wrk);
+		else
+			job->ret = lzo1x_1_compress(image + i * LZO_UNC_SIZE,
+						    chunk_len(i),
+						    cmp + i * LZO_CMP_SIZE,
+						    &cmp_len[i], wrk);
+	}
+	free(wrk);
+	return NULL;
+}
+
+static void *decompress_thread(void *arg)
+{
+	struct job *job = arg;
+	unsigned char *unc = malloc(LZO_UNC_SIZE);
+	size_t i, len;
+
+	for (i = job->thr; i < nr_chunks && !job->ret; i += job->nr_threads) {
+		len = LZO_UNC_SIZE;
+		if (job->lz4)
+			job->ret = lz4_decompress_unknownoutputsize(
+					cmp + i * LZO_CMP_SIZE, cmp_len[i],
+					unc, &len);
+		else
+			job->ret = lzo1x_decompress_safe(
+					cmp + i * LZO_CMP_SIZE, cmp_len[i],
+					unc, &len);
+		if (!job->ret && (len != chunk_len(i) ||
+		    memcmp(unc, image + i * LZO_UNC_SIZE, len)))
+			job->ret = -1;
+	}
+	free(unc);
+	return NULL;
+}
+
+static size_t compressed_size(void)
+{
+	size_t i, size = 0;
+
+	for (i = 0; i < nr_chunks; i++)
+		size += cmp_len[i];
+	return size;
+}
+
+/* run @fn on @nr_threads threads, return the seconds taken or -1 */
+static double run_once(void *(*fn)(void *), int lz4, unsigned int nr_threads)
+{
+	struct job jobs[LZO_THREADS];
+	double start = now();
+	unsigned int thr;
+	int ret = 0;
+
+	for (thr = 0; thr < nr_threads; thr++) {
+		jobs[thr].lz4 = lz4;
+		jobs[thr].thr = thr;
+		jobs[thr].nr_threads = nr_threads;
+		jobs[thr].ret = 0;
+		if (pthread_create(&jobs[thr].thread, NULL, fn, &jobs[thr]))
+			return -1;
+	}
+	for (thr = 0; thr < nr_threads; thr++) {
+		pthread_join(jobs[thr].thread, NULL);
+		ret |= jobs[thr].ret;
+	}
+	return ret ? -1 : now() - start;
+}
+
+/* the best of RUNS runs */
+static double run(void *(*fn)(void *), int lz4, unsigned int nr_threads)
+{
+	double t, best = -1;
+	int i;
+
+	for (i = 0; i < RUNS; i++) {
+		t = run_once(fn, lz4, nr_threads);
+		if (t < 0)
+			return -1;
+		if (best < 0 || t < best)
+			best = t;
+	}
+	return best;
+}
+
+static int load_image(const char *path)
+{
+	struct stat st;
+	ssize_t n;
+	size_t off;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) || !st.st_size)
+		return -1;
+	image_size = st.st_size;
+	image = malloc(image_size);
+	for (off = 0; image && off < image_size; off += n) {
+		n = read(fd, image + off, image_size - off);
+		if (n <= 0)
+			return -1;
+	}
+	close(fd);
+	return image ? 0 : -1;
+}
+
+static int make_image(void)
+{
+	unsigned char *exe = NULL;
+	size_t exe_size = 0, i, j;
+	ssize_t n;
+	int fd;
+
+	fd = open("/proc/self/exe", O_RDONLY);
+	exe = malloc(1 << 20);
+	if (fd < 0 || !exe)
+		return -1;
+	while ((n = read(fd, exe + exe_size, (1 << 20) - exe_size)) > 0)
+		exe_size += n;
+	close(fd);
+	if (exe_size < PAGE_SIZE)
+		return -1;
+
+	image_size = (size_t)SYNTH_PAGES * PAGE_SIZE;
+	image = calloc(SYNTH_PAGES, PAGE_SIZE);
+	if (!image)
+		return -1;
+	srandom(1);
+	for (i = 0; i < SYNTH_PAGES; i++) {
+		unsigned char *page = image + i * PAGE_SIZE;
+
+		switch (random() % 4) {
+		case 0:
+			break;
+		case 1:
+			for (j = 0; j < PAGE_SIZE; j++)
+				page[j] = random();
+			break;
+		default:
+			j = random() % (exe_size / PAGE_SIZE);
+			memcpy(page, exe + j * PAGE_SIZE, PAGE_SIZE);
+		}
+	}
+	free(exe);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	static const char * const names[] = { "lzo", "lz4" };
+	unsigned int threads[3], nr_runs, cpus, i;
+	double comp, decomp, mb;
+	int lz4;
+
+	if (argc > 1 ? load_image(argv[1]) : make_image()) {
+		fprintf(stderr, "compress_bench: no image\n");
+		return 1;
+	}
+	nr_chunks = (image_size + LZO_UNC_SIZE - 1) / LZO_UNC_SIZE;
+	cmp = malloc(nr_chunks * LZO_CMP_SIZE);
+	cmp_len = malloc(nr_chunks * sizeof(*cmp_len));
+	if (!cmp || !cmp_len)
+		return 1;
+	/* fault the buffer in ahead of the first run */
+	memset(cmp, 0, nr_chunks * LZO_CMP_SIZE);
+
+	/* as swap.c: one thread per CPU but one, at most LZO_THREADS */
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	nr_runs = 0;
+	threads[nr_runs++] = 1;
+	threads[nr_runs++] = 3;
+	if (cpus > 4)
+		threads[nr_runs++] = cpus - 1 < LZO_THREADS ? cpus - 1 :
+							      LZO_THREADS;
+
+	mb = image_size / 1048576.0;
+	printf("image %.0fMB, %u CPUs\n", mb, cpus);
+	printf("%-4s %7s %10s %12s %6s\n", "", "threads", "comp_MB/s",
+	       "decomp_MB/s", "ratio");
+	for (lz4 = 0; lz4 < 2; lz4++) {
+		for (i = 0; i < nr_runs; i++) {
+			comp = run(compress_thread, lz4, threads[i]);
+			decomp = run(decompress_thread, lz4, threads[i]);
+			if (comp < 0 || decomp < 0) {
+				printf("%s: chunks don't decompress back "
+				       "[FAIL]\n", names[lz4]);
+				return 1;
+			}
+			printf("%-4s %7u %10.0f %12.0f %6.3f\n", names[lz4],
+			       threads[i], mb / comp, mb / decomp,
+			       compressed_size() / (double)image_size);
+		}
+	}
+	printf("compress_bench: [PASS]\n");
+	return 0;
+}
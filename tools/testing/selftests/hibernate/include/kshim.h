@@ -0,0 +1,62 @@
+/*
+ * Just enough of the kernel environment to build the LZO and LZ4
+ * compressors of lib/lzo and lib/lz4 in userspace.
+ */
+#ifndef _HIBERNATE_BENCH_KSHIM_H
+#define _HIBERNATE_BENCH_KSHIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* the libc headers define both, the compressors want the one that holds */
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#undef __BIG_ENDIAN
+#else
+#undef __LITTLE_ENDIAN
+#endif
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+#define likely(x)		__builtin_expect(!!(x), 1)
+#define unlikely(x)		__builtin_expect(!!(x), 0)
+#define noinline		__attribute__((noinline))
+#define EXPORT_SYMBOL(sym)
+#define EXPORT_SYMBOL_GPL(sym)
+#define MODULE_LICENSE(s)
+#define MODULE_DESCRIPTION(s)
+
+#define BUILD_BUG_ON(c)		((void)sizeof(char[1 - 2 * !!(c)]))
+
+#define get_unaligned(p)						\
+({									\
+	const struct { __typeof__(*(p)) v; } __attribute__((packed))	\
+		*__p = (const void *)(p);				\
+	__p->v;								\
+})
+
+#define put_unaligned(val, p)						\
+do {									\
+	struct { __typeof__(*(p)) v; } __attribute__((packed))		\
+		*__p = (void *)(p);					\
+	__p->v = (val);							\
+} while (0)
+
+static inline u16 get_unaligned_le16(const void *p)
+{
+	const u8 *b = p;
+
+	return b[0] | b[1] << 8;
+}
+
+static inline u32 get_unaligned_le32(const void *p)
+{
+	const u8 *b = p;
+
+	return b[0] | b[1] << 8 | b[2] << 16 | (u32)b[3] << 24;
+}
+
+#endif
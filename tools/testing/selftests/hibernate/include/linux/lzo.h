@@ -0,0 +1 @@
+#include "../../../../../../include/linux/lzo.h"
@@ -0,0 +1,469 @@
+/*
+ * ioring_test.c - functional tests and a read benchmark for /dev/ioring
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Usage:
+ *   ioring_test                         run the functional tests
+ *   ioring_test bench FILE [BS] [QD]    read FILE with pread() and with the
+ *                                       ring (BS bytes per request, QD
+ *                                       requests in flight) and compare
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include <linux/ioring.h>
+
+#define barrier()	__asm__ __volatile__("" : : : "memory")
+#define read_barrier()	__sync_synchronize()
+#define write_barrier()	__sync_synchronize()
+
+struct ring {
+	int fd;
+	unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+	unsigned *cq_head, *cq_tail, *cq_mask;
+	struct ioring_sqe *sqes;
+	struct ioring_cqe *cqes;
+	unsigned sq_entries;
+	unsigned long syscalls;
+};
+
+static int ring_init(struct ring *r, unsigned entries)
+{
+	struct ioring_params p;
+	void *sq, *cq;
+
+	memset(r, 0, sizeof(*r));
+	memset(&p, 0, sizeof(p));
+	p.sq_entries = entries;
+
+	r->fd = open("/dev/ioring", O_RDWR);
+	if (r->fd < 0) {
+		perror("open /dev/ioring");
+		return -1;
+	}
+	if (ioctl(r->fd, IORING_SETUP, &p) < 0) {
+		perror("IORING_SETUP");
+		return -1;
+	}
+
+	sq = mmap(NULL, p.sq_off.array + p.sq_entries * sizeof(unsigned),
+		  PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, IORING_OFF_SQ_RING);
+	r->sqes = mmap(NULL, p.sq_entries * sizeof(struct ioring_sqe),
+		       PROT_READ | PROT_WRITE, MAP_SHARED, r->fd,
+		       IORING_OFF_SQES);
+	cq = mmap(NULL, p.cq_off.cqes + p.cq_entries * sizeof(struct ioring_cqe),
+		  PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, IORING_OFF_CQ_RING);
+	if (sq == MAP_FAILED || r->sqes == MAP_FAILED || cq == MAP_FAILED) {
+		perror("mmap");
+		return -1;
+	}
+
+	r->sq_head = sq + p.sq_off.head;
+	r->sq_tail = sq + p.sq_off.tail;
+	r->sq_mask = sq + p.sq_off.ring_mask;
+	r->sq_array = sq + p.sq_off.array;
+	r->cq_head = cq + p.cq_off.head;
+	r->cq_tail = cq + p.cq_off.tail;
+	r->cq_mask = cq + p.cq_off.ring_mask;
+	r->cqes = cq + p.cq_off.cqes;
+	r->sq_entries = p.sq_entries;
+
+	return 0;
+}
+
+/* Queue one entry; the kernel sees it at the next ring_enter() */
+static struct ioring_sqe *ring_get_sqe(struct ring *r)
+{
+	unsigned tail = *r->sq_tail;
+	unsigned idx;
+
+	read_barrier();
+	if (tail - *r->sq_head == r->sq_entries)
+		return NULL;
+
+	idx = tail & *r->sq_mask;
+	r->sq_array[idx] = idx;
+	memset(&r->sqes[idx], 0, sizeof(r->sqes[idx]));
+	return &r->sqes[idx];
+}
+
+static void ring_queue_sqe(struct ring *r)
+{
+	write_barrier();
+	*r->sq_tail = *r->sq_tail + 1;
+}
+
+static int ring_enter(struct ring *r, unsigned to_submit, unsigned min_complete)
+{
+	struct ioring_enter e = {
+		.to_submit = to_submit,
+		.min_complete = min_complete,
+	};
+
+	r->syscalls++;
+	return ioctl(r->fd, IORING_ENTER, &e);
+}
+
+static int ring_reap(struct ring *r, struct ioring_cqe *cqe)
+{
+	unsigned head = *r->cq_head;
+
+	read_barrier();
+	if (head == *r->cq_tail)
+		return 0;
+
+	*cqe = r->cqes[head & *r->cq_mask];
+	barrier();
+	*r->cq_head = head + 1;
+	return 1;
+}
+
+static int test_nop(void)
+{
+	struct ring r;
+	struct ioring_cqe cqe;
+	unsigned i, seen = 0;
+
+	if (ring_init(&r, 32))
+		return 1;
+
+	for (i = 0; i < 32; i++) {
+		struct ioring_sqe *sqe = ring_get_sqe(&r);
+
+		sqe->opcode = IORING_OP_NOP;
+		sqe->user_data = i;
+		ring_queue_sqe(&r);
+	}
+
+	if (ring_enter(&r, 32, 32) != 32) {
+		perror("nop: IORING_ENTER");
+		return 1;
+	}
+
+	while (ring_reap(&r, &cqe)) {
+		if (cqe.res || cqe.user_data != seen) {
+			fprintf(stderr, "nop: bad completion %llu/%d\n",
+				(unsigned long long)cqe.user_data, cqe.res);
+			return 1;
+		}
+		seen++;
+	}
+	close(r.fd);
+
+	if (seen != 32) {
+		fprintf(stderr, "nop: %u of 32 completions\n", seen);
+		return 1;
+	}
+	printf("nop: 32 requests with one call [PASS]\n");
+	return 0;
+}
+
+static int test_rw(void)
+{
+	char path[] = "/tmp/ioring_test.XXXXXX";
+	static char wbuf[4][4096], rbuf[4][4096];
+	struct ioring_sqe *sqe;
+	struct ioring_cqe cqe;
+	struct ring r;
+	int fd, i, n;
+
+	fd = mkstemp(path);
+	if (fd < 0) {
+		perror("mkstemp");
+		return 1;
+	}
+	unlink(path);
+
+	if (ring_init(&r, 8))
+		return 1;
+
+	for (i = 0; i < 4; i++) {
+		memset(wbuf[i], 'a' + i, sizeof(wbuf[i]));
+		sqe = ring_get_sqe(&r);
+		sqe->opcode = IORING_OP_WRITE;
+		sqe->fd = fd;
+		sqe->off = i * 4096;
+		sqe->addr = (unsigned long)wbuf[i];
+		sqe->len = 4096;
+		sqe->user_data = i;
+		ring_queue_sqe(&r);
+	}
+	sqe = ring_get_sqe(&r);
+	sqe->opcode = IORING_OP_FSYNC;
+	sqe->fd = fd;
+	sqe->user_data = 100;
+	ring_queue_sqe(&r);
+
+	/* The fsync is unordered against the writes, wait for all five */
+	ring_enter(&r, 5, 5);
+	for (n = 0; ring_reap(&r, &cqe); n++) {
+		if (cqe.res != (cqe.user_data == 100 ? 0 : 4096)) {
+			fprintf(stderr, "rw: write %llu returned %d\n",
+				(unsigned long long)cqe.user_data, cqe.res);
+			return 1;
+		}
+	}
+
+	for (i = 0; i < 4; i++) {
+		sqe = ring_get_sqe(&r);
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = fd;
+		sqe->off = i * 4096;
+		sqe->addr = (unsigned long)rbuf[i];
+		sqe->len = 4096;
+		sqe->user_data = i;
+		ring_queue_sqe(&r);
+	}
+	ring_enter(&r, 4, 4);
+	for (; ring_reap(&r, &cqe); n++) {
+		if (cqe.res != 4096) {
+			fprintf(stderr, "rw: read returned %d\n", cqe.res);
+			return 1;
+		}
+	}
+	close(r.fd);
+	close(fd);
+
+	if (n != 9 || memcmp(wbuf, rbuf, sizeof(wbuf))) {
+		fprintf(stderr, "rw: data mismatch or lost completions\n");
+		return 1;
+	}
+	printf("rw: buffered write, fsync and read back [PASS]\n");
+	return 0;
+}
+
+/*
+ * Writes run in a kernel worker, the submitter's RLIMIT_FSIZE must still
+ * apply: a write across the limit is cut short and one past it fails.
+ */
+static int test_fsize(void)
+{
+	char path[] = "/tmp/ioring_test.XXXXXX";
+	static char buf[8192];
+	struct ioring_sqe *sqe;
+	struct ioring_cqe cqe;
+	struct rlimit old, lim;
+	struct ring r;
+	int fd, i, res[2] = { 0, 0 };
+
+	fd = mkstemp(path);
+	if (fd < 0) {
+		perror("mkstemp");
+		return 1;
+	}
+	unlink(path);
+
+	if (ring_init(&r, 8))
+		return 1;
+
+	signal(SIGXFSZ, SIG_IGN);
+	getrlimit(RLIMIT_FSIZE, &old);
+	lim = old;
+	lim.rlim_cur = 4096;
+	if (setrlimit(RLIMIT_FSIZE, &lim)) {
+		perror("setrlimit");
+		return 1;
+	}
+
+	for (i = 0; i < 2; i++) {
+		sqe = ring_get_sqe(&r);
+		sqe->opcode = IORING_OP_WRITE;
+		sqe->fd = fd;
+		sqe->off = i * 4096;
+		sqe->addr = (unsigned long)buf;
+		sqe->len = sizeof(buf);
+		sqe->user_data = i;
+		ring_queue_sqe(&r);
+	}
+	ring_enter(&r, 2, 2);
+	setrlimit(RLIMIT_FSIZE, &old);
+
+	while (ring_reap(&r, &cqe))
+		if (cqe.user_data < 2)
+			res[cqe.user_data] = cqe.res;
+	close(r.fd);
+	close(fd);
+
+	if (res[0] != 4096 || res[1] != -EFBIG) {
+		fprintf(stderr, "fsize: writes returned %d and %d\n",
+			res[0], res[1]);
+		return 1;
+	}
+	printf("fsize: RLIMIT_FSIZE of the submitter applies [PASS]\n");
+	return 0;
+}
+
+static int test_poll(void)
+{
+	struct ioring_sqe *sqe;
+	struct ioring_cqe cqe;
+	struct pollfd pfd;
+	struct ring r;
+	int pipefd[2];
+
+	if (pipe(pipefd) || ring_init(&r, 4))
+		return 1;
+
+	sqe = ring_get_sqe(&r);
+	sqe->opcode = IORING_OP_POLL;
+	sqe->fd = pipefd[0];
+	sqe->poll_events = POLLIN;
+	sqe->user_data = 7;
+	ring_queue_sqe(&r);
+	ring_enter(&r, 1, 0);
+
+	/* Nothing to read yet, the request must stay pending */
+	usleep(100000);
+	if (ring_reap(&r, &cqe)) {
+		fprintf(stderr, "poll: completed early with %d\n", cqe.res);
+		return 1;
+	}
+
+	if (write(pipefd[1], "x", 1) != 1)
+		return 1;
+
+	/* The ring itself is pollable for completions */
+	pfd.fd = r.fd;
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, 5000) != 1) {
+		fprintf(stderr, "poll: no completion\n");
+		return 1;
+	}
+	if (!ring_reap(&r, &cqe) || cqe.user_data != 7 ||
+	    !(cqe.res & POLLIN)) {
+		fprintf(stderr, "poll: bad completion\n");
+		return 1;
+	}
+
+	/* A pending poll must be cancelled when the ring goes away */
+	sqe = ring_get_sqe(&r);
+	sqe->opcode = IORING_OP_POLL;
+	sqe->fd = pipefd[1];
+	sqe->poll_events = POLLPRI;
+	ring_queue_sqe(&r);
+	ring_enter(&r, 1, 0);
+	close(r.fd);
+
+	printf("poll: wakeup driven completion [PASS]\n");
+	return 0;
+}
+
+static double now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static int bench(const char *path, size_t bs, unsigned qd)
+{
+	struct ioring_cqe cqe;
+	struct ring r;
+	struct stat st;
+	off_t off, size;
+	unsigned long reqs = 0;
+	unsigned inflight = 0, i;
+	double t, t_pread, t_ring;
+	char *buf;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st)) {
+		perror(path);
+		return 1;
+	}
+	size = st.st_size;
+	buf = malloc(bs * qd);
+	if (!buf || ring_init(&r, qd))
+		return 1;
+
+	/* Both passes read from the page cache, warm it up first */
+	for (off = 0; off < size; off += bs)
+		pread(fd, buf, bs, off);
+
+	t = now();
+	for (off = 0; off < size; off += bs, reqs++)
+		if (pread(fd, buf, bs, off) < 0)
+			return 1;
+	t_pread = now() - t;
+
+	t = now();
+	off = 0;
+	while (off < size || inflight) {
+		unsigned queued = 0;
+
+		for (i = 0; off < size && inflight + queued < qd; i++) {
+			struct ioring_sqe *sqe = ring_get_sqe(&r);
+
+			if (!sqe)
+				break;
+			sqe->opcode = IORING_OP_READ;
+			sqe->fd = fd;
+			sqe->off = off;
+			sqe->addr = (unsigned long)(buf + (off / bs % qd) * bs);
+			sqe->len = bs;
+			ring_queue_sqe(&r);
+			off += bs;
+			queued++;
+		}
+
+		if (ring_enter(&r, queued, 1) < 0) {
+			perror("IORING_ENTER");
+			return 1;
+		}
+		inflight += queued;
+
+		while (ring_reap(&r, &cqe)) {
+			if (cqe.res < 0) {
+				fprintf(stderr, "read failed: %d\n", cqe.res);
+				return 1;
+			}
+			inflight--;
+		}
+	}
+	t_ring = now() - t;
+
+	printf("%lu reads of %zu bytes\n", reqs, bs);
+	printf("pread:  %8.1f MB/s, %lu syscalls\n",
+	       size / t_pread / 1e6, reqs);
+	printf("ioring: %8.1f MB/s, %lu syscalls (queue depth %u)\n",
+	       size / t_ring / 1e6, r.syscalls, qd);
+
+	close(r.fd);
+	close(fd);
+	free(buf);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 2 && !strcmp(argv[1], "bench"))
+		return bench(argv[2], argc > 3 ? strtoul(argv[3], NULL, 0) : 4096,
+			     argc > 4 ? strtoul(argv[4], NULL, 0) : 32);
+
+	if (access("/dev/ioring", F_OK)) {
+		printf("/dev/ioring not present, skipping\n");
+		return 0;
+	}
+
+	return test_nop() || test_rw() || test_fsize() || test_poll();
+}
@@ -0,0 +1,202 @@
+/*
+ * Just enough of the kernel environment to build mc/isomgr.c in userspace.
+ * The clocks, the workqueue and the wait queues are implemented by
+ * isomgr_test.c.
+ */
+#ifndef _ISOMGR_TEST_KSHIM_H
+#define _ISOMGR_TEST_KSHIM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+
+#define CONFIG_TEGRA_ISOMGR
+#define CONFIG_TEGRA_ISOMGR_POOL_KB_PER_SEC	6000000
+
+typedef int32_t s32;
+typedef uint32_t u32;
+typedef int64_t s64;
+typedef uint64_t u64;
+
+#define __init
+#define unlikely(x)	__builtin_expect(!!(x), 0)
+#define ACCESS_ONCE(x)	(*(volatile __typeof__(x) *)&(x))
+#define ARRAY_SIZE(a)	(sizeof(a) / sizeof((a)[0]))
+#define max(a, b)	((a) > (b) ? (a) : (b))
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+#define BUG()		abort()
+#define BUG_ON(c)	do { if (c) abort(); } while (0)
+#define WARN(c, ...)	(!!(c))
+#define BUILD_BUG_ON(c)
+
+#define pr_err(...)	fprintf(stderr, __VA_ARGS__)
+#define pr_info(...)	do { } while (0)
+
+#define EXPORT_SYMBOL(sym)
+
+#define ERR_PTR(err)		((void *)(long)(err))
+#define IS_ERR_OR_NULL(p)	(!(p) || (unsigned long)(p) >= (unsigned long)-4095)
+
+/* tasks */
+struct task_struct {
+	char comm[16];
+};
+extern __thread struct task_struct shim_current;
+#define current (&shim_current)
+
+/* atomics and kref */
+typedef struct {
+	int counter;
+} atomic_t;
+
+static inline int atomic_read(atomic_t *v)
+{
+	return __atomic_load_n(&v->counter, __ATOMIC_SEQ_CST);
+}
+
+static inline void atomic_set(atomic_t *v, int i)
+{
+	__atomic_store_n(&v->counter, i, __ATOMIC_SEQ_CST);
+}
+
+static inline int atomic_inc_not_zero(atomic_t *v)
+{
+	int c = atomic_read(v);
+
+	while (c && !__atomic_compare_exchange_n(&v->counter, &c, c + 1,
+			false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+		;
+	return c != 0;
+}
+
+struct kref {
+	atomic_t refcount;
+};
+
+static inline void kref_init(struct kref *kref)
+{
+	atomic_set(&kref->refcount, 1);
+}
+
+static inline int kref_put(struct kref *kref, void (*release)(struct kref *))
+{
+	if (__atomic_sub_fetch(&kref->refcount.counter, 1,
+			       __ATOMIC_SEQ_CST) == 0) {
+		release(kref);
+		return 1;
+	}
+	return 0;
+}
+
+/* locking */
+struct mutex {
+	pthread_mutex_t m;
+};
+
+#define mutex_init(l)		pthread_mutex_init(&(l)->m, NULL)
+#define mutex_lock(l)		pthread_mutex_lock(&(l)->m)
+#define mutex_unlock(l)		pthread_mutex_unlock(&(l)->m)
+#define mutex_trylock(l)	(pthread_mutex_trylock(&(l)->m) == 0)
+
+struct completion {
+	int done;
+};
+#define init_completion(x)	((x)->done = 0)
+
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+} wait_queue_head_t;
+
+void init_waitqueue_head(wait_queue_head_t *q);
+void wake_up_all(wait_queue_head_t *q);
+
+#define wait_event(wq, condition)					\
+do {									\
+	pthread_mutex_lock(&(wq).lock);					\
+	while (!(condition))						\
+		pthread_cond_wait(&(wq).cond, &(wq).lock);		\
+	pthread_mutex_unlock(&(wq).lock);				\
+} while (0)
+
+/* one worker thread runs all the work */
+struct work_struct;
+typedef void (*work_func_t)(struct work_struct *);
+struct work_struct {
+	work_func_t func;
+	bool pending;
+};
+
+#define INIT_WORK(w, f)	((w)->func = (f), (w)->pending = false)
+bool schedule_work(struct work_struct *work);
+
+/* time */
+typedef s64 ktime_t;
+ktime_t ktime_get(void);
+#define ktime_us_delta(a, b)	(((a) - (b)) / 1000)
+
+/* clocks */
+struct clk;
+struct clk *clk_get_sys(const char *dev_id, const char *con_id);
+struct clk *clk_get_parent(struct clk *clk);
+long clk_round_rate(struct clk *clk, unsigned long rate);
+int clk_set_rate(struct clk *clk, unsigned long rate);
+int clk_enable(struct clk *clk);
+void clk_disable(struct clk *clk);
+
+/* chip and EMC */
+enum tegra_chipid {
+	TEGRA_CHIPID_UNKNOWN,
+	TEGRA_CHIPID_TEGRA11,
+	TEGRA_CHIPID_TEGRA14,
+	TEGRA_CHIPID_TEGRA12,
+	TEGRA_CHIPID_TEGRA13,
+	TEGRA_CHIPID_TEGRA21,
+};
+#define tegra_get_chipid()	TEGRA_CHIPID_TEGRA21
+
+unsigned long tegra_emc_bw_to_freq_req(unsigned long bw);
+unsigned long tegra_emc_freq_req_to_bw(unsigned long freq);
+u32 tegra_emc_dvfs_latency(u32 freq);
+
+/* tracepoints */
+static inline void shim_trace(const char *event, ...)
+{
+}
+
+#define trace_tegra_isomgr_register(...) \
+	shim_trace("trace_tegra_isomgr_register", __VA_ARGS__)
+#define trace_tegra_isomgr_unregister(...) \
+	shim_trace("trace_tegra_isomgr_unregister", __VA_ARGS__)
+#define trace_tegra_isomgr_unregister_iso_client(...) \
+	shim_trace("trace_tegra_isomgr_unregister_iso_client", __VA_ARGS__)
+#define trace_tegra_isomgr_reserve(...) \
+	shim_trace("trace_tegra_isomgr_reserve", __VA_ARGS__)
+#define trace_tegra_isomgr_realize(...) \
+	shim_trace("trace_tegra_isomgr_realize", __VA_ARGS__)
+#define trace_tegra_isomgr_set_margin(...) \
+	shim_trace("trace_tegra_isomgr_set_margin", __VA_ARGS__)
+#define trace_tegra_isomgr_get_imp_time(...) \
+	shim_trace("trace_tegra_isomgr_get_imp_time", __VA_ARGS__)
+#define trace_tegra_isomgr_get_available_iso_bw(...) \
+	shim_trace("trace_tegra_isomgr_get_available_iso_bw", __VA_ARGS__)
+#define trace_tegra_isomgr_get_total_iso_bw(...) \
+	shim_trace("trace_tegra_isomgr_get_total_iso_bw", __VA_ARGS__)
+#define trace_tegra_isomgr_scavenge(...) \
+	shim_trace("trace_tegra_isomgr_scavenge", __VA_ARGS__)
+#define trace_tegra_isomgr_scatter(...) \
+	shim_trace("trace_tegra_isomgr_scatter", __VA_ARGS__)
+#define trace_tegra_isomgr_latency(...) \
+	shim_trace("trace_tegra_isomgr_latency", __VA_ARGS__)
+#define trace_tegra_isomgr_clk_apply(...) \
+	shim_trace("trace_tegra_isomgr_clk_apply", __VA_ARGS__)
+
+#endif
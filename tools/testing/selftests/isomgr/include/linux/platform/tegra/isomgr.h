@@ -0,0 +1 @@
+#include "../../../../../../../../include/linux/platform/tegra/isomgr.h"
@@ -0,0 +1,370 @@
+/*
+ * isomgr_test.c - ISO bandwidth manager test and benchmark
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Builds drivers/platform/tegra/mc/isomgr.c against the shims in include/,
+ * with EMC clocks whose rate changes take SWITCH_US to complete.
+ *
+ * Usage:
+ *   isomgr_test [ITERATIONS [SWITCH_US]]
+ *       Check the bandwidth accounting and that realize returns with a
+ *       raised floor in effect, then have a display client raise and
+ *       lower its bandwidth ITERATIONS times (default 100) while a camera
+ *       client does the same, and report how long reserve and realize
+ *       took and how many clock switches the floor updates cost.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <kshim.h>
+#include <linux/platform/tegra/isomgr.h>
+
+#define BW_TO_FREQ	16	/* KB/sec per KHz of EMC freq */
+
+__thread struct task_struct shim_current = { .comm = "isomgr_test" };
+
+static unsigned long iterations = 100, switch_us = 2000;
+
+/* clocks */
+struct clk {
+	char name[64];
+	unsigned long rate;
+	int enabled;
+};
+
+static struct clk clks[TEGRA_ISO_CLIENT_COUNT + 2];
+static int nr_clks;
+static unsigned long nr_switches;
+static pthread_mutex_t clk_lock = PTHREAD_MUTEX_INITIALIZER;
+
+struct clk *clk_get_sys(const char *dev_id, const char *con_id)
+{
+	char name[64];
+	int i;
+
+	snprintf(name, sizeof(name), "%s.%s", dev_id, con_id);
+	for (i = 0; i < nr_clks; i++)
+		if (!strcmp(clks[i].name, name))
+			return &clks[i];
+	strcpy(clks[nr_clks].name, name);
+	return &clks[nr_clks++];
+}
+
+struct clk *clk_get_parent(struct clk *clk)
+{
+	return clk;
+}
+
+long clk_round_rate(struct clk *clk, unsigned long rate)
+{
+	return rate;
+}
+
+int clk_set_rate(struct clk *clk, unsigned long rate)
+{
+	usleep(switch_us);
+	pthread_mutex_lock(&clk_lock);
+	clk->rate = rate;
+	nr_switches++;
+	pthread_mutex_unlock(&clk_lock);
+	return 0;
+}
+
+int clk_enable(struct clk *clk)
+{
+	clk->enabled++;
+	return 0;
+}
+
+void clk_disable(struct clk *clk)
+{
+	clk->enabled--;
+}
+
+static unsigned long iso_emc_rate(void)
+{
+	unsigned long rate;
+
+	pthread_mutex_lock(&clk_lock);
+	rate = clk_get_sys("iso", "emc")->rate;
+	pthread_mutex_unlock(&clk_lock);
+	return rate;
+}
+
+unsigned long tegra_emc_bw_to_freq_req(unsigned long bw)
+{
+	return bw / BW_TO_FREQ;
+}
+
+unsigned long tegra_emc_freq_req_to_bw(unsigned long freq)
+{
+	return freq * BW_TO_FREQ;
+}
+
+u32 tegra_emc_dvfs_latency(u32 freq)
+{
+	return 4;
+}
+
+/* wait queues */
+void init_waitqueue_head(wait_queue_head_t *q)
+{
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_cond_init(&q->cond, NULL);
+}
+
+void wake_up_all(wait_queue_head_t *q)
+{
+	pthread_mutex_lock(&q->lock);
+	pthread_cond_broadcast(&q->cond);
+	pthread_mutex_unlock(&q->lock);
+}
+
+/* workqueue */
+static struct work_struct *work_queue[16];
+static int nr_queued;
+static bool work_running;
+static pthread_mutex_t work_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+
+bool schedule_work(struct work_struct *work)
+{
+	pthread_mutex_lock(&work_lock);
+	if (work->pending) {
+		pthread_mutex_unlock(&work_lock);
+		return false;
+	}
+	work->pending = true;
+	work_queue[nr_queued++] = work;
+	pthread_cond_broadcast(&work_cond);
+	pthread_mutex_unlock(&work_lock);
+	return true;
+}
+
+static void *worker(void *arg)
+{
+	struct work_struct *work;
+
+	strcpy(current->comm, "kworker");
+	for (;;) {
+		pthread_mutex_lock(&work_lock);
+		while (!nr_queued)
+			pthread_cond_wait(&work_cond, &work_lock);
+		work = work_queue[0];
+		memmove(work_queue, work_queue + 1,
+			--nr_queued * sizeof(*work_queue));
+		work->pending = false;
+		work_running = true;
+		pthread_mutex_unlock(&work_lock);
+
+		work->func(work);
+
+		pthread_mutex_lock(&work_lock);
+		work_running = false;
+		pthread_cond_broadcast(&work_cond);
+		pthread_mutex_unlock(&work_lock);
+	}
+	return NULL;
+}
+
+static void flush_work_queue(void)
+{
+	pthread_mutex_lock(&work_lock);
+	while (nr_queued || work_running)
+		pthread_cond_wait(&work_cond, &work_lock);
+	pthread_mutex_unlock(&work_lock);
+}
+
+ktime_t ktime_get(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+/* functional test */
+#define CHECK(cond)							\
+do {									\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%d: %s failed\n", __FILE__,		\
+			__LINE__, #cond);				\
+		return -1;						\
+	}								\
+} while (0)
+
+static int test_accounting(void)
+{
+	u32 total = tegra_isomgr_get_total_iso_bw();
+	tegra_isomgr_handle disp;
+	tegra_isomgr_handle vi;
+
+	disp = tegra_isomgr_register(TEGRA_ISO_CLIENT_DISP_0, 1000000,
+				     NULL, NULL);
+	vi = tegra_isomgr_register(TEGRA_ISO_CLIENT_VI_0, 500000, NULL, NULL);
+	CHECK(!IS_ERR_OR_NULL(disp) && !IS_ERR_OR_NULL(vi));
+
+	/* a raise is in effect when realize returns */
+	CHECK(tegra_isomgr_reserve(disp, 800000, 1000));
+	CHECK(tegra_isomgr_realize(disp));
+	CHECK(tegra_isomgr_get_available_iso_bw() == total - 800000);
+	CHECK(iso_emc_rate() == 800000 / BW_TO_FREQ * 1000);
+
+	CHECK(tegra_isomgr_reserve(vi, 400000, 1000));
+	CHECK(tegra_isomgr_realize(vi));
+	CHECK(tegra_isomgr_get_available_iso_bw() == total - 1200000);
+	CHECK(iso_emc_rate() == 800000 / BW_TO_FREQ * 1000);
+
+	/* more than dedicated without renegotiate fails */
+	CHECK(!tegra_isomgr_reserve(vi, 600000, 1000));
+
+	/* a lower floor is applied in the background */
+	CHECK(tegra_isomgr_reserve(disp, 200000, 1000));
+	CHECK(tegra_isomgr_realize(disp));
+	CHECK(tegra_isomgr_get_available_iso_bw() == total - 600000);
+	flush_work_queue();
+	CHECK(iso_emc_rate() == 400000 / BW_TO_FREQ * 1000);
+
+	tegra_isomgr_unregister(disp);
+	tegra_isomgr_unregister(vi);
+	CHECK(tegra_isomgr_get_available_iso_bw() == total);
+	flush_work_queue();
+	CHECK(iso_emc_rate() == 0);
+	CHECK(clk_get_sys("iso", "emc")->enabled == 0);
+
+	printf("accounting [PASS]\n");
+	return 0;
+}
+
+/* benchmark */
+struct stat {
+	u64 n, sum_us, max_us;
+};
+
+static void stat_add(struct stat *s, ktime_t start)
+{
+	u64 us = ktime_us_delta(ktime_get(), start);
+
+	s->n++;
+	s->sum_us += us;
+	if (us > s->max_us)
+		s->max_us = us;
+}
+
+static void stat_print(const char *what, struct stat *s)
+{
+	printf("%-16s %6llu calls  avg %6llu us  max %6llu us\n", what,
+	       (unsigned long long)s->n,
+	       (unsigned long long)(s->n ? s->sum_us / s->n : 0),
+	       (unsigned long long)s->max_us);
+}
+
+struct bench_client {
+	enum tegra_iso_client client;
+	u32 lo_bw, hi_bw;
+	struct stat reserve, raise, lower;
+	int failed;
+};
+
+static void *bench_client(void *arg)
+{
+	struct bench_client *bc = arg;
+	tegra_isomgr_handle h;
+	ktime_t start;
+	unsigned long i;
+
+	h = tegra_isomgr_register(bc->client, bc->hi_bw, NULL, NULL);
+	if (IS_ERR_OR_NULL(h)) {
+		bc->failed = 1;
+		return NULL;
+	}
+
+	for (i = 0; i < iterations * 2; i++) {
+		u32 bw = i & 1 ? bc->lo_bw : bc->hi_bw;
+
+		start = ktime_get();
+		if (!tegra_isomgr_reserve(h, bw, 1000))
+			bc->failed = 1;
+		stat_add(&bc->reserve, start);
+
+		start = ktime_get();
+		if (!tegra_isomgr_realize(h))
+			bc->failed = 1;
+		stat_add(i & 1 ? &bc->lower : &bc->raise, start);
+	}
+
+	tegra_isomgr_unregister(h);
+	return NULL;
+}
+
+static int bench(void)
+{
+	struct bench_client disp = {
+		.client = TEGRA_ISO_CLIENT_DISP_0,
+		.lo_bw = 300000, .hi_bw = 1600000,
+	};
+	struct bench_client vi = {
+		.client = TEGRA_ISO_CLIENT_VI_0,
+		.lo_bw = 100000, .hi_bw = 800000,
+	};
+	pthread_t td, tv;
+	struct stat reserve = { 0 }, lower = { 0 };
+
+	nr_switches = 0;
+	pthread_create(&td, NULL, bench_client, &disp);
+	pthread_create(&tv, NULL, bench_client, &vi);
+	pthread_join(td, NULL);
+	pthread_join(tv, NULL);
+	flush_work_queue();
+
+	if (disp.failed || vi.failed) {
+		fprintf(stderr, "bench: reserve or realize failed\n");
+		return -1;
+	}
+
+	reserve.n = disp.reserve.n + vi.reserve.n;
+	reserve.sum_us = disp.reserve.sum_us + vi.reserve.sum_us;
+	reserve.max_us = max(disp.reserve.max_us, vi.reserve.max_us);
+	lower.n = disp.lower.n + vi.lower.n;
+	lower.sum_us = disp.lower.sum_us + vi.lower.sum_us;
+	lower.max_us = max(disp.lower.max_us, vi.lower.max_us);
+
+	printf("%lu us per clock switch\n", switch_us);
+	stat_print("reserve", &reserve);
+	stat_print("realize, raise", &disp.raise);
+	stat_print("realize, lower", &lower);
+	printf("%llu floor updates, %lu clock switches\n",
+	       (unsigned long long)(disp.raise.n + disp.lower.n +
+				    vi.raise.n + vi.lower.n),
+	       nr_switches);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	pthread_t tw;
+	int ret;
+
+	if (argc > 1)
+		iterations = strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		switch_us = strtoul(argv[2], NULL, 0);
+
+	pthread_create(&tw, NULL, worker, NULL);
+	isomgr_init();
+
+	ret = test_accounting();
+	if (!ret)
+		ret = bench();
+	return ret ? 1 : 0;
+}
@@ -0,0 +1,3 @@
+#ifndef _IVC_TEST_ASM_COMPILER_H
+#define _IVC_TEST_ASM_COMPILER_H
+#endif
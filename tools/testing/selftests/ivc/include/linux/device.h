@@ -0,0 +1,6 @@
+#ifndef _IVC_TEST_LINUX_DEVICE_H
+#define _IVC_TEST_LINUX_DEVICE_H
+
+struct device;
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef _IVC_TEST_LINUX_ERR_H
+#define _IVC_TEST_LINUX_ERR_H
+
+#define MAX_ERRNO	4095
+
+#define ERR_PTR(err)	((void *)(long)(err))
+#define PTR_ERR(ptr)	((long)(ptr))
+#define IS_ERR(ptr)	((unsigned long)(ptr) >= (unsigned long)-MAX_ERRNO)
+
+#endif
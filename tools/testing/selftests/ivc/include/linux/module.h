@@ -0,0 +1,27 @@
+#ifndef _IVC_TEST_LINUX_MODULE_H
+#define _IVC_TEST_LINUX_MODULE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <linux/types.h>
+
+/* the two ends of a channel run on different threads */
+#define CONFIG_SMP
+
+#define smp_rmb()	__atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define smp_wmb()	__atomic_thread_fence(__ATOMIC_RELEASE)
+#define smp_mb()	__atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#define ACCESS_ONCE(x)	(*(volatile __typeof__(x) *)&(x))
+
+#define BUG()		abort()
+#define BUG_ON(c)	do { if (c) abort(); } while (0)
+
+#define min_t(type, a, b) \
+	((type)(a) < (type)(b) ? (type)(a) : (type)(b))
+
+#define pr_err(...)	fprintf(stderr, __VA_ARGS__)
+
+#define EXPORT_SYMBOL(sym)
+
+#endif
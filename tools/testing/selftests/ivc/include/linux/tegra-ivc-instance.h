@@ -0,0 +1 @@
+#include "../../../../../../include/linux/tegra-ivc-instance.h"
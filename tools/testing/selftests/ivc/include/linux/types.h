@@ -0,0 +1,17 @@
+/*
+ * Just enough of the kernel environment to build tegra-ivc.c in userspace.
+ */
+#ifndef _IVC_TEST_LINUX_TYPES_H
+#define _IVC_TEST_LINUX_TYPES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+
+typedef uint64_t dma_addr_t;
+
+#define __user
+
+#endif
@@ -0,0 +1,269 @@
+/*
+ * ivc_test.c - IVC queue protocol test and benchmark
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Builds drivers/platform/tegra/tegra-ivc.c against the shims in include/
+ * and runs both ends of a channel in two threads over memory they share,
+ * as two guests would.  A side that finds the queue full or empty yields,
+ * so the test also makes progress on a single CPU.
+ *
+ * Usage:
+ *   ivc_test [FRAMES [NFRAMES [BATCH]]]
+ *       Send FRAMES sequence-numbered frames (default 1000000) through a
+ *       queue of NFRAMES frames (default 64) with the copying, the single
+ *       in-place and the batched in-place (BATCH frames, default 16) API.
+ *       Checks that every frame arrives in order and reports the rate,
+ *       the one-way latency and the number of notifications of each.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include <linux/err.h>
+#include <linux/tegra-ivc.h>
+#include <linux/tegra-ivc-instance.h>
+
+#define FRAME_SIZE	64
+#define MAX_BATCH	256
+
+enum mode { MODE_COPY, MODE_FRAME, MODE_BATCH };
+
+static const char *mode_names[] = { "copy", "frame", "batch" };
+
+struct msg {
+	uint64_t seq;
+	uint64_t sent_ns;
+};
+
+static struct ivc tx_end, rx_end;
+static unsigned long nr_frames = 1000000, nr_qframes = 64, batch = 16;
+static uint64_t *latency;
+static unsigned long notifies;
+static int failed;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void notify(struct ivc *ivc)
+{
+	__atomic_fetch_add(&notifies, 1, __ATOMIC_RELAXED);
+}
+
+static int setup(void)
+{
+	unsigned size = tegra_ivc_total_queue_size(nr_qframes * FRAME_SIZE);
+	void *q0 = aligned_alloc(64, size), *q1 = aligned_alloc(64, size);
+	int i;
+
+	if (!q0 || !q1)
+		return -1;
+	memset(q0, 0, size);
+	memset(q1, 0, size);
+
+	if (tegra_ivc_init(&tx_end, (uintptr_t)q1, (uintptr_t)q0, nr_qframes,
+			FRAME_SIZE, NULL, notify) ||
+	    tegra_ivc_init(&rx_end, (uintptr_t)q0, (uintptr_t)q1, nr_qframes,
+			FRAME_SIZE, NULL, notify))
+		return -1;
+
+	tegra_ivc_channel_reset(&tx_end);
+	tegra_ivc_channel_reset(&rx_end);
+	for (i = 0; i < 16; i++) {
+		int a = tegra_ivc_channel_notified(&tx_end);
+		int b = tegra_ivc_channel_notified(&rx_end);
+
+		if (!a && !b)
+			return 0;
+	}
+	return -1;
+}
+
+static void *writer(void *arg)
+{
+	enum mode mode = *(enum mode *)arg;
+	void *frames[MAX_BATCH];
+	unsigned long seq = 0;
+	struct msg m;
+	int i, n;
+
+	while (seq < nr_frames) {
+		switch (mode) {
+		case MODE_COPY:
+			m.seq = seq;
+			m.sent_ns = now_ns();
+			if (tegra_ivc_write(&tx_end, &m, sizeof(m)) < 0) {
+				sched_yield();
+				continue;
+			}
+			seq++;
+			break;
+		case MODE_FRAME:
+			frames[0] = tegra_ivc_write_get_next_frame(&tx_end);
+			if (IS_ERR(frames[0])) {
+				sched_yield();
+				continue;
+			}
+			m.seq = seq++;
+			m.sent_ns = now_ns();
+			memcpy(frames[0], &m, sizeof(m));
+			tegra_ivc_write_advance(&tx_end);
+			break;
+		case MODE_BATCH:
+			n = tegra_ivc_write_get_frames(&tx_end, frames,
+				nr_frames - seq < batch ? nr_frames - seq : batch);
+			if (n < 0) {
+				sched_yield();
+				continue;
+			}
+			for (i = 0; i < n; i++) {
+				m.seq = seq++;
+				m.sent_ns = now_ns();
+				memcpy(frames[i], &m, sizeof(m));
+			}
+			tegra_ivc_write_advance_frames(&tx_end, n);
+			break;
+		}
+	}
+	return NULL;
+}
+
+static int receive(const void *frame, unsigned long *seq)
+{
+	struct msg m;
+
+	memcpy(&m, frame, sizeof(m));
+	latency[*seq] = now_ns() - m.sent_ns;
+	if (m.seq != *seq) {
+		fprintf(stderr, "got frame %llu, expected %lu\n",
+			(unsigned long long)m.seq, *seq);
+		return -1;
+	}
+	(*seq)++;
+	return 0;
+}
+
+static void *reader(void *arg)
+{
+	enum mode mode = *(enum mode *)arg;
+	void *frames[MAX_BATCH];
+	unsigned long seq = 0;
+	struct msg m;
+	int i, n;
+
+	while (seq < nr_frames) {
+		switch (mode) {
+		case MODE_COPY:
+			if (tegra_ivc_read(&rx_end, &m, sizeof(m)) < 0) {
+				sched_yield();
+				continue;
+			}
+			if (receive(&m, &seq))
+				goto fail;
+			break;
+		case MODE_FRAME:
+			frames[0] = tegra_ivc_read_get_next_frame(&rx_end);
+			if (IS_ERR(frames[0])) {
+				sched_yield();
+				continue;
+			}
+			if (receive(frames[0], &seq))
+				goto fail;
+			tegra_ivc_read_advance(&rx_end);
+			break;
+		case MODE_BATCH:
+			n = tegra_ivc_read_get_frames(&rx_end, frames, batch);
+			if (n < 0) {
+				sched_yield();
+				continue;
+			}
+			for (i = 0; i < n; i++)
+				if (receive(frames[i], &seq))
+					goto fail;
+			tegra_ivc_read_advance_frames(&rx_end, n);
+			break;
+		}
+	}
+	return NULL;
+fail:
+	failed = 1;
+	exit(1);
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int run(enum mode mode)
+{
+	pthread_t tw, tr;
+	uint64_t start, ns;
+
+	if (setup()) {
+		fprintf(stderr, "%s: channel setup failed\n", mode_names[mode]);
+		return -1;
+	}
+	notifies = 0;
+
+	start = now_ns();
+	pthread_create(&tr, NULL, reader, &mode);
+	pthread_create(&tw, NULL, writer, &mode);
+	pthread_join(tw, NULL);
+	pthread_join(tr, NULL);
+	ns = now_ns() - start;
+
+	if (failed)
+		return -1;
+
+	qsort(latency, nr_frames, sizeof(*latency), cmp_u64);
+	printf("%-6s %10.0f frames/s  latency p50 %6llu ns p99 %7llu ns"
+	       "  notifies %lu [PASS]\n", mode_names[mode],
+	       nr_frames * 1e9 / ns,
+	       (unsigned long long)latency[nr_frames / 2],
+	       (unsigned long long)latency[nr_frames * 99 / 100],
+	       notifies);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int ret = 0;
+
+	if (argc > 1)
+		nr_frames = strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		nr_qframes = strtoul(argv[2], NULL, 0);
+	if (argc > 3)
+		batch = strtoul(argv[3], NULL, 0);
+	if (!nr_frames || !batch || batch > MAX_BATCH) {
+		fprintf(stderr, "usage: %s [FRAMES [NFRAMES [BATCH]]]\n",
+			argv[0]);
+		return 2;
+	}
+
+	latency = calloc(nr_frames, sizeof(*latency));
+	if (!latency)
+		return 1;
+
+	ret |= run(MODE_COPY);
+	ret |= run(MODE_FRAME);
+	ret |= run(MODE_BATCH);
+
+	return ret ? 1 : 0;
+}
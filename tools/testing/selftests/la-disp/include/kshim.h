@@ -0,0 +1,45 @@
+/*
+ * Just enough of the kernel environment to build mc/la_disp_calc.c in
+ * userspace.
+ */
+#ifndef _LA_DISP_TEST_KSHIM_H
+#define _LA_DISP_TEST_KSHIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+typedef uint8_t u8;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+#define EXPORT_SYMBOL(sym)
+
+/* as in the kernel, so that the results have the same types */
+#define min(x, y) ({				\
+	typeof(x) _min1 = (x);			\
+	typeof(y) _min2 = (y);			\
+	(void) (&_min1 == &_min2);		\
+	_min1 < _min2 ? _min1 : _min2; })
+
+#define max(x, y) ({				\
+	typeof(x) _max1 = (x);			\
+	typeof(y) _max2 = (y);			\
+	(void) (&_max1 == &_max2);		\
+	_max1 > _max2 ? _max1 : _max2; })
+
+static inline u64 div_u64(u64 dividend, u32 divisor)
+{
+	return dividend / divisor;
+}
+
+/* the test is single threaded */
+typedef struct {
+	int unused;
+} spinlock_t;
+
+#define spin_lock_init(lock)	do { } while (0)
+#define spin_lock(lock)		do { } while (0)
+#define spin_unlock(lock)	do { } while (0)
+
+#endif
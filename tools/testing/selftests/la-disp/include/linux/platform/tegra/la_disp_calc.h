@@ -0,0 +1,2 @@
+#include <kshim.h>
+#include "../../../../../../../../include/linux/platform/tegra/la_disp_calc.h"
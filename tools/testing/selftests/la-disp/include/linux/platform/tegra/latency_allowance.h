@@ -0,0 +1 @@
+#include "../../../../../../../../include/linux/platform/tegra/latency_allowance.h"
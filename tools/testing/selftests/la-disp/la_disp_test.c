@@ -0,0 +1,286 @@
+/*
+ * la_disp_test.c - display bandwidth and latency allowance calculator test
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Builds drivers/platform/tegra/mc/la_disp_calc.c against the shims in
+ * include/.
+ *
+ * Usage:
+ *   la_disp_test [GOLDEN]
+ *       Check the calculator against GOLDEN, the inputs and results of the
+ *       calculations as bandwidth.c and tegra21x_la.c used to do them, then
+ *       time the bandwidth and LA calculations of a flip of three windows,
+ *       with and without the per-window caches.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <mach/dc.h>
+#include <linux/platform/tegra/la_disp_calc.h>
+
+/* T21x */
+#define LA_FP_FACTOR		1000
+
+static unsigned int la_real_to_fp(unsigned int val)
+{
+	return val * LA_FP_FACTOR;
+}
+
+static unsigned int la_fp_to_real(unsigned int val)
+{
+	return val / LA_FP_FACTOR;
+}
+
+static const struct la_to_dc_params la_params = {
+	.fp_factor = LA_FP_FACTOR,
+	.la_real_to_fp = la_real_to_fp,
+	.la_fp_to_real = la_fp_to_real,
+	.static_la_minus_snap_arb_to_row_srt_emcclks_fp = 70000,
+	.dram_width_bits = 64,
+	.disp_catchup_factor_fp = 1100,
+};
+
+static const struct tegra_la_disp_chip chip = {
+	.ns_per_tick = 30,
+	.fp_factor = LA_FP_FACTOR,
+	.catchup_factor_fp = 1100,
+	.st_la_minus_snap_arb_to_row_srt_emcclks_fp = 70000,
+	.exp_time_emcclks_fp = 88000,
+	.max_la_nsec = 7650,
+	.la_max_value = 255,
+};
+
+static int golden(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	struct tegra_la_disp_cache cache;
+	struct tegra_la_disp_in in;
+	struct dc_to_la_params p, pc;
+	unsigned int win_type, tiled, thresh, spool, drain;
+	unsigned long bw;
+	long long la, res;
+	char line[512];
+	int n = 0, failed = 0, i;
+
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+
+	tegra_la_disp_cache_init(&cache);
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#')
+			continue;
+		if (sscanf(line, "%u %u %u %u %u %u %u %u %u %u %u %u %u %u "
+			   "%lu %u %u %u %u %u %lu %u %u %u %lld",
+			   &in.win.fmt, &in.win.flags, &in.win.w, &in.win.h,
+			   &in.win.out_w, &in.win.out_h, &in.mode.pclk,
+			   &in.mode.h_active, &in.mode.v_active,
+			   &in.mode.h_total, &in.mode.v_total, &win_type,
+			   &in.client.mccif_size_bytes,
+			   &in.client.line_buf_sz_bytes, &in.emc_freq_hz,
+			   &in.bw_mbps, &in.total_active_space_bw,
+			   &in.num_active_wins, &in.dvfs_time_nsec, &tiled,
+			   &bw, &thresh, &spool, &drain, &la) != 25) {
+			fprintf(stderr, "%s: bad line: %s", path, line);
+			fclose(f);
+			return -1;
+		}
+		in.client.win_type = win_type;
+		n++;
+
+		memset(&p, 0, sizeof(p));
+		tegra_la_disp_calc_params(&la_params, &in, &p);
+		res = tegra_la_disp_calc_la(&chip, &in.client, in.emc_freq_hz,
+					    in.bw_mbps, in.dvfs_time_nsec, &p);
+
+		if (tegra_la_disp_win_bw(&in.mode, &in.win, tiled) != bw ||
+		    p.thresh_lwm_bytes != thresh ||
+		    p.spool_up_buffering_adj_bytes != spool ||
+		    p.drain_time_usec_fp != drain || res != la) {
+			fprintf(stderr, "line %d: got %lu %u %u %u %lld\n", n,
+				tegra_la_disp_win_bw(&in.mode, &in.win, tiled),
+				p.thresh_lwm_bytes,
+				p.spool_up_buffering_adj_bytes,
+				p.drain_time_usec_fp, res);
+			failed++;
+			continue;
+		}
+
+		/* a miss, then a hit, both with the same results */
+		memset(&pc, 0, sizeof(pc));
+		for (i = 0; i < 2; i++)
+			tegra_la_disp_calc_params_cached(&cache, &la_params,
+							 &in, &pc);
+		if (tegra_la_disp_win_bw_cached(&cache, &in.mode, &in.win,
+						tiled) != bw ||
+		    tegra_la_disp_win_bw_cached(&cache, &in.mode, &in.win,
+						tiled) != bw ||
+		    memcmp(&p, &pc, sizeof(p))) {
+			fprintf(stderr, "line %d: cached results differ\n", n);
+			failed++;
+		}
+	}
+	fclose(f);
+
+	if (!n || failed || cache.hits != 2 * n || cache.misses != 2 * n) {
+		fprintf(stderr, "%d of %d cases failed, %lu hits %lu misses\n",
+			failed, n, cache.hits, cache.misses);
+		return -1;
+	}
+	printf("golden: %d cases [PASS]\n", n);
+	return 0;
+}
+
+/* benchmark */
+#define NR_WINS		3
+#define NR_FLIPS	200000
+
+static const unsigned long emc_rates[] = {
+	40800000, 68000000, 102000000, 204000000, 408000000, 665600000,
+	800000000, 1065600000, 1331200000, 1600000000,
+};
+#define NR_RATES	(sizeof(emc_rates) / sizeof(emc_rates[0]))
+
+static const struct tegra_la_disp_mode mode = {
+	.pclk = 148500000,
+	.h_active = 1920, .v_active = 1080,
+	.h_total = 2200, .v_total = 1125,
+};
+
+static const struct disp_client clients[NR_WINS] = {
+	{ TEGRA_LA_DISP_WIN_TYPE_FULL, 6144, 151552 },
+	{ TEGRA_LA_DISP_WIN_TYPE_FULLA, 6144, 112640 },
+	{ TEGRA_LA_DISP_WIN_TYPE_SIMPLE, 4672, 18432 },
+};
+
+/* a UI, a video being played in a window and a small overlay */
+static void flip_wins(unsigned int flip, struct tegra_la_disp_win *wins)
+{
+	static const struct tegra_la_disp_win ui = {
+		TEGRA_WIN_FMT_B8G8R8A8,
+		TEGRA_WIN_FLAG_ENABLED | TEGRA_WIN_FLAG_BLOCKLINEAR,
+		1920, 1080, 1920, 1080,
+	};
+	static const struct tegra_la_disp_win video = {
+		TEGRA_WIN_FMT_YUV420P,
+		TEGRA_WIN_FLAG_ENABLED | TEGRA_WIN_FLAG_BLOCKLINEAR,
+		3840, 2160, 1280, 720,
+	};
+	static const struct tegra_la_disp_win overlay = {
+		TEGRA_WIN_FMT_R8G8B8A8, TEGRA_WIN_FLAG_ENABLED,
+		256, 128, 256, 128,
+	};
+
+	wins[0] = ui;
+	wins[1] = video;
+	wins[2] = overlay;
+
+	/* the video window is resized every few seconds */
+	if (flip / 300 % 2) {
+		wins[1].out_w = 1920;
+		wins[1].out_h = 1080;
+	}
+}
+
+static unsigned long run(struct tegra_la_disp_cache *caches,
+			 unsigned long *sum)
+{
+	struct tegra_la_disp_win wins[NR_WINS];
+	struct dc_to_la_params p;
+	struct timespec t0, t1;
+	unsigned int flip, i, r;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (flip = 0; flip < NR_FLIPS; flip++) {
+		unsigned int bw_mbps[NR_WINS], total = 0;
+
+		flip_wins(flip, wins);
+		for (i = 0; i < NR_WINS; i++) {
+			unsigned long bw = caches ?
+				tegra_la_disp_win_bw_cached(&caches[i], &mode,
+							    &wins[i], 1) :
+				tegra_la_disp_win_bw(&mode, &wins[i], 1);
+
+			bw_mbps[i] = bw / 1000 + 1;
+			total += bw_mbps[i];
+		}
+
+		/* as tegra_dc_handle_latency_allowance() walks up the rates */
+		for (i = 0; i < NR_WINS; i++) {
+			struct tegra_la_disp_in in = {
+				.win = wins[i],
+				.mode = mode,
+				.client = clients[i],
+				.bw_mbps = bw_mbps[i],
+				.total_active_space_bw = total,
+				.num_active_wins = NR_WINS,
+				.dvfs_time_nsec = 2000,
+			};
+			long long la = -1;
+
+			for (r = 0; r < NR_RATES && la < 0; r++) {
+				if (emc_rates[r] / 1000000 * 4 < total)
+					continue;
+				in.emc_freq_hz = emc_rates[r];
+				if (caches)
+					tegra_la_disp_calc_params_cached(
+						&caches[i], &la_params, &in,
+						&p);
+				else
+					tegra_la_disp_calc_params(&la_params,
+								  &in, &p);
+				la = tegra_la_disp_calc_la(&chip, &clients[i],
+						in.emc_freq_hz, in.bw_mbps,
+						in.dvfs_time_nsec, &p);
+			}
+			*sum += la + r;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	return ((t1.tv_sec - t0.tv_sec) * 1000000000UL +
+		t1.tv_nsec - t0.tv_nsec) / NR_FLIPS;
+}
+
+static int bench(void)
+{
+	struct tegra_la_disp_cache caches[NR_WINS];
+	unsigned long sum = 0, sum_cached = 0, hits = 0, misses = 0;
+	unsigned long ns, ns_cached;
+	unsigned int i;
+
+	for (i = 0; i < NR_WINS; i++)
+		tegra_la_disp_cache_init(&caches[i]);
+
+	ns = run(NULL, &sum);
+	ns_cached = run(caches, &sum_cached);
+
+	for (i = 0; i < NR_WINS; i++) {
+		hits += caches[i].hits;
+		misses += caches[i].misses;
+	}
+
+	printf("flip of %d windows: %lu ns, cached %lu ns, %lu%% hits\n",
+	       NR_WINS, ns, ns_cached, hits * 100 / (hits + misses));
+
+	if (sum != sum_cached) {
+		fprintf(stderr, "cached flips differ\n");
+		return -1;
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (golden(argc > 1 ? argv[1] : "la_disp_golden.txt"))
+		return 1;
+
+	return bench() ? 1 : 0;
+}
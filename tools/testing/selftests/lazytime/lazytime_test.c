@@ -0,0 +1,251 @@
+/*
+ * lazytime_test.c - lazytime timestamp test and log-append write benchmark
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Usage:
+ *   lazytime_test                      run the functional test in the
+ *                                      current directory, which has to be
+ *                                      on a lazytime mount
+ *   lazytime_test bench [SECONDS] [RECORD] [append|overwrite]
+ *       Every 10ms for SECONDS, write a RECORD byte record to a scratch
+ *       file in the current directory without ever syncing it, appending
+ *       (the default) or overwriting the start of the file, the way a
+ *       logger does.  Reports how many jbd2 transactions the filesystem
+ *       committed and how many bytes its device wrote meanwhile.  Run it
+ *       on an otherwise idle ext4 filesystem mounted with and without
+ *       -o lazytime to compare.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#define SECTOR_SIZE	512
+#define EXPIRE_SECONDS	"/proc/sys/vm/dirtytime_expire_seconds"
+
+static char path[] = "lazytime.XXXXXX";
+
+/* Is the filesystem holding @dev mounted with lazytime? */
+static int is_lazytime(dev_t dev)
+{
+	char line[4096], opts[1024];
+	unsigned int maj, min;
+	int ret = 0;
+	char *sep;
+	FILE *f;
+
+	f = fopen("/proc/self/mountinfo", "r");
+	if (!f)
+		return 0;
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "%*d %*d %u:%u", &maj, &min) != 2 ||
+		    makedev(maj, min) != dev)
+			continue;
+		/* super block options follow " - fstype source " */
+		sep = strstr(line, " - ");
+		if (sep && sscanf(sep, " - %*s %*s %1023s", opts) == 1 &&
+		    strstr(opts, "lazytime"))
+			ret = 1;
+	}
+	fclose(f);
+
+	return ret;
+}
+
+/* Sectors written by @dev, or -1 if unknown. */
+static long long sectors_written(dev_t dev)
+{
+	unsigned long long st[7];
+	char name[64];
+	FILE *f;
+	int i;
+
+	snprintf(name, sizeof(name), "/sys/dev/block/%u:%u/stat",
+		 major(dev), minor(dev));
+	f = fopen(name, "r");
+	if (!f)
+		return -1;
+	for (i = 0; i < 7; i++)
+		if (fscanf(f, "%llu", &st[i]) != 1)
+			break;
+	fclose(f);
+
+	return i == 7 ? (long long)st[6] : -1;
+}
+
+/* Transactions committed by the journal of the filesystem on @dev. */
+static long long jbd2_transactions(dev_t dev)
+{
+	char name[128], line[128], devname[64] = "";
+	long long nr = -1;
+	FILE *f;
+
+	snprintf(name, sizeof(name), "/sys/dev/block/%u:%u/uevent",
+		 major(dev), minor(dev));
+	f = fopen(name, "r");
+	if (!f)
+		return -1;
+	while (fgets(line, sizeof(line), f))
+		if (sscanf(line, "DEVNAME=%63s", devname) == 1)
+			break;
+	fclose(f);
+	if (!*devname)
+		return -1;
+
+	/* the journal inode is inode 8 */
+	snprintf(name, sizeof(name), "/proc/fs/jbd2/%s-8/info", devname);
+	f = fopen(name, "r");
+	if (!f)
+		return -1;
+	if (fscanf(f, "%lld transactions", &nr) != 1)
+		nr = -1;
+	fclose(f);
+
+	return nr;
+}
+
+static int stat_mtime(int fd, struct timespec *ts)
+{
+	struct stat st;
+
+	if (fstat(fd, &st))
+		return -1;
+	*ts = st.st_mtim;
+	return 0;
+}
+
+static int ts_after(struct timespec *a, struct timespec *b)
+{
+	return a->tv_sec > b->tv_sec ||
+	       (a->tv_sec == b->tv_sec && a->tv_nsec > b->tv_nsec);
+}
+
+/*
+ * Timestamps kept in memory must still be what stat() reports, advance
+ * with every write and survive fsync(), which writes them out.
+ */
+static int test_timestamps(void)
+{
+	struct timespec before, after, synced;
+	struct stat st;
+	FILE *f;
+	int fd, ret = 1;
+
+	if (stat(".", &st) || !is_lazytime(st.st_dev)) {
+		fprintf(stderr, "timestamps: . isn't on a lazytime mount [SKIP]\n");
+		return 0;
+	}
+	f = fopen(EXPIRE_SECONDS, "r");
+	if (!f) {
+		fprintf(stderr, "timestamps: no %s\n", EXPIRE_SECONDS);
+		return 1;
+	}
+	fclose(f);
+
+	fd = mkstemp(path);
+	if (fd < 0) {
+		perror("mkstemp");
+		return 1;
+	}
+	if (write(fd, "a", 1) != 1 || stat_mtime(fd, &before)) {
+		perror("write");
+		goto out;
+	}
+	/* mtime has jiffy granularity: make sure it gets to move */
+	usleep(50 * 1000);
+	if (write(fd, "b", 1) != 1 || stat_mtime(fd, &after)) {
+		perror("write");
+		goto out;
+	}
+	if (!ts_after(&after, &before)) {
+		fprintf(stderr, "timestamps: mtime didn't advance on write\n");
+		goto out;
+	}
+	if (fsync(fd) || stat_mtime(fd, &synced)) {
+		perror("fsync");
+		goto out;
+	}
+	if (synced.tv_sec != after.tv_sec || synced.tv_nsec != after.tv_nsec) {
+		fprintf(stderr, "timestamps: fsync changed mtime\n");
+		goto out;
+	}
+	printf("timestamps: mtime advances and survives fsync [PASS]\n");
+	ret = 0;
+out:
+	close(fd);
+	unlink(path);
+	return ret;
+}
+
+static int bench(int seconds, size_t size, int overwrite)
+{
+	long long sect_before, sect_after, trans_before, trans_after;
+	char *buf = malloc(size);
+	struct stat st;
+	int i, fd, ret = 1;
+
+	if (!buf || !size || seconds < 1)
+		return 1;
+	memset(buf, 'x', size);
+	buf[size - 1] = '\n';
+
+	fd = mkstemp(path);
+	if (fd < 0) {
+		perror("mkstemp");
+		return 1;
+	}
+	/* start from a clean slate */
+	if (fstat(fd, &st) || write(fd, buf, size) != size || fsync(fd)) {
+		perror(path);
+		goto out;
+	}
+	sync();
+
+	sect_before = sectors_written(st.st_dev);
+	trans_before = jbd2_transactions(st.st_dev);
+	for (i = 0; i < seconds * 100; i++) {
+		if ((overwrite ? pwrite(fd, buf, size, 0) :
+				 write(fd, buf, size)) != size) {
+			perror("write");
+			goto out;
+		}
+		usleep(10 * 1000);
+	}
+	sect_after = sectors_written(st.st_dev);
+	trans_after = jbd2_transactions(st.st_dev);
+
+	printf("%d %s writes of %zu bytes over %ds, %slazytime\n", i,
+	       overwrite ? "overwrite" : "append", size, seconds,
+	       is_lazytime(st.st_dev) ? "" : "no ");
+	if (trans_before >= 0 && trans_after >= 0)
+		printf("jbd2 transactions: %lld\n", trans_after - trans_before);
+	if (sect_before >= 0 && sect_after >= 0)
+		printf("device writes:     %lld bytes\n",
+		       (sect_after - sect_before) * SECTOR_SIZE);
+	ret = 0;
+out:
+	close(fd);
+	unlink(path);
+	free(buf);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && !strcmp(argv[1], "bench"))
+		return bench(argc > 2 ? atoi(argv[2]) : 30,
+			     argc > 3 ? atoi(argv[3]) : 128,
+			     argc > 4 && !strcmp(argv[4], "overwrite"));
+
+	return test_timestamps();
+}
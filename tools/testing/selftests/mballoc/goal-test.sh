@@ -0,0 +1,91 @@
+#!/bin/bash
+#
+# Check that ext4 allocates a small file in its goal group when that group
+# has room, with mb_optimize_scan both off and on.
+#
+# Without flex_bg the goal of a file's first block is the first block of
+# its inode's group, which holds metadata, so the exact goal always fails
+# and the allocator has to pick a group: it must try the goal group before
+# the largest free order lists.  Each file is written on a fresh mount so
+# that it can't use another file's locality group preallocation.
+#
+# Needs root, losetup, mkfs.ext4, dumpe2fs and debugfs.
+
+DIRS=4
+MNT=$(mktemp -d)
+IMG=$MNT.img
+loop=
+
+cleanup()
+{
+	mountpoint -q $MNT && umount $MNT
+	[ -n "$loop" ] && losetup -d $loop
+	rm -f $IMG
+	rmdir $MNT
+}
+
+skip()
+{
+	echo "mballoc: $1 [SKIP]"
+	cleanup
+	exit 0
+}
+
+fail()
+{
+	echo "mballoc: $1 [FAIL]"
+	cleanup
+	exit 1
+}
+
+[ "$(id -u)" = 0 ] || skip "must be run as root"
+for cmd in losetup mkfs.ext4 dumpe2fs debugfs; do
+	which $cmd > /dev/null 2>&1 || skip "no $cmd"
+done
+
+truncate -s 512M $IMG
+loop=$(losetup -f --show $IMG) || fail "losetup failed"
+mkfs.ext4 -q -F -b 4096 -O ^flex_bg $loop || fail "mkfs.ext4 failed"
+SYSFS=/sys/fs/ext4/$(basename $loop)
+
+# field after "NAME:" in the superblock
+super()
+{
+	dumpe2fs -h $loop 2>/dev/null | sed -n "s/^$1: *//p"
+}
+
+ipg=$(super "Inodes per group")
+bpg=$(super "Blocks per group")
+
+# top level directories are spread over the groups
+mount $loop $MNT || fail "mount failed"
+for d in $(seq $DIRS); do
+	mkdir $MNT/d$d
+done
+umount $MNT
+
+for scan in 0 1; do
+	for d in $(seq $DIRS); do
+		mount $loop $MNT || fail "mount failed"
+		[ -w $SYSFS/mb_optimize_scan ] ||
+			skip "no $SYSFS/mb_optimize_scan"
+		echo $scan > $SYSFS/mb_optimize_scan
+		dd if=/dev/zero of=$MNT/d$d/f$scan bs=4k count=8 conv=fsync \
+			2>/dev/null || fail "write failed"
+		ino=$(stat -c %i $MNT/d$d/f$scan)
+		umount $MNT
+
+		blk=$(debugfs -R "bmap <$ino> 0" $loop 2>/dev/null)
+		[ -n "$blk" ] && [ "$blk" != 0 ] ||
+			fail "no block mapped for inode $ino"
+		goal=$(((ino - 1) / ipg))
+		group=$((blk / bpg))
+		echo "mballoc: mb_optimize_scan=$scan d$d: goal group $goal," \
+			"allocated in group $group"
+		[ $group = $goal ] ||
+			fail "mb_optimize_scan=$scan: missed the goal group"
+	done
+done
+
+cleanup
+echo "mballoc: [PASS]"
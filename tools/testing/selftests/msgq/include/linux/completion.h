@@ -0,0 +1,11 @@
+#ifndef _MSGQ_TEST_LINUX_COMPLETION_H
+#define _MSGQ_TEST_LINUX_COMPLETION_H
+
+struct completion { int dummy; };
+
+/* only referenced by inlines the test never calls */
+void wait_for_completion(struct completion *x);
+long wait_for_completion_interruptible_timeout(struct completion *x,
+					       unsigned long timeout);
+
+#endif
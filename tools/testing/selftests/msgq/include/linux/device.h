@@ -0,0 +1,7 @@
+#ifndef _MSGQ_TEST_LINUX_DEVICE_H
+#define _MSGQ_TEST_LINUX_DEVICE_H
+
+struct device;
+struct page;
+
+#endif
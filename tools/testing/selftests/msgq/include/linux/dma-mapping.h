@@ -0,0 +1,6 @@
+#ifndef _MSGQ_TEST_LINUX_DMA_MAPPING_H
+#define _MSGQ_TEST_LINUX_DMA_MAPPING_H
+
+enum dma_data_direction { DMA_BIDIRECTIONAL };
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef _MSGQ_TEST_LINUX_LIST_H
+#define _MSGQ_TEST_LINUX_LIST_H
+
+struct list_head { struct list_head *next, *prev; };
+
+#endif
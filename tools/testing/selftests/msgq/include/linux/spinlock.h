@@ -0,0 +1,18 @@
+#ifndef _MSGQ_TEST_LINUX_SPINLOCK_H
+#define _MSGQ_TEST_LINUX_SPINLOCK_H
+
+#include <stdio.h>
+#include <linux/types.h>
+
+typedef struct { int dummy; } spinlock_t;
+
+/* the ADSP is simulated by another thread */
+#define rmb()		__atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define wmb()		__atomic_thread_fence(__ATOMIC_RELEASE)
+#define mb()		__atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#define ACCESS_ONCE(x)	(*(volatile __typeof__(x) *)&(x))
+
+#define pr_info(...)	printf(__VA_ARGS__)
+
+#endif
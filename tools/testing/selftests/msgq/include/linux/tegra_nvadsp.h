@@ -0,0 +1 @@
+#include "../../../../../../include/linux/tegra_nvadsp.h"
@@ -0,0 +1,6 @@
+#ifndef _MSGQ_TEST_LINUX_TIMER_H
+#define _MSGQ_TEST_LINUX_TIMER_H
+
+struct timer_list { int dummy; };
+
+#endif
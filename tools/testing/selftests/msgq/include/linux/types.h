@@ -0,0 +1,20 @@
+/*
+ * Just enough of the kernel environment to build nvadsp/msgq.c in userspace.
+ */
+#ifndef _MSGQ_TEST_LINUX_TYPES_H
+#define _MSGQ_TEST_LINUX_TYPES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+
+typedef uint64_t u64;
+typedef uint64_t dma_addr_t;
+typedef uint64_t phys_addr_t;
+typedef unsigned gfp_t;
+
+#define __must_check
+
+#endif
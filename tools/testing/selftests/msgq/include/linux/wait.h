@@ -0,0 +1,7 @@
+#ifndef _MSGQ_TEST_LINUX_WAIT_H
+#define _MSGQ_TEST_LINUX_WAIT_H
+
+typedef struct { int dummy; } wait_queue_head_t;
+struct work_struct { int dummy; };
+
+#endif
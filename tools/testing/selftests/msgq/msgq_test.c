@@ -0,0 +1,207 @@
+/*
+ * msgq_test.c - nvadsp message queue test and benchmark
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Builds drivers/platform/tegra/nvadsp/msgq.c against the shims in
+ * include/ and runs the CPU side of a queue in one thread and a simulated
+ * ADSP in another, with a semaphore standing in for the mailbox interrupt.
+ *
+ * Usage:
+ *   msgq_test [MESSAGES [QUEUE_WORDS [BATCH]]]
+ *       Send MESSAGES sequence-numbered messages (default 1000000)
+ *       through a queue of QUEUE_WORDS words (default 1024), first one
+ *       at a time with an interrupt per message, then BATCH (default 16)
+ *       at a time with an interrupt only when the queue was empty and
+ *       the ADSP draining it on every interrupt. Checks that every
+ *       message arrives in order and reports the rate and the number of
+ *       interrupts of both.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <time.h>
+
+#include <linux/tegra_nvadsp.h>
+
+#define MAX_BATCH	256
+
+union test_msg {
+	msgq_message_t msgq_msg;
+	struct {
+		int32_t size;
+		uint32_t seq;
+		uint32_t data[2];
+	} m;
+};
+
+#define TEST_MSG_PAYLOAD_WSIZE	MSGQ_MSG_PAYLOAD_WSIZE(union test_msg)
+
+static msgq_t *msgq;
+static sem_t doorbell;
+static unsigned long nr_msgs = 1000000, qwords = 1024, batch = 16;
+static unsigned long nr_doorbells;
+static int batched;
+
+static double now_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void ring(void)
+{
+	nr_doorbells++;
+	sem_post(&doorbell);
+}
+
+static void *cpu(void *arg)
+{
+	union test_msg msgs[MAX_BATCH];
+	const msgq_message_t *ptrs[MAX_BATCH];
+	unsigned long seq = 0;
+	bool signal;
+	int i, n;
+
+	for (i = 0; i < MAX_BATCH; i++) {
+		msgs[i].m.size = TEST_MSG_PAYLOAD_WSIZE;
+		ptrs[i] = &msgs[i].msgq_msg;
+	}
+
+	while (seq < nr_msgs) {
+		n = batched ? batch : 1;
+		if (n > nr_msgs - seq)
+			n = nr_msgs - seq;
+		for (i = 0; i < n; i++) {
+			msgs[i].m.seq = seq + i;
+			msgs[i].m.data[0] = ~(seq + i);
+		}
+
+		if (batched) {
+			n = msgq_queue_messages(msgq, ptrs, n, &signal);
+		} else {
+			n = msgq_queue_message(msgq, ptrs[0]) ? -ENOSPC : 1;
+			signal = true;
+		}
+		if (n < 0) {
+			sched_yield();
+			continue;
+		}
+		seq += n;
+		if (signal)
+			ring();
+	}
+	return NULL;
+}
+
+static int check(union test_msg *msg, unsigned long *seq)
+{
+	if (msg->m.size != TEST_MSG_PAYLOAD_WSIZE ||
+	    msg->m.seq != (uint32_t)*seq ||
+	    msg->m.data[0] != (uint32_t)~*seq) {
+		fprintf(stderr, "got message %u, expected %lu\n",
+			msg->m.seq, *seq);
+		return -1;
+	}
+	(*seq)++;
+	return 0;
+}
+
+static void *adsp(void *arg)
+{
+	union test_msg msgs[MAX_BATCH];
+	msgq_message_t *ptrs[MAX_BATCH];
+	unsigned long seq = 0;
+	int i, n;
+
+	for (i = 0; i < MAX_BATCH; i++)
+		ptrs[i] = &msgs[i].msgq_msg;
+
+	while (seq < nr_msgs) {
+		sem_wait(&doorbell);
+
+		if (!batched) {
+			msgs[0].m.size = TEST_MSG_PAYLOAD_WSIZE;
+			if (msgq_dequeue_message(msgq, ptrs[0]) ||
+			    check(&msgs[0], &seq))
+				goto fail;
+			continue;
+		}
+
+		/* drain the queue on every interrupt */
+		for (;;) {
+			for (i = 0; i < batch; i++)
+				msgs[i].m.size = TEST_MSG_PAYLOAD_WSIZE;
+			n = msgq_dequeue_messages(msgq, ptrs, batch);
+			if (n == -ENOMSG)
+				break;
+			if (n < 0)
+				goto fail;
+			for (i = 0; i < n; i++)
+				if (check(&msgs[i], &seq))
+					goto fail;
+		}
+	}
+	return NULL;
+fail:
+	fprintf(stderr, "%s: dequeue failed at message %lu\n",
+		batched ? "batch" : "single", seq);
+	exit(1);
+}
+
+static void run(int batch_mode)
+{
+	pthread_t tc, ta;
+	double start, s;
+
+	msgq_init(msgq, qwords);
+	sem_init(&doorbell, 0, 0);
+	nr_doorbells = 0;
+	batched = batch_mode;
+
+	start = now_s();
+	pthread_create(&ta, NULL, adsp, NULL);
+	pthread_create(&tc, NULL, cpu, NULL);
+	pthread_join(tc, NULL);
+	pthread_join(ta, NULL);
+	s = now_s() - start;
+
+	printf("%-6s %10.0f messages/s  %lu interrupts [PASS]\n",
+	       batched ? "batch" : "single", nr_msgs / s, nr_doorbells);
+	sem_destroy(&doorbell);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1)
+		nr_msgs = strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		qwords = strtoul(argv[2], NULL, 0);
+	if (argc > 3)
+		batch = strtoul(argv[3], NULL, 0);
+	if (!nr_msgs || !batch || batch > MAX_BATCH ||
+	    qwords <= MSGQ_MSG_WSIZE(union test_msg) ||
+	    qwords > MSGQ_MAX_QUEUE_WSIZE) {
+		fprintf(stderr, "usage: %s [MESSAGES [QUEUE_WORDS [BATCH]]]\n",
+			argv[0]);
+		return 2;
+	}
+
+	msgq = calloc(1, MSGQ_HEADER_SIZE + qwords * sizeof(int32_t));
+	if (!msgq)
+		return 1;
+
+	run(0);
+	run(1);
+	return 0;
+}
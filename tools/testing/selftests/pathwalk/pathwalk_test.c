@@ -0,0 +1,247 @@
+/*
+ * pathwalk_test.c - concurrent path lookup test and stat() benchmark
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Usage:
+ *   pathwalk_test                              run the functional test
+ *   pathwalk_test bench [THREADS] [DEPTH] [SECONDS] [shared|private]
+ *       THREADS threads, pinned round robin to the online CPUs, stat()
+ *       files DEPTH directories below a scratch directory in the current
+ *       directory as fast as they can.  With "shared" (the default) all
+ *       threads look up the same file; with "private" each thread has a
+ *       file of its own in the same leaf directory, so only the directory
+ *       dentries are shared.  Reports the aggregate stat() rate.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#define MAX_DEPTH	32
+
+static char base[] = "pathwalk.XXXXXX";
+static char leaf[PATH_MAX / 2];
+static int depth;
+static volatile int stop;
+
+struct walker {
+	pthread_t thr;
+	int cpu;
+	char path[PATH_MAX];
+	unsigned long stats;
+	unsigned long errors;
+};
+
+static void *walker_fn(void *arg)
+{
+	struct walker *w = arg;
+	struct stat st;
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	CPU_SET(w->cpu, &set);
+	sched_setaffinity(0, sizeof(set), &set);
+
+	while (!stop) {
+		if (stat(w->path, &st))
+			w->errors++;
+		w->stats++;
+	}
+
+	return NULL;
+}
+
+static int make_tree(int levels)
+{
+	int i, len;
+
+	if (!mkdtemp(base)) {
+		perror("mkdtemp");
+		return -1;
+	}
+
+	len = snprintf(leaf, sizeof(leaf), "%s", base);
+	for (i = 0; i < levels; i++) {
+		len += snprintf(leaf + len, sizeof(leaf) - len, "/d%d", i);
+		if (mkdir(leaf, 0755)) {
+			perror("mkdir");
+			return -1;
+		}
+	}
+	depth = levels;
+
+	return 0;
+}
+
+static void remove_tree(int nr_files)
+{
+	char path[PATH_MAX];
+	int i;
+
+	for (i = 0; i < nr_files; i++) {
+		snprintf(path, sizeof(path), "%s/f%d", leaf, i);
+		unlink(path);
+	}
+	for (i = depth; i > 0; i--) {
+		rmdir(leaf);
+		*strrchr(leaf, '/') = '\0';
+	}
+	rmdir(base);
+}
+
+static int make_file(int i, char *path)
+{
+	int fd;
+
+	snprintf(path, PATH_MAX, "%s/f%d", leaf, i);
+	fd = open(path, O_CREAT | O_WRONLY, 0644);
+	if (fd < 0) {
+		perror("open");
+		return -1;
+	}
+	close(fd);
+
+	return 0;
+}
+
+static int run_walkers(struct walker *w, int nr, int seconds)
+{
+	int i;
+
+	stop = 0;
+	for (i = 0; i < nr; i++) {
+		if (pthread_create(&w[i].thr, NULL, walker_fn, &w[i])) {
+			perror("pthread_create");
+			return -1;
+		}
+	}
+	sleep(seconds);
+	stop = 1;
+	for (i = 0; i < nr; i++)
+		pthread_join(w[i].thr, NULL);
+
+	return 0;
+}
+
+/*
+ * Walkers keep looking up a file that always exists while its siblings are
+ * created, renamed and unlinked next to it.  Sequence count retries and
+ * the switch from rcu-walk to ref-walk must never turn into a failed
+ * lookup.
+ */
+static int test_concurrent(void)
+{
+	int ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int nr = ncpus < 4 ? 4 : ncpus;
+	struct walker *w = calloc(nr, sizeof(*w));
+	char from[PATH_MAX], to[PATH_MAX];
+	unsigned long stats = 0, errors = 0, renames = 0;
+	struct timeval start, now;
+	int i, fd, ret = 1;
+
+	if (!w || make_tree(4))
+		return 1;
+	for (i = 0; i < nr; i++) {
+		w[i].cpu = i % ncpus;
+		if (make_file(0, w[i].path))
+			goto out;
+	}
+
+	stop = 0;
+	for (i = 0; i < nr; i++)
+		pthread_create(&w[i].thr, NULL, walker_fn, &w[i]);
+
+	snprintf(from, sizeof(from), "%s/tmp", leaf);
+	snprintf(to, sizeof(to), "%s/f1", leaf);
+	gettimeofday(&start, NULL);
+	do {
+		fd = open(from, O_CREAT | O_WRONLY, 0644);
+		if (fd >= 0)
+			close(fd);
+		if (!rename(from, to))
+			renames++;
+		unlink(to);
+		gettimeofday(&now, NULL);
+	} while (now.tv_sec - start.tv_sec < 2);
+	unlink(from);
+
+	stop = 1;
+	for (i = 0; i < nr; i++) {
+		pthread_join(w[i].thr, NULL);
+		stats += w[i].stats;
+		errors += w[i].errors;
+	}
+
+	if (errors) {
+		fprintf(stderr, "concurrent: %lu of %lu lookups failed\n",
+			errors, stats);
+		goto out;
+	}
+	printf("concurrent: %lu lookups, %lu renames alongside [PASS]\n",
+	       stats, renames);
+	ret = 0;
+out:
+	remove_tree(2);
+	free(w);
+	return ret;
+}
+
+static int bench(int nr, int levels, int seconds, int private)
+{
+	struct walker *w = calloc(nr, sizeof(*w));
+	int ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned long stats = 0, errors = 0;
+	int i, ret = 1;
+
+	if (!w || levels < 1 || levels > MAX_DEPTH || make_tree(levels))
+		return 1;
+	for (i = 0; i < nr; i++) {
+		w[i].cpu = i % ncpus;
+		if (make_file(private ? i : 0, w[i].path))
+			goto out;
+	}
+
+	if (run_walkers(w, nr, seconds))
+		goto out;
+
+	for (i = 0; i < nr; i++) {
+		stats += w[i].stats;
+		errors += w[i].errors;
+	}
+
+	printf("%d threads, %s files %d levels deep, %d CPUs, %ds\n",
+	       nr, private ? "private" : "shared", levels, ncpus, seconds);
+	printf("stat():    %12.0f/s\n", (double)stats / seconds);
+	printf("per thread:%12.0f/s\n", (double)stats / seconds / nr);
+	if (errors)
+		printf("errors:    %12lu\n", errors);
+	ret = 0;
+out:
+	remove_tree(private ? nr : 1);
+	free(w);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && !strcmp(argv[1], "bench"))
+		return bench(argc > 2 ? atoi(argv[2]) : 8,
+			     argc > 3 ? atoi(argv[3]) : 4,
+			     argc > 4 ? atoi(argv[4]) : 5,
+			     argc > 5 && !strcmp(argv[5], "private"));
+
+	return test_concurrent();
+}
@@ -0,0 +1,97 @@
+#!/bin/bash
+#
+# Suspend and resume all devices with and without pm_async_all, using the
+# "devices" pm_test level so that the system never really sleeps, and
+# compare how long the dpm_suspend() and dpm_resume() phases took.
+#
+# Usage: pm-async-test.sh [CYCLES]
+#
+# Needs root, CONFIG_PM_DEBUG for /sys/power/pm_test and debugfs for
+# pm_device_times. Every cycle must suspend and resume all devices, and
+# with pm_async_all the same devices must be handled, asynchronously.
+
+CYCLES=${1:-3}
+POWER=/sys/power
+DEBUGFS=$(awk '$3 == "debugfs" { print $2; exit }' /proc/mounts)
+TIMES=$DEBUGFS/pm_device_times
+
+skip()
+{
+	echo "pm-async: $1 [SKIP]"
+	exit 0
+}
+
+fail()
+{
+	echo "pm-async: $1 [FAIL]"
+	restore
+	exit 1
+}
+
+[ "$(id -u)" = 0 ] || skip "must be run as root"
+[ -w $POWER/pm_async_all ] || skip "no $POWER/pm_async_all"
+[ -w $POWER/pm_test ] || skip "no $POWER/pm_test, needs CONFIG_PM_DEBUG"
+grep -qw mem $POWER/state || skip "no suspend to mem"
+[ -n "$DEBUGFS" ] && [ -r $TIMES ] || skip "no pm_device_times in debugfs"
+
+old_test=$(sed 's/.*\[\(.*\)\].*/\1/' $POWER/pm_test)
+old_async=$(cat $POWER/pm_async)
+old_async_all=$(cat $POWER/pm_async_all)
+
+restore()
+{
+	echo $old_test > $POWER/pm_test
+	echo $old_async > $POWER/pm_async
+	echo $old_async_all > $POWER/pm_async_all
+}
+
+# field FIELD of the PHASE line of pm_device_times
+phase()
+{
+	awk -v p=$1 -v f=$2 '$1 == p { print $f; exit }' $TIMES
+}
+
+# run CYCLES suspend/resume cycles, print "devices async suspend_us resume_us"
+# with the phase times averaged over the cycles
+run()
+{
+	local i devices async suspend=0 resume=0
+
+	echo $1 > $POWER/pm_async_all
+	for i in $(seq $CYCLES); do
+		echo mem > $POWER/state || fail "suspend cycle failed"
+		devices=$(phase suspend 2)
+		async=$(phase suspend 3)
+		[ "$(phase resume 2)" = "$devices" ] ||
+			fail "resumed a different number of devices"
+		suspend=$((suspend + $(phase suspend 6)))
+		resume=$((resume + $(phase resume 6)))
+	done
+	echo $devices $async $((suspend / CYCLES)) $((resume / CYCLES))
+}
+
+echo devices > $POWER/pm_test
+echo 1 > $POWER/pm_async
+
+# run() runs in a subshell: its fail() restores, but only exits that and
+# its message is in the output
+out=$(run 0) || { echo "$out"; exit 1; }
+set -- $out
+sync_devices=$1 sync_async=$2 sync_suspend=$3 sync_resume=$4
+out=$(run 1) || { echo "$out"; exit 1; }
+set -- $out
+all_devices=$1 all_async=$2 all_suspend=$3 all_resume=$4
+restore
+
+printf "%-14s %8s %6s %11s %11s\n" pm_async_all devices async \
+	suspend_us resume_us
+printf "%-14s %8s %6s %11s %11s\n" 0 $sync_devices $sync_async \
+	$sync_suspend $sync_resume
+printf "%-14s %8s %6s %11s %11s\n" 1 $all_devices $all_async \
+	$all_suspend $all_resume
+
+[ "$all_devices" = "$sync_devices" ] ||
+	fail "pm_async_all changed the number of devices"
+[ "$all_async" = "$all_devices" ] ||
+	fail "pm_async_all left devices synchronous"
+echo "pm-async: [PASS]"
@@ -0,0 +1,237 @@
+/*
+ * readahead_test.c - interleaved and strided readahead test and benchmark
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Usage:
+ *   readahead_test                     run the functional test in the
+ *                                      current directory
+ *   readahead_test bench [STREAMS] [STRIDE_KB]
+ *       Read a 64MB scratch file in the current directory with STREAMS
+ *       interleaved sequential readers on one descriptor, then in 4KB
+ *       reads STRIDE_KB apart, dropping its page cache before each.
+ *       Reports the throughput of both and the readahead counters from
+ *       /proc/vmstat.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#define FILE_SIZE	(64 << 20)
+#define CHUNK		(64 << 10)
+
+static char path[] = "readahead.XXXXXX";
+
+static const char *counters[] = {
+	"readahead_hit", "readahead_miss", "readahead_pages",
+	"readahead_stream", "readahead_stride",
+};
+#define NR_COUNTERS	(sizeof(counters) / sizeof(counters[0]))
+
+static double now_us(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+/* Read the readahead counters, returns -1 if the kernel has none */
+static int read_counters(long long *val)
+{
+	char name[64];
+	long long v;
+	unsigned int i, found = 0;
+	FILE *f;
+
+	f = fopen("/proc/vmstat", "r");
+	if (!f)
+		return -1;
+	while (fscanf(f, "%63s %lld", name, &v) == 2)
+		for (i = 0; i < NR_COUNTERS; i++)
+			if (!strcmp(name, counters[i])) {
+				val[i] = v;
+				found++;
+			}
+	fclose(f);
+
+	return found == NR_COUNTERS ? 0 : -1;
+}
+
+static int create_file(size_t size)
+{
+	char *buf = malloc(CHUNK);
+	size_t done;
+	int fd;
+
+	fd = mkstemp(path);
+	if (fd < 0 || !buf) {
+		perror("mkstemp");
+		free(buf);
+		return -1;
+	}
+	memset(buf, 0x5a, CHUNK);
+	for (done = 0; done < size; done += CHUNK)
+		if (write(fd, buf, CHUNK) != CHUNK) {
+			perror("write");
+			close(fd);
+			fd = -1;
+			break;
+		}
+	free(buf);
+	if (fd >= 0 && fsync(fd)) {
+		perror("fsync");
+		close(fd);
+		fd = -1;
+	}
+	return fd;
+}
+
+static int drop_cache(int fd)
+{
+	return posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+/* @streams sequential readers, taking turns reading @len bytes each */
+static int read_interleaved(int fd, int streams, size_t size, size_t len)
+{
+	size_t part = size / streams, off;
+	char *buf = malloc(len);
+	int i;
+
+	if (!buf)
+		return -1;
+	for (off = 0; off + len <= part; off += len)
+		for (i = 0; i < streams; i++)
+			if (pread(fd, buf, len, i * part + off) != len) {
+				free(buf);
+				return -1;
+			}
+	free(buf);
+	return 0;
+}
+
+static int read_strided(int fd, size_t size, size_t stride)
+{
+	char buf[4096];
+	size_t off;
+
+	for (off = 0; off + sizeof(buf) <= size; off += stride)
+		if (pread(fd, buf, sizeof(buf), off) != sizeof(buf))
+			return -1;
+	return 0;
+}
+
+/*
+ * Two streams reading one descriptor in turns must keep their windows,
+ * and a strided reader must be detected.
+ */
+static int test_streams(void)
+{
+	long long before[NR_COUNTERS], after[NR_COUNTERS];
+	int fd, ret = 1;
+
+	if (read_counters(before)) {
+		printf("streams: no readahead counters in /proc/vmstat [SKIP]\n");
+		return 0;
+	}
+	fd = create_file(16 << 20);
+	if (fd < 0)
+		return 1;
+
+	if (drop_cache(fd) || read_interleaved(fd, 2, 16 << 20, 16 << 10)) {
+		perror("interleaved read");
+		goto out;
+	}
+	if (read_counters(after))
+		goto out;
+	if (after[3] == before[3]) {
+		fprintf(stderr, "streams: no stream was resumed\n");
+		goto out;
+	}
+	printf("streams: %lld stream switches [PASS]\n", after[3] - before[3]);
+
+	if (drop_cache(fd) || read_strided(fd, 16 << 20, 64 << 10)) {
+		perror("strided read");
+		goto out;
+	}
+	if (read_counters(before))
+		goto out;
+	if (before[4] == after[4]) {
+		fprintf(stderr, "stride: no strided reads detected\n");
+		goto out;
+	}
+	printf("stride: %lld strided readaheads [PASS]\n", before[4] - after[4]);
+	ret = 0;
+out:
+	close(fd);
+	unlink(path);
+	return ret;
+}
+
+static void report(const char *what, double us, long long *before)
+{
+	long long after[NR_COUNTERS];
+	unsigned int i;
+
+	printf("%-12s %8.1f MB/s", what, FILE_SIZE / us);
+	if (!read_counters(after))
+		for (i = 0; i < NR_COUNTERS; i++)
+			printf(" %s %lld", counters[i] + strlen("readahead_"),
+			       after[i] - before[i]);
+	printf("\n");
+}
+
+static int bench(int streams, size_t stride)
+{
+	long long before[NR_COUNTERS];
+	double start;
+	int fd, ret = 1;
+
+	if (streams < 1 || stride < 4096)
+		return 1;
+	fd = create_file(FILE_SIZE);
+	if (fd < 0)
+		return 1;
+
+	drop_cache(fd);
+	read_counters(before);
+	start = now_us();
+	if (read_interleaved(fd, streams, FILE_SIZE, CHUNK)) {
+		perror("interleaved read");
+		goto out;
+	}
+	report("interleaved", now_us() - start, before);
+
+	drop_cache(fd);
+	read_counters(before);
+	start = now_us();
+	if (read_strided(fd, FILE_SIZE, stride)) {
+		perror("strided read");
+		goto out;
+	}
+	/* counts the whole file, not just the 4KB read from each stride */
+	report("strided", now_us() - start, before);
+	ret = 0;
+out:
+	close(fd);
+	unlink(path);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && !strcmp(argv[1], "bench"))
+		return bench(argc > 2 ? atoi(argv[2]) : 4,
+			     (argc > 3 ? atoi(argv[3]) : 64) << 10);
+
+	return test_streams();
+}
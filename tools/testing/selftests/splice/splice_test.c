@@ -0,0 +1,332 @@
+/*
+ * splice_test.c - copy_file_range test and file serving benchmark
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Usage:
+ *   splice_test                        run the functional test in the
+ *                                      current directory
+ *   splice_test bench FILE [SECONDS] [CHUNK]
+ *       Send FILE over a loopback TCP connection again and again for
+ *       SECONDS, CHUNK bytes at a time, with read()/write(), sendfile()
+ *       and splice() through a pipe in turn, the way a media server
+ *       streams files.  Reports the throughput of each and the CPU time
+ *       the sender used.  Drop the page cache or use a file larger than
+ *       memory to include the storage in the measurement.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#ifndef __NR_copy_file_range
+# if defined(__aarch64__)
+#  define __NR_copy_file_range	285
+# elif defined(__arm__)
+#  define __NR_copy_file_range	391
+# endif
+#endif
+
+#define FILE_SIZE	(4 << 20)
+
+static char src_path[] = "splice_src.XXXXXX";
+static char dst_path[] = "splice_dst.XXXXXX";
+
+static ssize_t copy_range(int fd_in, loff_t *off_in, int fd_out,
+			  loff_t *off_out, size_t len)
+{
+#ifdef __NR_copy_file_range
+	return syscall(__NR_copy_file_range, fd_in, off_in, fd_out, off_out,
+		       len, 0);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+static double now_us(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+static void fill(char *buf, size_t len, unsigned int seed)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (char)(seed * 31 + i * 7 + (i >> 12));
+}
+
+/* Copy len bytes, coping with short copies */
+static int copy_all(int in, loff_t *off_in, int out, loff_t *off_out,
+		    size_t len)
+{
+	ssize_t n;
+
+	while (len) {
+		n = copy_range(in, off_in, out, off_out, len);
+		if (n <= 0)
+			return -1;
+		len -= n;
+	}
+	return 0;
+}
+
+/*
+ * Copy a whole file through the file positions, then overwrite a range
+ * in the middle at explicit offsets, and check the result and that only
+ * the positions used were moved.
+ */
+static int test_copy_file_range(void)
+{
+	size_t mid = FILE_SIZE / 3 + 123, mid_len = FILE_SIZE / 4;
+	char *buf = malloc(FILE_SIZE), *rd = malloc(FILE_SIZE);
+	loff_t off_in, off_out;
+	int in = -1, out = -1, ret = 1;
+
+	if (!buf || !rd)
+		return 1;
+	in = mkstemp(src_path);
+	out = mkstemp(dst_path);
+	if (in < 0 || out < 0) {
+		perror("mkstemp");
+		goto out;
+	}
+	fill(buf, FILE_SIZE, 1);
+	if (write(in, buf, FILE_SIZE) != FILE_SIZE ||
+	    lseek(in, 0, SEEK_SET)) {
+		perror("write");
+		goto out;
+	}
+
+	if (copy_range(in, NULL, out, NULL, 0) < 0 && errno == ENOSYS) {
+		printf("copy_file_range: not supported [SKIP]\n");
+		ret = 0;
+		goto out;
+	}
+	if (copy_all(in, NULL, out, NULL, FILE_SIZE)) {
+		perror("copy_file_range");
+		goto out;
+	}
+	if (lseek(in, 0, SEEK_CUR) != FILE_SIZE ||
+	    lseek(out, 0, SEEK_CUR) != FILE_SIZE) {
+		fprintf(stderr, "copy_file_range: file positions not updated\n");
+		goto out;
+	}
+
+	/* move a range of the source to another place in the copy */
+	off_in = 0;
+	off_out = mid;
+	if (copy_all(in, &off_in, out, &off_out, mid_len)) {
+		perror("copy_file_range");
+		goto out;
+	}
+	if (off_in != mid_len || off_out != mid + mid_len ||
+	    lseek(in, 0, SEEK_CUR) != FILE_SIZE) {
+		fprintf(stderr, "copy_file_range: offsets not updated\n");
+		goto out;
+	}
+	memmove(buf + mid, buf, mid_len);
+
+	if (pread(out, rd, FILE_SIZE, 0) != FILE_SIZE ||
+	    memcmp(buf, rd, FILE_SIZE)) {
+		fprintf(stderr, "copy_file_range: copy differs\n");
+		goto out;
+	}
+	printf("copy_file_range: whole file and range copies [PASS]\n");
+	ret = 0;
+out:
+	if (in >= 0)
+		close(in);
+	if (out >= 0)
+		close(out);
+	unlink(src_path);
+	unlink(dst_path);
+	free(buf);
+	free(rd);
+	return ret;
+}
+
+enum method { RW, SENDFILE, SPLICE };
+
+static const char *method_name[] = { "read/write", "sendfile", "splice" };
+
+/* Send @size bytes of @fd from the start to @sock */
+static int send_file(enum method m, int fd, off_t size, int sock,
+		     size_t chunk, char *buf, int *pipefd)
+{
+	off_t off = 0;
+	ssize_t n, w, s;
+
+	while (off < size) {
+		switch (m) {
+		case RW:
+			n = pread(fd, buf, chunk, off);
+			for (w = 0; n > 0 && w < n; w += s) {
+				s = write(sock, buf + w, n - w);
+				if (s <= 0)
+					return -1;
+			}
+			break;
+		case SENDFILE:
+			n = sendfile(sock, fd, &off, chunk);
+			off -= n > 0 ? n : 0;
+			break;
+		case SPLICE:
+			n = splice(fd, &off, pipefd[1], NULL, chunk,
+				   SPLICE_F_MOVE | SPLICE_F_MORE);
+			off -= n > 0 ? n : 0;
+			for (w = 0; n > 0 && w < n; w += s) {
+				s = splice(pipefd[0], NULL, sock, NULL, n - w,
+					   SPLICE_F_MOVE | SPLICE_F_MORE);
+				if (s <= 0)
+					return -1;
+			}
+			break;
+		default:
+			return -1;
+		}
+		if (n <= 0)
+			return -1;
+		off += n;
+	}
+	return 0;
+}
+
+static int connect_loopback(pid_t *sink)
+{
+	struct sockaddr_in addr = { .sin_family = AF_INET };
+	socklen_t len = sizeof(addr);
+	int lsock, sock, conn;
+	char buf[65536];
+
+	lsock = socket(AF_INET, SOCK_STREAM, 0);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (lsock < 0 || bind(lsock, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    listen(lsock, 1) ||
+	    getsockname(lsock, (struct sockaddr *)&addr, &len)) {
+		perror("socket");
+		return -1;
+	}
+
+	*sink = fork();
+	if (*sink < 0) {
+		perror("fork");
+		return -1;
+	}
+	if (!*sink) {
+		/* the client only drains the connection */
+		sock = socket(AF_INET, SOCK_STREAM, 0);
+		if (sock < 0 ||
+		    connect(sock, (struct sockaddr *)&addr, sizeof(addr)))
+			_exit(1);
+		while (read(sock, buf, sizeof(buf)) > 0)
+			;
+		_exit(0);
+	}
+
+	conn = accept(lsock, NULL, NULL);
+	close(lsock);
+	if (conn < 0)
+		perror("accept");
+	return conn;
+}
+
+static double cpu_us(void)
+{
+	struct rusage ru;
+
+	getrusage(RUSAGE_SELF, &ru);
+	return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e6 +
+	       ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+static int bench(const char *name, int seconds, size_t chunk)
+{
+	char *buf = malloc(chunk);
+	int fd, sock, pipefd[2], ret = 1;
+	double start, end, cpu;
+	long long bytes;
+	struct stat st;
+	enum method m;
+	pid_t sink;
+
+	if (!buf || !chunk || seconds < 1)
+		return 1;
+	fd = open(name, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) || !st.st_size) {
+		perror(name);
+		return 1;
+	}
+	if (pipe(pipefd)) {
+		perror("pipe");
+		return 1;
+	}
+	/* let a whole chunk sit in the pipe */
+	fcntl(pipefd[1], F_SETPIPE_SZ, chunk);
+
+	for (m = RW; m <= SPLICE; m++) {
+		sock = connect_loopback(&sink);
+		if (sock < 0)
+			goto out;
+
+		bytes = 0;
+		cpu = cpu_us();
+		start = now_us();
+		do {
+			if (send_file(m, fd, st.st_size, sock, chunk, buf,
+				      pipefd)) {
+				perror(method_name[m]);
+				close(sock);
+				kill(sink, SIGKILL);
+				waitpid(sink, NULL, 0);
+				goto out;
+			}
+			bytes += st.st_size;
+			end = now_us();
+		} while (end - start < seconds * 1e6);
+		cpu = cpu_us() - cpu;
+
+		close(sock);
+		waitpid(sink, NULL, 0);
+		printf("%-10s %8.1f MB/s, sender cpu %5.1f%%\n",
+		       method_name[m], bytes / (end - start),
+		       100 * cpu / (end - start));
+	}
+	ret = 0;
+out:
+	close(pipefd[0]);
+	close(pipefd[1]);
+	close(fd);
+	free(buf);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 2 && !strcmp(argv[1], "bench"))
+		return bench(argv[2], argc > 3 ? atoi(argv[3]) : 10,
+			     argc > 4 ? atoi(argv[4]) : 65536);
+
+	return test_copy_file_range();
+}
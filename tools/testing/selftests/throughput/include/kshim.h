@@ -0,0 +1,32 @@
+/*
+ * Just enough of the kernel environment to build
+ * drivers/misc/tegra-throughput-est.c in userspace.
+ */
+#ifndef _THROUGHPUT_SIM_KSHIM_H
+#define _THROUGHPUT_SIM_KSHIM_H
+
+#include <stdint.h>
+#include <string.h>
+
+typedef uint16_t u16;
+typedef int32_t s32;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+#define EXPORT_SYMBOL(sym)
+
+#define min(a, b)		((a) < (b) ? (a) : (b))
+#define min_t(type, a, b)	((type)(a) < (type)(b) ? (type)(a) : (type)(b))
+#define max_t(type, a, b)	((type)(a) > (type)(b) ? (type)(a) : (type)(b))
+#define DIV_ROUND_UP(n, d)	(((n) + (d) - 1) / (d))
+
+static inline u64 div_u64(u64 dividend, u32 divisor)
+{
+	return dividend / divisor;
+}
+
+struct blocking_notifier_head {
+	int unused;
+};
+
+#endif
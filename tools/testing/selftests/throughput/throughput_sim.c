@@ -0,0 +1,258 @@
+/*
+ * throughput_sim.c - tegra-throughput frame hint test and DVFS simulator
+ *
+ * Copyright (c) 2016, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Builds drivers/misc/tegra-throughput-est.c against the shims in include/.
+ *
+ * Usage:
+ *   throughput_sim [TRACE]
+ *       Check the estimator, then replay TRACE, a file with the GPU time of
+ *       one frame at the top frequency in usec per line, or without TRACE a
+ *       synthetic light, heavy and medium scene of 600 frames each. Frames
+ *       are rendered at 60 Hz with vsync by a GPU whose busy time scales
+ *       inversely with its frequency, scaled by the pod governor rules for
+ *       the old throughput hint and for the frame hint. Reports missed
+ *       deadlines, average frequency and energy relative to running at the
+ *       top frequency, taking voltage to scale with frequency. Fails if the
+ *       frame hint misses more deadlines than the throughput hint.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <linux/tegra-throughput.h>
+
+#define TARGET_US	16667
+
+/* pod governor defaults for T21x */
+#define HINT_LO_LIMIT	500
+#define HINT_HI_LIMIT	997
+#define SCALEUP_LIMIT	1100
+#define SCALEDOWN_LIMIT	1300
+#define SMOOTH		10
+
+static const unsigned long freqs[] = {
+	76800000, 153600000, 230400000, 307200000, 384000000, 460800000,
+	537600000, 614400000, 691200000, 768000000, 844800000, 921600000,
+	998400000,
+};
+#define NR_FREQS	(sizeof(freqs) / sizeof(freqs[0]))
+#define FMAX		freqs[NR_FREQS - 1]
+
+static u32 *work;
+static unsigned long nr_frames;
+
+/* estimator checks */
+#define CHECK(cond)							\
+do {									\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%d: %s failed\n", __FILE__,		\
+			__LINE__, #cond);				\
+		return -1;						\
+	}								\
+} while (0)
+
+static int check(void)
+{
+	struct tegra_throughput_est est;
+	struct tegra_throughput_frame_hint fh;
+	int i;
+
+	tegra_throughput_est_init(&est, TARGET_US);
+	tegra_throughput_est_hint(&est, &fh);
+	CHECK(fh.predicted_us == TARGET_US && fh.scale == 1000);
+
+	/* frames on time, with a little jitter */
+	for (i = 0; i < TEGRA_THROUGHPUT_WINDOW; i++)
+		tegra_throughput_est_add(&est, TARGET_US - 200 + i % 400);
+	tegra_throughput_est_hint(&est, &fh);
+	CHECK(fh.predicted_us == TARGET_US && fh.slack_us == 0);
+	CHECK(fh.miss_permille == 0);
+
+	/* 3 of 64 long frames are below the 95th percentile, 4 are not */
+	for (i = 0; i < 3; i++)
+		tegra_throughput_est_add(&est, TARGET_US * 3 / 2);
+	tegra_throughput_est_hint(&est, &fh);
+	CHECK(fh.predicted_us == TARGET_US);
+	CHECK(fh.miss_permille == 3 * 1000 / TEGRA_THROUGHPUT_WINDOW);
+	tegra_throughput_est_add(&est, TARGET_US * 3 / 2);
+	tegra_throughput_est_hint(&est, &fh);
+	CHECK(fh.predicted_us == TARGET_US * 3 / 2);
+	CHECK(fh.slack_us == -(TARGET_US / 2));
+	CHECK(fh.scale >= 1499 && fh.scale <= 1500);
+
+	/* a pause is not a frame */
+	tegra_throughput_est_add(&est, 1000000);
+	tegra_throughput_est_hint(&est, &fh);
+	CHECK(fh.last_us == 1000000 && fh.predicted_us == TARGET_US * 3 / 2);
+
+	/* frames that made 30 Hz miss 60 Hz */
+	tegra_throughput_est_init(&est, 2 * TARGET_US);
+	for (i = 0; i < TEGRA_THROUGHPUT_WINDOW; i++)
+		tegra_throughput_est_add(&est, 2 * TARGET_US);
+	tegra_throughput_est_set_target(&est, TARGET_US);
+	tegra_throughput_est_hint(&est, &fh);
+	CHECK(fh.miss_permille == 1000 && fh.slack_us <= -TARGET_US / 2);
+
+	/* half busy in frames on time: half the rate, plus headroom */
+	tegra_throughput_est_init(&est, TARGET_US);
+	tegra_throughput_est_add(&est, TARGET_US);
+	tegra_throughput_est_hint(&est, &fh);
+	CHECK(tegra_throughput_hint_rate(&fh, 1000000000, 500) == 600000000);
+
+	printf("estimator [PASS]\n");
+	return 0;
+}
+
+/* simulator */
+static unsigned int lcg(void)
+{
+	static unsigned int seed = 1;
+
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) & 0x7fff;
+}
+
+static int gen_trace(void)
+{
+	unsigned long i;
+
+	nr_frames = 1800;
+	work = calloc(nr_frames, sizeof(*work));
+	if (!work)
+		return -1;
+
+	for (i = 0; i < nr_frames; i++) {
+		if (i < 600)
+			work[i] = 3200 + lcg() % 1600;
+		else if (i < 1200)
+			work[i] = 9500 + lcg() % 3000 + (i % 15 ? 0 : 4000);
+		else
+			work[i] = 6000 + lcg() % 2000;
+	}
+	return 0;
+}
+
+static int load_trace(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	unsigned long max = 0;
+	unsigned int w;
+
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+	while (fscanf(f, "%u", &w) == 1) {
+		if (nr_frames == max) {
+			max = max ? 2 * max : 4096;
+			work = realloc(work, max * sizeof(*work));
+			if (!work)
+				return -1;
+		}
+		work[nr_frames++] = w;
+	}
+	fclose(f);
+	if (!nr_frames) {
+		fprintf(stderr, "%s: no frames\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+enum policy { POLICY_RATIO, POLICY_FRAME };
+
+static unsigned long simulate(enum policy policy)
+{
+	struct tegra_throughput_est est;
+	struct tegra_throughput_frame_hint fh;
+	unsigned long i, missed = 0;
+	int cur = NR_FREQS - 1, target, block = 0;
+	unsigned int idle_avg = 0, hint_avg = 0;
+	double freq_sum = 0, energy = 0, work_sum = 0;
+
+	tegra_throughput_est_init(&est, TARGET_US);
+
+	for (i = 0; i < nr_frames; i++) {
+		unsigned long f = freqs[cur];
+		u32 render = (u64)work[i] * FMAX / f;
+		u32 frame = (render + TARGET_US - 1) / TARGET_US * TARGET_US;
+		unsigned int busy = (u64)render * 1000 / frame;
+		int hint = TARGET_US * 1000 / frame;
+
+		missed += frame > TARGET_US;
+		freq_sum += f;
+		work_sum += work[i];
+		energy += work[i] * ((double)f / FMAX) * ((double)f / FMAX);
+
+		/* what the governor sees at the flip */
+		idle_avg = (SMOOTH * idle_avg + 1000 - busy) / (SMOOTH + 1);
+		tegra_throughput_est_add(&est, frame);
+		tegra_throughput_est_hint(&est, &fh);
+
+		if (--block > 0)
+			continue;
+
+		hint_avg = (SMOOTH * hint_avg + hint) / (SMOOTH + 1);
+		target = cur;
+		if (policy == POLICY_FRAME) {
+			unsigned long need = tegra_throughput_hint_rate(&fh,
+						f, 1000 - idle_avg);
+
+			if (need > f)
+				target = cur + 1;
+			else if (cur > 0 && !fh.miss_permille &&
+				 freqs[cur - 1] >= need)
+				target = cur - 1;
+		} else if (hint_avg < HINT_LO_LIMIT) {
+			target = cur + 1;
+		} else {
+			unsigned int score = idle_avg + hint_avg;
+
+			if (score > SCALEDOWN_LIMIT)
+				target = cur - 1;
+			else if (score < SCALEUP_LIMIT && hint < HINT_HI_LIMIT)
+				target = cur + 1;
+		}
+
+		if (target < 0 || target >= (int)NR_FREQS)
+			target = cur;
+		if (target != cur) {
+			block = SMOOTH;
+			cur = target;
+		}
+	}
+
+	printf("%-6s %5lu frames  %4lu missed (%4.1f%%)  avg %4.0f MHz"
+	       "  energy %.2f\n", policy == POLICY_FRAME ? "frame" : "ratio",
+	       nr_frames, missed, 100.0 * missed / nr_frames,
+	       freq_sum / nr_frames / 1e6, energy / work_sum);
+	return missed;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long ratio_missed, frame_missed;
+
+	if (check())
+		return 1;
+
+	if (argc > 1 ? load_trace(argv[1]) : gen_trace())
+		return 1;
+
+	ratio_missed = simulate(POLICY_RATIO);
+	frame_missed = simulate(POLICY_FRAME);
+
+	/* the frame hint must not miss more deadlines than it replaces */
+	if (frame_missed > ratio_missed) {
+		printf("frame hint misses more than ratio [FAIL]\n");
+		return 1;
+	}
+	printf("simulator [PASS]\n");
+	return 0;
+}